@@ -0,0 +1,1102 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyBenchmarks.cpp
+ * \brief File containing the micro-benchmarks for the video pipeline's hot spots.
+ */
+#include <benchmark/benchmark.h>
+#include <QGuiApplication>
+#include <QImage>
+#include <QSize>
+#include <QRect>
+#include <QRectF>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <ctime>
+#include <chrono>
+#include <stdexcept>
+#include <opencv2/opencv.hpp>
+#include <boost/exception/all.hpp>
+#include <boost/filesystem.hpp>
+#include "IpFreelyCameraDatabase.h"
+#include "IpFreelyImageUtils.h"
+#include "IpFreelyFramePool.h"
+#include "IpFreelyFramePyramid.h"
+#include "IpFreelyMotionDetector.h"
+#include "IpFreelyStreamProcessor.h"
+#include "IpFreelyDiskSpaceManager.h"
+#include "IpFreelyClock.h"
+#include "IpFreelySchedule.h"
+#include "IpFreelyPipelineEnvironment.h"
+#include "FileUtils/FileUtils.h"
+#include "StringUtils/StringUtils.h"
+
+namespace bfs = boost::filesystem;
+
+namespace ipfreely
+{
+
+/*! \brief Structure giving the benchmarks access to the pipeline's private stages. */
+struct IpFreelyBenchmarkAccess
+{
+    /*! \brief Typedef to the stream processor's cached motion regions overlay. */
+    typedef IpFreelyStreamProcessor::OverlayLayer overlay_layer_t;
+
+    static QImage RenderDisplayFrame(IpFreelyFramePyramid& framePyramid, bool const expanded,
+                                     QSize const& requestedSize, QRect const& motionBoundingRect,
+                                     IpCamera::regions_t const& motionRegions,
+                                     overlay_layer_t&           overlay)
+    {
+        return IpFreelyStreamProcessor::RenderDisplayFrame(
+            framePyramid,
+            expanded ? eDisplayTarget::expanded : eDisplayTarget::feed,
+            requestedSize,
+            QRectF(),
+            motionBoundingRect,
+            true,
+            motionRegions,
+            1,
+            overlay);
+    }
+
+    static void SetMotionFrames(IpFreelyMotionDetector& detector, cv::Mat const& prevGreyFrame,
+                                cv::Mat const& currentGreyFrame, cv::Mat const& nextGreyFrame)
+    {
+        detector.m_prevGreyFrame    = prevGreyFrame;
+        detector.m_currentGreyFrame = currentGreyFrame;
+        detector.m_nextGreyFrame    = nextGreyFrame;
+    }
+
+    static void SetMotionBoundingRect(IpFreelyMotionDetector& detector, cv::Rect const& rect)
+    {
+        detector.m_motionBoundingRect = rect;
+    }
+
+    static bool DetectMotion(IpFreelyMotionDetector& detector)
+    {
+        return detector.DetectMotion();
+    }
+
+    static cv::Mat CreateMotionMask(IpFreelyMotionDetector const& detector)
+    {
+        return detector.CreateMotionMask();
+    }
+
+    static cv::Rect FindMotionBounds(IpFreelyMotionDetector const& detector,
+                                     cv::Mat const&                motion)
+    {
+        return detector.FindMotionBounds(motion);
+    }
+
+    static void UpdateMotionBoundingRect(IpFreelyMotionDetector& detector,
+                                         cv::Rect const&         motionRect)
+    {
+        detector.UpdateMotionBoundingRect(motionRect);
+    }
+
+    static bool CheckForIntersections(IpFreelyMotionDetector& detector)
+    {
+        return detector.CheckForIntersections();
+    }
+
+    static uint64_t DirectorySize(std::string const& directoryPath)
+    {
+        return IpFreelyDiskSpaceManager::DirectorySize(directoryPath);
+    }
+
+    static bool ScheduledRecording(IpFreelyStreamProcessor const& processor)
+    {
+        return processor.GetEnableVideoWriting();
+    }
+
+    static std::string const& VideoFilePath(IpFreelyStreamProcessor const& processor)
+    {
+        return processor.m_videoFilePath;
+    }
+
+    static IpFreelyMotionDetector const* MotionDetector(IpFreelyStreamProcessor const& processor)
+    {
+        return processor.m_motionDetector.get();
+    }
+
+    static std::string const& VideoFilePath(IpFreelyMotionDetector const& detector)
+    {
+        return detector.m_videoFilePath;
+    }
+};
+
+} // namespace ipfreely
+
+namespace
+{
+
+using ipfreely::IpFreelyBenchmarkAccess;
+
+/*! \brief Input source enumeration. */
+enum class eInputSource
+{
+    synthetic,
+    recorded
+};
+
+/*! \brief Structure describing one of the input resolutions. */
+struct Resolution
+{
+    /*! \brief The name used in the benchmarks' labels. */
+    char const* name;
+    /*! \brief The frame size. */
+    cv::Size size;
+};
+
+static Resolution const RESOLUTIONS[] = {
+    {"720p", cv::Size(1280, 720)}, {"1080p", cv::Size(1920, 1080)}, {"4K", cv::Size(3840, 2160)}};
+
+static constexpr int    NUM_RESOLUTIONS      = 3;
+static constexpr int    NUM_INPUT_FRAMES     = 8;
+static constexpr double INPUT_FPS            = 25.0;
+static constexpr size_t MAX_POOLED_FRAMES    = 16;
+static constexpr int    NUM_RECORDING_DAYS   = 30;
+static constexpr double SYNTHETIC_NOISE_SDEV = 6.0;
+
+// The medium sensitivity preset from the camera setup dialog.
+static constexpr double MOTION_PIXEL_THRESHOLD   = 50.0;
+static constexpr double MOTION_MAX_STDDEV        = 20.0;
+static constexpr double MOTION_MIN_AREA_FACTOR   = 0.025;
+static constexpr double MOTION_AREA_AVE_FACTOR   = 0.1;
+static constexpr int    REGION_COUNT_MULTIPLIER  = 4;
+static constexpr int    MAX_NUM_MOTION_REGIONS   = 1024;
+static constexpr int    NUM_DISK_SCAN_FILE_SIZES = 3;
+static constexpr int    DISK_SCAN_FILE_COUNTS[NUM_DISK_SCAN_FILE_SIZES] = {1000, 10000, 100000};
+
+// DivX and Xvid as recorded on Windows and Linux respectively, and Motion JPEG for comparison.
+static char const* const CODECS[] = {"DIVX", "XVID", "MJPG"};
+
+static constexpr int NUM_CODECS = 3;
+
+// The simulated days run at the lowest recording frame rate, at which a day is 86400 frames.
+static constexpr int    HOURS_PER_DAY                = 24;
+static constexpr int    SECS_PER_HOUR                = 3600;
+static constexpr int    NUM_WEEKDAYS                 = 7;
+static constexpr double SIMULATED_FPS                = ipfreely::MIN_FPS;
+static constexpr double SIMULATED_FRAME_PERIOD_SECS  = 1.0 / SIMULATED_FPS;
+static constexpr double SIMULATED_FILE_DURATION_SECS = 300.0;
+static constexpr double SIMULATED_MOTION_SECS        = 120.0;
+static constexpr int    SIMULATED_DAYS_TO_STORE      = 2;
+static constexpr int    MAX_PERCENT_USED_SPACE       = 100;
+static constexpr int    MAX_SIMULATED_DAYS           = 3;
+
+// The motion detector's hold-off, plus the frames it takes to see that motion has ended.
+static constexpr double MOTION_HOLD_OFF_SECS        = 10.0;
+static constexpr double MOTION_HOLD_OFF_MARGIN_SECS = 5.0;
+
+// Monday 1st January 2018, 00:00 UTC.
+static constexpr time_t SIMULATION_START = 1514764800;
+
+static cv::Size const SIMULATED_FRAME_SIZE(320, 240);
+
+std::string g_recordedVideoPath;
+bfs::path   g_workingFolder;
+
+/*! \brief Structure holding a benchmark input's consecutive video frames. */
+struct InputFrames
+{
+    /*! \brief The native BGR video frames. */
+    std::vector<cv::Mat> videoFrames{};
+};
+
+char const* SourceName(eInputSource const source)
+{
+    return source == eInputSource::recorded ? "recorded" : "synthetic";
+}
+
+std::vector<cv::Mat> SyntheticFrames(cv::Size const& size)
+{
+    // A noisy gradient with a bright block moving across it, the noise keeps the encoders and
+    // the motion detector's threshold honest and the block provides the motion.
+    cv::RNG rng(0x1f2e3d4c);
+    cv::Mat background(size, CV_8UC3);
+
+    for (int j = 0; j < size.height; ++j)
+    {
+        auto const shade = static_cast<uchar>((j * 255) / size.height);
+        background.row(j).setTo(cv::Scalar(shade, 128, 255 - shade));
+    }
+
+    std::vector<cv::Mat> frames;
+    auto const           block = cv::Size(size.width / 8, size.height / 6);
+
+    for (int i = 0; i < NUM_INPUT_FRAMES; ++i)
+    {
+        cv::Mat noise(size, CV_8UC3);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(SYNTHETIC_NOISE_SDEV));
+
+        cv::Mat frame;
+        cv::add(background, noise, frame);
+
+        auto const x = (size.width / 4) + ((i * size.width) / (4 * NUM_INPUT_FRAMES));
+        cv::rectangle(frame,
+                      cv::Rect(cv::Point(x, size.height / 2), block),
+                      cv::Scalar(240, 240, 240),
+                      cv::FILLED);
+        frames.emplace_back(frame);
+    }
+
+    return frames;
+}
+
+std::vector<cv::Mat> RecordedFrames(cv::Size const& size)
+{
+    cv::VideoCapture capture(g_recordedVideoPath);
+
+    if (!capture.isOpened())
+    {
+        BOOST_THROW_EXCEPTION(
+            std::runtime_error("Failed to open recorded video: " + g_recordedVideoPath));
+    }
+
+    std::vector<cv::Mat> frames;
+    cv::Mat              frame;
+
+    while ((frames.size() < NUM_INPUT_FRAMES) && capture.read(frame))
+    {
+        frames.emplace_back(ipfreely::utils::ResizeMat(frame, QSize(size.width, size.height)));
+    }
+
+    if (frames.size() < NUM_INPUT_FRAMES)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::runtime_error("Too few frames in recorded video: " + g_recordedVideoPath));
+    }
+
+    return frames;
+}
+
+InputFrames const& Input(eInputSource const source, int const resolution)
+{
+    // Inputs are created on first use, outside of any timed region, and then shared by every
+    // benchmark using the same source and resolution.
+    static std::map<std::pair<eInputSource, int>, InputFrames> inputs;
+
+    auto& input = inputs[std::make_pair(source, resolution)];
+
+    if (input.videoFrames.empty())
+    {
+        auto const size   = RESOLUTIONS[resolution].size;
+        input.videoFrames = source == eInputSource::recorded ? RecordedFrames(size)
+                                                             : SyntheticFrames(size);
+    }
+
+    return input;
+}
+
+std::string InputLabel(eInputSource const source, int const resolution)
+{
+    return std::string(SourceName(source)) + "/" + RESOLUTIONS[resolution].name;
+}
+
+ipfreely::IpCamera MotionCamera(ipfreely::IpCamera::regions_t const& motionRegions = {})
+{
+    ipfreely::IpCamera camera;
+    camera.camId                      = 1;
+    camera.streamUrl                  = "benchmark";
+    camera.motionDectorMode           = ipfreely::eMotionDetectorMode::mediumSensitivity;
+    camera.shrinkVideoFrames          = true;
+    camera.pixelThreshold             = MOTION_PIXEL_THRESHOLD;
+    camera.maxMotionStdDev            = MOTION_MAX_STDDEV;
+    camera.minMotionAreaPercentFactor = MOTION_MIN_AREA_FACTOR;
+    camera.motionAreaAveFactor        = MOTION_AREA_AVE_FACTOR;
+    camera.motionRegions              = motionRegions;
+    return camera;
+}
+
+/*! \brief Class holding a motion detector primed with three consecutive luma frames. */
+class MotionFixture final
+{
+public:
+    MotionFixture(eInputSource const source, int const resolution,
+                  ipfreely::IpCamera::regions_t const& motionRegions = {})
+    {
+        auto const& input = Input(source, resolution);
+        auto const  size  = RESOLUTIONS[resolution].size;
+
+        // The detector's message queue thread idles as no frames are ever queued, every stage
+        // is called directly on the benchmark's thread instead.
+        m_detector = std::make_unique<ipfreely::IpFreelyMotionDetector>(
+            "benchmark",
+            MotionCamera(motionRegions),
+            (g_workingFolder / "motion").string(),
+            60.0,
+            INPUT_FPS,
+            size.width,
+            size.height);
+
+        // Take the luma frames from frame pyramids, exactly as the stream processor does.
+        auto const framePool = std::make_shared<ipfreely::IpFreelyFramePool>(MAX_POOLED_FRAMES);
+        auto const motionSize = m_detector->MotionFrameSize();
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            ipfreely::IpFreelyFramePyramid pyramid(input.videoFrames[i], i, framePool);
+            m_greyFrames.emplace_back(pyramid.MotionLevel(motionSize).clone());
+        }
+
+        IpFreelyBenchmarkAccess::SetMotionFrames(
+            *m_detector, m_greyFrames[0], m_greyFrames[1], m_greyFrames[2]);
+    }
+
+    ipfreely::IpFreelyMotionDetector& Detector()
+    {
+        return *m_detector;
+    }
+
+private:
+    std::unique_ptr<ipfreely::IpFreelyMotionDetector> m_detector;
+    std::vector<cv::Mat>                              m_greyFrames;
+};
+
+void BM_CvMatToQImage(benchmark::State& state, eInputSource const source)
+{
+    auto const  resolution = static_cast<int>(state.range(0));
+    auto const& frame      = Input(source, resolution).videoFrames.front();
+    QImage      image;
+
+    for (auto _ : state)
+    {
+        ipfreely::utils::CvMatToQImage(frame, image);
+        benchmark::DoNotOptimize(image.constBits());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(frame.total()) *
+                            static_cast<int64_t>(frame.elemSize()));
+    state.SetLabel(InputLabel(source, resolution));
+}
+
+void BM_DetectMotion(benchmark::State& state, eInputSource const source)
+{
+    auto const    resolution = static_cast<int>(state.range(0));
+    MotionFixture fixture(source, resolution);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(IpFreelyBenchmarkAccess::DetectMotion(fixture.Detector()));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(InputLabel(source, resolution));
+}
+
+void BM_CreateMotionMask(benchmark::State& state, eInputSource const source)
+{
+    auto const    resolution = static_cast<int>(state.range(0));
+    MotionFixture fixture(source, resolution);
+
+    for (auto _ : state)
+    {
+        auto motion = IpFreelyBenchmarkAccess::CreateMotionMask(fixture.Detector());
+        benchmark::DoNotOptimize(motion.data);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(InputLabel(source, resolution));
+}
+
+void BM_FindMotionBounds(benchmark::State& state, eInputSource const source)
+{
+    auto const    resolution = static_cast<int>(state.range(0));
+    MotionFixture fixture(source, resolution);
+    auto const    motion = IpFreelyBenchmarkAccess::CreateMotionMask(fixture.Detector());
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            IpFreelyBenchmarkAccess::FindMotionBounds(fixture.Detector(), motion));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(InputLabel(source, resolution));
+}
+
+void BM_UpdateMotionBoundingRect(benchmark::State& state, eInputSource const source)
+{
+    auto const    resolution = static_cast<int>(state.range(0));
+    MotionFixture fixture(source, resolution);
+    auto const    motion = IpFreelyBenchmarkAccess::CreateMotionMask(fixture.Detector());
+    auto const rect = IpFreelyBenchmarkAccess::FindMotionBounds(fixture.Detector(), motion);
+
+    for (auto _ : state)
+    {
+        IpFreelyBenchmarkAccess::UpdateMotionBoundingRect(fixture.Detector(), rect);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(InputLabel(source, resolution));
+}
+
+void BM_CheckForIntersections(benchmark::State& state)
+{
+    // Regions are tiled over the bottom half of the frame and motion is held in the top half,
+    // so every region has to be tested, the worst case for a camera with many regions.
+    auto const                    numRegions = static_cast<int>(state.range(0));
+    auto const                    columns    = static_cast<int>(std::ceil(std::sqrt(numRegions)));
+    auto const                    rows       = (numRegions + columns - 1) / columns;
+    ipfreely::IpCamera::regions_t motionRegions;
+
+    for (int i = 0; i < numRegions; ++i)
+    {
+        double const width  = 1.0 / columns;
+        double const height = 0.5 / rows;
+        motionRegions.emplace_back(std::make_pair(
+            std::make_pair((i % columns) * width, 0.5 + ((i / columns) * height)),
+            std::make_pair(width * 0.9, height * 0.9)));
+    }
+
+    static constexpr int resolution = 1;
+    MotionFixture        fixture(eInputSource::synthetic, resolution, motionRegions);
+    auto&                detector = fixture.Detector();
+    auto const           size     = RESOLUTIONS[resolution].size;
+
+    IpFreelyBenchmarkAccess::SetMotionBoundingRect(
+        detector, cv::Rect(size.width / 4, size.height / 8, size.width / 2, size.height / 4));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(IpFreelyBenchmarkAccess::CheckForIntersections(detector));
+    }
+
+    state.SetItemsProcessed(state.iterations() * numRegions);
+}
+
+void BM_RenderDisplayFrame(benchmark::State& state, eInputSource const source)
+{
+    auto const  resolution   = static_cast<int>(state.range(0));
+    auto const  displayWidth = static_cast<int>(state.range(1));
+    auto const& input        = Input(source, resolution);
+    auto const  size         = RESOLUTIONS[resolution].size;
+    auto const  displaySize  = QSize(displayWidth, (displayWidth * size.height) / size.width);
+    auto const  framePool    = std::make_shared<ipfreely::IpFreelyFramePool>(MAX_POOLED_FRAMES);
+    auto const  motionRect =
+        QRect(size.width / 4, size.height / 2, size.width / 4, size.height / 4);
+    ipfreely::IpCamera::regions_t const motionRegions = {{{0.1, 0.1}, {0.3, 0.3}},
+                                                         {{0.6, 0.1}, {0.3, 0.3}},
+                                                         {{0.1, 0.6}, {0.3, 0.3}},
+                                                         {{0.6, 0.6}, {0.3, 0.3}}};
+    IpFreelyBenchmarkAccess::overlay_layer_t overlay;
+    uint64_t                                 frameSequence = 0;
+
+    for (auto _ : state)
+    {
+        // A new pyramid per frame, as captured, so the scaled levels are computed every time.
+        auto const& frame = input.videoFrames[frameSequence % input.videoFrames.size()];
+        ipfreely::IpFreelyFramePyramid pyramid(frame, ++frameSequence, framePool);
+
+        auto displayFrame = IpFreelyBenchmarkAccess::RenderDisplayFrame(
+            pyramid, displayWidth >= size.width, displaySize, motionRect, motionRegions, overlay);
+        benchmark::DoNotOptimize(displayFrame.constBits());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(InputLabel(source, resolution) + "->" + std::to_string(displaySize.width()) +
+                   "x" + std::to_string(displaySize.height()));
+}
+
+void BM_VideoWriter(benchmark::State& state, eInputSource const source)
+{
+    auto const  codec      = static_cast<int>(state.range(0));
+    auto const  resolution = static_cast<int>(state.range(1));
+    auto const& input      = Input(source, resolution);
+    auto const  fourcc     = CODECS[codec];
+    auto const  filePath   = (g_workingFolder / (std::string(fourcc) + ".avi")).string();
+
+    {
+        cv::VideoWriter writer(filePath,
+                               cv::VideoWriter::fourcc(fourcc[0], fourcc[1], fourcc[2], fourcc[3]),
+                               INPUT_FPS,
+                               RESOLUTIONS[resolution].size);
+
+        if (!writer.isOpened())
+        {
+            state.SkipWithError("Codec not available in this OpenCV build.");
+            return;
+        }
+
+        size_t frameIndex = 0;
+
+        for (auto _ : state)
+        {
+            writer.write(input.videoFrames[frameIndex++ % input.videoFrames.size()]);
+        }
+    }
+
+    boost::system::error_code ec;
+    state.counters["bytes_per_frame"] =
+        static_cast<double>(bfs::file_size(filePath, ec)) / static_cast<double>(state.iterations());
+    bfs::remove(filePath, ec);
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(std::string(fourcc) + "/" + InputLabel(source, resolution));
+}
+
+bfs::path RecordingTree(int const numFiles)
+{
+    // Laid out as the recorders do, one sub-directory per day, and created once per size as
+    // creating 100k files takes far longer than scanning them.
+    auto const root = g_workingFolder / ("recordings_" + std::to_string(numFiles));
+
+    if (bfs::exists(root))
+    {
+        return root;
+    }
+
+    for (int i = 0; i < numFiles; ++i)
+    {
+        std::ostringstream day;
+        day << "201901" << std::setw(2) << std::setfill('0') << ((i % NUM_RECORDING_DAYS) + 1);
+
+        auto const dayFolder = root / day.str();
+
+        if (i < NUM_RECORDING_DAYS)
+        {
+            bfs::create_directories(dayFolder);
+        }
+
+        std::ofstream file((dayFolder / ("cam_motion_" + std::to_string(i) + ".avi")).string());
+        file << 'x';
+    }
+
+    return root;
+}
+
+void BM_ListSubDirectories(benchmark::State& state)
+{
+    auto const numFiles = static_cast<int>(state.range(0));
+    auto const root     = core_lib::string_utils::StringToWString(RecordingTree(numFiles).string());
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(core_lib::file_utils::ListSubDirectories(root));
+    }
+
+    state.SetItemsProcessed(state.iterations() * NUM_RECORDING_DAYS);
+}
+
+void BM_DirectorySize(benchmark::State& state)
+{
+    auto const numFiles = static_cast<int>(state.range(0));
+    auto const root     = RecordingTree(numFiles).string();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(IpFreelyBenchmarkAccess::DirectorySize(root));
+    }
+
+    state.SetItemsProcessed(state.iterations() * numFiles);
+}
+
+/*! \brief Class defining a frame source that replays synthetic frames by the virtual clock. */
+class SyntheticCapture final : public cv::VideoCapture
+{
+public:
+    SyntheticCapture(std::vector<cv::Mat> const&                            frames,
+                     std::shared_ptr<ipfreely::IpFreelyVirtualClock> const& clock)
+        : m_frames(frames)
+        , m_clock(clock)
+    {
+    }
+
+    virtual bool isOpened() const
+    {
+        return true;
+    }
+
+    virtual double get(int propId) const
+    {
+        switch (propId)
+        {
+        case cv::CAP_PROP_FPS:
+            return SIMULATED_FPS;
+        case cv::CAP_PROP_FRAME_WIDTH:
+            return m_frames.front().cols;
+        case cv::CAP_PROP_FRAME_HEIGHT:
+            return m_frames.front().rows;
+        default:
+            return 0.0;
+        }
+    }
+
+    virtual bool read(cv::OutputArray image)
+    {
+        // The scene only changes at the start of each hour, the rest of the hour it is still.
+        auto const inMotion =
+            std::fmod(m_clock->ElapsedSecs(), SECS_PER_HOUR) < SIMULATED_MOTION_SECS;
+        auto const index = inMotion ? m_frameIndex++ % m_frames.size() : 0;
+        m_frames[index].copyTo(image);
+        return true;
+    }
+
+    virtual cv::VideoCapture& operator>>(cv::Mat& image)
+    {
+        read(image);
+        return *this;
+    }
+
+private:
+    std::vector<cv::Mat>                            m_frames;
+    std::shared_ptr<ipfreely::IpFreelyVirtualClock> m_clock;
+    size_t                                          m_frameIndex{0};
+};
+
+bool SimulatedRecordingHour(int const hour)
+{
+    // Three hours on, three hours off, so a day has eight recording transitions.
+    return (hour % 6) < 3;
+}
+
+bool SimulatedMotionHour(int const hour)
+{
+    // Daytime only, overlapping both the recording hours and the gaps between them.
+    return (hour >= 7) && (hour < 20);
+}
+
+ipfreely::IpFreelySchedule SimulatedSchedule(bool (*isScheduledHour)(int))
+{
+    // Hourly slots and no pre-warm, so transitions land exactly on the hour as checked below.
+    ipfreely::IpFreelySchedule schedule(60);
+
+    for (int day = 0; day < NUM_WEEKDAYS; ++day)
+    {
+        for (int hour = 0; hour < HOURS_PER_DAY; ++hour)
+        {
+            schedule.SetSlot(day, hour, isScheduledHour(hour));
+        }
+    }
+
+    return schedule;
+}
+
+std::string DayFolderName(ipfreely::IpFreelyClock const& clock, time_t const time)
+{
+    auto const localTime = clock.LocalTime(time);
+    char       folderName[9];
+    std::strftime(folderName, sizeof(folderName), "%Y%m%d", &localTime);
+    return folderName;
+}
+
+size_t CountSubDirectories(bfs::path const& folder)
+{
+    size_t                    numSubDirs = 0;
+    boost::system::error_code ec;
+
+    for (bfs::directory_iterator dirIter(folder, ec), endIter; !ec && (dirIter != endIter);
+         dirIter.increment(ec))
+    {
+        if (bfs::is_directory(dirIter->path(), ec))
+        {
+            ++numSubDirs;
+        }
+    }
+
+    return numSubDirs;
+}
+
+/*! \brief Class checking a simulated run's video files against the expected boundaries. */
+class SegmentChecker final
+{
+public:
+    SegmentChecker(char const* name, double const requiredFileDurationSecs)
+        : m_name(name)
+        , m_requiredFileDurationSecs(requiredFileDurationSecs)
+    {
+    }
+
+    size_t NumSegments() const
+    {
+        return m_numSegments;
+    }
+
+    std::string const& Error() const
+    {
+        return m_error;
+    }
+
+    void Update(std::string const& videoFilePath, ipfreely::IpFreelyClock const& clock,
+                time_t const stepTime, double const stepSecs, bool const mayStop)
+    {
+        if (videoFilePath == m_videoFilePath)
+        {
+            return;
+        }
+
+        std::ostringstream oss;
+
+        if (!m_videoFilePath.empty())
+        {
+            // Files roll over once they reach their duration, or stop early with the schedule.
+            auto const durationSecs = stepSecs - m_openSecs;
+            auto const rollover     = !videoFilePath.empty();
+
+            if ((rollover && (std::abs(durationSecs - m_requiredFileDurationSecs) >
+                              SIMULATED_FRAME_PERIOD_SECS)) ||
+                (!rollover && !mayStop) ||
+                (durationSecs > m_requiredFileDurationSecs + SIMULATED_FRAME_PERIOD_SECS))
+            {
+                oss << m_name << " file " << m_videoFilePath << " lasted " << durationSecs
+                    << "s, " << (rollover ? "rolled over" : "stopped") << " at " << stepSecs
+                    << "s";
+            }
+        }
+
+        if (!videoFilePath.empty())
+        {
+            // Each file is saved in the folder named after the day it was opened on.
+            auto const folder = bfs::path(videoFilePath).parent_path().filename().string();
+
+            if (folder != DayFolderName(clock, stepTime))
+            {
+                oss << m_name << " file " << videoFilePath << " opened at " << stepSecs
+                    << "s is not in folder " << DayFolderName(clock, stepTime);
+            }
+
+            ++m_numSegments;
+        }
+
+        if (m_error.empty())
+        {
+            m_error = oss.str();
+        }
+
+        m_videoFilePath = videoFilePath;
+        m_openSecs      = stepSecs;
+    }
+
+private:
+    char const* m_name;
+    double      m_requiredFileDurationSecs;
+    std::string m_videoFilePath{};
+    double      m_openSecs{0.0};
+    size_t      m_numSegments{0};
+    std::string m_error{};
+};
+
+std::string RunSimulatedDays(int64_t const numSteps, bfs::path const& saveFolder,
+                             std::vector<cv::Mat> const& frames, size_t& numFiles,
+                             size_t& numSwitches)
+{
+    auto const clock = std::make_shared<ipfreely::IpFreelyVirtualClock>(SIMULATION_START);
+
+    ipfreely::PipelineEnvironment environment;
+    environment.clock          = clock;
+    environment.manualStepping = true;
+    environment.captureFactory = [&frames, &clock](ipfreely::IpCamera const&) {
+        return cv::Ptr<cv::VideoCapture>(new SyntheticCapture(frames, clock));
+    };
+
+    auto camera         = MotionCamera();
+    camera.cameraMaxFps = SIMULATED_FPS;
+
+    ipfreely::IpFreelyStreamProcessor processor("simulated",
+                                                camera,
+                                                saveFolder.string(),
+                                                SIMULATED_FILE_DURATION_SECS,
+                                                SimulatedSchedule(SimulatedRecordingHour),
+                                                SimulatedSchedule(SimulatedMotionHour),
+                                                {},
+                                                {},
+                                                environment);
+    ipfreely::IpFreelyDiskSpaceManager diskSpaceManager(
+        saveFolder.string(), SIMULATED_DAYS_TO_STORE, MAX_PERCENT_USED_SPACE, {}, environment);
+
+    SegmentChecker recordingFiles("Recording", SIMULATED_FILE_DURATION_SECS);
+    SegmentChecker motionFiles("Motion", SIMULATED_FILE_DURATION_SECS);
+    bool           wasRecording = false;
+    bool           wasDetecting = false;
+    auto           currentDay   = DayFolderName(*clock, clock->Now());
+    std::string    error;
+
+    for (int64_t step = 0; (step < numSteps) && error.empty(); ++step)
+    {
+        // The pipeline reads the clock at the start of each step.
+        auto const stepTime  = clock->Now();
+        auto const stepSecs  = clock->ElapsedSecs();
+        auto const localTime = clock->LocalTime(stepTime);
+
+        processor.Step();
+
+        auto const isRecording = IpFreelyBenchmarkAccess::ScheduledRecording(processor);
+        auto const detector    = IpFreelyBenchmarkAccess::MotionDetector(processor);
+        auto const isDetecting = detector != nullptr;
+
+        std::ostringstream oss;
+
+        // Each schedule must switch on and off on the first frame of its hour.
+        if (isRecording != SimulatedRecordingHour(localTime.tm_hour))
+        {
+            oss << "Recording " << (isRecording ? "on" : "off") << " at " << stepSecs << "s";
+        }
+        else if (isDetecting != SimulatedMotionHour(localTime.tm_hour))
+        {
+            oss << "Motion detector " << (isDetecting ? "on" : "off") << " at " << stepSecs
+                << "s";
+        }
+
+        numSwitches += (isRecording != wasRecording) ? 1 : 0;
+        numSwitches += (isDetecting != wasDetecting) ? 1 : 0;
+
+        recordingFiles.Update(IpFreelyBenchmarkAccess::VideoFilePath(processor),
+                              *clock,
+                              stepTime,
+                              stepSecs,
+                              wasRecording && !isRecording);
+
+        // Motion files stop once the scene has been still for the hold-off period, give or take
+        // the frames the detector needs to see the motion end, or when the motion schedule ends.
+        auto const motionFilePath =
+            isDetecting ? IpFreelyBenchmarkAccess::VideoFilePath(*detector) : std::string();
+        auto const secsSinceMotion = std::fmod(stepSecs, SECS_PER_HOUR) - SIMULATED_MOTION_SECS;
+
+        motionFiles.Update(
+            motionFilePath, *clock, stepTime, stepSecs, !isDetecting || (secsSinceMotion >= 0.0));
+
+        if (!motionFilePath.empty() &&
+            (secsSinceMotion > MOTION_HOLD_OFF_SECS + MOTION_HOLD_OFF_MARGIN_SECS))
+        {
+            oss << "Motion file " << motionFilePath << " still open at " << stepSecs << "s";
+        }
+
+        wasRecording = isRecording;
+        wasDetecting = isDetecting;
+
+        // Old recordings are deleted as each new day's folder appears.
+        auto const day = DayFolderName(*clock, stepTime);
+
+        if (day != currentDay)
+        {
+            currentDay = day;
+            diskSpaceManager.Step();
+
+            auto const numDaysStored = CountSubDirectories(saveFolder);
+
+            if (numDaysStored > static_cast<size_t>(SIMULATED_DAYS_TO_STORE))
+            {
+                oss << numDaysStored << " days stored at " << stepSecs << "s";
+            }
+        }
+
+        error = oss.str();
+
+        if (error.empty())
+        {
+            error = recordingFiles.Error().empty() ? motionFiles.Error() : recordingFiles.Error();
+        }
+
+        clock->Advance(SIMULATED_FRAME_PERIOD_SECS);
+    }
+
+    numFiles = recordingFiles.NumSegments() + motionFiles.NumSegments();
+
+    if (error.empty() && (recordingFiles.NumSegments() == 0))
+    {
+        error = "No video files were written, is the XVID codec available?";
+    }
+
+    return error;
+}
+
+void BM_SimulatedDays(benchmark::State& state)
+{
+    // SkipWithError() keeps a pointer to the message rather than a copy.
+    static std::string error;
+
+    auto const numDays  = static_cast<int>(state.range(0));
+    auto const numSteps = static_cast<int64_t>(numDays) * HOURS_PER_DAY * SECS_PER_HOUR *
+                          static_cast<int64_t>(SIMULATED_FPS);
+    auto const frames      = SyntheticFrames(SIMULATED_FRAME_SIZE);
+    size_t     numFiles    = 0;
+    size_t     numSwitches = 0;
+    double     wallSecs    = 0.0;
+
+    for (auto _ : state)
+    {
+        auto const saveFolder = g_workingFolder / bfs::unique_path("simulated_%%%%%%%%");
+        auto const startTime  = std::chrono::steady_clock::now();
+
+        numFiles    = 0;
+        numSwitches = 0;
+        error       = RunSimulatedDays(numSteps, saveFolder, frames, numFiles, numSwitches);
+
+        wallSecs +=
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        boost::system::error_code ec;
+        bfs::remove_all(saveFolder, ec);
+
+        if (!error.empty())
+        {
+            state.SkipWithError(error.c_str());
+            break;
+        }
+    }
+
+    // A day's schedule transitions, file rollovers and retention checks take seconds.
+    auto const simulatedSecs =
+        static_cast<double>(state.iterations() * numSteps) / SIMULATED_FPS;
+
+    state.SetItemsProcessed(state.iterations() * numSteps);
+    state.counters["files"]    = static_cast<double>(numFiles);
+    state.counters["switches"] = static_cast<double>(numSwitches);
+    state.counters["speedup"]  = (wallSecs > 0.0) ? simulatedSecs / wallSecs : 0.0;
+    state.SetLabel(std::to_string(numDays) + (numDays == 1 ? " day" : " days"));
+}
+
+void RegisterBenchmarks()
+{
+    std::vector<eInputSource> sources{eInputSource::synthetic};
+
+    if (!g_recordedVideoPath.empty())
+    {
+        sources.emplace_back(eInputSource::recorded);
+    }
+
+    for (auto const source : sources)
+    {
+        auto const suffix = std::string("/") + SourceName(source);
+
+        benchmark::RegisterBenchmark(("CvMatToQImage" + suffix).c_str(), BM_CvMatToQImage, source)
+            ->DenseRange(0, NUM_RESOLUTIONS - 1);
+        benchmark::RegisterBenchmark(("DetectMotion" + suffix).c_str(), BM_DetectMotion, source)
+            ->DenseRange(0, NUM_RESOLUTIONS - 1);
+        benchmark::RegisterBenchmark(
+            ("CreateMotionMask" + suffix).c_str(), BM_CreateMotionMask, source)
+            ->DenseRange(0, NUM_RESOLUTIONS - 1);
+        benchmark::RegisterBenchmark(
+            ("FindMotionBounds" + suffix).c_str(), BM_FindMotionBounds, source)
+            ->DenseRange(0, NUM_RESOLUTIONS - 1);
+        benchmark::RegisterBenchmark(
+            ("UpdateMotionBoundingRect" + suffix).c_str(), BM_UpdateMotionBoundingRect, source)
+            ->DenseRange(0, NUM_RESOLUTIONS - 1);
+
+        // Grid tile, single camera and full size expanded views.
+        auto render = benchmark::RegisterBenchmark(
+            ("RenderDisplayFrame" + suffix).c_str(), BM_RenderDisplayFrame, source);
+
+        for (int resolution = 0; resolution < NUM_RESOLUTIONS; ++resolution)
+        {
+            for (auto const displayWidth : {480, 1280, RESOLUTIONS[resolution].size.width})
+            {
+                render->Args({resolution, displayWidth});
+            }
+        }
+
+        auto writer =
+            benchmark::RegisterBenchmark(("VideoWriter" + suffix).c_str(), BM_VideoWriter, source);
+
+        for (int codec = 0; codec < NUM_CODECS; ++codec)
+        {
+            for (int resolution = 0; resolution < NUM_RESOLUTIONS; ++resolution)
+            {
+                writer->Args({codec, resolution});
+            }
+        }
+    }
+
+    benchmark::RegisterBenchmark("CheckForIntersections", BM_CheckForIntersections)
+        ->RangeMultiplier(REGION_COUNT_MULTIPLIER)
+        ->Range(1, MAX_NUM_MOTION_REGIONS);
+
+    auto listSubDirs = benchmark::RegisterBenchmark("ListSubDirectories", BM_ListSubDirectories);
+    auto dirSize     = benchmark::RegisterBenchmark("DirectorySize", BM_DirectorySize);
+
+    for (auto const numFiles : DISK_SCAN_FILE_COUNTS)
+    {
+        listSubDirs->Arg(numFiles)->Unit(benchmark::kMillisecond);
+        dirSize->Arg(numFiles)->Unit(benchmark::kMillisecond);
+    }
+
+    // Whole days are run once each, three days also exercises deleting the oldest recordings.
+    benchmark::RegisterBenchmark("SimulatedDays", BM_SimulatedDays)
+        ->DenseRange(1, MAX_SIMULATED_DAYS)
+        ->Iterations(1)
+        ->Unit(benchmark::kSecond);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int retCode = EXIT_SUCCESS;
+
+    try
+    {
+        // Results are written as JSON with the library's own options, e.g.
+        // --benchmark_out=results.json --benchmark_out_format=json
+        benchmark::Initialize(&argc, argv);
+
+        // A recorded clip adds a second set of inputs alongside the synthetic frames.
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string const arg = argv[i];
+
+            if (arg.compare(0, 8, "--input=") == 0)
+            {
+                g_recordedVideoPath = arg.substr(8);
+            }
+            else
+            {
+                benchmark::ReportUnrecognizedArguments(argc, argv);
+                return EXIT_FAILURE;
+            }
+        }
+
+        // The overlays' text needs a GUI application, but never a display.
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+
+        QGuiApplication a(argc, argv);
+
+        g_workingFolder = bfs::temp_directory_path() / bfs::unique_path("ipfreely_bench_%%%%%%%%");
+        bfs::create_directories(g_workingFolder);
+
+        RegisterBenchmarks();
+        benchmark::RunSpecifiedBenchmarks();
+    }
+    catch (...)
+    {
+        std::cerr << boost::current_exception_diagnostic_information() << std::endl;
+        retCode = EXIT_FAILURE;
+    }
+
+    if (!g_workingFolder.empty())
+    {
+        boost::system::error_code ec;
+        bfs::remove_all(g_workingFolder, ec);
+    }
+
+    return retCode;
+}
@@ -0,0 +1,32 @@
+#-------------------------------------------------
+#
+# Micro-benchmarks for the video pipeline
+# hot spots, built on Google Benchmark.
+#
+#-------------------------------------------------
+
+QT       = core gui
+
+TARGET = IpFreelyBenchmarks
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+include(IpFreelyCore.pri)
+
+# On Windows we do this, assumes Google Benchmark is installed with the other third party libs.
+win32 {
+    INCLUDEPATH += $$(THIRD_PARTY_LIBS)/benchmark/include
+
+    LIBS += -L$$(THIRD_PARTY_LIBS)/benchmark/lib \
+            -lbenchmark \
+            -lshlwapi
+}
+# On non-windows, assumed to be Linux, we do this.
+else {
+    LIBS += -lbenchmark -lpthread
+}
+
+SOURCES += \
+    IpFreelyBenchmarks.cpp
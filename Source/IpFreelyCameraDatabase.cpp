@@ -26,6 +26,7 @@
 #include <sstream>
 #include <fstream>
 #include <utility>
+#include <set>
 #include <boost/throw_exception.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/exception/all.hpp>
@@ -118,7 +119,7 @@ std::string IpCamera::CompleteStorageHttpUrl(bool const isHttps) const noexcept
 
 bool IpCamera::IsValid() const noexcept
 {
-    return !streamUrl.empty() && (camId != eCamId::noCam);
+    return !streamUrl.empty() && (camId > NO_CAMERA_ID);
 }
 
 IpFreelyCameraDatabase::IpFreelyCameraDatabase(bool const load)
@@ -162,25 +163,32 @@ void IpFreelyCameraDatabase::AddCamera(IpCamera const& camera)
     if (DoesCameraExist(camera.camId))
     {
         std::ostringstream oss;
-        oss << "Camera already exists, ID: " << static_cast<int>(camera.camId);
+        oss << "Camera already exists, ID: " << camera.camId;
         BOOST_THROW_EXCEPTION(std::invalid_argument(oss.str()));
     }
     else
     {
-        m_cameras[camera.camId] = camera;
+        UpdateCamera(camera);
     }
 }
 
-void IpFreelyCameraDatabase::UpdateCamera(IpCamera const& camera) noexcept
+void IpFreelyCameraDatabase::UpdateCamera(IpCamera const& camera)
 {
-    m_cameras[camera.camId] = camera;
+    // Readers may still hold the old snapshot so it is replaced rather than modified.
+    auto snapshot           = std::make_shared<IpCamera const>(camera);
+    m_cameras[camera.camId] = snapshot;
+    ++m_revision;
+
+    NotifyChange(camera.camId, snapshot);
 }
 
-void IpFreelyCameraDatabase::RemoveCamera(eCamId const camId) noexcept
+void IpFreelyCameraDatabase::RemoveCamera(camera_id_t const camId)
 {
-    if (DoesCameraExist(camId))
+    if (m_cameras.erase(camId) > 0)
     {
-        m_cameras.erase(camId);
+        ++m_revision;
+
+        NotifyChange(camId, nullptr);
     }
 }
 
@@ -189,12 +197,61 @@ size_t IpFreelyCameraDatabase::GetCameraCount() const noexcept
     return m_cameras.size();
 }
 
-bool IpFreelyCameraDatabase::DoesCameraExist(eCamId const camId) const noexcept
+std::vector<camera_id_t> IpFreelyCameraDatabase::GetCameraIds() const
+{
+    std::vector<camera_id_t> camIds;
+    camIds.reserve(m_cameras.size());
+
+    for (auto const& camera : m_cameras)
+    {
+        camIds.emplace_back(camera.first);
+    }
+
+    return camIds;
+}
+
+std::vector<std::string> IpFreelyCameraDatabase::GetGroups() const
+{
+    std::set<std::string> groups;
+
+    for (auto const& camera : m_cameras)
+    {
+        if (!camera.second->group.empty())
+        {
+            groups.emplace(camera.second->group);
+        }
+    }
+
+    return std::vector<std::string>(groups.begin(), groups.end());
+}
+
+std::vector<camera_id_t>
+IpFreelyCameraDatabase::GetCameraIdsInGroup(std::string const& group) const
+{
+    std::vector<camera_id_t> camIds;
+
+    for (auto const& camera : m_cameras)
+    {
+        if (camera.second->group == group)
+        {
+            camIds.emplace_back(camera.first);
+        }
+    }
+
+    return camIds;
+}
+
+camera_id_t IpFreelyCameraDatabase::NextFreeCameraId() const noexcept
+{
+    return m_cameras.empty() ? 1 : m_cameras.rbegin()->first + 1;
+}
+
+bool IpFreelyCameraDatabase::DoesCameraExist(camera_id_t const camId) const noexcept
 {
     return m_cameras.count(camId) > 0;
 }
 
-bool IpFreelyCameraDatabase::FindCamera(eCamId const camId, IpCamera& camera) const noexcept
+bool IpFreelyCameraDatabase::FindCamera(camera_id_t const camId, IpCamera& camera) const noexcept
 {
     auto iter = m_cameras.find(camId);
 
@@ -203,73 +260,140 @@ bool IpFreelyCameraDatabase::FindCamera(eCamId const camId, IpCamera& camera) co
         return false;
     }
 
-    camera = iter->second;
+    camera = *iter->second;
 
     return true;
 }
 
-void IpFreelyCameraDatabase::Save() const
+IpFreelyCameraDatabase::camera_ptr_t
+IpFreelyCameraDatabase::GetCamera(camera_id_t const camId) const
 {
-    if (bfs::exists(m_dbPath))
+    auto iter = m_cameras.find(camId);
+    return iter == m_cameras.end() ? nullptr : iter->second;
+}
+
+int IpFreelyCameraDatabase::AddChangeListener(change_callback_t const& callback)
+{
+    auto const handle         = m_nextListenerHandle++;
+    m_changeListeners[handle] = callback;
+    return handle;
+}
+
+void IpFreelyCameraDatabase::RemoveChangeListener(int const handle) noexcept
+{
+    m_changeListeners.erase(handle);
+}
+
+void IpFreelyCameraDatabase::Save()
+{
+    if ((m_revision == m_savedRevision) && bfs::exists(m_dbPath))
     {
-        if (!bfs::remove(m_dbPath))
+        return;
+    }
+
+    auto parentPath = bfs::path(m_dbPath).parent_path();
+
+    if (!bfs::exists(parentPath))
+    {
+        if (!bfs::create_directories(parentPath))
         {
             std::ostringstream oss;
-            oss << "failed to remove existing file: " << m_dbPath;
+            oss << "failed to create directories for file: " << m_dbPath;
             BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
         }
     }
-    else
+
+    auto const tempPath = m_dbPath + ".tmp";
+
     {
-        auto parentPath = bfs::path(m_dbPath).parent_path();
+        std::ofstream ofs(tempPath.c_str());
 
-        if (!bfs::exists(parentPath))
+        if (!ofs)
         {
-            if (!bfs::create_directories(parentPath))
-            {
-                std::ostringstream oss;
-                oss << "failed to create directories for file: " << m_dbPath;
-                BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
-            }
+            std::ostringstream oss;
+            oss << "failed to create std::ofstream to: " << tempPath;
+            BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
+        }
+
+        {
+            core_lib::serialize::archives::out_port_bin_t oa(ofs);
+            oa(cereal::make_nvp("camDb", *this));
+        }
+
+        ofs.close();
+
+        if (!ofs)
+        {
+            std::ostringstream oss;
+            oss << "failed to write file: " << tempPath;
+            BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
         }
     }
 
-    std::ofstream ofs(m_dbPath.c_str());
+    // Renaming over the old file replaces it in one step, a crash part way through a save
+    // leaves either the old or the new database, never a truncated one.
+    boost::system::error_code ec;
+    bfs::rename(tempPath, m_dbPath, ec);
 
-    if (!ofs)
+    if (ec)
     {
+        boost::system::error_code removeEc;
+        bfs::remove(tempPath, removeEc);
+
         std::ostringstream oss;
-        oss << "failed to create std::ofstream to: " << m_dbPath;
+        oss << "failed to replace file: " << m_dbPath << ", error: " << ec.message();
         BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
     }
 
-    core_lib::serialize::archives::out_port_bin_t oa(ofs);
-    auto                                          camDb = *this;
-    oa(CEREAL_NVP(camDb));
+    m_savedRevision = m_revision;
 }
 
 void IpFreelyCameraDatabase::Load()
 {
     IpFreelyCameraDatabase camDb(false);
 
-    if (!bfs::exists(m_dbPath))
+    if (bfs::exists(m_dbPath))
     {
-        *this = std::move(camDb);
-        return;
+        std::ifstream ifs(m_dbPath.c_str());
+
+        if (!ifs)
+        {
+            std::ostringstream oss;
+            oss << "failed to create std::ifstream to: " << m_dbPath;
+            BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
+        }
+
+        core_lib::serialize::archives::in_port_bin_t ia(ifs);
+        ia(CEREAL_NVP(camDb));
     }
 
-    std::ifstream ifs(m_dbPath.c_str());
+    auto oldCameras = std::move(m_cameras);
+    m_cameras       = std::move(camDb.m_cameras);
+    m_savedRevision = ++m_revision;
 
-    if (!ifs)
+    for (auto const& camera : m_cameras)
     {
-        std::ostringstream oss;
-        oss << "failed to create std::ifstream to: " << m_dbPath;
-        BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
+        NotifyChange(camera.first, camera.second);
     }
 
-    core_lib::serialize::archives::in_port_bin_t ia(ifs);
-    ia(CEREAL_NVP(camDb));
-    *this = std::move(camDb);
+    for (auto const& camera : oldCameras)
+    {
+        if (m_cameras.count(camera.first) == 0)
+        {
+            NotifyChange(camera.first, nullptr);
+        }
+    }
+}
+
+void IpFreelyCameraDatabase::NotifyChange(camera_id_t const camId, camera_ptr_t const& camera) const
+{
+    // Copied so listeners may add or remove listeners from within their callbacks.
+    auto const changeListeners = m_changeListeners;
+
+    for (auto const& listener : changeListeners)
+    {
+        listener.second(camId, camera);
+    }
 }
 
 QRect CreateQRectFromVideoFrameDims(int const videoFrameWidth, int const videoFrameHeight,
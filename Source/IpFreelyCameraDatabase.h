@@ -28,6 +28,10 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <utility>
 #include <QRect>
 #include <cereal/types/map.hpp>
 #include <cereal/types/vector.hpp>
@@ -40,15 +44,11 @@
 namespace ipfreely
 {
 
-/*! \brief Camera ID enumeration. */
-enum class eCamId
-{
-    noCam,
-    cam1,
-    cam2,
-    cam3,
-    cam4
-};
+/*! \brief Typedef for a camera's ID, any positive integer uniquely identifies a camera. */
+typedef int camera_id_t;
+
+/*! \brief Camera ID used to denote no camera. */
+static constexpr camera_id_t NO_CAMERA_ID = 0;
 
 /*! \brief Motion detector mode. */
 enum class eMotionDetectorMode
@@ -85,7 +85,7 @@ struct IpCamera final
     std::string password{};
 
     /*! \brief Camera's ID. */
-    eCamId camId{eCamId::noCam};
+    camera_id_t camId{NO_CAMERA_ID};
 
     /*! \brief Enabled scheduled recording mode, when enabled this disables maual recording. */
     bool enableScheduledRecording{false};
@@ -126,6 +126,12 @@ struct IpCamera final
     /*! \brief Enabled scheduled motion recording mode. */
     bool enabledMotionRecording{false};
 
+    /*! \brief Maximum FPS at which the camera's video tile is refreshed, 0 means no limit. */
+    double displayMaxFps{0.0};
+
+    /*! \brief Name of the group the camera belongs to, empty if it is not in a group. */
+    std::string group{};
+
     /*! \brief IpCamera's default constructor. */
     IpCamera() = default;
 
@@ -248,15 +254,44 @@ struct IpCamera final
             ar(CEREAL_NVP(temp));
             enabledMotionRecording = temp == 1;
         }
+
+        if (version > 7)
+        {
+            // Added with version 8.
+            ar(CEREAL_NVP(displayMaxFps));
+        }
+
+        if (version > 8)
+        {
+            // Added with version 9.
+            ar(CEREAL_NVP(group));
+        }
     }
 };
 
-/*! \brief Cameras' database class. */
+/*!
+ * \brief Cameras' database class.
+ *
+ * Each camera is held as an immutable shared snapshot. Updating a camera replaces its snapshot,
+ * so a snapshot given out by GetCamera() can be kept and read from any thread without copying
+ * the camera or locking the database.
+ */
 class IpFreelyCameraDatabase final
 {
     friend class cereal::access;
 
 public:
+    /*! \brief Typedef for a shared, immutable snapshot of a camera's details. */
+    typedef std::shared_ptr<IpCamera const> camera_ptr_t;
+
+    /*!
+     * \brief Typedef for a camera change callback.
+     *
+     * Called with the camera's ID and its new snapshot, or a null snapshot if the camera was
+     * removed.
+     */
+    typedef std::function<void(camera_id_t, camera_ptr_t const&)> change_callback_t;
+
     /*!
      * \brief IpFreelyCameraDatabase's default constructor.
      * \param[in] load - Should constructor load settings from disk on startup.
@@ -291,13 +326,13 @@ public:
      * \brief UpdateCamera update exsiting camera details in database.
      * \param[in] camera - A camera details object.
      */
-    void UpdateCamera(IpCamera const& camera) noexcept;
+    void UpdateCamera(IpCamera const& camera);
 
     /*!
      * \brief RemoveCamera removes a camera with a ID.
      * \param[in] camId - A camera ID.
      */
-    void RemoveCamera(eCamId const camId) noexcept;
+    void RemoveCamera(camera_id_t const camId);
 
     /*!
      * \brief GetCameraCount reports the number of cameras in the database.
@@ -305,12 +340,37 @@ public:
      */
     size_t GetCameraCount() const noexcept;
 
+    /*!
+     * \brief GetCameraIds gives the IDs of all cameras in the database.
+     * \return A vector of camera IDs in ascending order.
+     */
+    std::vector<camera_id_t> GetCameraIds() const;
+
+    /*!
+     * \brief GetGroups gives the names of all camera groups in the database.
+     * \return A vector of group names in ascending order, without duplicates.
+     */
+    std::vector<std::string> GetGroups() const;
+
+    /*!
+     * \brief GetCameraIdsInGroup gives the IDs of the cameras in a group.
+     * \param[in] group - A group name, empty for the cameras that are not in a group.
+     * \return A vector of camera IDs in ascending order.
+     */
+    std::vector<camera_id_t> GetCameraIdsInGroup(std::string const& group) const;
+
+    /*!
+     * \brief NextFreeCameraId gives an ID not yet used by any camera in the database.
+     * \return One more than the largest camera ID in use, or 1 if the database is empty.
+     */
+    camera_id_t NextFreeCameraId() const noexcept;
+
     /*!
      * \brief DoesCameraExist checks if a camera with the given ID.
      * \param[in] camId - A camera ID.
      * \return True of the camera exists, false otherwise..
      */
-    bool DoesCameraExist(eCamId const camId) const noexcept;
+    bool DoesCameraExist(camera_id_t const camId) const noexcept;
 
     /*!
      * \brief FindCamera find a camera with the given ID.
@@ -318,32 +378,97 @@ public:
      * \param[out] camera - A copy of the camera object if found.
      * \return True of the camera exists, false otherwise.
      */
-    bool FindCamera(eCamId const camId, IpCamera& camera) const noexcept;
+    bool FindCamera(camera_id_t const camId, IpCamera& camera) const noexcept;
+
+    /*!
+     * \brief GetCamera gives access to a camera without copying it.
+     * \param[in] camId - A camera ID.
+     * \return The camera's current snapshot, null if the camera does not exist.
+     *
+     * Later updates to the camera do not change the returned snapshot, call this again to
+     * see them.
+     */
+    camera_ptr_t GetCamera(camera_id_t const camId) const;
+
+    /*!
+     * \brief AddChangeListener registers a callback for camera changes.
+     * \param[in] callback - Called after a camera is added, updated, removed or reloaded.
+     * \return A handle used to remove the listener.
+     *
+     * The callback is called on the thread making the change, after the database has been
+     * updated, so it may look up other cameras.
+     */
+    int AddChangeListener(change_callback_t const& callback);
+
+    /*!
+     * \brief RemoveChangeListener unregisters a camera change callback.
+     * \param[in] handle - The handle returned by AddChangeListener().
+     */
+    void RemoveChangeListener(int const handle) noexcept;
 
     /*!
      * \brief Save the database file to disk from memory.
+     *
+     * The database is written to a temporary file which then replaces the old file, so an
+     * interrupted save never leaves a truncated database. Nothing is written if the database
+     * has not changed since it was last saved or loaded.
      */
-    void Save() const;
+    void Save();
 
     /*!
      * \brief Load the database file from disk to memory.
+     *
+     * Change listeners are kept and notified of every camera loaded or removed.
      */
     void Load();
 
 private:
-    template <class Archive> void serialize(Archive& ar, const unsigned int version)
+    template <class Archive> void save(Archive& ar, const unsigned int version) const
+    {
+        if (version < 1)
+        {
+            return;
+        }
+
+        // Same layout as a std::map<camera_id_t, IpCamera> so older files still load.
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(m_cameras.size())));
+
+        for (auto const& camera : m_cameras)
+        {
+            ar(cereal::make_map_item(camera.first, *camera.second));
+        }
+    }
+
+    template <class Archive> void load(Archive& ar, const unsigned int version)
     {
+        m_cameras.clear();
+
         if (version < 1)
         {
             return;
         }
 
-        ar(CEREAL_NVP(m_cameras));
+        cereal::size_type numCameras{0};
+        ar(cereal::make_size_tag(numCameras));
+
+        for (cereal::size_type i = 0; i < numCameras; ++i)
+        {
+            camera_id_t camId{NO_CAMERA_ID};
+            IpCamera    camera;
+            ar(cereal::make_map_item(camId, camera));
+            m_cameras[camId] = std::make_shared<IpCamera const>(std::move(camera));
+        }
     }
 
+    void NotifyChange(camera_id_t const camId, camera_ptr_t const& camera) const;
+
 private:
-    std::string                m_dbPath{};
-    std::map<eCamId, IpCamera> m_cameras{};
+    std::string                         m_dbPath{};
+    std::map<camera_id_t, camera_ptr_t> m_cameras{};
+    std::map<int, change_callback_t>    m_changeListeners{};
+    int                                 m_nextListenerHandle{1};
+    uint64_t                            m_revision{0};
+    uint64_t                            m_savedRevision{0};
 };
 
 /*!
@@ -359,7 +484,7 @@ QRect CreateQRectFromVideoFrameDims(int const videoFrameWidth, int const videoFr
 
 } // namespace ipfreely
 
-CEREAL_CLASS_VERSION(ipfreely::IpCamera, 7);
+CEREAL_CLASS_VERSION(ipfreely::IpCamera, 9);
 CEREAL_CLASS_VERSION(ipfreely::IpFreelyCameraDatabase, 1);
 
 #endif // IPFREELYCAMERADATABASE_H
@@ -0,0 +1,1248 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyCameraSimulator.cpp
+ * \brief File containing definition of IpFreelyCameraSimulator class.
+ */
+#include "IpFreelyCameraSimulator.h"
+#include <QThread>
+#include <QTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QVariant>
+#include <QUrl>
+#include <vector>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include <memory>
+#include <stdexcept>
+#include <opencv2/opencv.hpp>
+#include <boost/exception/all.hpp>
+#include "IpFreelyRtspMessage.h"
+#include "DebugLog/DebugLogging.h"
+
+namespace ipfreely
+{
+
+namespace
+{
+
+// RTSP requests are never this large.
+static constexpr int MAX_MESSAGE_SIZE = 16384;
+
+// HTTP requests are a single GET line plus headers, anything larger is not one of ours.
+static constexpr qint64 MAX_REQUEST_SIZE = 8192;
+
+// Dynamic property set on an HTTP client's socket once its request has been handled.
+static constexpr char const* REQUEST_HANDLED_PROPERTY = "requestHandled";
+
+// Boundary between the parts, i.e. frames, of a multipart MJPEG stream.
+static constexpr char const* MJPEG_BOUNDARY = "ipfreelyframe";
+
+// Upper limit on the data queued for an RTSP client before it skips to the next key frame.
+static constexpr qint64 MAX_CLIENT_QUEUE_BYTES = 4 * 1024 * 1024;
+
+// The session timeout, in seconds, given to RTSP clients.
+static constexpr int CLIENT_SESSION_TIMEOUT_SECS = 60;
+
+// RTP/JPEG gives the frame's size in 8 pixel blocks in a single byte.
+static constexpr int RTP_JPEG_BLOCK_SIZE    = 8;
+static constexpr int MAX_RTP_JPEG_DIMENSION = 255 * RTP_JPEG_BLOCK_SIZE;
+
+// Packets are kept within a typical network MTU, as a camera's would be.
+static constexpr int MAX_RTP_PACKET_SIZE = 1400;
+
+static constexpr int     INTERLEAVED_HEADER_SIZE     = 4;
+static constexpr int     RTP_HEADER_SIZE             = 12;
+static constexpr int     RTP_JPEG_HEADER_SIZE        = 8;
+static constexpr int     RTP_JPEG_QTABLE_HEADER_SIZE = 4;
+static constexpr int     JPEG_QTABLE_SIZE            = 64;
+static constexpr uint8_t RTP_VERSION                 = 0x80;
+static constexpr uint8_t RTP_MARKER                  = 0x80;
+static constexpr uint8_t RTP_JPEG_PAYLOAD_TYPE       = 26;
+static constexpr double  RTP_CLOCK_RATE              = 90000.0;
+
+// Q values of 128 and over mean the quantization tables are sent in the first packet.
+static constexpr uint8_t RTP_JPEG_INBAND_Q = 255;
+
+// How much lower the quality of the frames between key frames is.
+static constexpr int NON_KEY_FRAME_QUALITY_DROP = 25;
+static constexpr int MIN_JPEG_QUALITY           = 10;
+
+// Loop length for a generated pattern without motion events, and the cap on any loop.
+static constexpr double DEFAULT_LOOP_SECS = 10.0;
+static constexpr int    MAX_LOOP_FRAMES   = 3000;
+
+// The frame timer runs faster than the frame rate so frame times do not drift.
+static constexpr int TICKS_PER_FRAME = 4;
+
+// How far behind an overloaded host may fall before frames are skipped rather than sent late.
+static constexpr int64_t MAX_FRAMES_BEHIND = 5;
+
+static constexpr double PATTERN_NOISE_SDEV = 3.0;
+
+/*! \brief Structure holding one encoded frame of the simulated video. */
+struct EncodedFrame
+{
+    /*! \brief The JPEG file's bytes. */
+    QByteArray jpeg{};
+    /*! \brief Whether this frame starts a GOP. */
+    bool keyFrame{false};
+    /*! \brief The RTP/JPEG type, 0 for 4:2:2 and 1 for 4:2:0 chroma sub-sampling. */
+    uint8_t rtpType{1};
+    /*! \brief The luma then chroma quantization tables, in zig-zag order. */
+    QByteArray quantTables{};
+    /*! \brief Offset of the entropy coded scan data within the JPEG file. */
+    int scanOffset{0};
+    /*! \brief Size of the entropy coded scan data. */
+    int scanSize{0};
+};
+
+/*! \brief Typedef to the simulated video's frames, shared by all cameras. */
+typedef std::vector<EncodedFrame> encoded_loop_t;
+
+int ReadUint16(QByteArray const& data, int const pos)
+{
+    return (static_cast<int>(static_cast<uint8_t>(data[pos])) << 8) |
+           static_cast<int>(static_cast<uint8_t>(data[pos + 1]));
+}
+
+void AppendUint16(QByteArray& data, uint32_t const value)
+{
+    data.append(static_cast<char>((value >> 8) & 0xFF));
+    data.append(static_cast<char>(value & 0xFF));
+}
+
+void AppendUint24(QByteArray& data, uint32_t const value)
+{
+    data.append(static_cast<char>((value >> 16) & 0xFF));
+    AppendUint16(data, value);
+}
+
+void AppendUint32(QByteArray& data, uint32_t const value)
+{
+    AppendUint16(data, value >> 16);
+    AppendUint16(data, value);
+}
+
+// Finds what RTP/JPEG needs in a baseline JPEG file: its quantization tables, its chroma
+// sub-sampling and where its scan data is. The Huffman tables are not sent, RTP/JPEG
+// assumes the standard tables, which OpenCV uses unless told to optimise them.
+bool ParseJpeg(QByteArray const& jpeg, EncodedFrame& frame)
+{
+    QByteArray tables[2];
+    int        pos = 2;
+
+    while (pos + 4 <= jpeg.size())
+    {
+        if (static_cast<uint8_t>(jpeg[pos]) != 0xFF)
+        {
+            return false;
+        }
+
+        auto const marker        = static_cast<uint8_t>(jpeg[pos + 1]);
+        auto const segmentSize   = ReadUint16(jpeg, pos + 2);
+        auto const segmentStart  = pos + 4;
+        auto const segmentEnd    = pos + 2 + segmentSize;
+
+        if (segmentEnd > jpeg.size())
+        {
+            return false;
+        }
+
+        switch (marker)
+        {
+        // Define quantization tables, only 8-bit tables 0 and 1 are supported.
+        case 0xDB:
+            for (int i = segmentStart; i + 1 + JPEG_QTABLE_SIZE <= segmentEnd;
+                 i += 1 + JPEG_QTABLE_SIZE)
+            {
+                auto const precisionAndId = static_cast<uint8_t>(jpeg[i]);
+
+                if (precisionAndId > 1)
+                {
+                    return false;
+                }
+
+                tables[precisionAndId] = jpeg.mid(i + 1, JPEG_QTABLE_SIZE);
+            }
+            break;
+        // Baseline start of frame, the luma component's sampling gives the sub-sampling.
+        case 0xC0:
+            switch (static_cast<uint8_t>(jpeg[segmentStart + 7]))
+            {
+            case 0x21:
+                frame.rtpType = 0;
+                break;
+            case 0x22:
+                frame.rtpType = 1;
+                break;
+            default:
+                return false;
+            }
+            break;
+        // Restart markers need a different RTP/JPEG type, OpenCV does not use them.
+        case 0xDD:
+            if (ReadUint16(jpeg, segmentStart) != 0)
+            {
+                return false;
+            }
+            break;
+        // Start of scan, the scan data runs to the end of image marker.
+        case 0xDA:
+            frame.scanOffset = segmentEnd;
+            frame.scanSize   = jpeg.size() - segmentEnd;
+
+            if (jpeg.endsWith("\xFF\xD9"))
+            {
+                frame.scanSize -= 2;
+            }
+
+            frame.quantTables = tables[0] + tables[1];
+            return (frame.quantTables.size() == 2 * JPEG_QTABLE_SIZE) && (frame.scanSize > 0);
+        default:
+            break;
+        }
+
+        pos = segmentEnd;
+    }
+
+    return false;
+}
+
+cv::Mat PatternFrame(cv::Size const& size, int const frameIndex, double const fps,
+                     cv::RNG& rng)
+{
+    // A colour gradient with a running clock, plus a little sensor-like noise so the frames
+    // compress, and trip the motion detector's thresholds, like a real camera's.
+    cv::Mat frame(size, CV_8UC3);
+
+    for (int j = 0; j < size.height; ++j)
+    {
+        auto const shade = static_cast<uchar>((j * 255) / size.height);
+        frame.row(j).setTo(cv::Scalar(255 - shade, 96, shade));
+    }
+
+    cv::Mat noise(size, CV_8UC3);
+    rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(PATTERN_NOISE_SDEV));
+    cv::add(frame, noise, frame);
+
+    std::ostringstream clock;
+    clock << "IpFreely simulator " << std::fixed << std::setprecision(2)
+          << static_cast<double>(frameIndex) / fps;
+
+    auto const fontScale = static_cast<double>(size.height) / 360.0;
+    cv::putText(frame,
+                clock.str(),
+                cv::Point(size.width / 20, size.height / 8),
+                cv::FONT_HERSHEY_SIMPLEX,
+                fontScale,
+                cv::Scalar(255, 255, 255),
+                std::max(cvRound(fontScale * 2.0), 1));
+
+    return frame;
+}
+
+void AddMotionEvent(cv::Mat& frame, int const frameIndex, SimulatorSettings const& settings)
+{
+    if (settings.motionPeriodSecs <= 0.0)
+    {
+        return;
+    }
+
+    auto const secs      = static_cast<double>(frameIndex) / settings.fps;
+    auto const eventSecs = std::fmod(secs, settings.motionPeriodSecs);
+
+    if (eventSecs >= settings.motionDurationSecs)
+    {
+        return;
+    }
+
+    // A block walks across the middle of the frame for the event's duration.
+    auto const block    = cv::Size(frame.cols / 6, frame.rows / 4);
+    auto const progress = eventSecs / settings.motionDurationSecs;
+    auto const x        = cvRound(progress * static_cast<double>(frame.cols - block.width));
+
+    cv::rectangle(frame,
+                  cv::Rect(cv::Point(x, (frame.rows - block.height) / 2), block),
+                  cv::Scalar(32, 200, 240),
+                  cv::FILLED);
+}
+
+std::shared_ptr<encoded_loop_t const> EncodeLoop(SimulatorSettings const& settings)
+{
+    auto const       size = cv::Size(settings.width, settings.height);
+    cv::VideoCapture capture;
+    auto             numFrames = MAX_LOOP_FRAMES;
+
+    if (!settings.videoFilePath.empty())
+    {
+        if (!capture.open(settings.videoFilePath))
+        {
+            std::ostringstream oss;
+            oss << "Failed to open video file: " << settings.videoFilePath;
+            BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
+        }
+    }
+    else
+    {
+        // A generated loop lasts one motion period so the motion events repeat seamlessly.
+        auto const loopSecs =
+            settings.motionPeriodSecs > 0.0 ? settings.motionPeriodSecs : DEFAULT_LOOP_SECS;
+        numFrames = std::min(std::max(cvRound(loopSecs * settings.fps), 1), MAX_LOOP_FRAMES);
+    }
+
+    auto    loop = std::make_shared<encoded_loop_t>();
+    cv::RNG rng(0x5eed);
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        cv::Mat frame;
+
+        if (capture.isOpened())
+        {
+            if (!capture.read(frame))
+            {
+                break;
+            }
+
+            if (frame.size() != size)
+            {
+                cv::resize(frame, frame, size, 0.0, 0.0, cv::INTER_AREA);
+            }
+        }
+        else
+        {
+            frame = PatternFrame(size, i, settings.fps, rng);
+        }
+
+        AddMotionEvent(frame, i, settings);
+
+        EncodedFrame encodedFrame;
+        encodedFrame.keyFrame = (i % settings.gopLength) == 0;
+
+        auto const quality =
+            encodedFrame.keyFrame
+                ? settings.jpegQuality
+                : std::max(settings.jpegQuality - NON_KEY_FRAME_QUALITY_DROP, MIN_JPEG_QUALITY);
+
+        std::vector<uchar> buffer;
+
+        if (!cv::imencode(".jpg", frame, buffer, {cv::IMWRITE_JPEG_QUALITY, quality}))
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to encode simulated frame."));
+        }
+
+        encodedFrame.jpeg = QByteArray(reinterpret_cast<char const*>(buffer.data()),
+                                       static_cast<int>(buffer.size()));
+
+        if (!ParseJpeg(encodedFrame.jpeg, encodedFrame))
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error("Unsupported JPEG format for RTP/JPEG."));
+        }
+
+        loop->emplace_back(std::move(encodedFrame));
+    }
+
+    if (loop->empty())
+    {
+        std::ostringstream oss;
+        oss << "No frames could be read from video file: " << settings.videoFilePath;
+        BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
+    }
+
+    return loop;
+}
+
+void VerifySettings(SimulatorSettings const& settings)
+{
+    std::ostringstream oss;
+
+    if (settings.numCameras < 1)
+    {
+        oss << "At least one camera must be simulated.";
+    }
+    else if ((settings.rtspPort == 0) && (settings.httpPort == 0))
+    {
+        oss << "At least one of RTSP and HTTP must be enabled.";
+    }
+    else if ((settings.width <= 0) || (settings.height <= 0) || (settings.fps <= 0.0) ||
+             (settings.gopLength < 1))
+    {
+        oss << "Frame size, frame rate and GOP length must be positive.";
+    }
+    else if ((settings.jpegQuality < 1) || (settings.jpegQuality > 100))
+    {
+        oss << "JPEG quality must be from 1 to 100.";
+    }
+    else if ((settings.packetLossPercent < 0.0) || (settings.packetLossPercent > 100.0))
+    {
+        oss << "Packet loss must be from 0 to 100%.";
+    }
+    else if ((settings.motionPeriodSecs > 0.0) &&
+             ((settings.motionDurationSecs <= 0.0) ||
+              (settings.motionDurationSecs > settings.motionPeriodSecs)))
+    {
+        oss << "Motion events must last no longer than the motion period.";
+    }
+    else if ((settings.stallPeriodSecs > 0.0) && (settings.stallDurationSecs <= 0.0))
+    {
+        oss << "Stalls must have a positive duration.";
+    }
+    else if ((settings.rtspPort != 0) &&
+             ((settings.width > MAX_RTP_JPEG_DIMENSION) ||
+              (settings.height > MAX_RTP_JPEG_DIMENSION) ||
+              (settings.width % RTP_JPEG_BLOCK_SIZE != 0) ||
+              (settings.height % RTP_JPEG_BLOCK_SIZE != 0)))
+    {
+        oss << "RTP/JPEG frame sizes must be multiples of " << RTP_JPEG_BLOCK_SIZE
+            << " and at most " << MAX_RTP_JPEG_DIMENSION
+            << " pixels, disable RTSP to serve larger frames over HTTP.";
+    }
+    else
+    {
+        return;
+    }
+
+    BOOST_THROW_EXCEPTION(std::invalid_argument(oss.str()));
+}
+
+/*! \brief Class defining the simulator's worker, which lives on the simulator's thread. */
+class SimulatorWorker final : public QObject
+{
+public:
+    SimulatorWorker(SimulatorSettings const&                     settings,
+                    std::shared_ptr<encoded_loop_t const> const& loop);
+    ~SimulatorWorker() = default;
+
+    void Start();
+
+private:
+    /*! \brief Structure holding a simulated camera's state. */
+    struct SimulatedCamera
+    {
+        /*! \brief The camera's ID, as used in its URLs. */
+        int camId{0};
+        /*! \brief The index of the camera's next frame within the loop. */
+        size_t frameIndex{0};
+        /*! \brief The camera's next RTP sequence number. */
+        uint16_t rtpSequence{0};
+        /*! \brief The camera's random RTP timestamp offset. */
+        uint32_t rtpTimestampBase{0};
+        /*! \brief The camera's RTP synchronisation source. */
+        uint32_t ssrc{0};
+        /*! \brief The camera's fault generator, seeded by its ID. */
+        std::mt19937 rng{};
+        /*! \brief When the camera's current stall ends, in milliseconds since starting. */
+        qint64 stallEndMs{0};
+        /*! \brief When the camera's next stall starts. */
+        qint64 nextStallMs{0};
+        /*! \brief When the camera next drops its clients. */
+        qint64 nextDisconnectMs{0};
+    };
+
+    /*! \brief Structure holding an RTSP client's session state. */
+    struct RtspClient
+    {
+        /*! \brief The camera the client is viewing. */
+        int camId{0};
+        /*! \brief The client's session ID. */
+        QByteArray sessionId{};
+        /*! \brief The client's interleaved RTP channel. */
+        int channel{-1};
+        /*! \brief Whether the client is playing. */
+        bool playing{false};
+        /*! \brief Whether the client is waiting for a key frame to start, or restart, from. */
+        bool waitingForKeyFrame{true};
+        /*! \brief Received data not yet parsed. */
+        QByteArray buffer{};
+    };
+
+    /*! \brief Structure holding an HTTP MJPEG client's state. */
+    struct HttpClient
+    {
+        /*! \brief The camera the client is viewing. */
+        int camId{0};
+        /*! \brief Whether the client is waiting for a key frame to start from. */
+        bool waitingForKeyFrame{true};
+    };
+
+private:
+    void        AcceptRtspConnections();
+    void        ReadRtspRequests(QTcpSocket* socket);
+    void        HandleRtspRequest(QTcpSocket* socket, RtspMessage const& request);
+    void        AcceptHttpConnections();
+    void        ReadHttpRequest(QTcpSocket* socket);
+    void        SendFrames();
+    void        SendCameraFrame(SimulatedCamera& camera, int64_t const frameNumber,
+                                qint64 const nowMs);
+    bool        InjectFaults(SimulatedCamera& camera, qint64 const nowMs);
+    bool        DropPacket(SimulatedCamera& camera);
+    void        DisconnectClients(int const camId);
+    QByteArray  Sdp(int const camId) const;
+    std::vector<QByteArray> Packetise(SimulatedCamera& camera, EncodedFrame const& frame,
+                                      uint32_t const timestamp) const;
+    bool        ParseCameraId(QByteArray const& path, int& camId) const;
+    static qint64 RandomPeriodMs(SimulatedCamera& camera, double const periodSecs);
+    static void SendRtspResponse(QTcpSocket* socket, RtspMessage const& request,
+                                 QByteArray const& status, QByteArray const& headers = {},
+                                 QByteArray const& body = {});
+    static void SendHttpResponse(QTcpSocket* socket, QByteArray const& status,
+                                 QByteArray const& contentType, QByteArray const& body);
+
+private:
+    SimulatorSettings                     m_settings;
+    std::shared_ptr<encoded_loop_t const> m_loop;
+    QTcpServer*                           m_rtspServer;
+    QTcpServer*                           m_httpServer;
+    QTimer*                               m_frameTimer;
+    QElapsedTimer                         m_clock;
+    int64_t                               m_framesSent;
+    std::vector<SimulatedCamera>          m_cameras;
+    std::map<QTcpSocket*, RtspClient>     m_rtspClients;
+    std::map<QTcpSocket*, HttpClient>     m_httpClients;
+};
+
+SimulatorWorker::SimulatorWorker(SimulatorSettings const&                     settings,
+                                 std::shared_ptr<encoded_loop_t const> const& loop)
+    : m_settings(settings)
+    , m_loop(loop)
+    , m_rtspServer(nullptr)
+    , m_httpServer(nullptr)
+    , m_frameTimer(nullptr)
+    , m_framesSent(0)
+{
+}
+
+void SimulatorWorker::Start()
+{
+    // Created here rather than in the constructor so they belong to the simulator's thread.
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+    m_frameTimer->setInterval(
+        std::max(cvRound(1000.0 / (m_settings.fps * TICKS_PER_FRAME)), 1));
+    connect(m_frameTimer, &QTimer::timeout, this, &SimulatorWorker::SendFrames);
+
+    if (m_settings.rtspPort != 0)
+    {
+        m_rtspServer = new QTcpServer(this);
+        connect(m_rtspServer,
+                &QTcpServer::newConnection,
+                this,
+                &SimulatorWorker::AcceptRtspConnections);
+
+        if (!m_rtspServer->listen(QHostAddress::Any, m_settings.rtspPort))
+        {
+            DEBUG_MESSAGE_EX_ERROR("Simulator failed to listen for RTSP on port: "
+                                   << m_settings.rtspPort << ", error: "
+                                   << m_rtspServer->errorString().toStdString());
+        }
+    }
+
+    if (m_settings.httpPort != 0)
+    {
+        m_httpServer = new QTcpServer(this);
+        connect(m_httpServer,
+                &QTcpServer::newConnection,
+                this,
+                &SimulatorWorker::AcceptHttpConnections);
+
+        if (!m_httpServer->listen(QHostAddress::Any, m_settings.httpPort))
+        {
+            DEBUG_MESSAGE_EX_ERROR("Simulator failed to listen for HTTP on port: "
+                                   << m_settings.httpPort << ", error: "
+                                   << m_httpServer->errorString().toStdString());
+        }
+    }
+
+    // Cameras play the loop from evenly spread points so their motion events and key frames
+    // do not all line up.
+    auto const loopSize = m_loop->size();
+
+    for (int i = 0; i < m_settings.numCameras; ++i)
+    {
+        SimulatedCamera camera;
+        camera.camId            = i + 1;
+        camera.frameIndex       = (static_cast<size_t>(i) * loopSize) /
+                            static_cast<size_t>(m_settings.numCameras);
+        camera.rng.seed(static_cast<std::mt19937::result_type>(camera.camId));
+        camera.rtpSequence      = static_cast<uint16_t>(camera.rng());
+        camera.rtpTimestampBase = static_cast<uint32_t>(camera.rng());
+        camera.ssrc             = static_cast<uint32_t>(camera.rng());
+
+        if (m_settings.stallPeriodSecs > 0.0)
+        {
+            camera.nextStallMs = RandomPeriodMs(camera, m_settings.stallPeriodSecs);
+        }
+
+        if (m_settings.disconnectPeriodSecs > 0.0)
+        {
+            camera.nextDisconnectMs = RandomPeriodMs(camera, m_settings.disconnectPeriodSecs);
+        }
+
+        m_cameras.emplace_back(std::move(camera));
+    }
+
+    m_clock.start();
+    m_frameTimer->start();
+
+    DEBUG_MESSAGE_EX_INFO("Simulating " << m_settings.numCameras << " cameras, RTSP port: "
+                                        << m_settings.rtspPort
+                                        << ", HTTP port: " << m_settings.httpPort);
+}
+
+void SimulatorWorker::AcceptRtspConnections()
+{
+    while (m_rtspServer->hasPendingConnections())
+    {
+        auto socket = m_rtspServer->nextPendingConnection();
+        m_rtspClients.emplace(socket, RtspClient());
+
+        connect(
+            socket, &QTcpSocket::readyRead, this, [this, socket]() { ReadRtspRequests(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_rtspClients.erase(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void SimulatorWorker::ReadRtspRequests(QTcpSocket* socket)
+{
+    auto clientIter = m_rtspClients.find(socket);
+
+    if (clientIter == m_rtspClients.end())
+    {
+        return;
+    }
+
+    auto& buffer = clientIter->second.buffer;
+    buffer += socket->readAll();
+
+    while (!buffer.isEmpty())
+    {
+        // Clients' RTCP receiver reports are interleaved with their requests, we discard them.
+        if (buffer[0] == '$')
+        {
+            QByteArray frame;
+
+            if (!TakeInterleavedFrame(buffer, frame))
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        RtspMessage request;
+
+        if (!TakeRtspMessage(buffer, request))
+        {
+            if (buffer.size() > MAX_MESSAGE_SIZE)
+            {
+                socket->abort();
+            }
+
+            break;
+        }
+
+        HandleRtspRequest(socket, request);
+
+        // Handling a request may have closed the connection.
+        if (m_rtspClients.count(socket) == 0)
+        {
+            break;
+        }
+    }
+}
+
+void SimulatorWorker::HandleRtspRequest(QTcpSocket* socket, RtspMessage const& request)
+{
+    auto const fields = request.startLine.split(' ');
+
+    if (fields.size() != 3)
+    {
+        SendRtspResponse(socket, request, "400 Bad Request");
+        return;
+    }
+
+    auto const& method = fields[0];
+    auto&       client = m_rtspClients[socket];
+
+    if (method == "OPTIONS")
+    {
+        SendRtspResponse(socket,
+                         request,
+                         "200 OK",
+                         "Public: OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN, GET_PARAMETER\r\n");
+    }
+    else if ((method == "GET_PARAMETER") || (method == "SET_PARAMETER"))
+    {
+        // Used by clients to keep their sessions alive.
+        SendRtspResponse(socket, request, "200 OK");
+    }
+    else if (method == "TEARDOWN")
+    {
+        SendRtspResponse(socket, request, "200 OK");
+        socket->disconnectFromHost();
+    }
+    else if (!ParseCameraId(QUrl::fromEncoded(fields[1]).path().toUtf8(), client.camId))
+    {
+        SendRtspResponse(socket, request, "404 Not Found");
+    }
+    else if (method == "DESCRIBE")
+    {
+        auto url = fields[1];
+
+        if (!url.endsWith('/'))
+        {
+            url += '/';
+        }
+
+        SendRtspResponse(socket,
+                         request,
+                         "200 OK",
+                         "Content-Base: " + url + "\r\nContent-Type: application/sdp\r\n",
+                         Sdp(client.camId));
+    }
+    else if (method == "SETUP")
+    {
+        auto const transport = HeaderValue(request, "transport");
+
+        if (!transport.contains("RTP/AVP/TCP"))
+        {
+            SendRtspResponse(socket, request, "461 Unsupported Transport");
+            return;
+        }
+
+        client.channel = 0;
+        InterleavedChannel(transport, client.channel);
+
+        if (client.sessionId.isEmpty())
+        {
+            client.sessionId = QByteArray::number(m_cameras[client.camId - 1].rng(), 16) +
+                               QByteArray::number(m_clock.elapsed(), 16);
+        }
+
+        SendRtspResponse(socket,
+                         request,
+                         "200 OK",
+                         "Transport: RTP/AVP/TCP;unicast;interleaved=" +
+                             QByteArray::number(client.channel) + "-" +
+                             QByteArray::number(client.channel + 1) + "\r\nSession: " +
+                             client.sessionId + ";timeout=" +
+                             QByteArray::number(CLIENT_SESSION_TIMEOUT_SECS) + "\r\n");
+    }
+    else if (method == "PLAY")
+    {
+        if (client.channel < 0)
+        {
+            SendRtspResponse(socket, request, "455 Method Not Valid in This State");
+            return;
+        }
+
+        SendRtspResponse(socket,
+                         request,
+                         "200 OK",
+                         "Session: " + client.sessionId + "\r\nRange: npt=0.000-\r\n");
+
+        // As with a real camera, the client's video starts at the next key frame.
+        client.playing            = true;
+        client.waitingForKeyFrame = true;
+    }
+    else
+    {
+        SendRtspResponse(socket, request, "501 Not Implemented");
+    }
+}
+
+void SimulatorWorker::AcceptHttpConnections()
+{
+    while (m_httpServer->hasPendingConnections())
+    {
+        auto socket = m_httpServer->nextPendingConnection();
+
+        // Stops Qt reading more from a client than a request can hold.
+        socket->setReadBufferSize(MAX_REQUEST_SIZE);
+
+        connect(
+            socket, &QTcpSocket::readyRead, this, [this, socket]() { ReadHttpRequest(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_httpClients.erase(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void SimulatorWorker::ReadHttpRequest(QTcpSocket* socket)
+{
+    if (socket->property(REQUEST_HANDLED_PROPERTY).toBool())
+    {
+        return;
+    }
+
+    auto const pending   = socket->peek(MAX_REQUEST_SIZE);
+    auto const headerEnd = pending.indexOf("\r\n\r\n");
+
+    if (headerEnd < 0)
+    {
+        if (pending.size() >= MAX_REQUEST_SIZE)
+        {
+            socket->abort();
+        }
+
+        return;
+    }
+
+    auto const request = socket->read(headerEnd + 4);
+    socket->setProperty(REQUEST_HANDLED_PROPERTY, true);
+
+    // The request line is "<method> <path> <version>", the headers are not needed.
+    auto const fields = request.left(request.indexOf("\r\n")).split(' ');
+    int        camId  = 0;
+
+    if ((fields.size() != 3) || (fields[0] != "GET"))
+    {
+        SendHttpResponse(socket, "400 Bad Request", "text/plain", "Bad request.\r\n");
+        return;
+    }
+
+    auto const path = fields[1].left(fields[1].indexOf('?'));
+
+    if (path.endsWith("/snapshot.jpg") &&
+        ParseCameraId(path.left(path.lastIndexOf('/')), camId))
+    {
+        auto const& camera = m_cameras[static_cast<size_t>(camId - 1)];
+        SendHttpResponse(socket, "200 OK", "image/jpeg", (*m_loop)[camera.frameIndex].jpeg);
+        return;
+    }
+
+    if (!path.endsWith("/live.mjpeg") || !ParseCameraId(path.left(path.lastIndexOf('/')), camId))
+    {
+        SendHttpResponse(socket, "404 Not Found", "text/plain", "Not found.\r\n");
+        return;
+    }
+
+    QByteArray header = "HTTP/1.1 200 OK\r\n"
+                        "Content-Type: multipart/x-mixed-replace; boundary=";
+    header += MJPEG_BOUNDARY;
+    header += "\r\n"
+              "Cache-Control: no-cache, no-store\r\n"
+              "Pragma: no-cache\r\n"
+              "Connection: close\r\n"
+              "\r\n";
+    socket->write(header);
+
+    m_httpClients[socket].camId = camId;
+}
+
+void SimulatorWorker::SendFrames()
+{
+    // Frames are due by the clock rather than by counting timer ticks, so the frame rate
+    // holds however late individual ticks are.
+    auto const nowMs     = m_clock.elapsed();
+    auto const dueFrames =
+        static_cast<int64_t>(static_cast<double>(nowMs) * m_settings.fps / 1000.0);
+
+    if (dueFrames - m_framesSent > MAX_FRAMES_BEHIND)
+    {
+        DEBUG_MESSAGE_EX_WARNING("Simulator fell behind, skipping "
+                                 << (dueFrames - m_framesSent - 1) << " frames per camera.");
+        m_framesSent = dueFrames - 1;
+    }
+
+    while (m_framesSent < dueFrames)
+    {
+        ++m_framesSent;
+
+        for (auto& camera : m_cameras)
+        {
+            SendCameraFrame(camera, m_framesSent, nowMs);
+        }
+    }
+}
+
+void SimulatorWorker::SendCameraFrame(SimulatedCamera& camera, int64_t const frameNumber,
+                                      qint64 const nowMs)
+{
+    auto const& frame = (*m_loop)[camera.frameIndex];
+    camera.frameIndex = (camera.frameIndex + 1) % m_loop->size();
+
+    // A stalled camera's video carries on, as if live, once the stall ends.
+    if (InjectFaults(camera, nowMs))
+    {
+        return;
+    }
+
+    std::vector<QByteArray> packets;
+
+    for (auto& clientEntry : m_rtspClients)
+    {
+        auto  socket = clientEntry.first;
+        auto& client = clientEntry.second;
+
+        if (!client.playing || (client.camId != camera.camId))
+        {
+            continue;
+        }
+
+        // A client that cannot keep up skips to the next key frame, as it would have to
+        // after losing part of a real camera's stream.
+        if (socket->bytesToWrite() > MAX_CLIENT_QUEUE_BYTES)
+        {
+            client.waitingForKeyFrame = true;
+        }
+
+        if (client.waitingForKeyFrame && !frame.keyFrame)
+        {
+            continue;
+        }
+
+        client.waitingForKeyFrame = false;
+
+        // Packets are built once per frame and shared by all of the camera's clients.
+        if (packets.empty())
+        {
+            auto const timestamp =
+                camera.rtpTimestampBase +
+                static_cast<uint32_t>(static_cast<uint64_t>(std::llround(
+                    static_cast<double>(frameNumber) * RTP_CLOCK_RATE / m_settings.fps)));
+            packets = Packetise(camera, frame, timestamp);
+        }
+
+        for (auto const& packet : packets)
+        {
+            if (DropPacket(camera))
+            {
+                continue;
+            }
+
+            if (client.channel == 0)
+            {
+                socket->write(packet);
+            }
+            else
+            {
+                auto clientPacket = packet;
+                clientPacket[1]   = static_cast<char>(client.channel);
+                socket->write(clientPacket);
+            }
+        }
+    }
+
+    QByteArray partHeader;
+
+    for (auto& clientEntry : m_httpClients)
+    {
+        auto  socket = clientEntry.first;
+        auto& client = clientEntry.second;
+
+        if ((client.camId != camera.camId) || (client.waitingForKeyFrame && !frame.keyFrame))
+        {
+            continue;
+        }
+
+        client.waitingForKeyFrame = false;
+
+        // As with the web server, a frame is dropped while the client still has the previous
+        // frame queued. Packet loss drops whole frames, a partial JPEG would break the stream.
+        if ((socket->bytesToWrite() > 0) || DropPacket(camera))
+        {
+            continue;
+        }
+
+        if (partHeader.isEmpty())
+        {
+            partHeader = "--";
+            partHeader += MJPEG_BOUNDARY;
+            partHeader += "\r\nContent-Type: image/jpeg\r\nContent-Length: ";
+            partHeader += QByteArray::number(frame.jpeg.size());
+            partHeader += "\r\n\r\n";
+        }
+
+        // The frame's bytes are shared with the loop rather than copied.
+        socket->write(partHeader);
+        socket->write(frame.jpeg);
+        socket->write("\r\n");
+    }
+}
+
+bool SimulatorWorker::InjectFaults(SimulatedCamera& camera, qint64 const nowMs)
+{
+    if ((m_settings.disconnectPeriodSecs > 0.0) && (nowMs >= camera.nextDisconnectMs))
+    {
+        DEBUG_MESSAGE_EX_INFO("Simulated camera " << camera.camId << " dropping its clients.");
+        DisconnectClients(camera.camId);
+        camera.nextDisconnectMs = nowMs + RandomPeriodMs(camera, m_settings.disconnectPeriodSecs);
+    }
+
+    if ((m_settings.stallPeriodSecs > 0.0) && (nowMs >= camera.nextStallMs))
+    {
+        DEBUG_MESSAGE_EX_INFO("Simulated camera " << camera.camId << " stalling for "
+                                                  << m_settings.stallDurationSecs << " seconds.");
+        camera.stallEndMs  = nowMs + cvRound(m_settings.stallDurationSecs * 1000.0);
+        camera.nextStallMs = camera.stallEndMs + RandomPeriodMs(camera, m_settings.stallPeriodSecs);
+    }
+
+    return nowMs < camera.stallEndMs;
+}
+
+bool SimulatorWorker::DropPacket(SimulatedCamera& camera)
+{
+    if (m_settings.packetLossPercent <= 0.0)
+    {
+        return false;
+    }
+
+    std::uniform_real_distribution<double> percent(0.0, 100.0);
+    return percent(camera.rng) < m_settings.packetLossPercent;
+}
+
+void SimulatorWorker::DisconnectClients(int const camId)
+{
+    // Aborting a socket removes it from the client maps, so collect them first.
+    std::vector<QTcpSocket*> sockets;
+
+    for (auto const& clientEntry : m_rtspClients)
+    {
+        if (clientEntry.second.camId == camId)
+        {
+            sockets.emplace_back(clientEntry.first);
+        }
+    }
+
+    for (auto const& clientEntry : m_httpClients)
+    {
+        if (clientEntry.second.camId == camId)
+        {
+            sockets.emplace_back(clientEntry.first);
+        }
+    }
+
+    for (auto socket : sockets)
+    {
+        socket->abort();
+    }
+}
+
+QByteArray SimulatorWorker::Sdp(int const camId) const
+{
+    QByteArray sdp = "v=0\r\n"
+                     "o=- 0 0 IN IP4 0.0.0.0\r\n"
+                     "s=IpFreely simulated camera ";
+    sdp += QByteArray::number(camId);
+    sdp += "\r\n"
+           "c=IN IP4 0.0.0.0\r\n"
+           "t=0 0\r\n"
+           "a=control:*\r\n"
+           "m=video 0 RTP/AVP 26\r\n"
+           "a=rtpmap:26 JPEG/90000\r\n"
+           "a=framerate:";
+    sdp += QByteArray::number(m_settings.fps);
+    sdp += "\r\n"
+           "a=control:track0\r\n";
+    return sdp;
+}
+
+std::vector<QByteArray> SimulatorWorker::Packetise(SimulatedCamera&    camera,
+                                                   EncodedFrame const& frame,
+                                                   uint32_t const      timestamp) const
+{
+    // RFC 2435 RTP/JPEG, each packet framed for RTP interleaved over RTSP on channel 0.
+    std::vector<QByteArray> packets;
+    int                     offset = 0;
+
+    while (offset < frame.scanSize)
+    {
+        auto const first = offset == 0;
+        auto const headerSize =
+            RTP_HEADER_SIZE + RTP_JPEG_HEADER_SIZE +
+            (first ? RTP_JPEG_QTABLE_HEADER_SIZE + frame.quantTables.size() : 0);
+        auto const payloadSize =
+            std::min(frame.scanSize - offset, MAX_RTP_PACKET_SIZE - headerSize);
+        auto const last        = offset + payloadSize == frame.scanSize;
+
+        QByteArray packet;
+        packet.reserve(INTERLEAVED_HEADER_SIZE + headerSize + payloadSize);
+
+        packet.append('$');
+        packet.append('\0');
+        AppendUint16(packet, static_cast<uint32_t>(headerSize + payloadSize));
+
+        packet.append(static_cast<char>(RTP_VERSION));
+        packet.append(static_cast<char>((last ? RTP_MARKER : 0) | RTP_JPEG_PAYLOAD_TYPE));
+        AppendUint16(packet, camera.rtpSequence++);
+        AppendUint32(packet, timestamp);
+        AppendUint32(packet, camera.ssrc);
+
+        packet.append('\0');
+        AppendUint24(packet, static_cast<uint32_t>(offset));
+        packet.append(static_cast<char>(frame.rtpType));
+        packet.append(static_cast<char>(RTP_JPEG_INBAND_Q));
+        packet.append(static_cast<char>(m_settings.width / RTP_JPEG_BLOCK_SIZE));
+        packet.append(static_cast<char>(m_settings.height / RTP_JPEG_BLOCK_SIZE));
+
+        if (first)
+        {
+            packet.append('\0');
+            packet.append('\0');
+            AppendUint16(packet, static_cast<uint32_t>(frame.quantTables.size()));
+            packet.append(frame.quantTables);
+        }
+
+        packet.append(frame.jpeg.constData() + frame.scanOffset + offset, payloadSize);
+        packets.emplace_back(packet);
+        offset += payloadSize;
+    }
+
+    return packets;
+}
+
+bool SimulatorWorker::ParseCameraId(QByteArray const& path, int& camId) const
+{
+    // Paths have the form "/cam<ID>", optionally followed by "/track0" for RTSP.
+    static QByteArray const CAMERA_PREFIX = "/cam";
+    static QByteArray const TRACK_SUFFIX  = "/track0";
+
+    auto cameraPath = path;
+
+    if (cameraPath.endsWith('/'))
+    {
+        cameraPath.chop(1);
+    }
+
+    if (cameraPath.endsWith(TRACK_SUFFIX))
+    {
+        cameraPath.chop(TRACK_SUFFIX.size());
+    }
+
+    if (!cameraPath.startsWith(CAMERA_PREFIX))
+    {
+        return false;
+    }
+
+    bool       ok = false;
+    auto const id = cameraPath.mid(CAMERA_PREFIX.size()).toInt(&ok);
+
+    if (!ok || (id < 1) || (id > m_settings.numCameras))
+    {
+        return false;
+    }
+
+    camId = id;
+    return true;
+}
+
+qint64 SimulatorWorker::RandomPeriodMs(SimulatedCamera& camera, double const periodSecs)
+{
+    // Spread evenly from half to one and a half times the average period.
+    std::uniform_real_distribution<double> period(periodSecs * 500.0, periodSecs * 1500.0);
+    return static_cast<qint64>(period(camera.rng));
+}
+
+void SimulatorWorker::SendRtspResponse(QTcpSocket* socket, RtspMessage const& request,
+                                       QByteArray const& status, QByteArray const& headers,
+                                       QByteArray const& body)
+{
+    QByteArray response = "RTSP/1.0 " + status + "\r\n";
+    response += "CSeq: " + HeaderValue(request, "cseq") + "\r\n";
+    response += "Server: IpFreelySimulator\r\n";
+    response += headers;
+
+    if (!body.isEmpty())
+    {
+        response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    }
+
+    response += "\r\n";
+    response += body;
+
+    socket->write(response);
+}
+
+void SimulatorWorker::SendHttpResponse(QTcpSocket* socket, QByteArray const& status,
+                                       QByteArray const& contentType, QByteArray const& body)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Cache-Control: no-cache, no-store\r\n"
+                "Connection: close\r\n"
+                "\r\n";
+
+    socket->write(response);
+    socket->write(body);
+
+    // Closes the connection once the response has been written.
+    socket->disconnectFromHost();
+}
+
+} // namespace
+
+IpFreelyCameraSimulator::IpFreelyCameraSimulator(SimulatorSettings const& settings)
+    : m_thread(new QThread)
+{
+    VerifySettings(settings);
+
+    DEBUG_MESSAGE_EX_INFO("Encoding simulated video, size: " << settings.width << "x"
+                                                             << settings.height
+                                                             << ", FPS: " << settings.fps);
+
+    auto const loop = EncodeLoop(settings);
+
+    size_t loopBytes = 0;
+
+    for (auto const& frame : *loop)
+    {
+        loopBytes += static_cast<size_t>(frame.jpeg.size());
+    }
+
+    DEBUG_MESSAGE_EX_INFO("Encoded " << loop->size() << " frames, total size (bytes): "
+                                     << loopBytes << ", per camera bit rate (bits/s): "
+                                     << (8.0 * static_cast<double>(loopBytes) * settings.fps /
+                                         static_cast<double>(loop->size())));
+
+    auto worker = new SimulatorWorker(settings, loop);
+
+    // The worker, its sockets and its timers all live on the simulator's thread.
+    worker->moveToThread(m_thread.get());
+    QObject::connect(m_thread.get(), &QThread::started, worker, &SimulatorWorker::Start);
+    QObject::connect(m_thread.get(), &QThread::finished, worker, &QObject::deleteLater);
+
+    m_thread->setObjectName("IpFreelyCameraSimulator");
+    m_thread->start();
+}
+
+IpFreelyCameraSimulator::~IpFreelyCameraSimulator()
+{
+    // The worker is deleted, closing its connections, as its thread finishes.
+    m_thread->quit();
+    m_thread->wait();
+}
+
+} // namespace ipfreely
@@ -0,0 +1,117 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyCameraSimulator.h
+ * \brief File containing declaration of IpFreelyCameraSimulator class.
+ */
+#ifndef IPFREELYCAMERASIMULATOR_H
+#define IPFREELYCAMERASIMULATOR_H
+
+#include <string>
+#include <memory>
+#include <cstdint>
+
+// Forward declarations.
+class QThread;
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*! \brief Structure holding the camera simulator's settings. */
+struct SimulatorSettings
+{
+    /*! \brief The number of simulated cameras, served as cam1 to camN. */
+    int numCameras{16};
+    /*! \brief The RTSP server's TCP port, 0 to disable RTSP. */
+    uint16_t rtspPort{8554};
+    /*! \brief The HTTP server's TCP port, 0 to disable HTTP MJPEG. */
+    uint16_t httpPort{8090};
+    /*! \brief A video file to loop, empty to generate a test pattern instead. */
+    std::string videoFilePath{};
+    /*! \brief The video's width in pixels. */
+    int width{1920};
+    /*! \brief The video's height in pixels. */
+    int height{1080};
+    /*! \brief The video's frame rate. */
+    double fps{25.0};
+    /*! \brief The number of frames from one key frame to the next. */
+    int gopLength{50};
+    /*! \brief The key frames' JPEG quality, 1 to 100. */
+    int jpegQuality{80};
+    /*! \brief Seconds from the start of one motion event to the next, 0 for no motion. */
+    double motionPeriodSecs{20.0};
+    /*! \brief How long each motion event lasts in seconds. */
+    double motionDurationSecs{5.0};
+    /*! \brief Percentage of RTP packets, or HTTP frames, dropped at random. */
+    double packetLossPercent{0.0};
+    /*! \brief Average seconds between a camera's stalls, 0 for no stalls. */
+    double stallPeriodSecs{0.0};
+    /*! \brief How long each stall lasts in seconds. */
+    double stallDurationSecs{0.0};
+    /*! \brief Average seconds between a camera dropping its clients, 0 for no disconnects. */
+    double disconnectPeriodSecs{0.0};
+};
+
+/*! \brief Class defining a simulator serving many synthetic cameras for load testing. */
+class IpFreelyCameraSimulator final
+{
+public:
+    /*!
+     * \brief IpFreelyCameraSimulator constructor.
+     * \param[in] settings - The simulator's settings.
+     *
+     * The video, either a looping file or a generated test pattern, is encoded once up front
+     * and shared by every camera, each camera playing it from a different point, so serving
+     * many cameras costs little more than sending their bytes. This keeps the host's CPU free
+     * for the stream processors being tested.
+     *
+     * Each camera is served as RTP/JPEG at rtsp://<host>:<rtspPort>/camN and as MJPEG at
+     * http://<host>:<httpPort>/camN/live.mjpeg, with a single frame at /camN/snapshot.jpg.
+     * RTSP clients must use RTP interleaved over the RTSP TCP connection.
+     *
+     * JPEG frames have no inter-frame coding, so a GOP is emulated: one frame per GOP is
+     * encoded at full quality and the others at a lower quality, giving the bursty bit rate
+     * of a real camera, and new clients only start receiving frames at the next key frame.
+     *
+     * Each camera's faults are independent: packet loss drops RTP packets, or whole frames
+     * for HTTP clients, stalls stop a camera's frames while keeping its connections open and
+     * disconnects close all of a camera's connections. Stalls and disconnects happen at random
+     * around their average periods, seeded by the camera's ID so runs are repeatable.
+     */
+    explicit IpFreelyCameraSimulator(SimulatorSettings const& settings);
+
+    /*! \brief IpFreelyCameraSimulator destructor. */
+    ~IpFreelyCameraSimulator();
+
+    /*! \brief IpFreelyCameraSimulator deleted copy constructor. */
+    IpFreelyCameraSimulator(IpFreelyCameraSimulator const&) = delete;
+
+    /*! \brief IpFreelyCameraSimulator deleted copy assignment operator. */
+    IpFreelyCameraSimulator& operator=(IpFreelyCameraSimulator const&) = delete;
+
+private:
+    std::unique_ptr<QThread> m_thread;
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYCAMERASIMULATOR_H
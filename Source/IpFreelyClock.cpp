@@ -0,0 +1,101 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyClock.cpp
+ * \brief File containing definition of IpFreelyClock classes.
+ */
+#include "IpFreelyClock.h"
+#include <boost/predef.h>
+#include <cmath>
+
+namespace ipfreely
+{
+
+namespace
+{
+
+/*! \brief Class defining the clock that follows the system's time. */
+class IpFreelySystemClock final : public IpFreelyClock
+{
+public:
+    virtual time_t Now() const
+    {
+        return time(nullptr);
+    }
+
+    virtual std::tm LocalTime(time_t const time) const
+    {
+        // Unlike std::localtime these do not share a buffer between threads, the stream
+        // processors and motion detectors each read the time on their own threads.
+        std::tm localTime{};
+#if BOOST_OS_WINDOWS
+        localtime_s(&localTime, &time);
+#else
+        localtime_r(&time, &localTime);
+#endif
+        return localTime;
+    }
+};
+
+} // namespace
+
+std::shared_ptr<IpFreelyClock> const& IpFreelyClock::SystemClock()
+{
+    static std::shared_ptr<IpFreelyClock> const systemClock =
+        std::make_shared<IpFreelySystemClock>();
+    return systemClock;
+}
+
+IpFreelyVirtualClock::IpFreelyVirtualClock(time_t const startTime)
+    : m_startTime(startTime)
+{
+}
+
+time_t IpFreelyVirtualClock::Now() const
+{
+    std::lock_guard<std::mutex> lock(m_clockMutex);
+    return m_startTime + static_cast<time_t>(std::floor(m_elapsedSecs));
+}
+
+std::tm IpFreelyVirtualClock::LocalTime(time_t const time) const
+{
+    std::tm utcTime{};
+#if BOOST_OS_WINDOWS
+    gmtime_s(&utcTime, &time);
+#else
+    gmtime_r(&time, &utcTime);
+#endif
+    return utcTime;
+}
+
+void IpFreelyVirtualClock::Advance(double const secs)
+{
+    std::lock_guard<std::mutex> lock(m_clockMutex);
+    m_elapsedSecs += secs;
+}
+
+double IpFreelyVirtualClock::ElapsedSecs() const
+{
+    std::lock_guard<std::mutex> lock(m_clockMutex);
+    return m_elapsedSecs;
+}
+
+} // namespace ipfreely
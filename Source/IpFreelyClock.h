@@ -0,0 +1,126 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyClock.h
+ * \brief File containing declaration of IpFreelyClock classes.
+ */
+#ifndef IPFREELYCLOCK_H
+#define IPFREELYCLOCK_H
+
+#include <ctime>
+#include <memory>
+#include <mutex>
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*!
+ * \brief Class defining the wall clock that the recording pipeline reads the time from.
+ *
+ * Schedules, video file names and the dated folders recordings are saved in all follow this
+ * clock, so a virtual clock can run a whole day's recording in seconds.
+ */
+class IpFreelyClock
+{
+public:
+    /*! \brief IpFreelyClock destructor. */
+    virtual ~IpFreelyClock() = default;
+
+    /*!
+     * \brief Now gives the current time.
+     * \return The current time in seconds since the epoch.
+     */
+    virtual time_t Now() const = 0;
+
+    /*!
+     * \brief LocalTime converts a time to the calendar time used by schedules and folders.
+     * \param[in] time - The time in seconds since the epoch.
+     * \return The broken down calendar time.
+     */
+    virtual std::tm LocalTime(time_t const time) const = 0;
+
+    /*!
+     * \brief SystemClock gives access to the clock that follows the system's time.
+     * \return The system clock, shared by all users.
+     */
+    static std::shared_ptr<IpFreelyClock> const& SystemClock();
+};
+
+/*! \brief Class defining a clock that only moves when it is advanced. */
+class IpFreelyVirtualClock final : public IpFreelyClock
+{
+public:
+    /*!
+     * \brief IpFreelyVirtualClock constructor.
+     * \param[in] startTime - The clock's initial time in seconds since the epoch.
+     *
+     * Calendar times are in UTC rather than the system's time zone, so a given start time
+     * gives the same schedule transitions and folder names on every machine.
+     */
+    explicit IpFreelyVirtualClock(time_t const startTime);
+
+    /*! \brief IpFreelyVirtualClock destructor. */
+    virtual ~IpFreelyVirtualClock() = default;
+
+    /*! \brief IpFreelyVirtualClock deleted copy constructor. */
+    IpFreelyVirtualClock(IpFreelyVirtualClock const&) = delete;
+
+    /*! \brief IpFreelyVirtualClock deleted copy assignment operator. */
+    IpFreelyVirtualClock& operator=(IpFreelyVirtualClock const&) = delete;
+
+    /*!
+     * \brief Now gives the current time.
+     * \return The start time plus the whole seconds the clock has been advanced by.
+     */
+    virtual time_t Now() const;
+
+    /*!
+     * \brief LocalTime converts a time to the calendar time used by schedules and folders.
+     * \param[in] time - The time in seconds since the epoch.
+     * \return The broken down calendar time, in UTC.
+     */
+    virtual std::tm LocalTime(time_t const time) const;
+
+    /*!
+     * \brief Advance moves the clock forwards.
+     * \param[in] secs - The number of seconds to move forwards by, may be fractional.
+     *
+     * Fractions of a second are accumulated, so advancing by one frame period per frame
+     * keeps the clock in step with the frames.
+     */
+    void Advance(double const secs);
+
+    /*!
+     * \brief ElapsedSecs gives how far the clock has been advanced.
+     * \return The seconds since the start time, including fractions.
+     */
+    double ElapsedSecs() const;
+
+private:
+    mutable std::mutex m_clockMutex{};
+    time_t             m_startTime{};
+    double             m_elapsedSecs{0.0};
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYCLOCK_H
@@ -0,0 +1,109 @@
+#-------------------------------------------------
+#
+# Settings and sources shared by the IpFreely GUI
+# and the IpFreelyDaemon headless recorder.
+#
+#-------------------------------------------------
+
+# The following define makes your compiler emit warnings if you use
+# any feature of Qt which has been marked as deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# The built-in web server, RTSP proxy and download manager need QtNetwork.
+QT += network
+
+CONFIG += core_lib c++14
+
+DEFINES += CORE_LIBRARY_LIB
+
+# Compiles in the pipeline's trace points, which cost a single atomic load each until
+# tracing is started. Comment out to remove them entirely.
+DEFINES += IPFREELY_ENABLE_TRACING
+
+# You can also make your code fail to compile if you use deprecated APIs.
+# In order to do so, uncomment the following line.
+# You can also select to disable deprecated APIs only up to a certain version of Qt.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# On Windows we do this, assumes we'll be using MS VC 2015.
+win32 {
+    # disable incremental linking with debug builds
+    QMAKE_LFLAGS_DEBUG += /INCREMENTAL:NO
+
+    # Due to exporting from DLL we might get suprious warnings of
+    # type 4251, 4275 and 4100 so disable them.
+    QMAKE_CXXFLAGS += /wd4251 /wd4275 /wd4100
+    DEFINES += _CRT_SECURE_NO_WARNINGS=1
+
+    INCLUDEPATH += $$(OPENCV_DIR)/../../include \
+        $$(THIRD_PARTY_LIBS)
+
+    CONFIG(debug, debug|release) {
+      LIBS += -L$$(OPENCV_DIR)/lib \
+              -lopencv_world340d
+    } else {
+      LIBS += -L$$(OPENCV_DIR)/lib \
+              -lopencv_world340
+    }
+}
+# On non-windows, assumed to be Linux, we do this.
+else {
+    # Make sure we enable C++14 support.
+    QMAKE_CXXFLAGS += -std=c++14
+
+    # Set version info for library.
+    VERSION = 1.2.1
+
+    INCLUDEPATH += /usr/include/opencv4 \
+        /mnt/Data/projects/ThirdParty
+
+    LIBS += -L/usr/lib   \
+            -lopencv_core      \
+            -lopencv_imgcodecs \
+            -lopencv_imgproc   \
+            -lopencv_video     \
+            -lopencv_videoio \
+            -lopencv_highgui
+}
+
+SOURCES += \
+    $$PWD/IpFreelyCameraDatabase.cpp \
+    $$PWD/IpFreelyPreferences.cpp \
+    $$PWD/IpFreelyClock.cpp \
+    $$PWD/IpFreelySchedule.cpp \
+    $$PWD/IpFreelyStreamProcessor.cpp \
+    $$PWD/IpFreelyMotionDetector.cpp \
+    $$PWD/IpFreelyDiskSpaceManager.cpp \
+    $$PWD/IpFreelyFramePool.cpp \
+    $$PWD/IpFreelyFramePyramid.cpp \
+    $$PWD/IpFreelyStreamStats.cpp \
+    $$PWD/IpFreelyMetrics.cpp \
+    $$PWD/IpFreelyTrace.cpp \
+    $$PWD/IpFreelyHttpServer.cpp \
+    $$PWD/IpFreelyRtspMessage.cpp \
+    $$PWD/IpFreelyRtspProxy.cpp \
+    $$PWD/IpFreelyDownloadManager.cpp \
+    $$PWD/IpFreelyStorageMirror.cpp
+
+HEADERS += \
+    $$PWD/IpFreelyCameraDatabase.h \
+    $$PWD/IpFreelyPreferences.h \
+    $$PWD/IpFreelyClock.h \
+    $$PWD/IpFreelyPipelineEnvironment.h \
+    $$PWD/IpFreelySchedule.h \
+    $$PWD/IpFreelyStreamProcessor.h \
+    $$PWD/IpFreelyMotionDetector.h \
+    $$PWD/IpFreelyDiskSpaceManager.h \
+    $$PWD/IpFreelyFramePool.h \
+    $$PWD/IpFreelyFramePyramid.h \
+    $$PWD/IpFreelyImageUtils.h \
+    $$PWD/IpFreelyStreamStats.h \
+    $$PWD/IpFreelyMetrics.h \
+    $$PWD/IpFreelyTrace.h \
+    $$PWD/IpFreelyHttpServer.h \
+    $$PWD/IpFreelyRtspMessage.h \
+    $$PWD/IpFreelyRtspProxy.h \
+    $$PWD/IpFreelyDownloadManager.h \
+    $$PWD/IpFreelyStorageMirror.h
@@ -0,0 +1,196 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyDaemon.cpp
+ * \brief File containing definition of headless recorder's main entry point.
+ */
+#include <boost/predef.h>
+#include <csignal>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QDir>
+#include <boost/exception/all.hpp>
+#include "DebugLog/DebugLogging.h"
+#include "IpFreelyRecorderService.h"
+#include "IpFreelyTrace.h"
+
+#define IPFREELY_VERSION "1.2.0.0"
+
+namespace
+{
+
+volatile std::sig_atomic_t g_stopRequested   = 0;
+volatile std::sig_atomic_t g_reloadRequested = 0;
+volatile std::sig_atomic_t g_traceRequested  = 0;
+
+extern "C" void OnStopSignal(int)
+{
+    g_stopRequested = 1;
+}
+
+#if !BOOST_OS_WINDOWS
+extern "C" void OnReloadSignal(int)
+{
+    g_reloadRequested = 1;
+}
+
+extern "C" void OnTraceSignal(int)
+{
+    g_traceRequested = 1;
+}
+#endif
+
+void HandleTraceRequest()
+{
+    // The first request starts recording, later requests save what has been recorded, so a
+    // stuttering camera can be traced without restarting the recorder.
+    if (!ipfreely::IpFreelyTracer::Enabled())
+    {
+        ipfreely::IpFreelyTracer::SetEnabled(true);
+        DEBUG_MESSAGE_EX_INFO("Trace recording started.");
+        return;
+    }
+
+    auto const fileName =
+        QDateTime::currentDateTime().toString("'ipfreely_trace_'yyyyMMdd_HHmmss'.json'");
+
+    ipfreely::IpFreelyTracer::SaveChromeTrace(QDir::current().filePath(fileName).toStdString(),
+                                              ipfreely::DEFAULT_TRACE_WINDOW);
+}
+
+bool ReloadService(ipfreely::IpFreelyRecorderService& service)
+{
+    // A bad edit to the configuration must not take the recorder down, it keeps running and
+    // retries so the edit can be corrected and picked up without restarting the daemon.
+    try
+    {
+        service.Reload();
+        return true;
+    }
+    catch (...)
+    {
+        DEBUG_MESSAGE_EX_ERROR("Failed to reload recorder service, error: "
+                               << boost::current_exception_diagnostic_information());
+        return false;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // How often to check the camera streams' health and for signals.
+    static constexpr std::chrono::milliseconds POLL_PERIOD{250};
+    // How many poll periods between camera stream health checks.
+    static constexpr int POLLS_PER_STREAM_CHECK = 4;
+    // How many poll periods between attempts to reload after a failed reload.
+    static constexpr int POLLS_PER_RELOAD_RETRY = 120;
+
+    int  retCode        = EXIT_SUCCESS;
+    bool logInitialised = false;
+
+    try
+    {
+        // No event loop is run on this thread, the application object just provides Qt's
+        // per-process state. The web server runs its own event loop on its own thread.
+        QCoreApplication a(argc, argv);
+        QString          appVersion = IPFREELY_VERSION;
+        a.setApplicationVersion(appVersion);
+
+        DEBUG_MESSAGE_INSTANTIATE_EX(appVersion.toStdString(),
+                                     "",
+                                     "IpFreelyDaemon",
+                                     core_lib::log::BYTES_IN_MEBIBYTE * 25);
+
+        logInitialised = true;
+
+        std::signal(SIGINT, OnStopSignal);
+        std::signal(SIGTERM, OnStopSignal);
+#if !BOOST_OS_WINDOWS
+        std::signal(SIGHUP, OnReloadSignal);
+        std::signal(SIGUSR1, OnTraceSignal);
+#endif
+
+        // Tracing can also be started from launch, e.g. to trace a camera's connection.
+        if (a.arguments().contains("--trace"))
+        {
+            HandleTraceRequest();
+        }
+
+        ipfreely::IpFreelyRecorderService service;
+
+        DEBUG_MESSAGE_EX_INFO("Starting headless recorder.");
+        service.Start();
+
+        int pollCount        = 0;
+        int reloadRetryPolls = 0;
+
+        while (!g_stopRequested)
+        {
+            std::this_thread::sleep_for(POLL_PERIOD);
+
+            if (g_reloadRequested || ((reloadRetryPolls > 0) && (--reloadRetryPolls == 0)))
+            {
+                g_reloadRequested = 0;
+                reloadRetryPolls  = ReloadService(service) ? 0 : POLLS_PER_RELOAD_RETRY;
+            }
+
+            if (g_traceRequested)
+            {
+                g_traceRequested = 0;
+                HandleTraceRequest();
+            }
+
+            if (++pollCount == POLLS_PER_STREAM_CHECK)
+            {
+                pollCount = 0;
+                service.CheckStreams();
+            }
+        }
+
+        DEBUG_MESSAGE_EX_INFO("Stop requested, stopping headless recorder.");
+        service.Stop();
+    }
+    catch (...)
+    {
+        auto exceptionMsg = boost::current_exception_diagnostic_information();
+
+        if (logInitialised)
+        {
+            DEBUG_MESSAGE_EX_FATAL(exceptionMsg);
+        }
+
+        std::cerr << exceptionMsg << std::endl;
+        retCode = EXIT_FAILURE;
+    }
+
+    if (logInitialised)
+    {
+        DEBUG_MESSAGE_EX_INFO("Application closing");
+    }
+
+    return retCode;
+}
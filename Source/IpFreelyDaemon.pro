@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Headless recorder, records the cameras configured
+# in IpFreely without the GUI.
+#
+#-------------------------------------------------
+
+QT       = core gui
+
+TARGET = IpFreelyDaemon
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+include(IpFreelyCore.pri)
+
+SOURCES += \
+    IpFreelyDaemon.cpp \
+    IpFreelyRecorderService.cpp
+
+HEADERS += \
+    IpFreelyRecorderService.h
@@ -26,8 +26,10 @@
 #include <QStorageInfo>
 #include <sstream>
 #include <algorithm>
+#include <cstdint>
 #include <boost/exception/all.hpp>
 #include <boost/filesystem.hpp>
+#include "IpFreelyMetrics.h"
 #include "Threads/EventThread.h"
 #include "DebugLog/DebugLogging.h"
 #include "FileUtils/FileUtils.h"
@@ -40,12 +42,37 @@ namespace ipfreely
 
 static constexpr unsigned int UPDATE_PERIOD_MS = 60000;
 
-IpFreelyDiskSpaceManager::IpFreelyDiskSpaceManager(std::string const& saveFolderPath,
-                                                   int const          maxNumDaysToStore,
-                                                   int const          maxPercentUsedSpace)
+uint64_t IpFreelyDiskSpaceManager::DirectorySize(std::string const& directoryPath)
+{
+    uint64_t                  totalBytes = 0;
+    boost::system::error_code ec;
+
+    // Files that vanish or cannot be read while we iterate are simply not counted.
+    for (bfs::recursive_directory_iterator fileIter(directoryPath, ec), endIter;
+         !ec && (fileIter != endIter);
+         fileIter.increment(ec))
+    {
+        // Sub-directories report an error rather than a size, so are skipped too.
+        auto const fileBytes = bfs::file_size(fileIter->path(), ec);
+
+        if (!ec)
+        {
+            totalBytes += fileBytes;
+        }
+
+        ec.clear();
+    }
+
+    return totalBytes;
+}
+
+IpFreelyDiskSpaceManager::IpFreelyDiskSpaceManager(
+    std::string const& saveFolderPath, int const maxNumDaysToStore, int const maxPercentUsedSpace,
+    std::shared_ptr<IpFreelyMetrics> const& metrics, PipelineEnvironment const& environment)
     : m_saveFolderPath(saveFolderPath)
     , m_maxNumDaysToStore(maxNumDaysToStore)
     , m_maxPercentUsedSpace(maxPercentUsedSpace)
+    , m_metrics(metrics)
 {
     bfs::path p(m_saveFolderPath);
     p = bfs::system_complete(p);
@@ -60,6 +87,11 @@ IpFreelyDiskSpaceManager::IpFreelyDiskSpaceManager(std::string const& saveFolder
     DEBUG_MESSAGE_EX_INFO(
         "Started disk space manager for disk containing save folder:" << m_saveFolderPath);
 
+    if (environment.manualStepping)
+    {
+        return;
+    }
+
     m_eventThread = std::make_shared<core_lib::threads::EventThread>(
         std::bind(&IpFreelyDiskSpaceManager::ThreadEventCallback, this), UPDATE_PERIOD_MS);
 }
@@ -69,6 +101,17 @@ IpFreelyDiskSpaceManager::~IpFreelyDiskSpaceManager()
     // Do nothing.
 }
 
+void IpFreelyDiskSpaceManager::Step()
+{
+    if (m_eventThread)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error(
+            "Disk space manager is run by its event thread, it cannot be stepped."));
+    }
+
+    ThreadEventCallback();
+}
+
 void IpFreelyDiskSpaceManager::ThreadEventCallback() noexcept
 {
     try
@@ -94,6 +137,12 @@ void IpFreelyDiskSpaceManager::CheckUsedDiskSpace()
     {
         QStorageInfo info(QString::fromStdString(m_saveFolderPath));
 
+        if (m_metrics)
+        {
+            m_metrics->SetDiskSpace(static_cast<uint64_t>(std::max(info.bytesAvailable(), 0LL)),
+                                    static_cast<uint64_t>(std::max(info.bytesTotal(), 0LL)));
+        }
+
         auto percentUsed =
             static_cast<int>(100.0 * (1.0 - (static_cast<double>(info.bytesAvailable()) /
                                              static_cast<double>(info.bytesTotal()))));
@@ -148,10 +197,17 @@ bool IpFreelyDiskSpaceManager::DeleteOldestRecording()
 
     if (bfs::exists(p))
     {
+        auto const directoryBytes = m_metrics ? DirectorySize(p.string()) : 0;
+
         if (bfs::remove_all(p))
         {
             DEBUG_MESSAGE_EX_INFO(
                 "Successfully deleted data recording sub-directory: " << p.string());
+
+            if (m_metrics)
+            {
+                m_metrics->DiskSpaceFreed(directoryBytes);
+            }
         }
         else
         {
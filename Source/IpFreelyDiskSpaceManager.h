@@ -28,6 +28,8 @@
 #include <string>
 #include <list>
 #include <memory>
+#include <cstdint>
+#include "IpFreelyPipelineEnvironment.h"
 
 namespace core_lib
 {
@@ -43,6 +45,8 @@ class EventThread;
 namespace ipfreely
 {
 
+class IpFreelyMetrics;
+
 /*! \brief Class defining disk space manager thread. */
 class IpFreelyDiskSpaceManager final
 {
@@ -52,9 +56,17 @@ public:
      * \param[in] saveFolderPath - A local folder to save captured videos to.
      * \param[in] maxNumDaysToStore - Maximum number of days of data to store.
      * \param[in] maxPercentUsedSpace - Maximum disk space percentage to be used.
+     * \param[in] metrics - (Optional) The metrics registry to report disk space to.
+     * \param[in] environment - (Optional) The threading to use, an event thread checking once
+     * a minute if not given.
+     *
+     * Recordings are saved in one folder per day, named after the day, so the oldest day's
+     * recordings are found by name and deleted first.
      */
     IpFreelyDiskSpaceManager(std::string const& saveFolderPath, int const maxNumDaysToStore,
-                             int const maxPercentUsedSpace);
+                             int const                               maxPercentUsedSpace,
+                             std::shared_ptr<IpFreelyMetrics> const& metrics     = {},
+                             PipelineEnvironment const&              environment = {});
 
     /*! \brief IpFreelyDiskSpaceManager destructor. */
     virtual ~IpFreelyDiskSpaceManager();
@@ -65,16 +77,29 @@ public:
     /*! \brief IpFreelyDiskSpaceManager deleted copy assignment operator. */
     IpFreelyDiskSpaceManager& operator=(IpFreelyDiskSpaceManager const&) = delete;
 
+    /*!
+     * \brief Step checks the disk space and days stored on the caller's thread.
+     *
+     * Only allowed when the environment asks for manual stepping, otherwise the event thread
+     * does the checks.
+     */
+    void Step();
+
 private:
-    void ThreadEventCallback() noexcept;
-    void CheckUsedDiskSpace();
-    void CheckNumDaysDataStored();
-    bool DeleteOldestRecording();
+    /*! \brief Lets the benchmarks time the private directory scans directly. */
+    friend struct IpFreelyBenchmarkAccess;
+
+    static uint64_t DirectorySize(std::string const& directoryPath);
+    void            ThreadEventCallback() noexcept;
+    void            CheckUsedDiskSpace();
+    void            CheckNumDaysDataStored();
+    bool            DeleteOldestRecording();
 
 private:
     std::string                                     m_saveFolderPath{};
     int                                             m_maxNumDaysToStore{7};
     int                                             m_maxPercentUsedSpace{90};
+    std::shared_ptr<IpFreelyMetrics>                m_metrics;
     std::list<std::wstring>                         m_subDirs;
     std::shared_ptr<core_lib::threads::EventThread> m_eventThread;
 };
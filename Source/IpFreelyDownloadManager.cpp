@@ -0,0 +1,1274 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+
+/*!
+ * \file IpFreelyDownloadManager.cpp
+ * \brief File containing definition of the HTTP download manager.
+ */
+#include "IpFreelyDownloadManager.h"
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QTimer>
+#include <QPointer>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+#include <boost/exception/all.hpp>
+#include "DebugLog/DebugLogging.h"
+
+namespace ipfreely
+{
+
+static constexpr int     TICK_PERIOD_MS      = 100;
+static constexpr int     SPEED_PERIOD_MS     = 1000;
+static constexpr int     STALL_TIMEOUT_MS    = 30000;
+static constexpr int     RETRY_DELAY_MS      = 2000;
+static constexpr int     MAX_SEGMENT_RETRIES = 3;
+static constexpr int     MAX_RESTARTS        = 3;
+static constexpr int64_t READ_BUFFER_BYTES   = 256 * 1024;
+static constexpr int64_t READ_CHUNK_BYTES    = 64 * 1024;
+
+namespace
+{
+
+QByteArray ResponseValidator(QNetworkReply const& reply)
+{
+    // Weak ETags cannot be used with If-Range, the date is the next best thing.
+    auto const etag = reply.rawHeader("ETag").trimmed();
+
+    if (!etag.isEmpty() && !etag.startsWith("W/"))
+    {
+        return etag;
+    }
+
+    return reply.rawHeader("Last-Modified").trimmed();
+}
+
+bool IsTransientError(QNetworkReply::NetworkError const error) noexcept
+{
+    // Network, proxy and server errors may go away, content and protocol errors will not.
+    return (error < QNetworkReply::ContentAccessDenied) ||
+           (error >= QNetworkReply::InternalServerError);
+}
+
+} // namespace
+
+IpFreelyDownloadManager::IpFreelyDownloadManager(QObject* parent)
+    : QObject(parent)
+    , m_network(new QNetworkAccessManager(this))
+    , m_tickTimer(new QTimer(this))
+    , m_lastSpeedMs(0)
+    , m_maxActiveDownloads(4)
+    , m_segmentMinBytes(32 * 1024 * 1024)
+    , m_maxSegments(4)
+    , m_nextDownloadId(1)
+    , m_wasIdle(true)
+{
+    m_clock.start();
+    m_tickTimer->setInterval(TICK_PERIOD_MS);
+    connect(m_tickTimer, &QTimer::timeout, this, &IpFreelyDownloadManager::OnTick);
+    m_tickTimer->start();
+}
+
+IpFreelyDownloadManager::~IpFreelyDownloadManager()
+{
+    // Leave partial files so the downloads can be resumed later.
+    for (auto& d : m_downloads)
+    {
+        StopTransfers(d.second);
+
+        if (d.second.segments.size() > 1)
+        {
+            SaveSegments(d.second);
+        }
+    }
+}
+
+void IpFreelyDownloadManager::SetMaxActiveDownloads(int const maxDownloads)
+{
+    if (maxDownloads < 1)
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("maxDownloads must be at least 1"));
+    }
+
+    m_maxActiveDownloads = maxDownloads;
+    Update();
+}
+
+void IpFreelyDownloadManager::SetDefaultHostLimits(HostLimits const& limits)
+{
+    if ((limits.maxConnections < 1) || (limits.maxBytesPerSec < 0))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("invalid host limits"));
+    }
+
+    m_defaultLimits = limits;
+
+    for (auto& h : m_hosts)
+    {
+        if (!h.second.customLimits)
+        {
+            h.second.limits = limits;
+        }
+    }
+
+    Update();
+}
+
+void IpFreelyDownloadManager::SetHostLimits(QString const& host, HostLimits const& limits)
+{
+    if ((limits.maxConnections < 1) || (limits.maxBytesPerSec < 0))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("invalid host limits"));
+    }
+
+    auto& hostState        = Host(host.toLower());
+    hostState.limits       = limits;
+    hostState.customLimits = true;
+    hostState.budget       = std::min(hostState.budget, limits.maxBytesPerSec);
+    Update();
+}
+
+void IpFreelyDownloadManager::SetSegmentation(int64_t const minFileBytes, int const maxSegments)
+{
+    if ((minFileBytes < 1) || (maxSegments < 1))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("invalid segmentation settings"));
+    }
+
+    m_segmentMinBytes = minFileBytes;
+    m_maxSegments     = maxSegments;
+}
+
+int IpFreelyDownloadManager::Enqueue(QUrl const& url, QString const& filePath,
+                                     bool const discardPartial)
+{
+    if (!url.isValid() || ((url.scheme() != "http") && (url.scheme() != "https")))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("url must be a valid HTTP(S) URL"));
+    }
+
+    if (filePath.isEmpty())
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("filePath must not be empty"));
+    }
+
+    auto const downloadId = m_nextDownloadId++;
+    auto&      download   = m_downloads[downloadId];
+    download.info.url      = url;
+    download.info.filePath = filePath;
+    download.host          = url.host().toLower();
+    m_wasIdle              = false;
+
+    if (discardPartial)
+    {
+        QFile::remove(SegmentsPath(download));
+        QFile::remove(ValidatorPath(download));
+        QFile::remove(PartPath(download));
+    }
+
+    // Start from the event loop so the caller can first connect to the download's signals.
+    QTimer::singleShot(0, this, [this] { Update(); });
+    return downloadId;
+}
+
+void IpFreelyDownloadManager::Pause(int const downloadId)
+{
+    auto download = Find(downloadId);
+
+    if (!download || ((download->info.state != eDownloadState::queued) &&
+                      (download->info.state != eDownloadState::inProgress)))
+    {
+        return;
+    }
+
+    StopTransfers(*download);
+
+    if (download->segments.size() > 1)
+    {
+        SaveSegments(*download);
+    }
+
+    download->recentBytes      = 0;
+    download->info.bytesPerSec = 0;
+    SetState(downloadId, *download, eDownloadState::paused);
+    Update();
+}
+
+void IpFreelyDownloadManager::Resume(int const downloadId)
+{
+    auto download = Find(downloadId);
+
+    if (!download || ((download->info.state != eDownloadState::paused) &&
+                      (download->info.state != eDownloadState::failed)))
+    {
+        return;
+    }
+
+    for (auto& segment : download->segments)
+    {
+        segment.retries   = 0;
+        segment.retryAtMs = 0;
+    }
+
+    download->info.errorString.clear();
+    m_wasIdle = false;
+    SetState(downloadId, *download, eDownloadState::queued);
+    Update();
+}
+
+void IpFreelyDownloadManager::Cancel(int const downloadId)
+{
+    auto download = Find(downloadId);
+
+    if (!download || (download->info.state == eDownloadState::completed) ||
+        (download->info.state == eDownloadState::cancelled))
+    {
+        return;
+    }
+
+    StopTransfers(*download);
+    QFile::remove(SegmentsPath(*download));
+    QFile::remove(ValidatorPath(*download));
+    QFile::remove(PartPath(*download));
+    download->segments.clear();
+    download->validator.clear();
+    download->probed             = false;
+    download->recentBytes        = 0;
+    download->info.receivedBytes = 0;
+    download->info.bytesPerSec   = 0;
+    download->info.errorString.clear();
+    SetState(downloadId, *download, eDownloadState::cancelled);
+    Update();
+}
+
+void IpFreelyDownloadManager::Remove(int const downloadId)
+{
+    auto download = Find(downloadId);
+
+    if (!download)
+    {
+        return;
+    }
+
+    StopTransfers(*download);
+
+    if ((download->info.state != eDownloadState::completed) && (download->segments.size() > 1))
+    {
+        SaveSegments(*download);
+    }
+
+    m_downloads.erase(downloadId);
+    Update();
+}
+
+DownloadInfo IpFreelyDownloadManager::Info(int const downloadId) const
+{
+    auto dIt = m_downloads.find(downloadId);
+
+    if (dIt == m_downloads.end())
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("unknown downloadId"));
+    }
+
+    return dIt->second.info;
+}
+
+bool IpFreelyDownloadManager::IsIdle() const noexcept
+{
+    return std::none_of(m_downloads.begin(), m_downloads.end(), [](auto const& d) {
+        return (d.second.info.state == eDownloadState::queued) ||
+               (d.second.info.state == eDownloadState::inProgress);
+    });
+}
+
+IpFreelyDownloadManager::Download* IpFreelyDownloadManager::Find(int const downloadId)
+{
+    auto dIt = m_downloads.find(downloadId);
+    return dIt == m_downloads.end() ? nullptr : &dIt->second;
+}
+
+IpFreelyDownloadManager::HostState& IpFreelyDownloadManager::Host(QString const& host)
+{
+    auto hIt = m_hosts.find(host);
+
+    if (hIt == m_hosts.end())
+    {
+        hIt                = m_hosts.emplace(host, HostState{}).first;
+        hIt->second.limits = m_defaultLimits;
+    }
+
+    return hIt->second;
+}
+
+void IpFreelyDownloadManager::Update()
+{
+    StartDownloads();
+    FlushSignals();
+}
+
+void IpFreelyDownloadManager::StartDownloads()
+{
+    // Work on a copy of the IDs as a failure to start can change the downloads' states.
+    std::vector<int> downloadIds;
+    downloadIds.reserve(m_downloads.size());
+    auto numActive = 0;
+
+    for (auto const& d : m_downloads)
+    {
+        downloadIds.push_back(d.first);
+
+        if (d.second.info.state == eDownloadState::inProgress)
+        {
+            ++numActive;
+        }
+    }
+
+    for (auto const downloadId : downloadIds)
+    {
+        auto download = Find(downloadId);
+
+        if (!download)
+        {
+            continue;
+        }
+
+        if (download->info.state == eDownloadState::inProgress)
+        {
+            // Segments may be waiting for a connection or a retry.
+            if (!download->probe)
+            {
+                StartSegments(downloadId, *download);
+            }
+        }
+        else if ((download->info.state == eDownloadState::queued) &&
+                 (numActive < m_maxActiveDownloads))
+        {
+            auto const& host = Host(download->host);
+
+            if (host.connections < host.limits.maxConnections)
+            {
+                StartDownload(downloadId, *download);
+                ++numActive;
+            }
+        }
+    }
+}
+
+void IpFreelyDownloadManager::StartDownload(int const downloadId, Download& download)
+{
+    SetState(downloadId, download, eDownloadState::inProgress);
+
+    if (download.segments.empty())
+    {
+        LoadValidator(download);
+    }
+
+    if (download.segments.empty() && !LoadSegments(download))
+    {
+        if ((m_maxSegments > 1) && !download.probed)
+        {
+            QNetworkRequest request(download.info.url);
+            request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+            auto reply     = m_network->head(request);
+            download.probe = reply;
+            ++Host(download.host).connections;
+
+            connect(reply, &QNetworkReply::finished, this, [this, downloadId, reply] {
+                ProbeFinished(downloadId, reply);
+            });
+
+            return;
+        }
+
+        if (!CreateSegments(downloadId, download, false))
+        {
+            return;
+        }
+    }
+
+    StartSegments(downloadId, download);
+}
+
+void IpFreelyDownloadManager::ProbeFinished(int const downloadId, QNetworkReply* reply)
+{
+    reply->deleteLater();
+    auto download = Find(downloadId);
+
+    if (!download || (download->probe != reply))
+    {
+        return;
+    }
+
+    download->probe  = nullptr;
+    download->probed = true;
+    ReleaseConnection(download->host);
+    auto acceptsRanges = false;
+
+    // Some servers refuse HEAD requests, if so download the file in one piece.
+    if (reply->error() == QNetworkReply::NoError)
+    {
+        auto const length = reply->header(QNetworkRequest::ContentLengthHeader);
+
+        if (length.isValid())
+        {
+            download->info.totalBytes = length.toLongLong();
+        }
+
+        // Segments are joined from several responses, so only a file that can be told apart
+        // from a changed one is split.
+        auto const validator = ResponseValidator(*reply);
+        acceptsRanges = !validator.isEmpty() &&
+                        (reply->rawHeader("Accept-Ranges").trimmed().toLower() == "bytes");
+
+        if (validator != download->validator)
+        {
+            // Any partial file is from an older version of the file, or cannot be checked.
+            QFile::remove(PartPath(*download));
+            download->validator = validator;
+            SaveValidator(*download);
+        }
+    }
+
+    if (CreateSegments(downloadId, *download, acceptsRanges))
+    {
+        StartSegments(downloadId, *download);
+    }
+
+    Update();
+}
+
+bool IpFreelyDownloadManager::CreateSegments(int const downloadId, Download& download,
+                                             bool const acceptsRanges)
+{
+    download.segments.clear();
+    auto const totalBytes = download.info.totalBytes;
+    auto const partPath   = PartPath(download);
+
+    if (acceptsRanges && (m_maxSegments > 1) && (totalBytes >= m_segmentMinBytes))
+    {
+        // Preallocate the partial file so each segment writes its data in place.
+        QFile partFile(partPath);
+
+        if (!partFile.open(QIODevice::WriteOnly) || !partFile.resize(totalBytes))
+        {
+            FailDownload(downloadId,
+                         download,
+                         QString("Failed to create %1: %2").arg(partPath, partFile.errorString()));
+            return false;
+        }
+
+        auto const segmentBytes = (totalBytes + m_maxSegments - 1) / m_maxSegments;
+
+        for (int64_t start = 0; start < totalBytes; start += segmentBytes)
+        {
+            Segment segment;
+            segment.start = start;
+            segment.end   = std::min(start + segmentBytes, totalBytes) - 1;
+            download.segments.push_back(std::move(segment));
+        }
+
+        download.info.receivedBytes = 0;
+        SaveSegments(download);
+    }
+    else
+    {
+        // Resume from the end of any partial file, received is 0 if there is none. A partial
+        // file without a validator cannot be checked against the server's file.
+        if (download.validator.isEmpty())
+        {
+            QFile::remove(partPath);
+        }
+
+        Segment segment;
+        segment.received            = QFileInfo(partPath).size();
+        download.info.receivedBytes = segment.received;
+        download.segments.push_back(std::move(segment));
+    }
+
+    return true;
+}
+
+void IpFreelyDownloadManager::StartSegments(int const downloadId, Download& download)
+{
+    if (std::all_of(download.segments.begin(), download.segments.end(), [](auto const& s) {
+            return s.done;
+        }))
+    {
+        CompleteDownload(downloadId, download);
+        return;
+    }
+
+    auto const& host  = Host(download.host);
+    auto const  nowMs = m_clock.elapsed();
+
+    for (size_t index = 0; index < download.segments.size(); ++index)
+    {
+        if (download.info.state != eDownloadState::inProgress)
+        {
+            break;
+        }
+
+        auto const& segment = download.segments[index];
+
+        if (segment.done || segment.reply || (segment.retryAtMs > nowMs))
+        {
+            continue;
+        }
+
+        if (host.connections >= host.limits.maxConnections)
+        {
+            break;
+        }
+
+        StartSegment(downloadId, download, index);
+    }
+}
+
+void IpFreelyDownloadManager::StartSegment(int const downloadId, Download& download,
+                                           size_t const index)
+{
+    auto&      segment  = download.segments[index];
+    auto const offset   = segment.start + segment.received;
+    auto const partPath = PartPath(download);
+    segment.file.reset(new QFile(partPath));
+
+    if (!segment.file->open(QIODevice::ReadWrite) || !segment.file->seek(offset))
+    {
+        auto const error = segment.file->errorString();
+        segment.file.reset();
+        FailDownload(downloadId, download, QString("Failed to open %1: %2").arg(partPath, error));
+        return;
+    }
+
+    QNetworkRequest request(download.info.url);
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+
+    // If the file changed since the validator was saved the server ignores the range and sends
+    // the whole new file. Without a validator the whole file is asked for, as what has been
+    // received cannot be checked.
+    if (segment.end >= 0)
+    {
+        auto const range = QString("bytes=%1-%2").arg(offset).arg(segment.end);
+        request.setRawHeader("Range", range.toLatin1());
+        request.setRawHeader("If-Range", download.validator);
+    }
+    else if ((offset > 0) && !download.validator.isEmpty())
+    {
+        request.setRawHeader("Range", QString("bytes=%1-").arg(offset).toLatin1());
+        request.setRawHeader("If-Range", download.validator);
+    }
+
+    // Limiting the read buffer stops the socket being read while we are throttling the host,
+    // so the server is slowed by TCP flow control rather than the data piling up in memory.
+    auto reply = m_network->get(request);
+    reply->setReadBufferSize(READ_BUFFER_BYTES);
+    segment.reply          = reply;
+    segment.checked        = false;
+    segment.lastActivityMs = m_clock.elapsed();
+    ++Host(download.host).connections;
+
+    connect(reply, &QNetworkReply::readyRead, this, [this, downloadId, index, reply] {
+        SegmentReadyRead(downloadId, index, reply);
+    });
+
+    connect(reply, &QNetworkReply::finished, this, [this, downloadId, index, reply] {
+        SegmentFinished(downloadId, index, reply);
+    });
+}
+
+void IpFreelyDownloadManager::SegmentReadyRead(int const downloadId, size_t const index,
+                                               QNetworkReply* reply)
+{
+    auto download = Find(downloadId);
+
+    if (!download || (index >= download->segments.size()) ||
+        (download->segments[index].reply != reply))
+    {
+        return;
+    }
+
+    ReadSegment(downloadId, *download, download->segments[index], false);
+    FlushSignals();
+}
+
+void IpFreelyDownloadManager::SegmentFinished(int const downloadId, size_t const index,
+                                              QNetworkReply* reply)
+{
+    reply->deleteLater();
+    auto download = Find(downloadId);
+
+    if (!download || (index >= download->segments.size()) ||
+        (download->segments[index].reply != reply))
+    {
+        return;
+    }
+
+    auto& segment = download->segments[index];
+
+    if (reply->error() == QNetworkReply::NoError)
+    {
+        // Whatever is still buffered is written regardless of the bandwidth limit.
+        ReadSegment(downloadId, *download, segment, true);
+
+        if (download->info.state != eDownloadState::inProgress)
+        {
+            Update();
+            return;
+        }
+    }
+
+    segment.reply = nullptr;
+    segment.file.reset();
+    ReleaseConnection(download->host);
+
+    auto const status =
+        reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // A server answers 416 to a request for the bytes after the end of the file, which
+    // means a single piece download was interrupted just before it completed.
+    auto const alreadyComplete =
+        (status == 416) && (download->segments.size() == 1) && (segment.received > 0);
+
+    if ((reply->error() != QNetworkReply::NoError) && !alreadyComplete)
+    {
+        RetrySegment(downloadId,
+                     *download,
+                     segment,
+                     reply->errorString(),
+                     IsTransientError(reply->error()));
+        Update();
+        return;
+    }
+
+    auto const expectedBytes = segment.end >= 0 ? segment.end - segment.start + 1
+                                                : download->info.totalBytes;
+
+    if (!alreadyComplete && (expectedBytes >= 0) && (segment.received < expectedBytes))
+    {
+        RetrySegment(
+            downloadId, *download, segment, "Connection closed before the data was received", true);
+        Update();
+        return;
+    }
+
+    segment.done = true;
+
+    if (download->segments.size() > 1)
+    {
+        SaveSegments(*download);
+    }
+
+    if (alreadyComplete)
+    {
+        download->info.totalBytes = segment.received;
+    }
+
+    StartSegments(downloadId, *download);
+    Update();
+}
+
+bool IpFreelyDownloadManager::CheckResponse(int const downloadId, Download& download,
+                                            Segment& segment)
+{
+    auto const reply  = segment.reply;
+    auto const status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    auto const offset = segment.start + segment.received;
+
+    if (status == 206)
+    {
+        // Content-Range is "bytes <first>-<last>/<total>", total may be "*".
+        auto const range = reply->rawHeader("Content-Range");
+        auto const dash  = range.indexOf('-');
+        auto const slash = range.lastIndexOf('/');
+        auto       ok    = false;
+        auto const first = range.mid(6, dash - 6).trimmed().toLongLong(&ok);
+
+        if (!range.startsWith("bytes ") || (dash < 0) || !ok || (first != offset))
+        {
+            FailDownload(downloadId,
+                         download,
+                         QString("Unexpected Content-Range: %1").arg(QString(range)));
+            return false;
+        }
+
+        auto const totalBytes = range.mid(slash + 1).toLongLong(&ok);
+
+        // A server that ignores If-Range would send part of a changed file.
+        auto const validator = ResponseValidator(*reply);
+
+        if (!validator.isEmpty() && (validator != download.validator))
+        {
+            RestartDownload(downloadId, download, "The file changed on the server", true);
+            return false;
+        }
+
+        if ((slash > dash) && ok)
+        {
+            download.info.totalBytes = totalBytes;
+        }
+    }
+    else if ((status >= 200) && (status < 300))
+    {
+        if (download.segments.size() > 1)
+        {
+            // The file changed or the server ignored the range, restart it in one piece.
+            RestartDownload(
+                downloadId, download, "The file changed or byte ranges are not supported", false);
+            return false;
+        }
+
+        if (offset > 0)
+        {
+            // The server ignored the range and is sending the whole file.
+            if (!segment.file->resize(0) || !segment.file->seek(0))
+            {
+                FailDownload(downloadId,
+                             download,
+                             QString("Failed to truncate %1: %2")
+                                 .arg(PartPath(download), segment.file->errorString()));
+                return false;
+            }
+
+            download.info.receivedBytes -= segment.received;
+            segment.received = 0;
+        }
+
+        auto const length = reply->header(QNetworkRequest::ContentLengthHeader);
+
+        if (length.isValid())
+        {
+            download.info.totalBytes = length.toLongLong();
+        }
+
+        // The partial file now holds the start of this response's file.
+        download.validator = ResponseValidator(*reply);
+        SaveValidator(download);
+    }
+    else
+    {
+        // An error page, the error is reported when the reply finishes.
+        reply->readAll();
+        return false;
+    }
+
+    segment.checked = true;
+    return true;
+}
+
+void IpFreelyDownloadManager::ReadSegment(int const downloadId, Download& download,
+                                          Segment& segment, bool const ignoreBudget)
+{
+    if (!segment.checked && !CheckResponse(downloadId, download, segment))
+    {
+        return;
+    }
+
+    auto const reply   = segment.reply;
+    auto&      host    = Host(download.host);
+    auto const limited = host.limits.maxBytesPerSec > 0;
+
+    while (reply->bytesAvailable() > 0)
+    {
+        auto toRead = std::min<int64_t>(reply->bytesAvailable(), READ_CHUNK_BYTES);
+
+        if (limited && !ignoreBudget)
+        {
+            if (host.budget <= 0)
+            {
+                break;
+            }
+
+            toRead = std::min(toRead, host.budget);
+        }
+
+        if (segment.end >= 0)
+        {
+            auto const remaining = segment.end - segment.start + 1 - segment.received;
+
+            if (remaining <= 0)
+            {
+                reply->readAll();
+                break;
+            }
+
+            toRead = std::min(toRead, remaining);
+        }
+
+        auto const data = reply->read(toRead);
+
+        if (data.isEmpty())
+        {
+            break;
+        }
+
+        if (segment.file->write(data) != data.size())
+        {
+            FailDownload(downloadId,
+                         download,
+                         QString("Failed to write %1: %2")
+                             .arg(PartPath(download), segment.file->errorString()));
+            return;
+        }
+
+        segment.received += data.size();
+        segment.retries        = 0;
+        segment.lastActivityMs = m_clock.elapsed();
+        download.info.receivedBytes += data.size();
+        download.recentBytes += data.size();
+
+        if (limited)
+        {
+            host.budget -= data.size();
+        }
+    }
+}
+
+void IpFreelyDownloadManager::RetrySegment(int const downloadId, Download& download,
+                                           Segment& segment, QString const& error,
+                                           bool const transient)
+{
+    if (!transient || (++segment.retries > MAX_SEGMENT_RETRIES))
+    {
+        FailDownload(downloadId, download, error);
+        return;
+    }
+
+    DEBUG_MESSAGE_EX_WARNING("Retrying download of " << download.info.filePath.toStdString()
+                                                     << ", error: " << error.toStdString());
+
+    // The segment is restarted by the first update after the delay, from where it stopped.
+    segment.retryAtMs = m_clock.elapsed() + RETRY_DELAY_MS;
+    QTimer::singleShot(RETRY_DELAY_MS, this, [this] { Update(); });
+}
+
+void IpFreelyDownloadManager::RestartDownload(int const downloadId, Download& download,
+                                              QString const& reason, bool const reprobe)
+{
+    if (++download.restarts > MAX_RESTARTS)
+    {
+        FailDownload(downloadId, download, reason);
+        return;
+    }
+
+    DEBUG_MESSAGE_EX_WARNING("Restarting download of " << download.info.filePath.toStdString()
+                                                       << ", reason: " << reason.toStdString());
+
+    StopTransfers(download);
+    QFile::remove(SegmentsPath(download));
+    QFile::remove(ValidatorPath(download));
+    QFile::remove(PartPath(download));
+    download.segments.clear();
+    download.validator.clear();
+    download.probed             = !reprobe;
+    download.recentBytes        = 0;
+    download.info.receivedBytes = 0;
+    download.info.totalBytes    = -1;
+
+    // Started again from the event loop, the caller may still be using the old segments.
+    SetState(downloadId, download, eDownloadState::queued);
+    QTimer::singleShot(0, this, [this] { Update(); });
+}
+
+void IpFreelyDownloadManager::CompleteDownload(int const downloadId, Download& download)
+{
+    auto const& filePath = download.info.filePath;
+    QFile::remove(SegmentsPath(download));
+    QFile::remove(ValidatorPath(download));
+
+    if (QFile::exists(filePath) && !QFile::remove(filePath))
+    {
+        FailDownload(downloadId, download, QString("Failed to replace %1").arg(filePath));
+        return;
+    }
+
+    if (!QFile::rename(PartPath(download), filePath))
+    {
+        FailDownload(downloadId, download, QString("Failed to create %1").arg(filePath));
+        return;
+    }
+
+    if (download.info.totalBytes < 0)
+    {
+        download.info.totalBytes = download.info.receivedBytes;
+    }
+
+    download.info.bytesPerSec = 0;
+    SetState(downloadId, download, eDownloadState::completed);
+}
+
+void IpFreelyDownloadManager::FailDownload(int const downloadId, Download& download,
+                                           QString const& error)
+{
+    StopTransfers(download);
+
+    if (download.segments.size() > 1)
+    {
+        SaveSegments(download);
+    }
+
+    DEBUG_MESSAGE_EX_ERROR("Download of " << download.info.filePath.toStdString()
+                                          << " failed, error: " << error.toStdString());
+
+    download.info.errorString = error;
+    download.info.bytesPerSec = 0;
+    SetState(downloadId, download, eDownloadState::failed);
+}
+
+void IpFreelyDownloadManager::StopTransfers(Download& download)
+{
+    // Disconnect before aborting as abort() emits finished() immediately.
+    if (download.probe)
+    {
+        download.probe->disconnect(this);
+        download.probe->abort();
+        download.probe->deleteLater();
+        download.probe = nullptr;
+        ReleaseConnection(download.host);
+    }
+
+    for (auto& segment : download.segments)
+    {
+        if (segment.reply)
+        {
+            segment.reply->disconnect(this);
+            segment.reply->abort();
+            segment.reply->deleteLater();
+            segment.reply = nullptr;
+            ReleaseConnection(download.host);
+        }
+
+        segment.file.reset();
+    }
+}
+
+void IpFreelyDownloadManager::ReleaseConnection(QString const& host)
+{
+    auto& hostState = Host(host);
+    hostState.connections = std::max(hostState.connections - 1, 0);
+}
+
+void IpFreelyDownloadManager::SetState(int const downloadId, Download& download,
+                                       eDownloadState const state)
+{
+    download.info.state = state;
+    NotifyChanged(downloadId, download);
+
+    if (IsFinished(state))
+    {
+        m_pendingFinished.push_back(downloadId);
+    }
+}
+
+void IpFreelyDownloadManager::NotifyChanged(int const downloadId, Download& download)
+{
+    if (!download.changed)
+    {
+        download.changed = true;
+        m_pendingChanged.push_back(downloadId);
+    }
+}
+
+void IpFreelyDownloadManager::FlushSignals()
+{
+    // Signals are emitted once our state is consistent, so slots may call back into us,
+    // e.g. to remove a finished download.
+    std::vector<int> changed;
+    std::vector<int> finished;
+    changed.swap(m_pendingChanged);
+    finished.swap(m_pendingFinished);
+
+    for (auto const downloadId : changed)
+    {
+        auto download = Find(downloadId);
+
+        if (download)
+        {
+            download->changed = false;
+            emit DownloadChanged(downloadId);
+        }
+    }
+
+    for (auto const downloadId : finished)
+    {
+        if (Find(downloadId))
+        {
+            emit DownloadFinished(downloadId);
+        }
+    }
+
+    if (!m_wasIdle && IsIdle())
+    {
+        m_wasIdle = true;
+        emit Idle();
+    }
+}
+
+void IpFreelyDownloadManager::OnTick()
+{
+    for (auto& h : m_hosts)
+    {
+        auto const rate = h.second.limits.maxBytesPerSec;
+
+        if (rate > 0)
+        {
+            // Allow a little burst so short gaps between reads do not waste bandwidth.
+            auto const perTick = std::max<int64_t>(rate * TICK_PERIOD_MS / 1000, 1);
+            h.second.budget    = std::min(h.second.budget + perTick, 2 * perTick);
+        }
+    }
+
+    auto const nowMs        = m_clock.elapsed();
+    auto const measureSpeed = nowMs - m_lastSpeedMs >= SPEED_PERIOD_MS;
+    std::vector<QPointer<QNetworkReply>> stalled;
+
+    for (auto& d : m_downloads)
+    {
+        auto& download = d.second;
+
+        if (download.info.state != eDownloadState::inProgress)
+        {
+            continue;
+        }
+
+        // Read data left buffered by the bandwidth limit, new data may not arrive to prompt it.
+        for (size_t index = 0; index < download.segments.size(); ++index)
+        {
+            auto& segment = download.segments[index];
+
+            if (!segment.reply)
+            {
+                continue;
+            }
+
+            if (segment.reply->bytesAvailable() > 0)
+            {
+                ReadSegment(d.first, download, segment, false);
+
+                // A write failure stops the download and may discard its segments.
+                if (download.info.state != eDownloadState::inProgress)
+                {
+                    break;
+                }
+            }
+            else if (nowMs - segment.lastActivityMs > STALL_TIMEOUT_MS)
+            {
+                stalled.emplace_back(segment.reply);
+            }
+        }
+
+        if (measureSpeed)
+        {
+            download.info.bytesPerSec =
+                download.recentBytes * 1000 / std::max<int64_t>(nowMs - m_lastSpeedMs, 1);
+            download.recentBytes = 0;
+            NotifyChanged(d.first, download);
+
+            if ((download.info.state == eDownloadState::inProgress) &&
+                (download.segments.size() > 1))
+            {
+                SaveSegments(download);
+            }
+        }
+        else if (download.recentBytes > 0)
+        {
+            NotifyChanged(d.first, download);
+        }
+    }
+
+    if (measureSpeed)
+    {
+        m_lastSpeedMs = nowMs;
+    }
+
+    // Aborting a stalled request finishes it with an error, so its segment is retried.
+    for (auto const& reply : stalled)
+    {
+        if (reply)
+        {
+            auto const url = reply->url().toString(QUrl::RemoveUserInfo);
+            DEBUG_MESSAGE_EX_WARNING("Download stalled, url: " << url.toStdString());
+            reply->abort();
+        }
+    }
+
+    FlushSignals();
+}
+
+void IpFreelyDownloadManager::SaveSegments(Download const& download)
+{
+    // Flush first so the progress saved never exceeds the data on disk.
+    for (auto const& segment : download.segments)
+    {
+        if (segment.file)
+        {
+            segment.file->flush();
+        }
+    }
+
+    QSaveFile segmentsFile(SegmentsPath(download));
+
+    if (!segmentsFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        DEBUG_MESSAGE_EX_WARNING("Failed to save download segments: "
+                                 << segmentsFile.fileName().toStdString());
+        return;
+    }
+
+    QTextStream stream(&segmentsFile);
+    stream << download.info.totalBytes << "\n";
+
+    for (auto const& segment : download.segments)
+    {
+        stream << segment.start << " " << segment.end << " " << segment.received << " "
+               << (segment.done ? 1 : 0) << "\n";
+    }
+
+    stream.flush();
+
+    if (!segmentsFile.commit())
+    {
+        DEBUG_MESSAGE_EX_WARNING("Failed to save download segments: "
+                                 << segmentsFile.fileName().toStdString());
+    }
+}
+
+bool IpFreelyDownloadManager::LoadSegments(Download& download)
+{
+    QFile segmentsFile(SegmentsPath(download));
+
+    if (!segmentsFile.exists())
+    {
+        return false;
+    }
+
+    std::vector<Segment> segments;
+    int64_t              totalBytes    = -1;
+    int64_t              receivedBytes = 0;
+
+    if (segmentsFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        QTextStream stream(&segmentsFile);
+        stream >> totalBytes;
+
+        while (stream.status() == QTextStream::Ok)
+        {
+            Segment segment;
+            int     done = 0;
+            stream >> segment.start >> segment.end >> segment.received >> done;
+
+            if (stream.status() != QTextStream::Ok)
+            {
+                break;
+            }
+
+            segment.done = done != 0;
+            receivedBytes += segment.received;
+            segments.push_back(std::move(segment));
+        }
+
+        segmentsFile.close();
+    }
+
+    // Without matching progress the partial file's content is unknown, so start again.
+    if (segments.empty() || (totalBytes <= 0) ||
+        (QFileInfo(PartPath(download)).size() != totalBytes))
+    {
+        DEBUG_MESSAGE_EX_WARNING("Discarding invalid download segments: "
+                                 << segmentsFile.fileName().toStdString());
+        QFile::remove(segmentsFile.fileName());
+        QFile::remove(PartPath(download));
+        return false;
+    }
+
+    // Segments are only created for a file with a validator, without it they cannot be trusted.
+    if (download.validator.isEmpty())
+    {
+        DEBUG_MESSAGE_EX_WARNING("Discarding download segments without a validator: "
+                                 << segmentsFile.fileName().toStdString());
+        QFile::remove(segmentsFile.fileName());
+        QFile::remove(PartPath(download));
+        return false;
+    }
+
+    download.segments           = std::move(segments);
+    download.probed             = true;
+    download.info.totalBytes    = totalBytes;
+    download.info.receivedBytes = receivedBytes;
+    return true;
+}
+
+void IpFreelyDownloadManager::SaveValidator(Download const& download)
+{
+    if (download.validator.isEmpty())
+    {
+        QFile::remove(ValidatorPath(download));
+        return;
+    }
+
+    QSaveFile validatorFile(ValidatorPath(download));
+
+    if (!validatorFile.open(QIODevice::WriteOnly) ||
+        (validatorFile.write(download.validator) != download.validator.size()) ||
+        !validatorFile.commit())
+    {
+        DEBUG_MESSAGE_EX_WARNING("Failed to save download validator: "
+                                 << validatorFile.fileName().toStdString());
+    }
+}
+
+void IpFreelyDownloadManager::LoadValidator(Download& download)
+{
+    QFile validatorFile(ValidatorPath(download));
+    download.validator.clear();
+
+    if (validatorFile.open(QIODevice::ReadOnly))
+    {
+        download.validator = validatorFile.readAll().trimmed();
+    }
+}
+
+bool IpFreelyDownloadManager::IsFinished(eDownloadState const state) noexcept
+{
+    return (state == eDownloadState::completed) || (state == eDownloadState::failed) ||
+           (state == eDownloadState::cancelled);
+}
+
+QString IpFreelyDownloadManager::PartPath(Download const& download)
+{
+    return download.info.filePath + ".part";
+}
+
+QString IpFreelyDownloadManager::SegmentsPath(Download const& download)
+{
+    return download.info.filePath + ".part.segments";
+}
+
+QString IpFreelyDownloadManager::ValidatorPath(Download const& download)
+{
+    return download.info.filePath + ".part.validator";
+}
+
+} // namespace ipfreely
@@ -0,0 +1,343 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+
+/*!
+ * \file IpFreelyDownloadManager.h
+ * \brief File containing declaration of the HTTP download manager.
+ */
+#ifndef IPFREELYDOWNLOADMANAGER_H
+#define IPFREELYDOWNLOADMANAGER_H
+
+#include <QObject>
+#include <QUrl>
+#include <QString>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <map>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Forward declarations.
+class QNetworkAccessManager;
+class QNetworkReply;
+class QFile;
+class QTimer;
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*! \brief Download states. */
+enum class eDownloadState
+{
+    queued,
+    inProgress,
+    paused,
+    completed,
+    failed,
+    cancelled
+};
+
+/*! \brief Structure describing a download's progress. */
+struct DownloadInfo
+{
+    /*! \brief The URL being downloaded. */
+    QUrl url{};
+    /*! \brief The file the download is saved to. */
+    QString filePath{};
+    /*! \brief The download's state. */
+    eDownloadState state{eDownloadState::queued};
+    /*! \brief Bytes received so far, including any received before the download resumed. */
+    int64_t receivedBytes{0};
+    /*! \brief The file's size in bytes, -1 if not yet known. */
+    int64_t totalBytes{-1};
+    /*! \brief Bytes received over the last second. */
+    int64_t bytesPerSec{0};
+    /*! \brief Why the download failed, empty unless it has failed. */
+    QString errorString{};
+};
+
+/*! \brief Structure holding the limits applied to a host's downloads. */
+struct HostLimits
+{
+    /*! \brief Maximum simultaneous connections to the host, segments count as connections. */
+    int maxConnections{2};
+    /*! \brief Maximum bytes per second received from the host, 0 means no limit. */
+    int64_t maxBytesPerSec{0};
+};
+
+/*!
+ * \brief Class defining a queued, resumable HTTP download manager.
+ *
+ * Downloads are queued and started as limits allow: a maximum number of active downloads
+ * overall, and a maximum number of connections and bandwidth per host. Data is written to
+ * disk as it arrives into "<file>.part", which is renamed to the file once complete.
+ *
+ * An interrupted download keeps its partial file and resumes from where it stopped using an
+ * HTTP Range request, whether it was paused, failed or the application was restarted. Large
+ * files on servers that accept ranges can be split into segments downloaded in parallel;
+ * their progress is kept in "<file>.part.segments" so they resume too.
+ *
+ * The file's ETag, or else its Last-Modified date, is kept in "<file>.part.validator" and sent
+ * as If-Range with every range request, so a file that changed on the server since the partial
+ * download, e.g. a camera recording over the same name, is downloaded again from the start
+ * rather than having its new end joined to its old start. Without a validator a partial file
+ * cannot be checked, so it is discarded.
+ *
+ * The manager must be used from the thread it lives in, which needs a running event loop.
+ * Pause(), Resume(), Cancel() and Remove() ignore unknown download IDs, so they are safe to
+ * call for a download that has just been removed.
+ */
+class IpFreelyDownloadManager final : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+     * \brief IpFreelyDownloadManager constructor.
+     * \param[in] parent - (Optional) The parent QObject.
+     */
+    explicit IpFreelyDownloadManager(QObject* parent = nullptr);
+
+    /*! \brief IpFreelyDownloadManager destructor, active downloads are paused. */
+    virtual ~IpFreelyDownloadManager();
+
+    /*!
+     * \brief SetMaxActiveDownloads sets how many downloads may run at once.
+     * \param[in] maxDownloads - The maximum number of active downloads, at least 1.
+     */
+    void SetMaxActiveDownloads(int const maxDownloads);
+
+    /*!
+     * \brief SetDefaultHostLimits sets the limits for hosts without their own limits.
+     * \param[in] limits - The connection and bandwidth limits.
+     */
+    void SetDefaultHostLimits(HostLimits const& limits);
+
+    /*!
+     * \brief SetHostLimits sets the limits for one host.
+     * \param[in] host - The host name or address, as given in download URLs.
+     * \param[in] limits - The connection and bandwidth limits.
+     *
+     * Changes apply to downloads already running, e.g. to throttle a camera while it records.
+     */
+    void SetHostLimits(QString const& host, HostLimits const& limits);
+
+    /*!
+     * \brief SetSegmentation sets when files are downloaded in parallel segments.
+     * \param[in] minFileBytes - Files at least this size are split into segments.
+     * \param[in] maxSegments - The maximum number of segments per file, 1 to never split.
+     *
+     * A file's size is found with a HEAD request before it is downloaded, so segmentation
+     * costs an extra request per file and is best disabled for hosts with many small files.
+     */
+    void SetSegmentation(int64_t const minFileBytes, int const maxSegments);
+
+    /*!
+     * \brief Enqueue adds a download to the queue.
+     * \param[in] url - The URL to download, it may contain a username and password.
+     * \param[in] filePath - The file to save it to, replaced once the download completes.
+     * \param[in] discardPartial - Whether to delete any partial download of the file first,
+     * e.g. because the file is known to have changed since it was started.
+     * \return The download's ID.
+     */
+    int Enqueue(QUrl const& url, QString const& filePath, bool const discardPartial = false);
+
+    /*!
+     * \brief Pause stops a queued or active download, keeping what has been received.
+     * \param[in] downloadId - The download's ID.
+     */
+    void Pause(int const downloadId);
+
+    /*!
+     * \brief Resume queues a paused or failed download again.
+     * \param[in] downloadId - The download's ID.
+     */
+    void Resume(int const downloadId);
+
+    /*!
+     * \brief Cancel stops a download and deletes what has been received.
+     * \param[in] downloadId - The download's ID.
+     */
+    void Cancel(int const downloadId);
+
+    /*!
+     * \brief Remove forgets a download, stopping it first if it is not finished.
+     * \param[in] downloadId - The download's ID.
+     *
+     * Partial files of removed downloads are kept so they can be resumed by enqueuing the
+     * same file again.
+     */
+    void Remove(int const downloadId);
+
+    /*!
+     * \brief Info gives access to a download's progress.
+     * \param[in] downloadId - The download's ID.
+     * \return The download's progress, throws std::invalid_argument if the ID is unknown.
+     */
+    DownloadInfo Info(int const downloadId) const;
+
+    /*!
+     * \brief IsIdle tells if there are no queued or active downloads.
+     * \return True if idle, false otherwise.
+     */
+    bool IsIdle() const noexcept;
+
+signals:
+    /*!
+     * \brief DownloadChanged is emitted when a download's state changes and, while it is
+     * active, as its progress changes at most ten times a second.
+     * \param[in] downloadId - The download's ID.
+     */
+    void DownloadChanged(int downloadId);
+
+    /*!
+     * \brief DownloadFinished is emitted when a download completes, fails or is cancelled.
+     * \param[in] downloadId - The download's ID.
+     */
+    void DownloadFinished(int downloadId);
+
+    /*! \brief Idle is emitted when the last queued or active download finishes. */
+    void Idle();
+
+private:
+    /*! \brief Structure holding a byte range of a download and its transfer. */
+    struct Segment
+    {
+        /*! \brief Offset of the segment's first byte. */
+        int64_t start{0};
+        /*! \brief Offset of the segment's last byte, -1 for the rest of the file. */
+        int64_t end{-1};
+        /*! \brief Bytes of the segment received so far. */
+        int64_t received{0};
+        /*! \brief Whether every byte of the segment has been received. */
+        bool done{false};
+        /*! \brief Failed attempts since the segment last received data. */
+        int retries{0};
+        /*! \brief The segment's active request, null while not transferring. */
+        QNetworkReply* reply{nullptr};
+        /*! \brief Whether the active request's response has been checked. */
+        bool checked{false};
+        /*! \brief When the active request last received data, in manager clock ms. */
+        int64_t lastActivityMs{0};
+        /*! \brief When the segment may be retried after a failure, in manager clock ms. */
+        int64_t retryAtMs{0};
+        /*! \brief The partial file, open while transferring. */
+        std::unique_ptr<QFile> file{};
+    };
+
+    /*! \brief Structure holding a download's state. */
+    struct Download
+    {
+        /*! \brief The download's public progress. */
+        DownloadInfo info{};
+        /*! \brief The host the download's connections count against. */
+        QString host{};
+        /*! \brief The size probe's active request, null if not probing. */
+        QNetworkReply* probe{nullptr};
+        /*! \brief Whether the file's size and range support have been probed. */
+        bool probed{false};
+        /*! \brief The download's byte ranges, empty until it first starts. */
+        std::vector<Segment> segments{};
+        /*! \brief The file's ETag or Last-Modified date, sent as If-Range, empty if unknown. */
+        QByteArray validator{};
+        /*! \brief Times the download restarted because the file changed on the server. */
+        int restarts{0};
+        /*! \brief Bytes received since the speed was last measured. */
+        int64_t recentBytes{0};
+        /*! \brief Whether DownloadChanged is pending for the download. */
+        bool changed{false};
+    };
+
+    /*! \brief Structure holding a host's limits and usage. */
+    struct HostState
+    {
+        /*! \brief The host's limits. */
+        HostLimits limits{};
+        /*! \brief Whether the limits were set for this host rather than by default. */
+        bool customLimits{false};
+        /*! \brief Connections in use. */
+        int connections{0};
+        /*! \brief Bytes that may still be read before the next tick. */
+        int64_t budget{0};
+    };
+
+private:
+    Download*      Find(int const downloadId);
+    HostState&     Host(QString const& host);
+    void           Update();
+    void           StartDownloads();
+    void           StartDownload(int const downloadId, Download& download);
+    void           ProbeFinished(int const downloadId, QNetworkReply* reply);
+    bool           CreateSegments(int const downloadId, Download& download,
+                                  bool const acceptsRanges);
+    void           StartSegments(int const downloadId, Download& download);
+    void           StartSegment(int const downloadId, Download& download, size_t const index);
+    void           SegmentReadyRead(int const downloadId, size_t const index,
+                                    QNetworkReply* reply);
+    void           SegmentFinished(int const downloadId, size_t const index,
+                                   QNetworkReply* reply);
+    bool           CheckResponse(int const downloadId, Download& download, Segment& segment);
+    void           ReadSegment(int const downloadId, Download& download, Segment& segment,
+                               bool const ignoreBudget);
+    void           RetrySegment(int const downloadId, Download& download, Segment& segment,
+                                QString const& error, bool const transient);
+    void           RestartDownload(int const downloadId, Download& download,
+                                   QString const& reason, bool const reprobe);
+    void           CompleteDownload(int const downloadId, Download& download);
+    void           FailDownload(int const downloadId, Download& download, QString const& error);
+    void           StopTransfers(Download& download);
+    void           ReleaseConnection(QString const& host);
+    void           SetState(int const downloadId, Download& download,
+                            eDownloadState const state);
+    void           NotifyChanged(int const downloadId, Download& download);
+    void           FlushSignals();
+    void           OnTick();
+    static void    SaveSegments(Download const& download);
+    static bool    LoadSegments(Download& download);
+    static void    SaveValidator(Download const& download);
+    static void    LoadValidator(Download& download);
+    static bool    IsFinished(eDownloadState const state) noexcept;
+    static QString PartPath(Download const& download);
+    static QString SegmentsPath(Download const& download);
+    static QString ValidatorPath(Download const& download);
+
+private:
+    QNetworkAccessManager*       m_network;
+    QTimer*                      m_tickTimer;
+    QElapsedTimer                m_clock;
+    int64_t                      m_lastSpeedMs;
+    int                          m_maxActiveDownloads;
+    HostLimits                   m_defaultLimits;
+    int64_t                      m_segmentMinBytes;
+    int                          m_maxSegments;
+    int                          m_nextDownloadId;
+    bool                         m_wasIdle;
+    std::map<int, Download>      m_downloads;
+    std::map<QString, HostState> m_hosts;
+    std::vector<int>             m_pendingChanged;
+    std::vector<int>             m_pendingFinished;
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYDOWNLOADMANAGER_H
@@ -75,35 +75,48 @@
 #include "ui_IpFreelyDownloadWidget.h"
 #include <QFileInfo>
 #include <QUrl>
-#include <QWebEngineDownloadItem>
+#include "IpFreelyDownloadManager.h"
 
-IpFreelyDownloadWidget::IpFreelyDownloadWidget(QWebEngineDownloadItem* download, QWidget* parent)
+using ipfreely::eDownloadState;
+
+IpFreelyDownloadWidget::IpFreelyDownloadWidget(ipfreely::IpFreelyDownloadManager* downloadManager,
+                                               int const downloadId, QWidget* parent)
     : QFrame(parent)
     , ui(new Ui::IpFreelyDownloadWidget)
-    , m_download(download)
-    , m_timeAdded(QTime::currentTime())
+    , m_downloadManager(downloadManager)
+    , m_downloadId(downloadId)
 {
     ui->setupUi(this);
 
-    ui->dstName->setText(QFileInfo(m_download->path()).fileName());
-    ui->srcUrl->setText(m_download->url().toDisplayString());
+    auto const info = m_downloadManager->Info(m_downloadId);
+    ui->dstName->setText(QFileInfo(info.filePath).fileName());
+    ui->srcUrl->setText(info.url.toDisplayString(QUrl::RemoveUserInfo));
 
-    connect(ui->cancelButton, &QPushButton::clicked, [this](bool) {
-        if (m_download->state() == QWebEngineDownloadItem::DownloadInProgress)
-            m_download->cancel();
+    connect(ui->pauseButton, &QPushButton::clicked, [this](bool) {
+        auto const state = m_downloadManager->Info(m_downloadId).state;
+
+        if ((state == eDownloadState::queued) || (state == eDownloadState::inProgress))
+            m_downloadManager->Pause(m_downloadId);
         else
-            emit removeClicked(this);
+            m_downloadManager->Resume(m_downloadId);
     });
 
-    connect(m_download,
-            &QWebEngineDownloadItem::downloadProgress,
-            this,
-            &IpFreelyDownloadWidget::updateWidget);
+    connect(ui->cancelButton, &QPushButton::clicked, [this](bool) {
+        auto const state = m_downloadManager->Info(m_downloadId).state;
+
+        if ((state == eDownloadState::completed) || (state == eDownloadState::cancelled))
+            emit removeClicked(this);
+        else
+            m_downloadManager->Cancel(m_downloadId);
+    });
 
-    connect(m_download,
-            &QWebEngineDownloadItem::stateChanged,
+    connect(m_downloadManager,
+            &ipfreely::IpFreelyDownloadManager::DownloadChanged,
             this,
-            &IpFreelyDownloadWidget::updateWidget);
+            [this](int downloadId) {
+                if (downloadId == m_downloadId)
+                    updateWidget();
+            });
 
     updateWidget();
 }
@@ -113,6 +126,11 @@ IpFreelyDownloadWidget::~IpFreelyDownloadWidget()
     delete ui;
 }
 
+int IpFreelyDownloadWidget::DownloadId() const noexcept
+{
+    return m_downloadId;
+}
+
 inline QString IpFreelyDownloadWidget::withUnit(qreal bytes)
 {
     if (bytes < (1 << 10))
@@ -135,18 +153,23 @@ inline QString IpFreelyDownloadWidget::withUnit(qreal bytes)
 
 void IpFreelyDownloadWidget::updateWidget()
 {
-    qreal totalBytes     = m_download->totalBytes();
-    qreal receivedBytes  = m_download->receivedBytes();
-    qreal bytesPerSecond = receivedBytes / m_timeAdded.elapsed() * 1000;
+    auto const info           = m_downloadManager->Info(m_downloadId);
+    qreal      totalBytes     = info.totalBytes;
+    qreal      receivedBytes  = info.receivedBytes;
+    qreal      bytesPerSecond = info.bytesPerSec;
 
-    auto state = m_download->state();
-    switch (state)
+    switch (info.state)
     {
-    case QWebEngineDownloadItem::DownloadRequested:
-        Q_UNREACHABLE();
+    case eDownloadState::queued:
+        ui->progressBar->setValue(0);
+        ui->progressBar->setDisabled(false);
+        ui->progressBar->setFormat(tr("queued"));
+        ui->pauseButton->setText(tr("Pause"));
+        ui->pauseButton->setEnabled(true);
+        ui->cancelButton->setText(tr("Cancel"));
         break;
-    case QWebEngineDownloadItem::DownloadInProgress:
-        if (totalBytes >= 0)
+    case eDownloadState::inProgress:
+        if (totalBytes > 0)
         {
             ui->progressBar->setValue(qRound(100 * receivedBytes / totalBytes));
             ui->progressBar->setDisabled(false);
@@ -163,27 +186,37 @@ void IpFreelyDownloadWidget::updateWidget()
                                            .arg(withUnit(receivedBytes))
                                            .arg(withUnit(bytesPerSecond)));
         }
+        ui->pauseButton->setText(tr("Pause"));
+        ui->pauseButton->setEnabled(true);
+        ui->cancelButton->setText(tr("Cancel"));
+        break;
+    case eDownloadState::paused:
+        ui->progressBar->setValue(totalBytes > 0 ? qRound(100 * receivedBytes / totalBytes) : 0);
+        ui->progressBar->setDisabled(true);
+        ui->progressBar->setFormat(tr("paused - %1 downloaded").arg(withUnit(receivedBytes)));
+        ui->pauseButton->setText(tr("Resume"));
+        ui->pauseButton->setEnabled(true);
+        ui->cancelButton->setText(tr("Cancel"));
         break;
-    case QWebEngineDownloadItem::DownloadCompleted:
+    case eDownloadState::completed:
         ui->progressBar->setValue(100);
         ui->progressBar->setDisabled(true);
-        ui->progressBar->setFormat(tr("completed - %1 downloaded - %2/s")
-                                       .arg(withUnit(receivedBytes))
-                                       .arg(withUnit(bytesPerSecond)));
+        ui->progressBar->setFormat(tr("completed - %1 downloaded").arg(withUnit(receivedBytes)));
         emit removeClicked(this);
         break;
-    case QWebEngineDownloadItem::DownloadCancelled:
+    case eDownloadState::cancelled:
         ui->progressBar->setValue(0);
         ui->progressBar->setDisabled(true);
-        ui->progressBar->setFormat(tr("cancelled - %1 downloaded - %2/s")
-                                       .arg(withUnit(receivedBytes))
-                                       .arg(withUnit(bytesPerSecond)));
+        ui->progressBar->setFormat(tr("cancelled"));
         emit removeClicked(this);
         break;
-    case QWebEngineDownloadItem::DownloadInterrupted:
+    case eDownloadState::failed:
         ui->progressBar->setValue(0);
         ui->progressBar->setDisabled(true);
-        ui->progressBar->setFormat(tr("interrupted: %1").arg(m_download->interruptReasonString()));
+        ui->progressBar->setFormat(tr("interrupted: %1").arg(info.errorString));
+        ui->pauseButton->setText(tr("Retry"));
+        ui->pauseButton->setEnabled(true);
+        ui->cancelButton->setText(tr("Cancel"));
         break;
     }
 }
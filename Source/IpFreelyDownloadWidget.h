@@ -75,7 +75,6 @@
 #define IPFREELYDOWNLOADWIDGET_H
 
 #include <QFrame>
-#include <QTime>
 
 // Forward declarations.
 namespace Ui
@@ -83,7 +82,10 @@ namespace Ui
 class IpFreelyDownloadWidget;
 } // namespace Ui
 
-class QWebEngineDownloadItem;
+namespace ipfreely
+{
+class IpFreelyDownloadManager;
+} // namespace ipfreely
 
 /*! \brief The IpFreelyDownloadWidget class. */
 class IpFreelyDownloadWidget final : public QFrame
@@ -93,14 +95,23 @@ class IpFreelyDownloadWidget final : public QFrame
 public:
     /*!
      * \brief Initialising constructor.
-     * \param[in] download - The web download item.
+     * \param[in] downloadManager - The download manager running the download.
+     * \param[in] downloadId - The download's ID.
      * \param[in] parent - (Optional) The parent QWidget object.
      */
-    explicit IpFreelyDownloadWidget(QWebEngineDownloadItem* download, QWidget* parent = nullptr);
+    IpFreelyDownloadWidget(ipfreely::IpFreelyDownloadManager* downloadManager,
+                           int const                          downloadId,
+                           QWidget*                           parent = nullptr);
 
     /*! \brief IpFreelyDownloadWidget destructor. */
     virtual ~IpFreelyDownloadWidget();
 
+    /*!
+     * \brief DownloadId gives access to the download's ID.
+     * \return The download's ID.
+     */
+    int DownloadId() const noexcept;
+
 signals:
     /*!
      * \brief Signal removeClicked notifies a slot that we need to remove the download widget.
@@ -116,9 +127,9 @@ private:
     QString withUnit(qreal bytes);
 
 private:
-    Ui::IpFreelyDownloadWidget* ui;
-    QWebEngineDownloadItem*     m_download;
-    QTime                       m_timeAdded;
+    Ui::IpFreelyDownloadWidget*        ui;
+    ipfreely::IpFreelyDownloadManager* m_downloadManager;
+    int                                m_downloadId;
 };
 
 #endif // IPFREELYDOWNLOADWIDGET_H
@@ -0,0 +1,83 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+
+/*!
+ * \file IpFreelyFramePool.cpp
+ * \brief File containing definition of IpFreelyFramePool class.
+ */
+#include "IpFreelyFramePool.h"
+#include <algorithm>
+
+namespace ipfreely
+{
+
+namespace
+{
+
+bool IsBufferFree(cv::Mat const& buffer)
+{
+    // The pool's own reference is the only one left.
+    return buffer.u && (buffer.u->refcount == 1);
+}
+
+} // namespace
+
+IpFreelyFramePool::IpFreelyFramePool(size_t const maxBuffers)
+    : m_maxBuffers(maxBuffers)
+{
+}
+
+cv::Mat IpFreelyFramePool::Acquire(cv::Size const& size, int const type)
+{
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+
+    auto bufferIter =
+        std::find_if(m_buffers.begin(), m_buffers.end(), [&size, type](cv::Mat const& buffer) {
+            return (buffer.size() == size) && (buffer.type() == type) && IsBufferFree(buffer);
+        });
+
+    if (bufferIter != m_buffers.end())
+    {
+        return *bufferIter;
+    }
+
+    cv::Mat buffer(size, type);
+
+    if (m_buffers.size() < m_maxBuffers)
+    {
+        m_buffers.emplace_back(buffer);
+    }
+    else
+    {
+        // Recycle the slot of a free buffer of the wrong size, e.g. after the
+        // stream's resolution changed, otherwise the new buffer is not pooled.
+        bufferIter = std::find_if(m_buffers.begin(), m_buffers.end(), IsBufferFree);
+
+        if (bufferIter != m_buffers.end())
+        {
+            *bufferIter = buffer;
+        }
+    }
+
+    return buffer;
+}
+
+} // namespace ipfreely
@@ -0,0 +1,77 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+
+/*!
+ * \file IpFreelyFramePool.h
+ * \brief File containing declaration of IpFreelyFramePool class.
+ */
+#ifndef IPFREELYFRAMEPOOL_H
+#define IPFREELYFRAMEPOOL_H
+
+#include <vector>
+#include <mutex>
+#include <cstddef>
+#include <opencv2/opencv.hpp>
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*! \brief Class defining a pool of reusable video frame buffers. */
+class IpFreelyFramePool final
+{
+public:
+    /*!
+     * \brief IpFreelyFramePool constructor.
+     * \param[in] maxBuffers - Maximum number of buffers the pool keeps hold of.
+     */
+    explicit IpFreelyFramePool(size_t const maxBuffers);
+
+    /*! \brief IpFreelyFramePool destructor. */
+    ~IpFreelyFramePool() = default;
+
+    /*! \brief IpFreelyFramePool deleted copy constructor. */
+    IpFreelyFramePool(IpFreelyFramePool const&) = delete;
+
+    /*! \brief IpFreelyFramePool deleted copy assignment operator. */
+    IpFreelyFramePool& operator=(IpFreelyFramePool const&) = delete;
+
+    /*!
+     * \brief Acquire gives access to a buffer of the requested size and type.
+     * \param[in] size - The required frame size.
+     * \param[in] type - The required OpenCV matrix type, e.g. CV_8UC3.
+     * \return A matrix that nobody else is using, its contents are undefined.
+     *
+     * A pooled buffer is free again once every cv::Mat referring to it has been destroyed,
+     * so callers simply drop their matrices when done. Passing the returned matrix as the
+     * output of an OpenCV function with the same size and type writes into it in place.
+     */
+    cv::Mat Acquire(cv::Size const& size, int const type);
+
+private:
+    mutable std::mutex   m_poolMutex{};
+    size_t               m_maxBuffers{0};
+    std::vector<cv::Mat> m_buffers{};
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYFRAMEPOOL_H
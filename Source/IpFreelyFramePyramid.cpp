@@ -0,0 +1,154 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+
+/*!
+ * \file IpFreelyFramePyramid.cpp
+ * \brief File containing definition of IpFreelyFramePyramid class.
+ */
+#include "IpFreelyFramePyramid.h"
+#include <algorithm>
+#include "IpFreelyFramePool.h"
+
+namespace ipfreely
+{
+
+IpFreelyFramePyramid::IpFreelyFramePyramid(cv::Mat const& fullFrame, uint64_t const frameSequence,
+                                           std::shared_ptr<IpFreelyFramePool> const& framePool)
+    : m_frameSequence(frameSequence)
+    , m_fullSize(fullFrame.size())
+    , m_framePool(framePool)
+{
+    m_levels[ePyramidLevel::full] = fullFrame;
+}
+
+uint64_t IpFreelyFramePyramid::FrameSequence() const noexcept
+{
+    return m_frameSequence;
+}
+
+cv::Size IpFreelyFramePyramid::FullSize() const noexcept
+{
+    return m_fullSize;
+}
+
+cv::Mat IpFreelyFramePyramid::Level(ePyramidLevel const level)
+{
+    std::lock_guard<std::mutex> lock(m_levelsMutex);
+    return LevelLocked(level);
+}
+
+cv::Mat IpFreelyFramePyramid::NearestLevel(cv::Size const& size)
+{
+    std::lock_guard<std::mutex> lock(m_levelsMutex);
+    return LevelLocked(FindNearestLevel(size));
+}
+
+cv::Mat IpFreelyFramePyramid::MotionLevel(cv::Size const& size)
+{
+    std::lock_guard<std::mutex> lock(m_levelsMutex);
+
+    if (!m_motionLevel.empty() && (m_motionLevel.size() == size))
+    {
+        return m_motionLevel;
+    }
+
+    auto const sourceFrame = LevelLocked(FindNearestLevel(size));
+    cv::Mat    greyFrame;
+
+    // Convert to luma before scaling so only a single channel plane is resampled.
+    switch (sourceFrame.type())
+    {
+    case CV_8UC1:
+        greyFrame = sourceFrame;
+        break;
+    case CV_8UC4:
+        greyFrame = m_framePool->Acquire(sourceFrame.size(), CV_8UC1);
+        cv::cvtColor(sourceFrame, greyFrame, cv::COLOR_BGRA2GRAY);
+        break;
+    default:
+        greyFrame = m_framePool->Acquire(sourceFrame.size(), CV_8UC1);
+        cv::cvtColor(sourceFrame, greyFrame, cv::COLOR_BGR2GRAY);
+        break;
+    }
+
+    if (greyFrame.size() != size)
+    {
+        auto scaledFrame = m_framePool->Acquire(size, CV_8UC1);
+        cv::resize(greyFrame, scaledFrame, size, 0.0, 0.0, cv::INTER_AREA);
+        greyFrame = scaledFrame;
+    }
+
+    m_motionLevel = greyFrame;
+
+    return m_motionLevel;
+}
+
+cv::Mat IpFreelyFramePyramid::LevelLocked(ePyramidLevel const level)
+{
+    auto levelIter = m_levels.find(level);
+
+    if (levelIter != m_levels.end())
+    {
+        return levelIter->second;
+    }
+
+    // Each level is computed from the next larger one, which is itself computed lazily.
+    auto const largerFrame =
+        LevelLocked(level == ePyramidLevel::quarter ? ePyramidLevel::half : ePyramidLevel::full);
+    auto const levelSize  = LevelSize(m_fullSize, level);
+    auto       levelFrame = m_framePool->Acquire(levelSize, largerFrame.type());
+    cv::resize(largerFrame, levelFrame, levelSize, 0.0, 0.0, cv::INTER_AREA);
+    m_levels[level] = levelFrame;
+
+    return levelFrame;
+}
+
+ePyramidLevel IpFreelyFramePyramid::FindNearestLevel(cv::Size const& size) const
+{
+    for (auto level : {ePyramidLevel::quarter, ePyramidLevel::half})
+    {
+        auto const levelSize = LevelSize(m_fullSize, level);
+
+        if ((levelSize.width >= size.width) && (levelSize.height >= size.height))
+        {
+            return level;
+        }
+    }
+
+    return ePyramidLevel::full;
+}
+
+cv::Size IpFreelyFramePyramid::LevelSize(cv::Size const& fullSize, ePyramidLevel const level)
+{
+    switch (level)
+    {
+    case ePyramidLevel::half:
+        return cv::Size(std::max(fullSize.width / 2, 1), std::max(fullSize.height / 2, 1));
+    case ePyramidLevel::quarter:
+        return cv::Size(std::max(fullSize.width / 4, 1), std::max(fullSize.height / 4, 1));
+    case ePyramidLevel::full:
+        break;
+    }
+
+    return fullSize;
+}
+
+} // namespace ipfreely
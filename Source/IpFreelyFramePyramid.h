@@ -0,0 +1,129 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+
+/*!
+ * \file IpFreelyFramePyramid.h
+ * \brief File containing declaration of IpFreelyFramePyramid class.
+ */
+#ifndef IPFREELYFRAMEPYRAMID_H
+#define IPFREELYFRAMEPYRAMID_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+class IpFreelyFramePool;
+
+/*! \brief Frame pyramid level enumeration. */
+enum class ePyramidLevel
+{
+    full,
+    half,
+    quarter
+};
+
+/*! \brief Class defining a lazily computed multi-resolution pyramid of one video frame. */
+class IpFreelyFramePyramid final
+{
+public:
+    /*!
+     * \brief IpFreelyFramePyramid constructor.
+     * \param[in] fullFrame - The captured video frame at full resolution.
+     * \param[in] frameSequence - The captured video frame's sequence number.
+     * \param[in] framePool - Pool that the pyramid's level buffers are taken from.
+     *
+     * One pyramid is created per captured frame and shared by all of the frame's consumers.
+     * Levels are only computed when first asked for and then reused, so each level is
+     * computed at most once per frame however many consumers ask for it.
+     */
+    IpFreelyFramePyramid(cv::Mat const& fullFrame, uint64_t const frameSequence,
+                         std::shared_ptr<IpFreelyFramePool> const& framePool);
+
+    /*! \brief IpFreelyFramePyramid destructor. */
+    ~IpFreelyFramePyramid() = default;
+
+    /*! \brief IpFreelyFramePyramid deleted copy constructor. */
+    IpFreelyFramePyramid(IpFreelyFramePyramid const&) = delete;
+
+    /*! \brief IpFreelyFramePyramid deleted copy assignment operator. */
+    IpFreelyFramePyramid& operator=(IpFreelyFramePyramid const&) = delete;
+
+    /*!
+     * \brief FrameSequence gives access to the frame's sequence number.
+     * \return The sequence number of the frame the pyramid was built from.
+     */
+    uint64_t FrameSequence() const noexcept;
+
+    /*!
+     * \brief FullSize gives access to the full resolution frame's size.
+     * \return The frame's size.
+     */
+    cv::Size FullSize() const noexcept;
+
+    /*!
+     * \brief Level gives access to a level of the pyramid.
+     * \param[in] level - The level required.
+     * \return The level's frame in the captured frame's native format.
+     *
+     * The half level is computed from the full level and the quarter level from the half.
+     */
+    cv::Mat Level(ePyramidLevel const level);
+
+    /*!
+     * \brief NearestLevel gives access to the smallest level at least as large as a size.
+     * \param[in] size - The size the consumer will scale the level to.
+     * \return The nearest level's frame, the full level if the size is larger still.
+     */
+    cv::Mat NearestLevel(cv::Size const& size);
+
+    /*!
+     * \brief MotionLevel gives access to the motion detector's level of the pyramid.
+     * \param[in] size - The motion detector's frame size.
+     * \return An 8-bit single channel luma frame of the requested size.
+     *
+     * The luma frame is made from the nearest level, so it gets cheaper the more the motion
+     * detector shrinks frames. It is computed once and reused while the size is unchanged.
+     */
+    cv::Mat MotionLevel(cv::Size const& size);
+
+private:
+    cv::Mat         LevelLocked(ePyramidLevel const level);
+    ePyramidLevel   FindNearestLevel(cv::Size const& size) const;
+    static cv::Size LevelSize(cv::Size const& fullSize, ePyramidLevel const level);
+
+private:
+    mutable std::mutex                 m_levelsMutex{};
+    uint64_t                           m_frameSequence{0};
+    cv::Size                           m_fullSize{};
+    std::shared_ptr<IpFreelyFramePool> m_framePool{};
+    std::map<ePyramidLevel, cv::Mat>   m_levels{};
+    cv::Mat                            m_motionLevel{};
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYFRAMEPYRAMID_H
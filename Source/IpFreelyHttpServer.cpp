@@ -0,0 +1,582 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyHttpServer.cpp
+ * \brief File containing definition of IpFreelyHttpServer class.
+ */
+#include "IpFreelyHttpServer.h"
+#include <QThread>
+#include <QTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QVariant>
+#include <functional>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+#include <boost/exception/all.hpp>
+#include "IpFreelyStreamProcessor.h"
+#include "IpFreelyMetrics.h"
+#include "DebugLog/DebugLogging.h"
+
+namespace ipfreely
+{
+
+namespace
+{
+
+// Requests are a single GET line plus headers, anything larger is not one of ours.
+static constexpr qint64 MAX_REQUEST_SIZE = 8192;
+
+// How long a client has to send its request before it is disconnected.
+static constexpr int REQUEST_TIMEOUT_MS = 10000;
+
+// Dynamic property set on a client's socket once its request has been handled.
+static constexpr char const* REQUEST_HANDLED_PROPERTY = "requestHandled";
+
+// Boundary between the parts, i.e. frames, of a multipart MJPEG stream.
+static constexpr char const* MJPEG_BOUNDARY = "ipfreelyframe";
+
+/*! \brief Typedef for the function used to find a camera's stream processor. */
+typedef std::function<std::shared_ptr<IpFreelyStreamProcessor>(camera_id_t)> stream_lookup_t;
+
+/*! \brief Class defining the web server's worker, which lives on the server's thread. */
+class HttpServerWorker final : public QObject
+{
+public:
+    HttpServerWorker(uint16_t const port, QHostAddress const& bindAddress,
+                     QSize const& frameSize, int const jpegQuality, int const maxFps,
+                     stream_lookup_t const&                  streamLookup,
+                     std::shared_ptr<IpFreelyMetrics> const& metrics);
+    ~HttpServerWorker() = default;
+
+    void Start();
+
+private:
+    /*! \brief Structure holding a camera's live stream clients. */
+    struct LiveStream
+    {
+        /*! \brief The sequence number of the last frame sent to the clients. */
+        uint64_t frameSequence{0};
+        /*! \brief The connected clients. */
+        std::vector<QTcpSocket*> clients{};
+    };
+
+private:
+    void        AcceptConnections();
+    void        ReadRequest(QTcpSocket* socket);
+    void        HandleRequest(QTcpSocket* socket, QByteArray const& method, QByteArray const& path);
+    void        SendSnapshot(QTcpSocket* socket, camera_id_t const camId);
+    void        StartLiveStream(QTcpSocket* socket, camera_id_t const camId);
+    void        PublishFrames();
+    void        RemoveClient(QTcpSocket* socket);
+    static void SendResponse(QTcpSocket* socket, QByteArray const& status,
+                             QByteArray const& contentType, QByteArray const& body);
+    static void SendFrame(QTcpSocket* socket, QByteArray const& framePart);
+    static bool ParseCameraPath(QByteArray const& path, camera_id_t& camId, QByteArray& resource);
+
+private:
+    uint16_t                          m_port;
+    QHostAddress                      m_bindAddress;
+    QSize                             m_frameSize;
+    int                               m_jpegQuality;
+    int                               m_maxFps;
+    stream_lookup_t                   m_streamLookup;
+    std::shared_ptr<IpFreelyMetrics>  m_metrics;
+    QTcpServer*                       m_server;
+    QTimer*                           m_publishTimer;
+    std::map<camera_id_t, LiveStream> m_liveStreams;
+};
+
+HttpServerWorker::HttpServerWorker(uint16_t const port, QHostAddress const& bindAddress,
+                                   QSize const& frameSize, int const jpegQuality,
+                                   int const maxFps, stream_lookup_t const& streamLookup,
+                                   std::shared_ptr<IpFreelyMetrics> const& metrics)
+    : m_port(port)
+    , m_bindAddress(bindAddress)
+    , m_frameSize(frameSize)
+    , m_jpegQuality(jpegQuality)
+    , m_maxFps(std::max(maxFps, 1))
+    , m_streamLookup(streamLookup)
+    , m_metrics(metrics)
+    , m_server(nullptr)
+    , m_publishTimer(nullptr)
+{
+}
+
+void HttpServerWorker::Start()
+{
+    // Created here rather than in the constructor so they belong to the server's thread.
+    m_server       = new QTcpServer(this);
+    m_publishTimer = new QTimer(this);
+
+    m_publishTimer->setInterval(1000 / m_maxFps);
+    connect(m_publishTimer, &QTimer::timeout, this, &HttpServerWorker::PublishFrames);
+    connect(m_server, &QTcpServer::newConnection, this, &HttpServerWorker::AcceptConnections);
+
+    if (!m_server->listen(m_bindAddress, m_port))
+    {
+        DEBUG_MESSAGE_EX_ERROR("Web server failed to listen on address: "
+                               << m_bindAddress.toString().toStdString() << ", port: " << m_port
+                               << ", error: " << m_server->errorString().toStdString());
+        return;
+    }
+
+    DEBUG_MESSAGE_EX_INFO("Web server listening on address: "
+                          << m_bindAddress.toString().toStdString() << ", port: " << m_port);
+}
+
+void HttpServerWorker::AcceptConnections()
+{
+    while (m_server->hasPendingConnections())
+    {
+        auto socket = m_server->nextPendingConnection();
+
+        // Stops Qt reading more from a client than a request can hold, so a client that keeps
+        // sending data cannot make us buffer it.
+        socket->setReadBufferSize(MAX_REQUEST_SIZE);
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { ReadRequest(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            RemoveClient(socket);
+            socket->deleteLater();
+        });
+
+        QTimer::singleShot(REQUEST_TIMEOUT_MS, socket, [socket]() {
+            if (!socket->property(REQUEST_HANDLED_PROPERTY).toBool())
+            {
+                socket->abort();
+            }
+        });
+    }
+}
+
+void HttpServerWorker::ReadRequest(QTcpSocket* socket)
+{
+    if (socket->property(REQUEST_HANDLED_PROPERTY).toBool())
+    {
+        return;
+    }
+
+    auto const pending   = socket->peek(MAX_REQUEST_SIZE);
+    auto const headerEnd = pending.indexOf("\r\n\r\n");
+
+    if (headerEnd < 0)
+    {
+        if (pending.size() >= MAX_REQUEST_SIZE)
+        {
+            socket->abort();
+        }
+
+        return;
+    }
+
+    auto const request = socket->read(headerEnd + 4);
+    socket->setProperty(REQUEST_HANDLED_PROPERTY, true);
+
+    // The request line is "<method> <path> <version>", the headers are not needed.
+    auto const requestLine = request.left(request.indexOf("\r\n"));
+    auto const fields      = requestLine.split(' ');
+
+    if (fields.size() != 3)
+    {
+        SendResponse(socket, "400 Bad Request", "text/plain", "Bad request.\r\n");
+        return;
+    }
+
+    try
+    {
+        HandleRequest(socket, fields[0], fields[1]);
+    }
+    catch (...)
+    {
+        auto exceptionMsg = boost::current_exception_diagnostic_information();
+        DEBUG_MESSAGE_EX_ERROR(exceptionMsg);
+        SendResponse(socket, "500 Internal Server Error", "text/plain", "Server error.\r\n");
+    }
+}
+
+void HttpServerWorker::HandleRequest(QTcpSocket* socket, QByteArray const& method,
+                                     QByteArray const& path)
+{
+    if (method != "GET")
+    {
+        SendResponse(socket, "405 Method Not Allowed", "text/plain", "Only GET is supported.\r\n");
+        return;
+    }
+
+    if (m_metrics && (path == "/metrics"))
+    {
+        SendResponse(socket,
+                     "200 OK",
+                     "text/plain; version=0.0.4",
+                     QByteArray::fromStdString(m_metrics->Exposition()));
+        return;
+    }
+
+    camera_id_t camId = NO_CAMERA_ID;
+    QByteArray  resource;
+
+    if (ParseCameraPath(path, camId, resource))
+    {
+        if (resource == "snapshot.jpg")
+        {
+            SendSnapshot(socket, camId);
+            return;
+        }
+
+        if (resource == "live.mjpeg")
+        {
+            StartLiveStream(socket, camId);
+            return;
+        }
+    }
+
+    SendResponse(socket, "404 Not Found", "text/plain", "Not found.\r\n");
+}
+
+void HttpServerWorker::SendSnapshot(QTcpSocket* socket, camera_id_t const camId)
+{
+    auto const streamProcessor = m_streamLookup(camId);
+    QByteArray jpeg;
+
+    if (streamProcessor)
+    {
+        jpeg = streamProcessor->JpegVideoFrame(m_frameSize, m_jpegQuality);
+    }
+
+    if (jpeg.isEmpty())
+    {
+        SendResponse(
+            socket, "503 Service Unavailable", "text/plain", "Camera not connected.\r\n");
+        return;
+    }
+
+    SendResponse(socket, "200 OK", "image/jpeg", jpeg);
+}
+
+void HttpServerWorker::StartLiveStream(QTcpSocket* socket, camera_id_t const camId)
+{
+    if (!m_streamLookup(camId))
+    {
+        SendResponse(
+            socket, "503 Service Unavailable", "text/plain", "Camera not connected.\r\n");
+        return;
+    }
+
+    QByteArray header = "HTTP/1.1 200 OK\r\n"
+                        "Content-Type: multipart/x-mixed-replace; boundary=";
+    header += MJPEG_BOUNDARY;
+    header += "\r\n"
+              "Cache-Control: no-cache, no-store\r\n"
+              "Pragma: no-cache\r\n"
+              "Connection: close\r\n"
+              "\r\n";
+    socket->write(header);
+
+    auto& liveStream = m_liveStreams[camId];
+    liveStream.clients.emplace_back(socket);
+
+    // Send the current frame straight away rather than making the new client wait for the
+    // next one. Resending it to the other clients is harmless.
+    liveStream.frameSequence = 0;
+
+    if (!m_publishTimer->isActive())
+    {
+        m_publishTimer->start();
+    }
+}
+
+void HttpServerWorker::PublishFrames()
+{
+    for (auto& liveStreamEntry : m_liveStreams)
+    {
+        auto const camId      = liveStreamEntry.first;
+        auto&      liveStream = liveStreamEntry.second;
+
+        // Iterate over a copy as a client disconnecting removes itself from the stream.
+        auto const clients = liveStream.clients;
+
+        if (clients.empty())
+        {
+            continue;
+        }
+
+        auto const streamProcessor = m_streamLookup(camId);
+
+        if (!streamProcessor)
+        {
+            // The camera was disconnected, end its streams so clients can reconnect later.
+            for (auto client : clients)
+            {
+                client->disconnectFromHost();
+            }
+
+            continue;
+        }
+
+        if (streamProcessor->VideoFrameSequence() == liveStream.frameSequence)
+        {
+            continue;
+        }
+
+        uint64_t   frameSequence = 0;
+        QByteArray jpeg;
+
+        try
+        {
+            jpeg = streamProcessor->JpegVideoFrame(m_frameSize, m_jpegQuality, &frameSequence);
+        }
+        catch (...)
+        {
+            auto exceptionMsg = boost::current_exception_diagnostic_information();
+            DEBUG_MESSAGE_EX_ERROR(exceptionMsg);
+        }
+
+        if (jpeg.isEmpty() || (frameSequence == liveStream.frameSequence))
+        {
+            continue;
+        }
+
+        liveStream.frameSequence = frameSequence;
+
+        // Build the part once and send the same bytes to every client.
+        QByteArray framePart = "--";
+        framePart += MJPEG_BOUNDARY;
+        framePart += "\r\nContent-Type: image/jpeg\r\nContent-Length: ";
+        framePart += QByteArray::number(jpeg.size());
+        framePart += "\r\n\r\n";
+        framePart += jpeg;
+        framePart += "\r\n";
+
+        for (auto client : clients)
+        {
+            SendFrame(client, framePart);
+        }
+    }
+
+    for (auto liveStreamIter = m_liveStreams.begin(); liveStreamIter != m_liveStreams.end();)
+    {
+        if (liveStreamIter->second.clients.empty())
+        {
+            liveStreamIter = m_liveStreams.erase(liveStreamIter);
+        }
+        else
+        {
+            ++liveStreamIter;
+        }
+    }
+
+    if (m_liveStreams.empty())
+    {
+        m_publishTimer->stop();
+    }
+}
+
+void HttpServerWorker::RemoveClient(QTcpSocket* socket)
+{
+    for (auto& liveStream : m_liveStreams)
+    {
+        auto& clients = liveStream.second.clients;
+        clients.erase(std::remove(clients.begin(), clients.end(), socket), clients.end());
+    }
+}
+
+void HttpServerWorker::SendResponse(QTcpSocket* socket, QByteArray const& status,
+                                    QByteArray const& contentType, QByteArray const& body)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Cache-Control: no-cache, no-store\r\n"
+                "Connection: close\r\n"
+                "\r\n";
+    response += body;
+
+    socket->write(response);
+
+    // Closes the connection once the response has been written.
+    socket->disconnectFromHost();
+}
+
+void HttpServerWorker::SendFrame(QTcpSocket* socket, QByteArray const& framePart)
+{
+    // Data still queued means the client has not taken the previous frame yet, so drop this
+    // one rather than letting the client's buffer grow.
+    if (socket->bytesToWrite() > 0)
+    {
+        return;
+    }
+
+    socket->write(framePart);
+}
+
+bool HttpServerWorker::ParseCameraPath(QByteArray const& path, camera_id_t& camId,
+                                       QByteArray& resource)
+{
+    // Paths have the form "/cam<ID>/<resource>", optionally followed by a query string.
+    static QByteArray const CAMERA_PREFIX = "/cam";
+
+    auto const queryStart = path.indexOf('?');
+    auto const pathOnly   = queryStart < 0 ? path : path.left(queryStart);
+
+    if (!pathOnly.startsWith(CAMERA_PREFIX))
+    {
+        return false;
+    }
+
+    auto const separator = pathOnly.indexOf('/', CAMERA_PREFIX.size());
+
+    if (separator < 0)
+    {
+        return false;
+    }
+
+    bool       ok = false;
+    auto const id =
+        pathOnly.mid(CAMERA_PREFIX.size(), separator - CAMERA_PREFIX.size()).toInt(&ok);
+
+    if (!ok || (id <= NO_CAMERA_ID))
+    {
+        return false;
+    }
+
+    camId    = id;
+    resource = pathOnly.mid(separator + 1);
+    return true;
+}
+
+} // namespace
+
+IpFreelyHttpServer::IpFreelyHttpServer(uint16_t const port, std::string const& bindAddress,
+                                       QSize const& frameSize, int const jpegQuality,
+                                       int const maxFps,
+                                       std::shared_ptr<IpFreelyMetrics> const& metrics)
+    : m_thread(new QThread)
+{
+    QHostAddress address;
+
+    if (!address.setAddress(QString::fromStdString(bindAddress)))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid web server bind address."));
+    }
+
+    auto worker = new HttpServerWorker(
+        port,
+        address,
+        frameSize,
+        jpegQuality,
+        maxFps,
+        [this](camera_id_t const camId) { return FindStreamProcessor(camId); },
+        metrics);
+
+    // The worker, its sockets and its timers all live on the server's thread, so serving
+    // clients and encoding frames never blocks the GUI or the stream processors.
+    worker->moveToThread(m_thread.get());
+    QObject::connect(m_thread.get(), &QThread::started, worker, &HttpServerWorker::Start);
+    QObject::connect(m_thread.get(), &QThread::finished, worker, &QObject::deleteLater);
+
+    m_thread->setObjectName("IpFreelyHttpServer");
+    m_thread->start();
+}
+
+IpFreelyHttpServer::~IpFreelyHttpServer()
+{
+    // The worker is deleted, closing its connections, as its thread finishes.
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void IpFreelyHttpServer::SetStreamProcessor(
+    camera_id_t const camId, std::shared_ptr<IpFreelyStreamProcessor> const& streamProcessor)
+{
+    std::unique_lock<std::mutex> lock(m_streamsMutex);
+    m_streamProcessors.erase(camId);
+    WaitForStreamUsers(lock, camId);
+    m_streamProcessors[camId] = streamProcessor;
+}
+
+void IpFreelyHttpServer::RemoveStreamProcessor(camera_id_t const camId)
+{
+    std::unique_lock<std::mutex> lock(m_streamsMutex);
+    m_streamProcessors.erase(camId);
+    WaitForStreamUsers(lock, camId);
+}
+
+std::shared_ptr<IpFreelyStreamProcessor>
+IpFreelyHttpServer::FindStreamProcessor(camera_id_t const camId)
+{
+    std::shared_ptr<IpFreelyStreamProcessor> streamProcessor;
+
+    {
+        std::lock_guard<std::mutex> lock(m_streamsMutex);
+        auto                        streamProcIter = m_streamProcessors.find(camId);
+
+        if (streamProcIter != m_streamProcessors.end())
+        {
+            streamProcessor = streamProcIter->second.lock();
+        }
+
+        if (!streamProcessor)
+        {
+            return {};
+        }
+
+        ++m_streamUsers[camId];
+    }
+
+    // The server's thread gets its own reference, which drops the stream processor before
+    // releasing it, so RemoveStreamProcessor() knows when the server is done with it.
+    auto const rawStreamProcessor = streamProcessor.get();
+
+    return std::shared_ptr<IpFreelyStreamProcessor>(
+        rawStreamProcessor,
+        [this, camId, streamProcessor](IpFreelyStreamProcessor*) mutable {
+            streamProcessor.reset();
+            ReleaseStreamProcessor(camId);
+        });
+}
+
+void IpFreelyHttpServer::ReleaseStreamProcessor(camera_id_t const camId)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_streamsMutex);
+        auto                        usersIter = m_streamUsers.find(camId);
+
+        if ((usersIter != m_streamUsers.end()) && (--usersIter->second == 0))
+        {
+            m_streamUsers.erase(usersIter);
+        }
+    }
+
+    m_streamsReleased.notify_all();
+}
+
+void IpFreelyHttpServer::WaitForStreamUsers(std::unique_lock<std::mutex>& lock,
+                                            camera_id_t const             camId)
+{
+    m_streamsReleased.wait(lock, [this, camId] { return m_streamUsers.count(camId) == 0; });
+}
+
+} // namespace ipfreely
@@ -0,0 +1,127 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyHttpServer.h
+ * \brief File containing declaration of IpFreelyHttpServer class.
+ */
+#ifndef IPFREELYHTTPSERVER_H
+#define IPFREELYHTTPSERVER_H
+
+#include <QSize>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <string>
+#include "IpFreelyCameraDatabase.h"
+
+// Forward declarations.
+class QThread;
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+class IpFreelyStreamProcessor;
+class IpFreelyMetrics;
+
+/*! \brief Class defining a built-in web server that fans out the camera streams. */
+class IpFreelyHttpServer final
+{
+public:
+    /*!
+     * \brief IpFreelyHttpServer constructor.
+     * \param[in] port - The TCP port to listen on.
+     * \param[in] bindAddress - The local IP address to listen on, e.g. "127.0.0.1".
+     * \param[in] frameSize - The size served frames must fit within.
+     * \param[in] jpegQuality - The JPEG quality of served frames, from 1 to 100.
+     * \param[in] maxFps - The maximum frame rate of the live streams.
+     * \param[in] metrics - (Optional) The metrics registry to serve.
+     *
+     * Each camera is served at two URLs:
+     *
+     * /camN/snapshot.jpg - the camera's current frame as a JPEG image.
+     * /camN/live.mjpeg - the camera's live video as a multipart MJPEG stream.
+     *
+     * where N is the camera's ID. Every frame is encoded once, by the server's own thread, and
+     * the same bytes are sent to every client, so extra viewers never open extra sessions to
+     * the camera. A frame is dropped for a client that has not yet taken the previous frame, so
+     * a slow client gets a lower frame rate rather than an ever growing buffer.
+     *
+     * If a metrics registry is given it is served at /metrics for Prometheus to scrape.
+     *
+     * Clients are not authenticated, so anyone who can reach the bind address can view the
+     * cameras. Binding to the loopback address keeps the server private to this computer.
+     * Throws std::invalid_argument if the bind address is not an IP address.
+     */
+    IpFreelyHttpServer(uint16_t const port, std::string const& bindAddress,
+                       QSize const& frameSize, int const jpegQuality, int const maxFps,
+                       std::shared_ptr<IpFreelyMetrics> const& metrics = {});
+
+    /*! \brief IpFreelyHttpServer destructor. */
+    ~IpFreelyHttpServer();
+
+    /*! \brief IpFreelyHttpServer deleted copy constructor. */
+    IpFreelyHttpServer(IpFreelyHttpServer const&) = delete;
+
+    /*! \brief IpFreelyHttpServer deleted copy assignment operator. */
+    IpFreelyHttpServer& operator=(IpFreelyHttpServer const&) = delete;
+
+    /*!
+     * \brief SetStreamProcessor sets the stream processor serving a camera's frames.
+     * \param[in] camId - The camera's ID.
+     * \param[in] streamProcessor - The camera's stream processor.
+     *
+     * The server does not keep the stream processor alive, once it is destroyed the camera is
+     * reported as not connected until a new stream processor is set. Any stream processor
+     * previously set for the camera is finished with by the server before this returns.
+     */
+    void SetStreamProcessor(camera_id_t const                               camId,
+                            std::shared_ptr<IpFreelyStreamProcessor> const& streamProcessor);
+
+    /*!
+     * \brief RemoveStreamProcessor stops serving a camera's frames.
+     * \param[in] camId - The camera's ID.
+     *
+     * Waits for the server's thread to finish with the camera's stream processor, e.g. an
+     * encode in progress, so must be called before the owner drops its reference. The owner's
+     * reference is then the last one and the stream processor is destroyed on its thread.
+     */
+    void RemoveStreamProcessor(camera_id_t const camId);
+
+private:
+    std::shared_ptr<IpFreelyStreamProcessor> FindStreamProcessor(camera_id_t const camId);
+    void                                     ReleaseStreamProcessor(camera_id_t const camId);
+    void                                     WaitForStreamUsers(std::unique_lock<std::mutex>& lock,
+                                                                camera_id_t const camId);
+
+private:
+    std::mutex                                                    m_streamsMutex;
+    std::condition_variable                                       m_streamsReleased;
+    std::map<camera_id_t, std::weak_ptr<IpFreelyStreamProcessor>> m_streamProcessors;
+    std::map<camera_id_t, int>                                    m_streamUsers;
+    std::unique_ptr<QThread>                                      m_thread;
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYHTTPSERVER_H
@@ -0,0 +1,224 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyImageUtils.h
+ * \brief File containing the image conversion and scaling helpers used by the video pipeline.
+ */
+#ifndef IPFREELYIMAGEUTILS_H
+#define IPFREELYIMAGEUTILS_H
+
+#include <QImage>
+#include <QByteArray>
+#include <QSize>
+#include <QRect>
+#include <QRectF>
+#include <vector>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+#include "IpFreelyTrace.h"
+#include "DebugLog/DebugLogging.h"
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*! \brief The utils namespace. */
+namespace utils
+{
+
+/*!
+ * \brief CvMatToQImage converts an OpenCV matrix to a QImage of the same size.
+ * \param[in] inMat - An 8-bit, 1, 3 or 4 channel matrix.
+ * \param[out] image - The 32-bit QImage, ready to paint without further conversion.
+ * \return True if converted, false if the matrix format is unsupported.
+ */
+inline bool CvMatToQImage(cv::Mat const& inMat, QImage& image)
+{
+    IPFREELY_TRACE_SCOPE("CvMatToQImage");
+
+    // We always produce one of Qt's native 32-bit raster formats so painting the image needs
+    // no further conversion. On little-endian hosts these are stored as BGRA bytes, which
+    // OpenCV can write straight into the image's buffer in a single pass.
+    static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "32-bit QImage formats must be BGRA in memory");
+
+    switch (inMat.type())
+    {
+    // 8-bit, 4 channel
+    case CV_8UC4:
+        image = QImage(inMat.cols, inMat.rows, QImage::Format_ARGB32);
+        break;
+    // 8-bit, 3 channel
+    case CV_8UC3:
+    // 8-bit, 1 channel
+    case CV_8UC1:
+        image = QImage(inMat.cols, inMat.rows, QImage::Format_RGB32);
+        break;
+    default:
+        DEBUG_MESSAGE_EX_ERROR("unsupported cv::Mat format");
+        return false;
+    }
+
+    cv::Mat imageMat(image.height(),
+                     image.width(),
+                     CV_8UC4,
+                     image.bits(),
+                     static_cast<size_t>(image.bytesPerLine()));
+
+    switch (inMat.type())
+    {
+    case CV_8UC4:
+        inMat.copyTo(imageMat);
+        break;
+    case CV_8UC3:
+        cv::cvtColor(inMat, imageMat, cv::COLOR_BGR2BGRA);
+        break;
+    default:
+        cv::cvtColor(inMat, imageMat, cv::COLOR_GRAY2BGRA);
+        break;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief ResizeMat scales a matrix to the given size.
+ * \param[in] inMat - The matrix to scale.
+ * \param[in] size - The required size.
+ * \return The scaled matrix, or the input matrix if it is already the required size.
+ */
+inline cv::Mat ResizeMat(cv::Mat const& inMat, QSize const& size)
+{
+    if ((size.width() == inMat.cols) && (size.height() == inMat.rows))
+    {
+        return inMat;
+    }
+
+    auto const interpolation = size.width() < inMat.cols ? cv::INTER_AREA : cv::INTER_LINEAR;
+    cv::Mat    scaledMat;
+    cv::resize(
+        inMat, scaledMat, cv::Size(size.width(), size.height()), 0.0, 0.0, interpolation);
+
+    return scaledMat;
+}
+
+/*!
+ * \brief CvMatToDisplayImage scales and converts an OpenCV matrix to a QImage.
+ * \param[in] inMat - An 8-bit, 1, 3 or 4 channel matrix.
+ * \param[in] displaySize - The required image size.
+ * \param[out] image - The 32-bit QImage.
+ * \return True if converted, false if the matrix format is unsupported.
+ */
+inline bool CvMatToDisplayImage(cv::Mat const& inMat, QSize const& displaySize, QImage& image)
+{
+    // Scale the native frame first so the colour conversion only runs at display size.
+    return CvMatToQImage(ResizeMat(inMat, displaySize), image);
+}
+
+/*!
+ * \brief CvMatToJpeg scales and encodes an OpenCV matrix as a JPEG file.
+ * \param[in] inMat - The matrix to encode.
+ * \param[in] jpegSize - The required image size.
+ * \param[in] quality - The JPEG quality, 0 to 100.
+ * \param[out] jpeg - The JPEG file's bytes.
+ * \return True if encoded, false otherwise.
+ */
+inline bool CvMatToJpeg(cv::Mat const& inMat, QSize const& jpegSize, int const quality,
+                        QByteArray& jpeg)
+{
+    // The native BGR frame is encoded directly, without converting it to a QImage first.
+    std::vector<uchar> buffer;
+
+    if (!cv::imencode(
+            ".jpg", ResizeMat(inMat, jpegSize), buffer, {cv::IMWRITE_JPEG_QUALITY, quality}))
+    {
+        DEBUG_MESSAGE_EX_ERROR("failed to encode JPEG frame");
+        return false;
+    }
+
+    jpeg =
+        QByteArray(reinterpret_cast<char const*>(buffer.data()), static_cast<int>(buffer.size()));
+    return true;
+}
+
+/*!
+ * \brief ScaledDisplaySize fits a frame within a requested size, keeping its aspect ratio.
+ * \param[in] frameSize - The frame's size.
+ * \param[in] requestedSize - The size to fit the frame within.
+ * \param[in] allowUpscale - Whether the frame may be scaled up beyond its own size.
+ * \return The scaled size.
+ */
+inline QSize ScaledDisplaySize(QSize const& frameSize, QSize const& requestedSize,
+                               bool const allowUpscale)
+{
+    if (!allowUpscale && (requestedSize.width() >= frameSize.width()) &&
+        (requestedSize.height() >= frameSize.height()))
+    {
+        return frameSize;
+    }
+
+    return frameSize.scaled(requestedSize, Qt::KeepAspectRatio);
+}
+
+/*!
+ * \brief RegionOfInterest converts a fractional region of a frame to pixels.
+ * \param[in] frameSize - The frame's size.
+ * \param[in] region - The region as fractions of the frame, empty for the whole frame.
+ * \return The region in pixels, clipped to the frame.
+ */
+inline QRect RegionOfInterest(QSize const& frameSize, QRectF const& region)
+{
+    auto const frameRect = QRect(QPoint(0, 0), frameSize);
+
+    if (region.isEmpty())
+    {
+        return frameRect;
+    }
+
+    auto const roi = QRect(static_cast<int>(region.x() * frameSize.width()),
+                           static_cast<int>(region.y() * frameSize.height()),
+                           std::max(static_cast<int>(region.width() * frameSize.width()), 1),
+                           std::max(static_cast<int>(region.height() * frameSize.height()), 1))
+                         .intersected(frameRect);
+
+    return roi.isEmpty() ? frameRect : roi;
+}
+
+/*!
+ * \brief ScaleRect scales a rectangle's coordinates.
+ * \param[in] rect - The rectangle to scale.
+ * \param[in] scalar - The scale factor.
+ * \return The scaled rectangle.
+ */
+inline QRect ScaleRect(QRect const& rect, double const scalar)
+{
+    QRect scaledRect;
+    scaledRect.setTop(static_cast<int>(static_cast<double>(rect.top()) * scalar));
+    scaledRect.setLeft(static_cast<int>(static_cast<double>(rect.left()) * scalar));
+    scaledRect.setRight(static_cast<int>(static_cast<double>(rect.right()) * scalar));
+    scaledRect.setBottom(static_cast<int>(static_cast<double>(rect.bottom()) * scalar));
+    return scaledRect;
+}
+
+} // namespace utils
+
+} // namespace ipfreely
+
+#endif // IPFREELYIMAGEUTILS_H
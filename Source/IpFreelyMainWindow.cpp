@@ -26,99 +26,145 @@
 #include "ui_IpFreelyMainWindow.h"
 #include <QTimer>
 #include <QToolButton>
-#include <QResizeEvent>
 #include <QCloseEvent>
+#include <QEvent>
 #include <QMessageBox>
-#include <QLayout>
-#include <QLayoutItem>
-#include <QPainter>
-#include <QPen>
-#include <QBrush>
+#include <QFileDialog>
+#include <QDir>
 #include <QScreen>
 #include <QRectF>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QLocale>
+#include <QProcess>
+#include <QCoreApplication>
 #include <stdexcept>
 #include <string>
 #include <ctime>
 #include <set>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+#include <exception>
 #include <boost/filesystem.hpp>
-#include "IpFreelyVideoFrame.h"
+#include "IpFreelyVideoGrid.h"
 #include "IpFreelyVideoForm.h"
 #include "IpFreelyPreferencesDialog.h"
 #include "IpFreelyAbout.h"
 #include "IpFreelyCameraSetupDialog.h"
-#include "IpFreelySdCardViewerDialog.h"
 #include "IpFreelyStreamProcessor.h"
 #include "IpFreelyDiskSpaceManager.h"
+#include "IpFreelyHttpServer.h"
+#include "IpFreelyRtspProxy.h"
+#include "IpFreelyStorageMirror.h"
+#include "IpFreelySchedule.h"
+#include "IpFreelyMetrics.h"
+#include "IpFreelyStreamStats.h"
+#include "IpFreelyTrace.h"
 #include "StringUtils/StringUtils.h"
 #include "DebugLog/DebugLogging.h"
 
 namespace bfs = boost::filesystem;
 
-namespace
+IpFreelyMainWindow::IpFreelyMainWindow(QString const& appVersion, QWidget* parent)
+    : QMainWindow(parent)
+    , ui(new Ui::IpFreelyMainWindow)
+    , m_appVersion(appVersion)
+    , m_videoFeedsUpdatePending(false)
+    , m_videoForm(std::make_shared<IpFreelyVideoForm>())
+    , m_videoFormId(ipfreely::NO_CAMERA_ID)
+    , m_videoFormFrameSequence(0)
+    , m_gridPage(0)
+    , m_thumbnailTimer(new QTimer(this))
+    , m_hudTimer(new QTimer(this))
+    , m_metrics(std::make_shared<ipfreely::IpFreelyMetrics>())
+    , m_diskSpaceMgr(std::make_shared<ipfreely::IpFreelyDiskSpaceManager>(
+          m_prefs.SaveFolderPath(), m_prefs.MaxNumDaysData(), m_prefs.MaxUsedDiskSpacePercent(),
+          m_metrics))
 {
+    ui->setupUi(this);
 
-static constexpr int DEFAULT_UPDATE_PERIOD_MS = 100;
-
-void ClearLayout(QLayout* layout, bool deleteWidgets)
-{
-    if (!layout)
-    {
-        return;
-    }
+    // Connected streams pick up edited camera settings without reconnecting where possible.
+    m_camDb.AddChangeListener([this](ipfreely::camera_id_t camId, camera_ptr_t const& camera) {
+        CameraChanged(camId, camera);
+    });
 
-    while (layout->count() > 0)
-    {
-        QLayoutItem* item = layout->takeAt(0);
+    connect(ui->videoGrid,
+            &IpFreelyVideoGrid::CurrentCameraChanged,
+            this,
+            &IpFreelyMainWindow::SelectCamera);
 
-        if (item)
+    connect(ui->videoGrid, &IpFreelyVideoGrid::CameraActivated, this, [this](int cameraId) {
+        if (m_streamProcessors.count(cameraId) > 0)
         {
-            QWidget* widget = item->widget();
-
-            if (widget)
-            {
-                widget->setParent(nullptr);
+            ShowExpandedVideoForm(cameraId);
+        }
+    });
 
-                if (deleteWidgets)
-                {
-                    delete widget;
-                }
-            }
+    connect(ui->videoGrid,
+            &IpFreelyVideoGrid::AreaSelected,
+            this,
+            &IpFreelyMainWindow::VideoFrameAreaSelection);
 
-            delete item;
-        }
-    }
-}
+    connect(ui->videoGrid,
+            &IpFreelyVideoGrid::TileLayoutChanged,
+            this,
+            &IpFreelyMainWindow::UpdateFeedDisplaySizes);
 
-} // namespace
+    // The expanded view unsubscribes while minimised so must resubscribe when restored.
+    connect(m_videoForm.get(),
+            &IpFreelyVideoForm::WindowStateChanged,
+            this,
+            &IpFreelyMainWindow::UpdateVideoFeeds);
 
-IpFreelyMainWindow::IpFreelyMainWindow(QString const& appVersion, QWidget* parent)
-    : QMainWindow(parent)
-    , ui(new Ui::IpFreelyMainWindow)
-    , m_appVersion(appVersion)
-    , m_updateFeedsTimer(new QTimer(this))
-    , m_numConnections(0)
-    , m_videoForm(std::make_shared<IpFreelyVideoForm>())
-    , m_diskSpaceMgr(std::make_shared<ipfreely::IpFreelyDiskSpaceManager>(
-          m_prefs.SaveFolderPath(), m_prefs.MaxNumDaysData(), m_prefs.MaxUsedDiskSpacePercent()))
-{
-    ui->setupUi(this);
+    // The performance overlay derives its rates from counter snapshots taken once a second.
+    static constexpr int HUD_UPDATE_PERIOD_MS = 1000;
+    m_hudTimer->setInterval(HUD_UPDATE_PERIOD_MS);
+    connect(m_hudTimer, &QTimer::timeout, this, &IpFreelyMainWindow::UpdatePerformanceHud);
 
-    connect(m_updateFeedsTimer, &QTimer::timeout, this, &IpFreelyMainWindow::on_updateFeedsTimer);
+    // Thumbnails are also saved on disconnect and on close, the timer covers crashes.
+    static constexpr int THUMBNAIL_SAVE_PERIOD_MS = 60000;
+    m_thumbnailTimer->setInterval(THUMBNAIL_SAVE_PERIOD_MS);
+    connect(m_thumbnailTimer, &QTimer::timeout, this, &IpFreelyMainWindow::SaveThumbnails);
+    m_thumbnailTimer->start();
 
     SetDisplaySize();
+    ShowGridPage(0);
+    CreateHttpServer();
+    CreateRtspProxy();
+    CreateStorageMirror();
 
-    ConnectButtons();
+    ui->removeMotionRegionsToolButton->setVisible(false);
 
-    ui->cam1RemoveMotionRegionsToolButton->setVisible(false);
-    ui->cam2RemoveMotionRegionsToolButton->setVisible(false);
-    ui->cam3RemoveMotionRegionsToolButton->setVisible(false);
-    ui->cam4RemoveMotionRegionsToolButton->setVisible(false);
+#ifndef IPFREELY_ENABLE_TRACING
+    // The trace points are compiled out so there is nothing to record.
+    ui->actionRecordTrace->setVisible(false);
+    ui->actionSaveTrace->setVisible(false);
+#endif
 
     QTimer::singleShot(100, this, &IpFreelyMainWindow::CheckStartupConnections);
 }
 
 IpFreelyMainWindow::~IpFreelyMainWindow()
 {
+    // Wait for cameras that are still connecting, the queued completions are discarded along
+    // with us so the new stream processors must be stopped here too.
+    for (auto& pendingConnection : m_pendingConnections)
+    {
+        pendingConnection.second.wait();
+    }
+
+    m_pendingConnections.clear();
+
+    // Stop serving clients before the stream processors go, so the last reference to a
+    // stream processor is never dropped by the web server's thread.
+    m_httpServer.reset();
+
+    // Stop the stream processors before we go so their display callbacks cannot reach us.
+    m_streamProcessors.clear();
+
     delete ui;
 }
 
@@ -137,63 +183,43 @@ void IpFreelyMainWindow::on_actionPreferences_triggered()
         return;
     }
 
-    std::set<ipfreely::eCamId> camIds;
+    // Cameras still connecting were created with the old preferences, so they are reconnected
+    // by CompleteConnection() as soon as they finish connecting.
+    for (auto const& pendingConnection : m_pendingConnections)
+    {
+        m_reconnectOnConnect.emplace(pendingConnection.first);
+    }
+
+    std::set<ipfreely::camera_id_t> camIds;
 
-    for (auto const& camFeed : m_camFeeds)
+    for (auto const& streamProcessor : m_streamProcessors)
     {
-        camIds.emplace(camFeed.first);
+        camIds.emplace(streamProcessor.first);
     }
 
     // Disconnect from feeds so we pick up changes to prefs when we reconnect.
     for (auto const& camId : camIds)
     {
-        switch (camId)
-        {
-        case ipfreely::eCamId::cam1:
-            on_connect1ToolButton_clicked();
-            break;
-        case ipfreely::eCamId::cam2:
-            on_connect2ToolButton_clicked();
-            break;
-        case ipfreely::eCamId::cam3:
-            on_connect3ToolButton_clicked();
-            break;
-        case ipfreely::eCamId::cam4:
-            on_connect4ToolButton_clicked();
-            break;
-        case ipfreely::eCamId::noCam:
-            // Do nothing.
-            break;
-        }
+        ToggleConnection(camId);
     }
 
     // Reconnect to cameras that were previsouly running before changing preferences.
     for (auto const& camId : camIds)
     {
-        switch (camId)
-        {
-        case ipfreely::eCamId::cam1:
-            on_connect1ToolButton_clicked();
-            break;
-        case ipfreely::eCamId::cam2:
-            on_connect2ToolButton_clicked();
-            break;
-        case ipfreely::eCamId::cam3:
-            on_connect3ToolButton_clicked();
-            break;
-        case ipfreely::eCamId::cam4:
-            on_connect4ToolButton_clicked();
-            break;
-        case ipfreely::eCamId::noCam:
-            // Do nothing.
-            break;
-        }
+        ToggleConnection(camId);
     }
 
     // Recreate disk space manager.
     m_diskSpaceMgr.reset();
     m_diskSpaceMgr = std::make_shared<ipfreely::IpFreelyDiskSpaceManager>(
-        m_prefs.SaveFolderPath(), m_prefs.MaxNumDaysData(), m_prefs.MaxUsedDiskSpacePercent());
+        m_prefs.SaveFolderPath(),
+        m_prefs.MaxNumDaysData(),
+        m_prefs.MaxUsedDiskSpacePercent(),
+        m_metrics);
+
+    CreateHttpServer();
+    CreateRtspProxy();
+    CreateStorageMirror();
 }
 
 void IpFreelyMainWindow::on_actionAbout_triggered()
@@ -205,378 +231,267 @@ void IpFreelyMainWindow::on_actionAbout_triggered()
     aboutDlg.exec();
 }
 
-void IpFreelyMainWindow::on_settings1ToolButton_clicked()
+void IpFreelyMainWindow::on_actionAddCamera_triggered()
 {
-    auto streamProcIter = m_streamProcessors.find(ipfreely::eCamId::cam1);
-    bool reconnect      = false;
-
-    if (m_camDb.DoesCameraExist(ipfreely::eCamId::cam1) &&
-        (streamProcIter != m_streamProcessors.end()))
-    {
-        on_connect1ToolButton_clicked();
-        reconnect = true;
-    }
-
-    SetupCameraInDb(ipfreely::eCamId::cam1, ui->cam1ConnectToolButton);
-
-    if (ui->cam1ConnectToolButton->isEnabled() && reconnect)
-    {
-        on_connect1ToolButton_clicked();
-    }
-}
+    auto const camId = m_camDb.NextFreeCameraId();
 
-void IpFreelyMainWindow::on_connect1ToolButton_clicked()
-{
-    ipfreely::IpCamera camera;
+    SetupCameraInDb(camId);
 
-    if (!m_camDb.FindCamera(ipfreely::eCamId::cam1, camera))
+    if (!m_camDb.DoesCameraExist(camId))
     {
-        DEBUG_MESSAGE_EX_ERROR(
-            "Failed to find camera, ID: " << static_cast<int>(ipfreely::eCamId::cam1));
         return;
     }
 
-    ConnectionHandler(camera,
-                      ui->cam1ConnectToolButton,
-                      ui->cam1MotionRegionsToolButton,
-                      ui->cam1RemoveMotionRegionsToolButton,
-                      ui->cam1RecordToolButton,
-                      ui->cam1ImageToolButton,
-                      ui->cam1ExpandToolButton,
-                      ui->cam1StorageToolButton);
+    // New cameras get the largest ID so they always appear on the last page.
+    ShowGridPage(static_cast<int>(m_camDb.GetCameraCount()));
+    SelectCamera(camId);
 }
 
-void IpFreelyMainWindow::on_motionDetectorRegions1ToolButton_toggled(bool checked)
+void IpFreelyMainWindow::on_actionOneTile_triggered()
 {
-    EnableMotionRegionsSetup(ipfreely::eCamId::cam1,
-                             checked,
-                             ui->cam1RemoveMotionRegionsToolButton,
-                             ui->cam1RemoveMotionRegionsToolButton);
+    SetTilesPerPage(1);
 }
 
-void IpFreelyMainWindow::on_removeMotionRegions1ToolButton_clicked()
+void IpFreelyMainWindow::on_actionFourTiles_triggered()
 {
-    RemoveMotionRegions(ipfreely::eCamId::cam1);
+    SetTilesPerPage(4);
 }
 
-void IpFreelyMainWindow::on_record1ToolButton_clicked()
+void IpFreelyMainWindow::on_actionNineTiles_triggered()
 {
-    RecordActionHandler(ipfreely::eCamId::cam1, ui->cam1RecordToolButton);
+    SetTilesPerPage(9);
 }
 
-void IpFreelyMainWindow::on_snapshot1ToolButton_clicked()
+void IpFreelyMainWindow::on_actionSixteenTiles_triggered()
 {
-    SaveImageSnapshot(ipfreely::eCamId::cam1);
+    SetTilesPerPage(16);
 }
 
-void IpFreelyMainWindow::on_expand1ToolButton_clicked()
+void IpFreelyMainWindow::on_actionPreviousPage_triggered()
 {
-    ShowExpandedVideoForm(ipfreely::eCamId::cam1);
+    ShowGridPage(m_gridPage - 1);
 }
 
-void IpFreelyMainWindow::on_storage1ToolButton_clicked()
+void IpFreelyMainWindow::on_actionNextPage_triggered()
 {
-    ipfreely::IpCamera camera;
-
-    if (!m_camDb.FindCamera(ipfreely::eCamId::cam1, camera))
-    {
-        DEBUG_MESSAGE_EX_ERROR(
-            "Failed to find camera, ID: " << static_cast<int>(ipfreely::eCamId::cam1));
-        return;
-    }
-
-    ViewStorage(camera);
+    ShowGridPage(m_gridPage + 1);
 }
 
-void IpFreelyMainWindow::on_settings2ToolButton_clicked()
+void IpFreelyMainWindow::on_actionPerformanceHud_toggled(bool checked)
 {
-    auto streamProcIter = m_streamProcessors.find(ipfreely::eCamId::cam2);
-    bool reconnect      = false;
+    m_hudSnapshots.clear();
 
-    if (m_camDb.DoesCameraExist(ipfreely::eCamId::cam2) &&
-        (streamProcIter != m_streamProcessors.end()))
+    if (checked)
     {
-        on_connect2ToolButton_clicked();
-        reconnect = true;
+        m_hudTimer->start();
     }
-
-    SetupCameraInDb(ipfreely::eCamId::cam2, ui->cam2ConnectToolButton);
-
-    if (ui->cam2ConnectToolButton->isEnabled() && reconnect)
-    {
-        on_connect2ToolButton_clicked();
-    }
-}
-
-void IpFreelyMainWindow::on_connect2ToolButton_clicked()
-{
-    ipfreely::IpCamera camera;
-
-    if (!m_camDb.FindCamera(ipfreely::eCamId::cam2, camera))
+    else
     {
-        DEBUG_MESSAGE_EX_ERROR(
-            "Failed to find camera, ID: " << static_cast<int>(ipfreely::eCamId::cam2));
-        return;
+        m_hudTimer->stop();
     }
 
-    ConnectionHandler(camera,
-                      ui->cam2ConnectToolButton,
-                      ui->cam2MotionRegionsToolButton,
-                      ui->cam2RemoveMotionRegionsToolButton,
-                      ui->cam2RecordToolButton,
-                      ui->cam2ImageToolButton,
-                      ui->cam2ExpandToolButton,
-                      ui->cam2StorageToolButton);
-}
-
-void IpFreelyMainWindow::on_motionDetectorRegions2ToolButton_toggled(bool checked)
-{
-    EnableMotionRegionsSetup(ipfreely::eCamId::cam2,
-                             checked,
-                             ui->cam2RemoveMotionRegionsToolButton,
-                             ui->cam2RemoveMotionRegionsToolButton);
-}
-
-void IpFreelyMainWindow::on_removeMotionRegions2ToolButton_clicked()
-{
-    RemoveMotionRegions(ipfreely::eCamId::cam2);
-}
-
-void IpFreelyMainWindow::on_record2ToolButton_clicked()
-{
-    RecordActionHandler(ipfreely::eCamId::cam2, ui->cam2RecordToolButton);
+    UpdatePerformanceHud();
 }
 
-void IpFreelyMainWindow::on_snapshot2ToolButton_clicked()
+void IpFreelyMainWindow::on_actionRecordTrace_toggled(bool checked)
 {
-    SaveImageSnapshot(ipfreely::eCamId::cam2);
+    ipfreely::IpFreelyTracer::SetEnabled(checked);
+    ui->actionSaveTrace->setEnabled(checked);
 }
 
-void IpFreelyMainWindow::on_expand2ToolButton_clicked()
+void IpFreelyMainWindow::on_actionSaveTrace_triggered()
 {
-    ShowExpandedVideoForm(ipfreely::eCamId::cam2);
-}
+    // Taken before the file dialog opens so the trace ends when the user asked for it.
+    auto const traceJson =
+        ipfreely::IpFreelyTracer::ChromeTraceJson(ipfreely::DEFAULT_TRACE_WINDOW);
 
-void IpFreelyMainWindow::on_storage2ToolButton_clicked()
-{
-    ipfreely::IpCamera camera;
+    auto const fileName =
+        QDateTime::currentDateTime().toString("'ipfreely_trace_'yyyyMMdd_HHmmss'.json'");
+    auto const filePath = QFileDialog::getSaveFileName(this,
+                                                       tr("Save trace..."),
+                                                       QDir(QDir::homePath()).filePath(fileName),
+                                                       tr("Chrome trace files (*.json)"));
 
-    if (!m_camDb.FindCamera(ipfreely::eCamId::cam2, camera))
+    if (filePath.isEmpty())
     {
-        DEBUG_MESSAGE_EX_ERROR(
-            "Failed to find camera, ID: " << static_cast<int>(ipfreely::eCamId::cam2));
         return;
     }
 
-    ViewStorage(camera);
+    QSaveFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly) ||
+        (file.write(traceJson.data(), static_cast<qint64>(traceJson.size())) < 0) ||
+        !file.commit())
+    {
+        QMessageBox::critical(this,
+                              tr("Trace Error"),
+                              tr("Failed to save trace file: %1").arg(filePath),
+                              QMessageBox::Ok,
+                              QMessageBox::Ok);
+    }
 }
 
-void IpFreelyMainWindow::on_settings3ToolButton_clicked()
+void IpFreelyMainWindow::on_settingsToolButton_clicked()
 {
-    auto streamProcIter = m_streamProcessors.find(ipfreely::eCamId::cam3);
-    bool reconnect      = false;
+    auto const camId = SelectedCamId();
 
-    if (m_camDb.DoesCameraExist(ipfreely::eCamId::cam3) &&
-        (streamProcIter != m_streamProcessors.end()))
+    if (camId == ipfreely::NO_CAMERA_ID)
     {
-        on_connect3ToolButton_clicked();
-        reconnect = true;
+        return;
     }
 
-    SetupCameraInDb(ipfreely::eCamId::cam3, ui->cam3ConnectToolButton);
+    // A connected camera is updated, or reconnected if need be, by CameraChanged().
+    SetupCameraInDb(camId);
 
-    if (ui->cam3ConnectToolButton->isEnabled() && reconnect)
+    if (!m_camDb.DoesCameraExist(camId))
     {
-        on_connect3ToolButton_clicked();
+        // The camera's settings were cleared so it has been removed from the database.
+        ShowGridPage(m_gridPage);
     }
+
+    UpdateCameraControls();
 }
 
-void IpFreelyMainWindow::on_connect3ToolButton_clicked()
+void IpFreelyMainWindow::on_connectToolButton_clicked()
 {
-    ipfreely::IpCamera camera;
-
-    if (!m_camDb.FindCamera(ipfreely::eCamId::cam3, camera))
-    {
-        DEBUG_MESSAGE_EX_ERROR(
-            "Failed to find camera, ID: " << static_cast<int>(ipfreely::eCamId::cam3));
-        return;
-    }
-
-    ConnectionHandler(camera,
-                      ui->cam3ConnectToolButton,
-                      ui->cam3MotionRegionsToolButton,
-                      ui->cam3RemoveMotionRegionsToolButton,
-                      ui->cam3RecordToolButton,
-                      ui->cam3ImageToolButton,
-                      ui->cam3ExpandToolButton,
-                      ui->cam3StorageToolButton);
+    ToggleConnection(SelectedCamId());
 }
 
-void IpFreelyMainWindow::on_motionDetectorRegions3ToolButton_toggled(bool checked)
+void IpFreelyMainWindow::on_motionRegionsToolButton_toggled(bool checked)
 {
-    EnableMotionRegionsSetup(ipfreely::eCamId::cam3,
-                             checked,
-                             ui->cam3RemoveMotionRegionsToolButton,
-                             ui->cam3RemoveMotionRegionsToolButton);
+    EnableMotionRegionsSetup(SelectedCamId(), checked);
 }
 
-void IpFreelyMainWindow::on_removeMotionRegions3ToolButton_clicked()
+void IpFreelyMainWindow::on_removeMotionRegionsToolButton_clicked()
 {
-    RemoveMotionRegions(ipfreely::eCamId::cam3);
+    RemoveMotionRegions(SelectedCamId());
 }
 
-void IpFreelyMainWindow::on_record3ToolButton_clicked()
+void IpFreelyMainWindow::on_recordToolButton_clicked()
 {
-    RecordActionHandler(ipfreely::eCamId::cam3, ui->cam3RecordToolButton);
+    RecordActionHandler(SelectedCamId());
 }
 
-void IpFreelyMainWindow::on_snapshot3ToolButton_clicked()
+void IpFreelyMainWindow::on_imageToolButton_clicked()
 {
-    SaveImageSnapshot(ipfreely::eCamId::cam3);
+    SaveImageSnapshot(SelectedCamId());
 }
 
-void IpFreelyMainWindow::on_expand3ToolButton_clicked()
+void IpFreelyMainWindow::on_expandToolButton_clicked()
 {
-    ShowExpandedVideoForm(ipfreely::eCamId::cam3);
+    ShowExpandedVideoForm(SelectedCamId());
 }
 
-void IpFreelyMainWindow::on_storage3ToolButton_clicked()
+void IpFreelyMainWindow::on_storageToolButton_clicked()
 {
+    auto const         camId = SelectedCamId();
     ipfreely::IpCamera camera;
 
-    if (!m_camDb.FindCamera(ipfreely::eCamId::cam3, camera))
+    if (!m_camDb.FindCamera(camId, camera))
     {
-        DEBUG_MESSAGE_EX_ERROR(
-            "Failed to find camera, ID: " << static_cast<int>(ipfreely::eCamId::cam3));
+        DEBUG_MESSAGE_EX_ERROR("Failed to find camera, ID: " << camId);
         return;
     }
 
     ViewStorage(camera);
 }
 
-void IpFreelyMainWindow::on_settings4ToolButton_clicked()
+void IpFreelyMainWindow::UpdateVideoFeeds()
 {
-    auto streamProcIter = m_streamProcessors.find(ipfreely::eCamId::cam4);
-    bool reconnect      = false;
+    // Clear the flag first so frames that arrive while we are busy schedule another update.
+    m_videoFeedsUpdatePending = false;
 
-    if (m_camDb.DoesCameraExist(ipfreely::eCamId::cam4) &&
-        (streamProcIter != m_streamProcessors.end()))
+    for (auto const& streamProcessor : m_streamProcessors)
     {
-        on_connect4ToolButton_clicked();
-        reconnect = true;
-    }
+        uint64_t frameSequence = 0;
+        auto     displayFrame  = streamProcessor.second->DisplayVideoFrame(
+            ipfreely::eDisplayTarget::feed, &frameSequence);
 
-    SetupCameraInDb(ipfreely::eCamId::cam4, ui->cam4ConnectToolButton);
+        if (frameSequence != m_camFeedFrameSequences[streamProcessor.first])
+        {
+            UpdateCamFeedFrame(streamProcessor.first, displayFrame);
 
-    if (ui->cam4ConnectToolButton->isEnabled() && reconnect)
-    {
-        on_connect4ToolButton_clicked();
-    }
-}
+            SetFpsInTitle(streamProcessor.first,
+                          streamProcessor.second->CurrentFps(),
+                          streamProcessor.second->OriginalFps());
 
-void IpFreelyMainWindow::on_connect4ToolButton_clicked()
-{
-    ipfreely::IpCamera camera;
+            m_camFeedFrameSequences[streamProcessor.first] = frameSequence;
+        }
 
-    if (!m_camDb.FindCamera(ipfreely::eCamId::cam4, camera))
-    {
-        DEBUG_MESSAGE_EX_ERROR(
-            "Failed to find camera, ID: " << static_cast<int>(ipfreely::eCamId::cam4));
-        return;
-    }
+        bool const formActive = m_videoForm->isVisible() && !m_videoForm->isMinimized() &&
+                                (m_videoFormId == streamProcessor.first);
 
-    ConnectionHandler(camera,
-                      ui->cam4ConnectToolButton,
-                      ui->cam4MotionRegionsToolButton,
-                      ui->cam4RemoveMotionRegionsToolButton,
-                      ui->cam4RecordToolButton,
-                      ui->cam4ImageToolButton,
-                      ui->cam4ExpandToolButton,
-                      ui->cam4StorageToolButton);
-}
+        streamProcessor.second->SetDisplaySize(ipfreely::eDisplayTarget::expanded,
+                                               formActive ? m_videoForm->DisplaySize() : QSize());
+        streamProcessor.second->SetDisplayRegion(ipfreely::eDisplayTarget::expanded,
+                                                 formActive ? m_videoForm->DisplayRegion()
+                                                            : QRectF());
 
-void IpFreelyMainWindow::on_motionDetectorRegions4ToolButton_toggled(bool checked)
-{
-    EnableMotionRegionsSetup(ipfreely::eCamId::cam4,
-                             checked,
-                             ui->cam4RemoveMotionRegionsToolButton,
-                             ui->cam4RemoveMotionRegionsToolButton);
-}
+        if (formActive)
+        {
+            uint64_t expandedFrameSequence = 0;
+            auto     expandedFrame         = streamProcessor.second->DisplayVideoFrame(
+                ipfreely::eDisplayTarget::expanded, &expandedFrameSequence);
 
-void IpFreelyMainWindow::on_removeMotionRegions4ToolButton_clicked()
-{
-    RemoveMotionRegions(ipfreely::eCamId::cam4);
-}
+            if (expandedFrameSequence != m_videoFormFrameSequence)
+            {
+                int videoWidth  = 0;
+                int videoHeight = 0;
+                streamProcessor.second->GetAspectRatioAndSize(videoWidth, videoHeight);
 
-void IpFreelyMainWindow::on_record4ToolButton_clicked()
-{
-    RecordActionHandler(ipfreely::eCamId::cam4, ui->cam4RecordToolButton);
-}
+                m_videoForm->SetVideoFrame(expandedFrame,
+                                           QSize(videoWidth, videoHeight),
+                                           streamProcessor.second->CurrentFps(),
+                                           streamProcessor.second->OriginalFps());
 
-void IpFreelyMainWindow::on_snapshot4ToolButton_clicked()
-{
-    SaveImageSnapshot(ipfreely::eCamId::cam4);
+                m_videoFormFrameSequence = expandedFrameSequence;
+            }
+        }
+    }
 }
 
-void IpFreelyMainWindow::on_expand4ToolButton_clicked()
+void IpFreelyMainWindow::UpdatePerformanceHud()
 {
-    ShowExpandedVideoForm(ipfreely::eCamId::cam4);
-}
+    bool const showHud = ui->actionPerformanceHud->isChecked();
 
-void IpFreelyMainWindow::on_storage4ToolButton_clicked()
-{
-    ipfreely::IpCamera camera;
+    std::map<ipfreely::camera_id_t, ipfreely::StreamStatsSnapshot> snapshots;
+    QString                                                        videoFormHudText;
 
-    if (!m_camDb.FindCamera(ipfreely::eCamId::cam4, camera))
+    for (auto const camId : m_camDb.GetCameraIds())
     {
-        DEBUG_MESSAGE_EX_ERROR(
-            "Failed to find camera, ID: " << static_cast<int>(ipfreely::eCamId::cam4));
-        return;
-    }
-
-    ViewStorage(camera);
-}
+        auto streamProcIter = m_streamProcessors.find(camId);
 
-void IpFreelyMainWindow::on_updateFeedsTimer()
-{
-    for (auto const& streamProcessor : m_streamProcessors)
-    {
-        if (streamProcessor.second->VideoFrameUpdated())
+        if (!showHud || (streamProcIter == m_streamProcessors.end()))
         {
-            QRect motionBoundingRect;
-            auto currentVideoFrame = streamProcessor.second->CurrentVideoFrame(&motionBoundingRect);
-
-            auto originalFps = streamProcessor.second->OriginalFps();
-            auto fps         = streamProcessor.second->CurrentFps();
-            auto isRecording = streamProcessor.second->VideoWritingEnabled();
+            ui->videoGrid->SetHudText(camId, QString());
+            continue;
+        }
 
-            UpdateCamFeedFrame(
-                streamProcessor.first, currentVideoFrame, motionBoundingRect, isRecording);
+        // Taking a snapshot only reads the stream's atomic counters so never blocks it.
+        auto const snapshot = streamProcIter->second->PerformanceStats();
+        auto       prevIter = m_hudSnapshots.find(camId);
 
-            SetFpsInTitle(streamProcessor.first, fps, originalFps);
+        if (prevIter != m_hudSnapshots.end())
+        {
+            ui->videoGrid->SetHudText(camId, HudText(snapshot, prevIter->second, false));
 
-            if (m_videoForm->isVisible() && (m_videoFormId == streamProcessor.first))
+            if (camId == m_videoFormId)
             {
-                ipfreely::IpCamera::regions_t motionRegions;
-
-                if (m_motionAreaSetupEnabled[streamProcessor.first])
-                {
-                    motionRegions = m_camMotionRegions[streamProcessor.first];
-                }
-
-                m_videoForm->SetVideoFrame(currentVideoFrame,
-                                           fps,
-                                           originalFps,
-                                           motionBoundingRect,
-                                           isRecording,
-                                           motionRegions);
+                videoFormHudText = HudText(snapshot, prevIter->second, true);
             }
         }
+
+        snapshots[camId] = snapshot;
     }
+
+    m_hudSnapshots.swap(snapshots);
+    m_videoForm->SetHudText(videoFormHudText);
 }
 
 void IpFreelyMainWindow::closeEvent(QCloseEvent* event)
 {
+    SaveThumbnails();
+
     if (m_videoForm->isVisible())
     {
         m_videoForm->close();
@@ -585,69 +500,15 @@ void IpFreelyMainWindow::closeEvent(QCloseEvent* event)
     QMainWindow::closeEvent(event);
 }
 
-void IpFreelyMainWindow::resizeEvent(QResizeEvent* event)
+void IpFreelyMainWindow::changeEvent(QEvent* event)
 {
-    if (m_camFeeds.count(ipfreely::eCamId::cam1) > 0)
-    {
-        ClearLayout(ui->cam1Widget->layout(), true);
-        m_camFeeds.erase(ipfreely::eCamId::cam1);
-        auto feed = new IpFreelyVideoFrame(1,
-                                           std::bind(&IpFreelyMainWindow::VideoFrameAreaSelection,
-                                                     this,
-                                                     std::placeholders::_1,
-                                                     std::placeholders::_2),
-                                           this);
-        feed->SetEnableSelection(m_motionAreaSetupEnabled[ipfreely::eCamId::cam1]);
-        ui->cam1Widget->layout()->addWidget(feed);
-        m_camFeeds[ipfreely::eCamId::cam1] = feed;
-    }
-
-    if (m_camFeeds.count(ipfreely::eCamId::cam2) > 0)
-    {
-        ClearLayout(ui->cam2Widget->layout(), true);
-        m_camFeeds.erase(ipfreely::eCamId::cam2);
-        auto feed = new IpFreelyVideoFrame(2,
-                                           std::bind(&IpFreelyMainWindow::VideoFrameAreaSelection,
-                                                     this,
-                                                     std::placeholders::_1,
-                                                     std::placeholders::_2),
-                                           this);
-        feed->SetEnableSelection(m_motionAreaSetupEnabled[ipfreely::eCamId::cam2]);
-        ui->cam2Widget->layout()->addWidget(feed);
-        m_camFeeds[ipfreely::eCamId::cam2] = feed;
-    }
-
-    if (m_camFeeds.count(ipfreely::eCamId::cam3) > 0)
-    {
-        ClearLayout(ui->cam3Widget->layout(), true);
-        m_camFeeds.erase(ipfreely::eCamId::cam3);
-        auto feed = new IpFreelyVideoFrame(3,
-                                           std::bind(&IpFreelyMainWindow::VideoFrameAreaSelection,
-                                                     this,
-                                                     std::placeholders::_1,
-                                                     std::placeholders::_2),
-                                           this);
-        feed->SetEnableSelection(m_motionAreaSetupEnabled[ipfreely::eCamId::cam3]);
-        ui->cam3Widget->layout()->addWidget(feed);
-        m_camFeeds[ipfreely::eCamId::cam3] = feed;
-    }
-
-    if (m_camFeeds.count(ipfreely::eCamId::cam4) > 0)
-    {
-        ClearLayout(ui->cam4Widget->layout(), true);
-        m_camFeeds.erase(ipfreely::eCamId::cam4);
-        auto feed = new IpFreelyVideoFrame(4,
-                                           std::bind(&IpFreelyMainWindow::VideoFrameAreaSelection,
-                                                     this,
-                                                     std::placeholders::_1,
-                                                     std::placeholders::_2),
-                                           this);
-        feed->SetEnableSelection(m_motionAreaSetupEnabled[ipfreely::eCamId::cam4]);
-        ui->cam4Widget->layout()->addWidget(feed);
-        m_camFeeds[ipfreely::eCamId::cam4] = feed;
-    }
-
-    QMainWindow::resizeEvent(event);
+    // Unsubscribe the feeds while minimised so the stream processors stop converting frames.
+    if (event->type() == QEvent::WindowStateChange)
+    {
+        UpdateFeedDisplaySizes();
+    }
+
+    QMainWindow::changeEvent(event);
 }
 
 void IpFreelyMainWindow::SetDisplaySize()
@@ -701,7 +562,7 @@ void IpFreelyMainWindow::SetDisplaySize()
     displayGeometry.setHeight(displayHeight);
     setGeometry(displayGeometry);
 
-    auto buttonGeometry = ui->cam1SettingsToolButton->geometry();
+    auto buttonGeometry = ui->settingsToolButton->geometry();
     int  buttonSize = static_cast<int>(static_cast<double>(buttonGeometry.height()) * scaleFactor);
 
     if (buttonSize < MIN_BUTTON_SIZE)
@@ -713,280 +574,115 @@ void IpFreelyMainWindow::SetDisplaySize()
         buttonSize = MAX_BUTTON_SIZE;
     }
 
-    ui->cam1SettingsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam1ConnectToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam1MotionRegionsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam1RemoveMotionRegionsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam1ImageToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam1RecordToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam1ExpandToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam1StorageToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-
-    ui->cam4SettingsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam4ConnectToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam4MotionRegionsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam4RemoveMotionRegionsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam4ImageToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam4RecordToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam4ExpandToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam4StorageToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-
-    ui->cam2SettingsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam2ConnectToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam2MotionRegionsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam2RemoveMotionRegionsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam2ImageToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam2RecordToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam2ExpandToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam2StorageToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-
-    ui->cam3SettingsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam3ConnectToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam3MotionRegionsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam3RemoveMotionRegionsToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam3ImageToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam3RecordToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam3ExpandToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-    ui->cam3StorageToolButton->setMinimumSize(QSize(buttonSize, buttonSize));
-
-    ui->cam1SettingsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam1ConnectToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam1MotionRegionsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam1RemoveMotionRegionsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam1ImageToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam1RecordToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam1ExpandToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam1StorageToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-
-    ui->cam4SettingsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam4ConnectToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam4MotionRegionsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam4RemoveMotionRegionsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam4ImageToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam4RecordToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam4ExpandToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam4StorageToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-
-    ui->cam2SettingsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam2ConnectToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam2MotionRegionsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam2RemoveMotionRegionsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam2ImageToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam2RecordToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam2ExpandToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam2StorageToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-
-    ui->cam3SettingsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam3ConnectToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam3MotionRegionsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam3RemoveMotionRegionsToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam3ImageToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam3RecordToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam3ExpandToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
-    ui->cam3StorageToolButton->setMaximumSize(QSize(buttonSize, buttonSize));
+    for (auto button : {ui->settingsToolButton,
+                        ui->connectToolButton,
+                        ui->motionRegionsToolButton,
+                        ui->removeMotionRegionsToolButton,
+                        ui->imageToolButton,
+                        ui->recordToolButton,
+                        ui->expandToolButton,
+                        ui->storageToolButton})
+    {
+        button->setMinimumSize(QSize(buttonSize, buttonSize));
+        button->setMaximumSize(QSize(buttonSize, buttonSize));
+    }
 }
 
-void IpFreelyMainWindow::ConnectButtons()
+void IpFreelyMainWindow::CheckStartupConnections()
 {
-    connect(ui->cam1SettingsToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_settings1ToolButton_clicked);
-
-    connect(ui->cam2SettingsToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_settings2ToolButton_clicked);
-
-    connect(ui->cam3SettingsToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_settings3ToolButton_clicked);
-
-    connect(ui->cam4SettingsToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_settings4ToolButton_clicked);
-
-    connect(ui->cam1ConnectToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_connect1ToolButton_clicked);
-
-    connect(ui->cam2ConnectToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_connect2ToolButton_clicked);
-
-    connect(ui->cam3ConnectToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_connect3ToolButton_clicked);
-
-    connect(ui->cam4ConnectToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_connect4ToolButton_clicked);
-
-    connect(ui->cam1ImageToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_snapshot1ToolButton_clicked);
-
-    connect(ui->cam2ImageToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_snapshot2ToolButton_clicked);
-
-    connect(ui->cam3ImageToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_snapshot3ToolButton_clicked);
-
-    connect(ui->cam4ImageToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_snapshot4ToolButton_clicked);
-
-    connect(ui->cam1RecordToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_record1ToolButton_clicked);
-
-    connect(ui->cam2RecordToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_record2ToolButton_clicked);
-
-    connect(ui->cam3RecordToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_record3ToolButton_clicked);
-
-    connect(ui->cam4RecordToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_record4ToolButton_clicked);
-
-    connect(ui->cam1ExpandToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_expand1ToolButton_clicked);
-
-    connect(ui->cam2ExpandToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_expand2ToolButton_clicked);
-
-    connect(ui->cam3ExpandToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_expand3ToolButton_clicked);
-
-    connect(ui->cam4ExpandToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_expand4ToolButton_clicked);
-
-    connect(ui->cam1StorageToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_storage1ToolButton_clicked);
-
-    connect(ui->cam2StorageToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_storage2ToolButton_clicked);
-
-    connect(ui->cam3StorageToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_storage3ToolButton_clicked);
-
-    connect(ui->cam4StorageToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_storage4ToolButton_clicked);
-
-    connect(ui->cam1MotionRegionsToolButton,
-            &QToolButton::toggled,
-            this,
-            &IpFreelyMainWindow::on_motionDetectorRegions1ToolButton_toggled);
-
-    connect(ui->cam2MotionRegionsToolButton,
-            &QToolButton::toggled,
-            this,
-            &IpFreelyMainWindow::on_motionDetectorRegions2ToolButton_toggled);
-
-    connect(ui->cam3MotionRegionsToolButton,
-            &QToolButton::toggled,
-            this,
-            &IpFreelyMainWindow::on_motionDetectorRegions3ToolButton_toggled);
-
-    connect(ui->cam4MotionRegionsToolButton,
-            &QToolButton::toggled,
-            this,
-            &IpFreelyMainWindow::on_motionDetectorRegions4ToolButton_toggled);
-
-    connect(ui->cam1RemoveMotionRegionsToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_removeMotionRegions1ToolButton_clicked);
+    if (m_prefs.ConnectToCamerasOnStartup())
+    {
+        for (auto camId : m_camDb.GetCameraIds())
+        {
+            ToggleConnection(camId);
+        }
+    }
 
-    connect(ui->cam2RemoveMotionRegionsToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_removeMotionRegions2ToolButton_clicked);
+    UpdateCameraControls();
+}
 
-    connect(ui->cam3RemoveMotionRegionsToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_removeMotionRegions3ToolButton_clicked);
+ipfreely::camera_id_t IpFreelyMainWindow::SelectedCamId() const
+{
+    return ui->videoGrid->CurrentCameraId();
+}
 
-    connect(ui->cam4RemoveMotionRegionsToolButton,
-            &QToolButton::clicked,
-            this,
-            &IpFreelyMainWindow::on_removeMotionRegions4ToolButton_clicked);
+void IpFreelyMainWindow::SelectCamera(int const cameraId)
+{
+    ui->videoGrid->SetCurrentCameraId(cameraId);
+    UpdateCameraControls();
 }
 
-void IpFreelyMainWindow::CheckStartupConnections()
+void IpFreelyMainWindow::UpdateCameraControls()
 {
-    ui->cam1ConnectToolButton->setEnabled(m_camDb.DoesCameraExist(ipfreely::eCamId::cam1));
+    auto const         camId = SelectedCamId();
+    ipfreely::IpCamera camera;
+    bool const         cameraExists   = m_camDb.FindCamera(camId, camera);
+    auto               streamProcIter = m_streamProcessors.find(camId);
+    bool const         isConnected    = streamProcIter != m_streamProcessors.end();
+    bool const         isConnecting   = m_pendingConnections.count(camId) > 0;
+    bool const isRecording          = isConnected && streamProcIter->second->VideoWritingEnabled();
+    bool const isMotionRegionsSetup = m_motionAreaSetupEnabled.count(camId) > 0;
 
-    if (ui->cam1ConnectToolButton->isEnabled() && m_prefs.ConnectToCamerasOnStartup())
+    if (camId == ipfreely::NO_CAMERA_ID)
     {
-        on_connect1ToolButton_clicked();
+        ui->cameraControlsGroupBox->setTitle(tr("No Camera"));
     }
-
-    ui->cam2ConnectToolButton->setEnabled(m_camDb.DoesCameraExist(ipfreely::eCamId::cam2));
-
-    if (ui->cam2ConnectToolButton->isEnabled() && m_prefs.ConnectToCamerasOnStartup())
+    else
     {
-        on_connect2ToolButton_clicked();
+        ui->cameraControlsGroupBox->setTitle(tr("Camera %1").arg(camId));
     }
 
-    ui->cam3ConnectToolButton->setEnabled(m_camDb.DoesCameraExist(ipfreely::eCamId::cam3));
+    ui->settingsToolButton->setEnabled(camId != ipfreely::NO_CAMERA_ID);
+    ui->connectToolButton->setEnabled(cameraExists && !isConnecting);
 
-    if (ui->cam3ConnectToolButton->isEnabled() && m_prefs.ConnectToCamerasOnStartup())
+    if (isConnecting)
     {
-        on_connect3ToolButton_clicked();
+        ui->connectToolButton->setIcon(QIcon(":/icons/icons/WallCam_Connect_48.png"));
+        ui->connectToolButton->setToolTip("Connecting to camera stream...");
+    }
+    else if (isConnected)
+    {
+        ui->connectToolButton->setIcon(QIcon(":/icons/icons/WallCam_Disconnect_48.png"));
+        ui->connectToolButton->setToolTip("Disconnect from camera stream.");
+    }
+    else
+    {
+        ui->connectToolButton->setIcon(QIcon(":/icons/icons/WallCam_Connect_48.png"));
+        ui->connectToolButton->setToolTip("Connect to camera stream.");
     }
 
-    ui->cam4ConnectToolButton->setEnabled(m_camDb.DoesCameraExist(ipfreely::eCamId::cam4));
+    ui->recordToolButton->setEnabled(isConnected && !camera.enableScheduledRecording);
 
-    if (ui->cam4ConnectToolButton->isEnabled() && m_prefs.ConnectToCamerasOnStartup())
+    if (isRecording)
+    {
+        ui->recordToolButton->setIcon(QIcon(":/icons/icons/Stop-48.png"));
+        ui->recordToolButton->setToolTip("Stop recording from camera stream.");
+    }
+    else
     {
-        on_connect4ToolButton_clicked();
+        ui->recordToolButton->setIcon(QIcon(":/icons/icons/Record-48.png"));
+        ui->recordToolButton->setToolTip("Record from camera stream.");
     }
+
+    ui->imageToolButton->setEnabled(isConnected);
+    ui->expandToolButton->setEnabled(isConnected);
+    ui->storageToolButton->setEnabled(isConnected && !camera.storageHttpUrl.empty());
+    ui->motionRegionsToolButton->setEnabled(isConnected);
+
+    bool blockState = ui->motionRegionsToolButton->blockSignals(true);
+    ui->motionRegionsToolButton->setChecked(isMotionRegionsSetup);
+    ui->motionRegionsToolButton->blockSignals(blockState);
+
+    ui->removeMotionRegionsToolButton->setVisible(isMotionRegionsSetup);
 }
 
-void IpFreelyMainWindow::SetupCameraInDb(ipfreely::eCamId const camId, QToolButton* connectBtn)
+void IpFreelyMainWindow::SetupCameraInDb(ipfreely::camera_id_t const camId)
 {
     ipfreely::IpCamera camera;
 
     if (!m_camDb.FindCamera(camId, camera))
     {
-        DEBUG_MESSAGE_EX_ERROR("Failed to find camera, ID: " << static_cast<int>(camId));
+        DEBUG_MESSAGE_EX_ERROR("Failed to find camera, ID: " << camId);
         camera.camId = camId;
     }
 
@@ -1008,18 +704,30 @@ void IpFreelyMainWindow::SetupCameraInDb(ipfreely::eCamId const camId, QToolButt
     }
 
     m_camDb.Save();
-    connectBtn->setEnabled(camera.IsValid());
+    UpdateServiceCameras();
 }
 
-void IpFreelyMainWindow::ConnectionHandler(ipfreely::IpCamera const& camera,
-                                           QToolButton* connectBtn, QToolButton* motionRegionsBtn,
-                                           QToolButton* removeRegionsBtn, QToolButton* recordBtn,
-                                           QToolButton* snapshotBtn, QToolButton* expandBtn,
-                                           QToolButton* storageBtn)
+void IpFreelyMainWindow::ToggleConnection(ipfreely::camera_id_t const camId)
 {
-    if (m_updateFeedsTimer->isActive())
+    ipfreely::IpCamera camera;
+
+    if (!m_camDb.FindCamera(camId, camera))
     {
-        m_updateFeedsTimer->stop();
+        DEBUG_MESSAGE_EX_ERROR("Failed to find camera, ID: " << camId);
+        return;
+    }
+
+    ConnectionHandler(camera);
+}
+
+void IpFreelyMainWindow::ConnectionHandler(ipfreely::IpCamera const& camera)
+{
+    auto const cameraId = camera.camId;
+
+    if (m_pendingConnections.count(camera.camId) > 0)
+    {
+        DEBUG_MESSAGE_EX_WARNING("Camera is still connecting, ID: " << camera.camId);
+        return;
     }
 
     if (m_streamProcessors.count(camera.camId) > 0)
@@ -1027,328 +735,327 @@ void IpFreelyMainWindow::ConnectionHandler(ipfreely::IpCamera const& camera,
         if (m_videoForm->isVisible() && (m_videoFormId == camera.camId))
         {
             m_videoForm->close();
-            m_videoFormId = ipfreely::eCamId::noCam;
+            m_videoFormId = ipfreely::NO_CAMERA_ID;
         }
 
-        m_streamProcessors.erase(camera.camId);
-        m_camFeeds.erase(camera.camId);
-        m_camMotionRegions.erase(camera.camId);
+        SaveThumbnail(camera.camId);
 
-        switch (camera.camId)
+        // Waits for the web server to finish with the stream processor, so it is destroyed
+        // here rather than on the web server's thread.
+        if (m_httpServer)
         {
-        case ipfreely::eCamId::cam1:
-            ClearLayout(ui->cam1Widget->layout(), true);
-            ui->camFeed1GroupBox->setTitle(tr("Camera 1"));
-            ui->camFeed1GroupBox->setToolTip(tr("Not connected"));
-            break;
-        case ipfreely::eCamId::cam2:
-            ClearLayout(ui->cam2Widget->layout(), true);
-            ui->camFeed2GroupBox->setTitle(tr("Camera 2"));
-            ui->camFeed2GroupBox->setToolTip(tr("Not connected"));
-            break;
-        case ipfreely::eCamId::cam3:
-            ClearLayout(ui->cam3Widget->layout(), true);
-            ui->camFeed3GroupBox->setTitle(tr("Camera 3"));
-            ui->camFeed3GroupBox->setToolTip(tr("Not connected"));
-            break;
-        case ipfreely::eCamId::cam4:
-            ClearLayout(ui->cam4Widget->layout(), true);
-            ui->camFeed4GroupBox->setTitle(tr("Camera 4"));
-            ui->camFeed4GroupBox->setToolTip(tr("Not connected"));
-            break;
-        case ipfreely::eCamId::noCam:
-            // Do nothing.
-            break;
+            m_httpServer->RemoveStreamProcessor(camera.camId);
         }
 
-        connectBtn->setIcon(QIcon(":/icons/icons/WallCam_Connect_48.png"));
-        connectBtn->setToolTip("Connect to camera stream.");
-
-        recordBtn->setEnabled(false);
-        recordBtn->setIcon(QIcon(":/icons/icons/Record-48.png"));
-        recordBtn->setToolTip("Record from camera stream.");
-
-        snapshotBtn->setEnabled(false);
-        expandBtn->setEnabled(false);
-        storageBtn->setEnabled(false);
-        motionRegionsBtn->setEnabled(false);
-        motionRegionsBtn->setChecked(false);
-        removeRegionsBtn->setVisible(false);
-
+        m_streamProcessors.erase(camera.camId);
+        m_camFeedFrameSequences.erase(camera.camId);
+        m_snapshotFrameSequences.erase(camera.camId);
         m_camMotionRegions.erase(camera.camId);
         m_motionAreaSetupEnabled.erase(camera.camId);
 
-        if (--m_numConnections > 0)
-        {
-            m_updateFeedsTimer->start(DEFAULT_UPDATE_PERIOD_MS);
-        }
+        ui->videoGrid->ClearVideoFrame(cameraId);
+        ui->videoGrid->SetEnableSelection(cameraId, false);
+        ui->videoGrid->SetTitle(cameraId, tr("Camera %1").arg(cameraId));
+        ui->videoGrid->SetToolTip(cameraId, tr("Not connected"));
+        ShowThumbnail(cameraId);
     }
     else
     {
-        std::string camName;
-        int         cameraId = 0;
+        auto const camName = CameraName(camera.camId);
 
-        switch (camera.camId)
+        bfs::path p(m_prefs.SaveFolderPath());
+        p = bfs::system_complete(p);
+
+        ipfreely::IpFreelySchedule schedule;
+
+        if (camera.enableScheduledRecording)
         {
-        case ipfreely::eCamId::cam1:
-            camName  = "Camera1";
-            cameraId = 1;
-            break;
-        case ipfreely::eCamId::cam2:
-            camName  = "Camera2";
-            cameraId = 2;
-            break;
-        case ipfreely::eCamId::cam3:
-            camName  = "Camera3";
-            cameraId = 3;
-            break;
-        case ipfreely::eCamId::cam4:
-            camName  = "Camera4";
-            cameraId = 4;
-            break;
-        case ipfreely::eCamId::noCam:
-            // Do nothing.
-            break;
+            schedule = ipfreely::IpFreelySchedule::FromHourlySchedule(m_prefs.RecordingSchedule());
+            schedule.SetPrewarmSecs(ipfreely::DEFAULT_SCHEDULE_PREWARM_SECS);
         }
 
-        try
+        ipfreely::IpFreelySchedule motionSchedule;
+
+        if (camera.enabledMotionRecording)
         {
-            bfs::path p(m_prefs.SaveFolderPath());
-            p = bfs::system_complete(p);
+            motionSchedule =
+                ipfreely::IpFreelySchedule::FromHourlySchedule(m_prefs.MotionTrackingSchedule());
+            motionSchedule.SetPrewarmSecs(ipfreely::DEFAULT_SCHEDULE_PREWARM_SECS);
+        }
 
-            auto schedule = m_prefs.RecordingSchedule();
+        auto const saveFolderPath   = p.string();
+        auto const fileDurationSecs = m_prefs.FileDurationInSecs();
+        auto       displayCallback  = std::bind(&IpFreelyMainWindow::NotifyNewDisplayFrames, this);
+        auto const streamStats      = m_metrics->StreamStats(cameraId);
 
-            if (!camera.enableScheduledRecording)
+        streamStats->ConnectionAttempted();
+
+        // Opening an RTSP session and decoding its first frame can take several seconds, so
+        // the stream processor is created on a worker thread and handed back to the GUI
+        // thread by CompleteConnection(). The tile keeps showing its thumbnail meanwhile.
+        m_pendingConnections[cameraId] = std::async(std::launch::async, [=]() {
+            stream_proc_t      streamProcessor;
+            std::exception_ptr error;
+
+            try
+            {
+                streamProcessor =
+                    std::make_shared<ipfreely::IpFreelyStreamProcessor>(camName,
+                                                                        camera,
+                                                                        saveFolderPath,
+                                                                        fileDurationSecs,
+                                                                        schedule,
+                                                                        motionSchedule,
+                                                                        displayCallback,
+                                                                        streamStats);
+            }
+            catch (...)
             {
-                schedule.clear();
+                streamStats->ConnectionFailed();
+                error = std::current_exception();
             }
 
-            auto motionSchedule = m_prefs.MotionTrackingSchedule();
+            QMetaObject::invokeMethod(
+                this, [this, cameraId]() { CompleteConnection(cameraId); }, Qt::QueuedConnection);
 
-            if (!camera.enabledMotionRecording)
+            if (error)
             {
-                motionSchedule.clear();
+                std::rethrow_exception(error);
             }
 
-            m_streamProcessors[camera.camId] =
-                std::make_shared<ipfreely::IpFreelyStreamProcessor>(camName,
-                                                                    camera,
-                                                                    p.string(),
-                                                                    m_prefs.FileDurationInSecs(),
-                                                                    schedule,
-                                                                    motionSchedule);
-        }
-        catch (std::exception& e)
-        {
-            DEBUG_MESSAGE_EX_ERROR("Stream Error, camera: " << camName
-                                                            << ", error message: " << e.what());
-            QMessageBox::critical(this,
-                                  "Stream Error",
-                                  QString::fromLocal8Bit(e.what()),
-                                  QMessageBox::Ok,
-                                  QMessageBox::Ok);
-            return;
-        }
+            return streamProcessor;
+        });
+
+        ui->videoGrid->SetToolTip(cameraId, tr("Connecting..."));
+    }
+
+    UpdateCameraControls();
+}
+
+void IpFreelyMainWindow::CompleteConnection(ipfreely::camera_id_t const camId)
+{
+    auto pendingIter = m_pendingConnections.find(camId);
+
+    if (pendingIter == m_pendingConnections.end())
+    {
+        return;
+    }
+
+    auto pendingConnection = std::move(pendingIter->second);
+    m_pendingConnections.erase(pendingIter);
+
+    bool const    setupMotionRegions = m_motionSetupOnConnect.erase(camId) > 0;
+    bool const    reconnect          = m_reconnectOnConnect.erase(camId) > 0;
+    auto const    camName            = CameraName(camId);
+    stream_proc_t streamProcessor;
+
+    try
+    {
+        streamProcessor = pendingConnection.get();
+    }
+    catch (std::exception& e)
+    {
+        DEBUG_MESSAGE_EX_ERROR("Stream Error, camera: " << camName
+                                                        << ", error message: " << e.what());
+        ui->videoGrid->SetToolTip(camId, tr("Not connected"));
+        UpdateCameraControls();
+        QMessageBox::critical(this,
+                              "Stream Error",
+                              QString::fromLocal8Bit(e.what()),
+                              QMessageBox::Ok,
+                              QMessageBox::Ok);
+        return;
+    }
+
+    auto const camera = m_camDb.GetCamera(camId);
+
+    // The camera may have been removed while it was connecting.
+    if (!camera)
+    {
+        DEBUG_MESSAGE_EX_WARNING("Discarding connection to removed camera: " << camName);
+        return;
+    }
 
-        auto feed = new IpFreelyVideoFrame(cameraId,
-                                           std::bind(&IpFreelyMainWindow::VideoFrameAreaSelection,
-                                                     this,
-                                                     std::placeholders::_1,
-                                                     std::placeholders::_2),
-                                           this);
-        ;
-        QString hint = QString::fromStdString(camera.description);
+    // Or edited in a way the new stream processor cannot pick up, or the preferences changed.
+    if (reconnect || !streamProcessor->UpdateCameraDetails(*camera))
+    {
+        DEBUG_MESSAGE_EX_INFO("Reconnecting camera changed while connecting: " << camName);
 
-        switch (camera.camId)
+        if (setupMotionRegions)
         {
-        case ipfreely::eCamId::cam1:
-            ui->cam1Widget->layout()->addWidget(feed);
-            ui->camFeed1GroupBox->setToolTip(hint);
-            break;
-        case ipfreely::eCamId::cam2:
-            ui->cam2Widget->layout()->addWidget(feed);
-            ui->camFeed2GroupBox->setToolTip(hint);
-            break;
-        case ipfreely::eCamId::cam3:
-            ui->cam3Widget->layout()->addWidget(feed);
-            ui->camFeed3GroupBox->setToolTip(hint);
-            break;
-        case ipfreely::eCamId::cam4:
-            ui->cam4Widget->layout()->addWidget(feed);
-            ui->camFeed4GroupBox->setToolTip(hint);
-            break;
-        case ipfreely::eCamId::noCam:
-            // Do nothing.
-            break;
+            m_motionSetupOnConnect.emplace(camId);
         }
 
-        m_camFeeds[camera.camId] = feed;
+        ConnectionHandler(*camera);
+        return;
+    }
 
-        recordBtn->setEnabled(!camera.enableScheduledRecording);
-        recordBtn->setIcon(QIcon(":/icons/icons/Record-48.png"));
-        recordBtn->setToolTip("Record from camera stream.");
+    m_streamProcessors[camId] = streamProcessor;
 
-        snapshotBtn->setEnabled(true);
-        expandBtn->setEnabled(true);
-        storageBtn->setEnabled(!camera.storageHttpUrl.empty());
-        motionRegionsBtn->setEnabled(true);
+    if (m_httpServer)
+    {
+        m_httpServer->SetStreamProcessor(camId, streamProcessor);
+    }
 
-        connectBtn->setIcon(QIcon(":/icons/icons/WallCam_Disconnect_48.png"));
-        connectBtn->setToolTip("Disconnect from camera stream.");
+    UpdateFeedDisplaySizes();
 
-        ++m_numConnections;
+    ui->videoGrid->SetToolTip(camId, QString::fromStdString(camera->description));
 
-        m_updateFeedsTimer->start(DEFAULT_UPDATE_PERIOD_MS);
+    if (setupMotionRegions)
+    {
+        EnableMotionRegionsSetup(camId, true);
     }
+
+    UpdateCameraControls();
 }
 
-void IpFreelyMainWindow::RecordActionHandler(ipfreely::eCamId const camId, QToolButton* recordBtn)
+void IpFreelyMainWindow::RecordActionHandler(ipfreely::camera_id_t const camId)
 {
     auto streamProcIter = m_streamProcessors.find(camId);
 
     if (streamProcIter == m_streamProcessors.end())
     {
-        DEBUG_MESSAGE_EX_ERROR("Failed to find stream processor, ID: " << static_cast<int>(camId));
+        DEBUG_MESSAGE_EX_ERROR("Failed to find stream processor, ID: " << camId);
         return;
     }
 
     if (streamProcIter->second->VideoWritingEnabled())
     {
         streamProcIter->second->StopVideoWriting();
-
-        recordBtn->setIcon(QIcon(":/icons/icons/Record-48.png"));
-        recordBtn->setToolTip("Record from camera stream.");
     }
     else
     {
         streamProcIter->second->StartVideoWriting();
-
-        recordBtn->setIcon(QIcon(":/icons/icons/Stop-48.png"));
-        recordBtn->setToolTip("Stop recording from camera stream.");
     }
+
+    UpdateCameraControls();
 }
 
-void IpFreelyMainWindow::UpdateCamFeedFrame(ipfreely::eCamId const camId, QImage const& videoFrame,
-                                            QRect const& motionBoundingRect,
-                                            bool const   streamProcIsWriting)
+void IpFreelyMainWindow::NotifyNewDisplayFrames()
 {
-    auto camFeedIter = m_camFeeds.find(camId);
-
-    if (camFeedIter == m_camFeeds.end())
+    // Called on the stream processors' threads so coalesce all notifications that arrive
+    // before the GUI thread gets round to them into a single queued update.
+    if (!m_videoFeedsUpdatePending.exchange(true))
     {
-        DEBUG_MESSAGE_EX_ERROR("Failed to find camera feed, ID: " << static_cast<int>(camId));
-        return;
+        QMetaObject::invokeMethod(
+            this, &IpFreelyMainWindow::UpdateVideoFeeds, Qt::QueuedConnection);
     }
+}
 
-    QImage displayFrame;
-    double scalar = 1.0;
+void IpFreelyMainWindow::UpdateFeedDisplaySizes()
+{
+    // Cameras not on the current page have no tile so get an empty size, as do all cameras
+    // while we are minimised, which unsubscribes them from feed display frames altogether.
+    bool const minimised = isMinimized();
 
-    if ((camFeedIter->second->width() < videoFrame.width()) ||
-        (camFeedIter->second->height() < videoFrame.height()))
+    for (auto const& streamProcessor : m_streamProcessors)
     {
-        double frameAspectRatio =
-            static_cast<double>(videoFrame.width()) / static_cast<double>(videoFrame.height());
-        double targetAspectRatio = static_cast<double>(camFeedIter->second->width()) /
-                                   static_cast<double>(camFeedIter->second->height());
-        int newWidth  = 0;
-        int newHeight = 0;
+        streamProcessor.second->SetDisplaySize(
+            ipfreely::eDisplayTarget::feed,
+            minimised ? QSize() : ui->videoGrid->VideoDisplaySize(streamProcessor.first));
+    }
+}
 
-        if (targetAspectRatio < frameAspectRatio)
-        {
-            newWidth  = camFeedIter->second->width();
-            newHeight = static_cast<int>(static_cast<double>(newWidth) / frameAspectRatio);
-        }
-        else
-        {
-            newHeight = camFeedIter->second->height();
-            newWidth  = static_cast<int>(static_cast<double>(newHeight) * frameAspectRatio);
-        }
+void IpFreelyMainWindow::SetTilesPerPage(int const tilesPerPage)
+{
+    // Keep the selected camera on screen when changing layout.
+    auto const camIds  = m_camDb.GetCameraIds();
+    auto const camIter = std::find(camIds.begin(), camIds.end(), SelectedCamId());
+    auto const index   = camIter == camIds.end() ? 0 : std::distance(camIds.begin(), camIter);
 
-        scalar = static_cast<double>(newWidth) / static_cast<double>(videoFrame.width());
+    m_prefs.SetTilesPerPage(tilesPerPage);
 
-        displayFrame =
-            videoFrame.scaled(newWidth, newHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    try
+    {
+        m_prefs.Save();
     }
-    else
+    catch (std::exception& e)
     {
-        displayFrame = videoFrame;
+        DEBUG_MESSAGE_EX_ERROR("Failed to save preferences, error message: " << e.what());
     }
 
-    auto motionAreasEnabled = m_motionAreaSetupEnabled[camId];
+    ShowGridPage(static_cast<int>(index) / tilesPerPage);
+}
 
-    if (!motionBoundingRect.isNull() || streamProcIsWriting || motionAreasEnabled)
-    {
-        QPainter p(&displayFrame);
-        QRect    rect                   = motionBoundingRect;
-        bool     intersectsMotionRegion = false;
+void IpFreelyMainWindow::ShowGridPage(int const page)
+{
+    auto const camIds       = m_camDb.GetCameraIds();
+    auto const numCams      = static_cast<int>(camIds.size());
+    auto const tilesPerPage = m_prefs.TilesPerPage();
+    auto const numPages     = std::max((numCams + tilesPerPage - 1) / tilesPerPage, 1);
 
-        if (!motionBoundingRect.isNull())
-        {
-            rect.setTop(static_cast<int>(static_cast<double>(motionBoundingRect.top()) * scalar));
-            rect.setLeft(static_cast<int>(static_cast<double>(motionBoundingRect.left()) * scalar));
-            rect.setRight(
-                static_cast<int>(static_cast<double>(motionBoundingRect.right()) * scalar));
-            rect.setBottom(
-                static_cast<int>(static_cast<double>(motionBoundingRect.bottom()) * scalar));
-        }
+    m_gridPage = std::min(std::max(page, 0), numPages - 1);
 
-        if (motionAreasEnabled)
-        {
-            auto motionRectAreas = m_camMotionRegions[camId];
-            auto pen             = QPen(Qt::cyan);
-            pen.setWidth(2);
-            p.setPen(pen);
-            p.setBackground(QBrush(Qt::NoBrush));
-            p.setBackgroundMode(Qt::TransparentMode);
-            p.setBrush(QBrush(Qt::NoBrush));
-
-            for (auto const& motionRegion : motionRectAreas)
-            {
-                auto r = ipfreely::CreateQRectFromVideoFrameDims(
-                    displayFrame.width(), displayFrame.height(), motionRegion);
+    auto const       firstIndex = m_gridPage * tilesPerPage;
+    auto const       lastIndex  = std::min(firstIndex + tilesPerPage, numCams);
+    std::vector<int> pageCamIds(camIds.begin() + firstIndex, camIds.begin() + lastIndex);
 
-                if (rect.intersects(r))
-                {
-                    intersectsMotionRegion = true;
-                }
+    ui->videoGrid->SetCameraIds(pageCamIds, tilesPerPage);
 
-                p.drawRect(r);
-            }
-        }
+    for (auto camId : pageCamIds)
+    {
+        ipfreely::IpCamera camera;
+        m_camDb.FindCamera(camId, camera);
 
-        if (!rect.isNull())
-        {
-            auto pen = QPen(intersectsMotionRegion ? Qt::red : Qt::green);
-            pen.setWidth(2);
-            p.setPen(pen);
-            p.setBackground(QBrush(Qt::NoBrush));
-            p.setBackgroundMode(Qt::TransparentMode);
-            p.setBrush(QBrush(Qt::NoBrush));
-            p.drawRect(rect);
-        }
+        bool const isConnected = m_streamProcessors.count(camId) > 0;
 
-        if (streamProcIsWriting)
+        ui->videoGrid->SetTitle(camId, tr("Camera %1").arg(camId));
+        ui->videoGrid->SetToolTip(camId,
+                                  isConnected ? QString::fromStdString(camera.description)
+                                              : tr("Not connected"));
+        ui->videoGrid->SetEnableSelection(camId, m_motionAreaSetupEnabled.count(camId) > 0);
+
+        // Until a camera's live video arrives its tile shows the camera's last known frame.
+        if (!isConnected)
         {
-            p.setPen(QPen(Qt::red));
-            p.setBackground(QBrush(Qt::white, Qt::SolidPattern));
-            p.setBackgroundMode(Qt::OpaqueMode);
-            p.setFont(QFont("Segoe UI", 16, QFont::Bold));
-            auto posRec = displayFrame.rect();
-            posRec.setTop(posRec.top() + 16);
-            p.drawText(posRec, Qt::AlignHCenter | Qt::AlignTop, tr("Recording").toLocal8Bit());
+            ShowThumbnail(camId);
         }
+
+        // Make sure a tile coming back on screen picks up the next display frame.
+        m_camFeedFrameSequences.erase(camId);
     }
 
-    camFeedIter->second->SetVideoFrame(displayFrame);
+    ui->actionOneTile->setChecked(tilesPerPage == 1);
+    ui->actionFourTiles->setChecked(tilesPerPage == 4);
+    ui->actionNineTiles->setChecked(tilesPerPage == 9);
+    ui->actionSixteenTiles->setChecked(tilesPerPage == 16);
+    ui->actionPreviousPage->setEnabled(m_gridPage > 0);
+    ui->actionNextPage->setEnabled(m_gridPage < numPages - 1);
+    ui->pageLabel->setText(tr("%1/%2").arg(m_gridPage + 1).arg(numPages));
+
+    // The grid only signals tile size changes but cameras may also have moved on or off screen.
+    UpdateFeedDisplaySizes();
+    UpdateCameraControls();
+}
+
+std::string IpFreelyMainWindow::CameraName(ipfreely::camera_id_t const camId)
+{
+    return "Camera" + std::to_string(camId);
 }
 
-void IpFreelyMainWindow::SaveImageSnapshot(ipfreely::eCamId const camId)
+void IpFreelyMainWindow::UpdateCamFeedFrame(ipfreely::camera_id_t const camId,
+                                            QImage const&               displayFrame)
+{
+    IPFREELY_TRACE_SCOPE_ID("UpdateCamFeedFrame", camId);
+    ui->videoGrid->SetVideoFrame(camId, displayFrame);
+}
+
+void IpFreelyMainWindow::SaveImageSnapshot(ipfreely::camera_id_t const camId)
 {
     auto streamProcIter = m_streamProcessors.find(camId);
 
     if (streamProcIter == m_streamProcessors.end())
     {
-        DEBUG_MESSAGE_EX_ERROR("Failed to find stream processor, ID: " << static_cast<int>(camId));
+        DEBUG_MESSAGE_EX_ERROR("Failed to find stream processor, ID: " << camId);
+        return;
+    }
+
+    auto const frameSequence = streamProcIter->second->VideoFrameSequence();
+
+    if ((frameSequence == 0) || (frameSequence == m_snapshotFrameSequences[camId]))
+    {
+        DEBUG_MESSAGE_EX_WARNING("No new video frame available for snapshot, ID: "
+                                 << camId);
         return;
     }
 
@@ -1377,26 +1084,7 @@ void IpFreelyMainWindow::SaveImageSnapshot(ipfreely::eCamId const camId)
         }
     }
 
-    std::string camName;
-
-    switch (camId)
-    {
-    case ipfreely::eCamId::cam1:
-        camName = "Camera1";
-        break;
-    case ipfreely::eCamId::cam2:
-        camName = "Camera2";
-        break;
-    case ipfreely::eCamId::cam3:
-        camName = "Camera3";
-        break;
-    case ipfreely::eCamId::cam4:
-        camName = "Camera4";
-        break;
-    case ipfreely::eCamId::noCam:
-        // Do nothing.
-        break;
-    }
+    auto const camName = CameraName(camId);
 
     std::ostringstream fileOss;
     fileOss << camName << "_" << timestamp << ".png";
@@ -1405,7 +1093,10 @@ void IpFreelyMainWindow::SaveImageSnapshot(ipfreely::eCamId const camId)
 
     DEBUG_MESSAGE_EX_INFO("Creating new output image file: " << p.string());
 
-    auto videoFrame = streamProcIter->second->CurrentVideoFrame();
+    uint64_t currentFrameSequence = 0;
+    auto     videoFrame = streamProcIter->second->CurrentVideoFrame(nullptr, &currentFrameSequence);
+
+    m_snapshotFrameSequences[camId] = currentFrameSequence;
 
     if (!videoFrame.save(QString::fromStdString(p.string())))
     {
@@ -1420,93 +1111,155 @@ void IpFreelyMainWindow::SaveImageSnapshot(ipfreely::eCamId const camId)
     }
 }
 
-void IpFreelyMainWindow::SetFpsInTitle(ipfreely::eCamId const camId, double fps, double originalFps)
+std::string IpFreelyMainWindow::ThumbnailPath(ipfreely::camera_id_t const camId)
+{
+    auto path = bfs::initial_path();
+    path /= "Thumbnails";
+    path /= CameraName(camId) + ".jpg";
+    return bfs::system_complete(path).string();
+}
+
+void IpFreelyMainWindow::SaveThumbnail(ipfreely::camera_id_t const camId)
+{
+    static constexpr int THUMBNAIL_MAX_WIDTH  = 320;
+    static constexpr int THUMBNAIL_MAX_HEIGHT = 240;
+    static constexpr int THUMBNAIL_QUALITY    = 75;
+
+    auto streamProcIter = m_streamProcessors.find(camId);
+
+    if (streamProcIter == m_streamProcessors.end())
+    {
+        return;
+    }
+
+    auto const thumbnail = streamProcIter->second->ThumbnailVideoFrame(
+        QSize(THUMBNAIL_MAX_WIDTH, THUMBNAIL_MAX_HEIGHT));
+
+    if (thumbnail.isNull())
+    {
+        return;
+    }
+
+    bfs::path  p(ThumbnailPath(camId));
+    auto const parentPath = p.parent_path();
+
+    try
+    {
+        if (!bfs::exists(parentPath))
+        {
+            bfs::create_directories(parentPath);
+        }
+    }
+    catch (std::exception& e)
+    {
+        DEBUG_MESSAGE_EX_ERROR("Failed to create thumbnail folder: " << parentPath.string()
+                                                                     << ", error message: "
+                                                                     << e.what());
+        return;
+    }
+
+    // Write to a temporary file that replaces the old thumbnail only once complete, so a
+    // crash part way through never leaves a corrupt thumbnail behind.
+    QSaveFile file(QString::fromStdString(p.string()));
+
+    if (!file.open(QIODevice::WriteOnly) || !thumbnail.save(&file, "JPG", THUMBNAIL_QUALITY) ||
+        !file.commit())
+    {
+        DEBUG_MESSAGE_EX_ERROR("Failed to save thumbnail: " << p.string());
+    }
+}
+
+void IpFreelyMainWindow::SaveThumbnails()
 {
-    switch (camId)
-    {
-    case ipfreely::eCamId::cam1:
-        ui->camFeed1GroupBox->setTitle(tr("Camera 1: ") + QString::number(fps) +
-                                       tr(" Recording FPS, ") + QString::number(originalFps) +
-                                       tr(" Stream FPS"));
-        break;
-    case ipfreely::eCamId::cam2:
-        ui->camFeed2GroupBox->setTitle(tr("Camera 2: ") + QString::number(fps) +
-                                       tr(" Recording FPS, ") + QString::number(originalFps) +
-                                       tr(" Stream FPS"));
-        break;
-    case ipfreely::eCamId::cam3:
-        ui->camFeed3GroupBox->setTitle(tr("Camera 3: ") + QString::number(fps) +
-                                       tr(" Recording FPS, ") + QString::number(originalFps) +
-                                       tr(" Stream FPS"));
-        break;
-    case ipfreely::eCamId::cam4:
-        ui->camFeed4GroupBox->setTitle(tr("Camera 4: ") + QString::number(fps) +
-                                       tr(" Recording FPS, ") + QString::number(originalFps) +
-                                       tr(" Stream FPS"));
-        break;
-    case ipfreely::eCamId::noCam:
-        // Do nothing.
-        break;
+    for (auto const& streamProcessor : m_streamProcessors)
+    {
+        SaveThumbnail(streamProcessor.first);
+    }
+}
+
+void IpFreelyMainWindow::ShowThumbnail(ipfreely::camera_id_t const camId)
+{
+    auto const path = QString::fromStdString(ThumbnailPath(camId));
+    QImage     thumbnail;
+
+    if (!QFileInfo::exists(path) || !thumbnail.load(path))
+    {
+        return;
     }
+
+    // Thumbnails are JPEGs so convert once here rather than every time the tile is painted.
+    thumbnail = thumbnail.convertToFormat(QImage::Format_RGB32);
+
+    auto const lastSeen = QLocale().toString(QFileInfo(path).lastModified(), QLocale::ShortFormat);
+
+    ui->videoGrid->SetStaleVideoFrame(camId, thumbnail, tr("Last seen %1").arg(lastSeen));
 }
 
-void IpFreelyMainWindow::ShowExpandedVideoForm(ipfreely::eCamId const camId)
+void IpFreelyMainWindow::SetFpsInTitle(ipfreely::camera_id_t const camId,
+                                       double                      fps,
+                                       double                      originalFps)
+{
+    ui->videoGrid->SetTitle(camId,
+                            tr("Camera %1: ").arg(camId) + QString::number(fps) +
+                                tr(" Recording FPS, ") + QString::number(originalFps) +
+                                tr(" Stream FPS"));
+}
+
+void IpFreelyMainWindow::ShowExpandedVideoForm(ipfreely::camera_id_t const camId)
 {
     if (m_videoForm->isVisible())
     {
         m_videoForm->close();
     }
 
-    switch (camId)
+    if (camId != ipfreely::NO_CAMERA_ID)
     {
-    case ipfreely::eCamId::cam1:
-        m_videoForm->SetTitle(tr("Camera 1"));
-        break;
-    case ipfreely::eCamId::cam2:
-        m_videoForm->SetTitle(tr("Camera 2"));
-        break;
-    case ipfreely::eCamId::cam3:
-        m_videoForm->SetTitle(tr("Camera 3"));
-        break;
-    case ipfreely::eCamId::cam4:
-        m_videoForm->SetTitle(tr("Camera 4"));
-        break;
-    case ipfreely::eCamId::noCam:
-        // Do nothing.
-        break;
+        m_videoForm->SetTitle(tr("Camera %1").arg(camId));
     }
 
-    m_videoFormId = camId;
+    m_videoFormId            = camId;
+    m_videoFormFrameSequence = 0;
     m_videoForm->show();
+
+    auto streamProcIter = m_streamProcessors.find(camId);
+
+    if (streamProcIter != m_streamProcessors.end())
+    {
+        streamProcIter->second->SetDisplaySize(ipfreely::eDisplayTarget::expanded,
+                                               m_videoForm->DisplaySize());
+        streamProcIter->second->SetDisplayRegion(ipfreely::eDisplayTarget::expanded,
+                                                 m_videoForm->DisplayRegion());
+    }
 }
 
 void IpFreelyMainWindow::ViewStorage(ipfreely::IpCamera const& camera)
 {
-    IpFreelySdCardViewerDialog sdCardDlg(camera, this);
-    sdCardDlg.setModal(true);
-    sdCardDlg.exec();
+    // The browser needs QtWebEngine so runs as a separate process, only started when it is
+    // used. It reads the camera's details from the saved database in our working folder.
+    static constexpr char const* STORAGE_BROWSER_NAME = "IpFreelyStorageBrowser";
+
+    auto const program =
+        QDir(QCoreApplication::applicationDirPath()).filePath(STORAGE_BROWSER_NAME);
+    QStringList const arguments{"--camera", QString::number(camera.camId)};
+
+    if (!QProcess::startDetached(program, arguments, QDir::currentPath()))
+    {
+        DEBUG_MESSAGE_EX_ERROR("Failed to start storage browser: " << program.toStdString());
+        QMessageBox::critical(this,
+                              tr("Storage Error"),
+                              tr("Failed to start the storage browser: %1").arg(program),
+                              QMessageBox::Ok,
+                              QMessageBox::Ok);
+    }
 }
 
 void IpFreelyMainWindow::VideoFrameAreaSelection(int const     cameraId,
                                                  QRectF const& percentageSelection)
 {
-    ipfreely::eCamId camId;
-
-    switch (cameraId)
-    {
-    case 1:
-        camId = ipfreely::eCamId::cam1;
-        break;
-    case 2:
-        camId = ipfreely::eCamId::cam2;
-        break;
-    case 3:
-        camId = ipfreely::eCamId::cam3;
-        break;
-    case 4:
-        camId = ipfreely::eCamId::cam4;
-        break;
-    default:
+    auto const camId = static_cast<ipfreely::camera_id_t>(cameraId);
+
+    if (camId == ipfreely::NO_CAMERA_ID)
+    {
         DEBUG_MESSAGE_EX_ERROR("Invalid camera ID value: " << cameraId);
         return;
     }
@@ -1524,26 +1277,23 @@ void IpFreelyMainWindow::VideoFrameAreaSelection(int const     cameraId,
         camera.motionRegions = m_camMotionRegions[camId];
         m_camDb.UpdateCamera(camera);
         m_camDb.Save();
-
-        ReconnectCamera(camId);
     }
+
+    UpdateMotionRegionsOverlay(camId);
 }
 
-void IpFreelyMainWindow::EnableMotionRegionsSetup(ipfreely::eCamId const camId, bool const enable,
-                                                  QToolButton* removeRegionsBtn,
-                                                  QToolButton* setMotionRegionsBtn)
+void IpFreelyMainWindow::EnableMotionRegionsSetup(ipfreely::camera_id_t const camId,
+                                                  bool const                  enable)
 {
-    removeRegionsBtn->setVisible(enable);
-
-    auto camFeedIter = m_camFeeds.find(camId);
+    auto streamProcIter = m_streamProcessors.find(camId);
 
-    if (camFeedIter == m_camFeeds.end())
+    if (streamProcIter == m_streamProcessors.end())
     {
-        DEBUG_MESSAGE_EX_ERROR("Failed to find camera feed, ID: " << static_cast<int>(camId));
+        DEBUG_MESSAGE_EX_ERROR("Failed to find stream processor, ID: " << camId);
         return;
     }
 
-    camFeedIter->second->SetEnableSelection(enable);
+    ui->videoGrid->SetEnableSelection(camId, enable);
 
     if (enable)
     {
@@ -1554,25 +1304,28 @@ void IpFreelyMainWindow::EnableMotionRegionsSetup(ipfreely::eCamId const camId,
             m_camMotionRegions[camId]       = camera.motionRegions;
             m_motionAreaSetupEnabled[camId] = true;
         }
-
-        bool blockState = setMotionRegionsBtn->blockSignals(true);
-        setMotionRegionsBtn->setChecked(true);
-        setMotionRegionsBtn->blockSignals(blockState);
     }
     else
     {
         m_camMotionRegions.erase(camId);
         m_motionAreaSetupEnabled.erase(camId);
     }
+
+    UpdateMotionRegionsOverlay(camId);
+
+    if (camId == SelectedCamId())
+    {
+        UpdateCameraControls();
+    }
 }
 
-void IpFreelyMainWindow::RemoveMotionRegions(ipfreely::eCamId const camId)
+void IpFreelyMainWindow::RemoveMotionRegions(ipfreely::camera_id_t const camId)
 {
     ipfreely::IpCamera camera;
 
     if (!m_camDb.FindCamera(camId, camera))
     {
-        DEBUG_MESSAGE_EX_ERROR("Failed to find camera, ID: " << static_cast<int>(camId));
+        DEBUG_MESSAGE_EX_ERROR("Failed to find camera, ID: " << camId);
         return;
     }
 
@@ -1591,40 +1344,219 @@ void IpFreelyMainWindow::RemoveMotionRegions(ipfreely::eCamId const camId)
     camera.motionRegions = m_camMotionRegions[camId];
     m_camDb.UpdateCamera(camera);
     m_camDb.Save();
+    UpdateMotionRegionsOverlay(camId);
+}
+
+void IpFreelyMainWindow::UpdateMotionRegionsOverlay(ipfreely::camera_id_t const camId)
+{
+    // The overlay is drawn by the stream processor, so it only changes when it is pushed there.
+    auto streamProcIter = m_streamProcessors.find(camId);
+
+    if (streamProcIter == m_streamProcessors.end())
+    {
+        return;
+    }
 
+    ipfreely::IpCamera::regions_t motionRegions;
+    auto                          motionRegionsIter = m_camMotionRegions.find(camId);
+
+    if (motionRegionsIter != m_camMotionRegions.end())
+    {
+        motionRegions = motionRegionsIter->second;
+    }
+
+    streamProcIter->second->SetMotionRegionsOverlay(motionRegions);
+}
+
+void IpFreelyMainWindow::ReconnectCamera(ipfreely::camera_id_t const camId)
+{
+    // Connecting completes asynchronously so the motion regions setup is restored then.
+    if (m_motionAreaSetupEnabled.count(camId) > 0)
+    {
+        m_motionSetupOnConnect.emplace(camId);
+    }
+
+    ToggleConnection(camId);
+    ToggleConnection(camId);
+}
+
+void IpFreelyMainWindow::CameraChanged(ipfreely::camera_id_t const camId,
+                                       camera_ptr_t const&         camera)
+{
+    auto streamProcIter = m_streamProcessors.find(camId);
+
+    if (streamProcIter == m_streamProcessors.end())
+    {
+        return;
+    }
+
+    if (!camera)
+    {
+        // Only the camera's ID is needed to disconnect from it.
+        ipfreely::IpCamera removedCamera;
+        removedCamera.camId = camId;
+        ConnectionHandler(removedCamera);
+        return;
+    }
+
+    if (streamProcIter->second->UpdateCameraDetails(*camera))
+    {
+        ui->videoGrid->SetToolTip(camId, QString::fromStdString(camera->description));
+        return;
+    }
+
+    DEBUG_MESSAGE_EX_INFO("Reconnecting to apply new camera settings: " << CameraName(camId));
     ReconnectCamera(camId);
 }
 
-void IpFreelyMainWindow::ReconnectCamera(ipfreely::eCamId const camId)
+void IpFreelyMainWindow::CreateHttpServer()
+{
+    // Stop the old server first so the new one can listen on the same port.
+    m_httpServer.reset();
+
+    if (m_prefs.HttpServerPort() == 0)
+    {
+        return;
+    }
+
+    m_httpServer = std::make_shared<ipfreely::IpFreelyHttpServer>(
+        static_cast<uint16_t>(m_prefs.HttpServerPort()),
+        m_prefs.HttpBindAddress(),
+        QSize(m_prefs.HttpFrameWidth(), m_prefs.HttpFrameHeight()),
+        m_prefs.HttpJpegQuality(),
+        m_prefs.HttpMaxFps(),
+        m_metrics);
+
+    for (auto const& streamProcessor : m_streamProcessors)
+    {
+        m_httpServer->SetStreamProcessor(streamProcessor.first, streamProcessor.second);
+    }
+}
+
+void IpFreelyMainWindow::CreateRtspProxy()
 {
-    switch (camId)
-    {
-    case ipfreely::eCamId::cam1:
-        on_connect1ToolButton_clicked();
-        on_connect1ToolButton_clicked();
-        EnableMotionRegionsSetup(
-            camId, true, ui->cam1RemoveMotionRegionsToolButton, ui->cam1MotionRegionsToolButton);
-        break;
-    case ipfreely::eCamId::cam2:
-        on_connect2ToolButton_clicked();
-        on_connect2ToolButton_clicked();
-        EnableMotionRegionsSetup(
-            camId, true, ui->cam2RemoveMotionRegionsToolButton, ui->cam2MotionRegionsToolButton);
-        break;
-    case ipfreely::eCamId::cam3:
-        on_connect3ToolButton_clicked();
-        on_connect3ToolButton_clicked();
-        EnableMotionRegionsSetup(
-            camId, true, ui->cam3RemoveMotionRegionsToolButton, ui->cam3MotionRegionsToolButton);
-        break;
-    case ipfreely::eCamId::cam4:
-        on_connect4ToolButton_clicked();
-        on_connect4ToolButton_clicked();
-        EnableMotionRegionsSetup(
-            camId, true, ui->cam4RemoveMotionRegionsToolButton, ui->cam4MotionRegionsToolButton);
-        break;
-    case ipfreely::eCamId::noCam:
-        // Do nothing
-        break;
+    // Stop the old proxy first so the new one can listen on the same port.
+    m_rtspProxy.reset();
+
+    if (m_prefs.RtspProxyPort() == 0)
+    {
+        return;
     }
+
+    m_rtspProxy = std::make_shared<ipfreely::IpFreelyRtspProxy>(
+        static_cast<uint16_t>(m_prefs.RtspProxyPort()), m_prefs.RtspProxyBindAddress());
+
+    UpdateServiceCameras();
+}
+
+void IpFreelyMainWindow::CreateStorageMirror()
+{
+    // Stop the old mirror first so two never write to the same folder.
+    m_storageMirror.reset();
+
+    if (m_prefs.MirrorFolderPath().empty())
+    {
+        return;
+    }
+
+    ipfreely::MirrorSettings settings;
+    settings.mirrorFolderPath            = m_prefs.MirrorFolderPath();
+    settings.syncIntervalMins            = m_prefs.MirrorIntervalMins();
+    settings.maxActiveDownloads          = m_prefs.MaxActiveDownloads();
+    settings.connectionsPerCamera        = m_prefs.DownloadConnectionsPerCamera();
+    settings.kibPerSecPerCamera          = m_prefs.DownloadKiBPerSecPerCamera();
+    settings.recordingKiBPerSecPerCamera = m_prefs.MirrorRecordingKiBPerSecPerCamera();
+    settings.recordingSchedule =
+        ipfreely::IpFreelySchedule::FromHourlySchedule(m_prefs.RecordingSchedule());
+    settings.motionSchedule =
+        ipfreely::IpFreelySchedule::FromHourlySchedule(m_prefs.MotionTrackingSchedule());
+
+    m_storageMirror = std::make_shared<ipfreely::IpFreelyStorageMirror>(settings);
+
+    UpdateServiceCameras();
+}
+
+void IpFreelyMainWindow::UpdateServiceCameras()
+{
+    if (!m_rtspProxy && !m_storageMirror)
+    {
+        return;
+    }
+
+    // The proxy and mirror open their own sessions to the cameras, so they are given every
+    // camera in the database whether or not we are connected to it.
+    std::vector<ipfreely::IpCamera> cameras;
+
+    for (auto const camId : m_camDb.GetCameraIds())
+    {
+        ipfreely::IpCamera camera;
+
+        if (m_camDb.FindCamera(camId, camera))
+        {
+            cameras.emplace_back(camera);
+        }
+    }
+
+    if (m_rtspProxy)
+    {
+        m_rtspProxy->SetCameras(cameras);
+    }
+
+    if (m_storageMirror)
+    {
+        m_storageMirror->SetCameras(cameras);
+    }
+}
+
+QString IpFreelyMainWindow::HudText(ipfreely::StreamStatsSnapshot const& current,
+                                    ipfreely::StreamStatsSnapshot const& previous,
+                                    bool const                           expanded)
+{
+    auto const elapsedSecs =
+        std::chrono::duration<double>(current.sampleTime - previous.sampleTime).count();
+
+    if (elapsedSecs <= 0.0)
+    {
+        return QString();
+    }
+
+    // The camera's counters persist across reconnects, so a difference is the activity since
+    // the previous HUD update. A snapshot can never be ahead of a later one, but clamp anyway.
+    auto const delta = [](uint64_t const currentCount, uint64_t const previousCount) {
+        return currentCount > previousCount ? currentCount - previousCount : 0;
+    };
+
+    auto const averageMs = [](uint64_t const nanosecs, uint64_t const count) {
+        return count > 0 ? static_cast<double>(nanosecs) / 1.0e6 / static_cast<double>(count)
+                         : 0.0;
+    };
+
+    auto const framesGrabbed = delta(current.framesGrabbed, previous.framesGrabbed);
+    auto const framesRendered =
+        expanded ? delta(current.expandedFramesRendered, previous.expandedFramesRendered)
+                 : delta(current.feedFramesRendered, previous.feedFramesRendered);
+    auto const motionFrames = delta(current.motionFramesProcessed, previous.motionFramesProcessed);
+    auto const latencyNanosecs =
+        expanded ? current.expandedLatencyNanosecs : current.feedLatencyNanosecs;
+
+    return tr("Input: %1 fps, Displayed: %2 fps\n"
+              "Decode: %3 ms, Latency: %4 ms\n"
+              "Motion: %5 queued, %6 ms/frame\n"
+              "Encoder: %7 queued, %8 dropped\n"
+              "Bitrate: %9")
+        .arg(static_cast<double>(framesGrabbed) / elapsedSecs, 0, 'f', 1)
+        .arg(static_cast<double>(framesRendered) / elapsedSecs, 0, 'f', 1)
+        .arg(averageMs(delta(current.decodeNanosecs, previous.decodeNanosecs), framesGrabbed),
+             0,
+             'f',
+             1)
+        .arg(static_cast<double>(latencyNanosecs) / 1.0e6, 0, 'f', 1)
+        .arg(current.motionQueueDepth)
+        .arg(averageMs(delta(current.motionNanosecs, previous.motionNanosecs), motionFrames),
+             0,
+             'f',
+             1)
+        .arg(current.encoderQueueDepth)
+        .arg(current.framesDropped)
+        .arg(current.bitrateKbps > 0 ? tr("%1 kbit/s").arg(current.bitrateKbps) : tr("n/a"));
 }
@@ -30,8 +30,14 @@
 #include <QPoint>
 #include <memory>
 #include <map>
+#include <set>
+#include <future>
+#include <string>
+#include <cstdint>
+#include <atomic>
 #include "IpFreelyPreferences.h"
 #include "IpFreelyCameraDatabase.h"
+#include "IpFreelyStreamStats.h"
 
 // Forward declarations.
 namespace Ui
@@ -43,16 +49,17 @@ namespace ipfreely
 {
 class IpFreelyStreamProcessor;
 class IpFreelyDiskSpaceManager;
+class IpFreelyHttpServer;
+class IpFreelyRtspProxy;
+class IpFreelyStorageMirror;
+class IpFreelyMetrics;
 } // namespace ipfreely
 
-class QToolButton;
-class QTimer;
-class QResizeEvent;
 class QCloseEvent;
-class QGroupBox;
-class IpFreelyVideoFrame;
+class QEvent;
 class IpFreelyVideoForm;
 class QRectF;
+class QTimer;
 
 /*! \brief Class defining the main window's form. */
 class IpFreelyMainWindow : public QMainWindow
@@ -60,6 +67,7 @@ class IpFreelyMainWindow : public QMainWindow
     Q_OBJECT
 
     typedef std::shared_ptr<ipfreely::IpFreelyStreamProcessor> stream_proc_t;
+    typedef ipfreely::IpFreelyCameraDatabase::camera_ptr_t     camera_ptr_t;
 
 public:
     /*!
@@ -75,81 +83,102 @@ private slots:
     void on_actionClose_triggered();
     void on_actionPreferences_triggered();
     void on_actionAbout_triggered();
-    void on_settings1ToolButton_clicked();
-    void on_connect1ToolButton_clicked();
-    void on_motionDetectorRegions1ToolButton_toggled(bool checked);
-    void on_removeMotionRegions1ToolButton_clicked();
-    void on_record1ToolButton_clicked();
-    void on_snapshot1ToolButton_clicked();
-    void on_expand1ToolButton_clicked();
-    void on_storage1ToolButton_clicked();
-    void on_settings2ToolButton_clicked();
-    void on_connect2ToolButton_clicked();
-    void on_motionDetectorRegions2ToolButton_toggled(bool checked);
-    void on_removeMotionRegions2ToolButton_clicked();
-    void on_record2ToolButton_clicked();
-    void on_snapshot2ToolButton_clicked();
-    void on_expand2ToolButton_clicked();
-    void on_storage2ToolButton_clicked();
-    void on_settings3ToolButton_clicked();
-    void on_connect3ToolButton_clicked();
-    void on_motionDetectorRegions3ToolButton_toggled(bool checked);
-    void on_removeMotionRegions3ToolButton_clicked();
-    void on_record3ToolButton_clicked();
-    void on_snapshot3ToolButton_clicked();
-    void on_expand3ToolButton_clicked();
-    void on_storage3ToolButton_clicked();
-    void on_settings4ToolButton_clicked();
-    void on_connect4ToolButton_clicked();
-    void on_motionDetectorRegions4ToolButton_toggled(bool checked);
-    void on_removeMotionRegions4ToolButton_clicked();
-    void on_record4ToolButton_clicked();
-    void on_snapshot4ToolButton_clicked();
-    void on_expand4ToolButton_clicked();
-    void on_storage4ToolButton_clicked();
-    void on_updateFeedsTimer();
+    void on_actionAddCamera_triggered();
+    void on_actionOneTile_triggered();
+    void on_actionFourTiles_triggered();
+    void on_actionNineTiles_triggered();
+    void on_actionSixteenTiles_triggered();
+    void on_actionPreviousPage_triggered();
+    void on_actionNextPage_triggered();
+    void on_actionPerformanceHud_toggled(bool checked);
+    void on_actionRecordTrace_toggled(bool checked);
+    void on_actionSaveTrace_triggered();
+    void on_settingsToolButton_clicked();
+    void on_connectToolButton_clicked();
+    void on_motionRegionsToolButton_toggled(bool checked);
+    void on_removeMotionRegionsToolButton_clicked();
+    void on_recordToolButton_clicked();
+    void on_imageToolButton_clicked();
+    void on_expandToolButton_clicked();
+    void on_storageToolButton_clicked();
+    void UpdateVideoFeeds();
+    void UpdatePerformanceHud();
 
 protected:
     virtual void closeEvent(QCloseEvent* event);
-    virtual void resizeEvent(QResizeEvent* event);
+    virtual void changeEvent(QEvent* event);
 
 private:
-    void     SetDisplaySize();
-    void     ConnectButtons();
-    void     CheckStartupConnections();
-    void     SetupCameraInDb(ipfreely::eCamId const camId, QToolButton* connectBtn);
-    void     ConnectionHandler(ipfreely::IpCamera const& camera, QToolButton* connectBtn,
-                               QToolButton* motionRegionsBtn, QToolButton* removeRegionsBtn,
-                               QToolButton* recordBtn, QToolButton* snapshotBtn, QToolButton* expandBtn,
-                               QToolButton* storageBtn);
-    void     RecordActionHandler(ipfreely::eCamId const camId, QToolButton* recordBtn);
-    QWidget* GetParentFrame(ipfreely::eCamId const camId) const;
-    void     UpdateCamFeedFrame(ipfreely::eCamId const camId, QImage const& videoFrame,
-                                QRect const& motionBoundingRect, bool const streamProcIsWriting);
-    void     SaveImageSnapshot(ipfreely::eCamId const camId);
-    void     SetFpsInTitle(ipfreely::eCamId const camId, double fps, double originalFps);
-    void     ShowExpandedVideoForm(ipfreely::eCamId const camId);
-    void     ViewStorage(ipfreely::IpCamera const& camera);
-    void     VideoFrameAreaSelection(int const cameraId, QRectF const& percentageSelection);
-    void     EnableMotionRegionsSetup(ipfreely::eCamId const camId, bool const enable,
-                                      QToolButton* removeRegionsBtn, QToolButton* setMotionRegionsBtn);
-    void     RemoveMotionRegions(ipfreely::eCamId const camId);
-    void     ReconnectCamera(ipfreely::eCamId const camId);
+    void                  SetDisplaySize();
+    void                  CheckStartupConnections();
+    ipfreely::camera_id_t SelectedCamId() const;
+    void                  SelectCamera(int const cameraId);
+    void                  UpdateCameraControls();
+    void                  SetupCameraInDb(ipfreely::camera_id_t const camId);
+    void                  ToggleConnection(ipfreely::camera_id_t const camId);
+    void                  ConnectionHandler(ipfreely::IpCamera const& camera);
+    void                  CompleteConnection(ipfreely::camera_id_t const camId);
+    void                  RecordActionHandler(ipfreely::camera_id_t const camId);
+    void                  NotifyNewDisplayFrames();
+    void                  UpdateFeedDisplaySizes();
+    void                  SetTilesPerPage(int const tilesPerPage);
+    void                  ShowGridPage(int const page);
+    static std::string    CameraName(ipfreely::camera_id_t const camId);
+    void                  UpdateCamFeedFrame(ipfreely::camera_id_t const camId,
+                                             QImage const&               displayFrame);
+    void                  SaveImageSnapshot(ipfreely::camera_id_t const camId);
+    static std::string    ThumbnailPath(ipfreely::camera_id_t const camId);
+    void                  SaveThumbnail(ipfreely::camera_id_t const camId);
+    void                  SaveThumbnails();
+    void                  ShowThumbnail(ipfreely::camera_id_t const camId);
+    void                  SetFpsInTitle(ipfreely::camera_id_t const camId,
+                                        double                      fps,
+                                        double                      originalFps);
+    void                  ShowExpandedVideoForm(ipfreely::camera_id_t const camId);
+    void                  ViewStorage(ipfreely::IpCamera const& camera);
+    void                  VideoFrameAreaSelection(int const     cameraId,
+                                                  QRectF const& percentageSelection);
+    void                  EnableMotionRegionsSetup(ipfreely::camera_id_t const camId,
+                                                   bool const                  enable);
+    void                  RemoveMotionRegions(ipfreely::camera_id_t const camId);
+    void                  UpdateMotionRegionsOverlay(ipfreely::camera_id_t const camId);
+    void                  ReconnectCamera(ipfreely::camera_id_t const camId);
+    void                  CameraChanged(ipfreely::camera_id_t const camId,
+                                        camera_ptr_t const&         camera);
+    void                  CreateHttpServer();
+    void                  CreateRtspProxy();
+    void                  CreateStorageMirror();
+    void                  UpdateServiceCameras();
+    static QString        HudText(ipfreely::StreamStatsSnapshot const& current,
+                                  ipfreely::StreamStatsSnapshot const& previous,
+                                  bool const                           expanded);
 
 private:
-    Ui::IpFreelyMainWindow*                                   ui;
-    QString                                                   m_appVersion;
-    ipfreely::IpFreelyPreferences                             m_prefs;
-    ipfreely::IpFreelyCameraDatabase                          m_camDb;
-    QTimer*                                                   m_updateFeedsTimer;
-    int                                                       m_numConnections;
-    std::shared_ptr<IpFreelyVideoForm>                        m_videoForm;
-    ipfreely::eCamId                                          m_videoFormId;
-    std::map<ipfreely::eCamId, IpFreelyVideoFrame*>           m_camFeeds;
-    std::map<ipfreely::eCamId, ipfreely::IpCamera::regions_t> m_camMotionRegions;
-    std::map<ipfreely::eCamId, bool>                          m_motionAreaSetupEnabled;
-    std::map<ipfreely::eCamId, stream_proc_t>                 m_streamProcessors;
-    std::shared_ptr<ipfreely::IpFreelyDiskSpaceManager>       m_diskSpaceMgr;
+    Ui::IpFreelyMainWindow*                                        ui;
+    QString                                                        m_appVersion;
+    ipfreely::IpFreelyPreferences                                  m_prefs;
+    ipfreely::IpFreelyCameraDatabase                               m_camDb;
+    std::atomic<bool>                                              m_videoFeedsUpdatePending;
+    std::shared_ptr<IpFreelyVideoForm>                             m_videoForm;
+    ipfreely::camera_id_t                                          m_videoFormId;
+    uint64_t                                                       m_videoFormFrameSequence;
+    int                                                            m_gridPage;
+    std::map<ipfreely::camera_id_t, uint64_t>                      m_camFeedFrameSequences;
+    std::map<ipfreely::camera_id_t, uint64_t>                      m_snapshotFrameSequences;
+    std::map<ipfreely::camera_id_t, ipfreely::IpCamera::regions_t> m_camMotionRegions;
+    std::map<ipfreely::camera_id_t, bool>                          m_motionAreaSetupEnabled;
+    std::map<ipfreely::camera_id_t, stream_proc_t>                 m_streamProcessors;
+    std::map<ipfreely::camera_id_t, std::future<stream_proc_t>>    m_pendingConnections;
+    std::set<ipfreely::camera_id_t>                                m_motionSetupOnConnect;
+    std::set<ipfreely::camera_id_t>                                m_reconnectOnConnect;
+    QTimer*                                                        m_thumbnailTimer;
+    QTimer*                                                        m_hudTimer;
+    std::map<ipfreely::camera_id_t, ipfreely::StreamStatsSnapshot> m_hudSnapshots;
+    std::shared_ptr<ipfreely::IpFreelyMetrics>                     m_metrics;
+    std::shared_ptr<ipfreely::IpFreelyDiskSpaceManager>            m_diskSpaceMgr;
+    std::shared_ptr<ipfreely::IpFreelyHttpServer>                  m_httpServer;
+    std::shared_ptr<ipfreely::IpFreelyRtspProxy>                   m_rtspProxy;
+    std::shared_ptr<ipfreely::IpFreelyStorageMirror>               m_storageMirror;
 };
 
 #endif // IPFREELYMAINWINDOW_H
@@ -0,0 +1,272 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyMetrics.cpp
+ * \brief File containing definition of IpFreelyMetrics class.
+ */
+#include "IpFreelyMetrics.h"
+#include <sstream>
+#include <iomanip>
+#include <utility>
+#include <vector>
+#include "IpFreelyStreamStats.h"
+
+namespace ipfreely
+{
+
+namespace
+{
+
+static constexpr uint64_t NANOSECS_PER_SEC = 1000000000;
+
+/*! \brief Typedef for the camera counter snapshots a scrape is rendered from. */
+typedef std::vector<std::pair<camera_id_t, StreamStatsSnapshot>> camera_snapshots_t;
+
+void WriteHeader(std::ostream& os, char const* name, char const* type, char const* help)
+{
+    os << "# HELP " << name << ' ' << help << '\n';
+    os << "# TYPE " << name << ' ' << type << '\n';
+}
+
+void WriteSeconds(std::ostream& os, uint64_t const nanosecs)
+{
+    // Written from integers so large sums lose no precision.
+    os << nanosecs / NANOSECS_PER_SEC << '.' << std::setfill('0') << std::setw(9)
+       << nanosecs % NANOSECS_PER_SEC << std::setfill(' ');
+}
+
+template <typename Getter>
+void WriteCameraMetric(std::ostream& os, char const* name, char const* type, char const* help,
+                       camera_snapshots_t const& snapshots, Getter getter)
+{
+    WriteHeader(os, name, type, help);
+
+    for (auto const& snapshot : snapshots)
+    {
+        os << name << "{camera=\"" << snapshot.first << "\"} " << getter(snapshot.second)
+           << '\n';
+    }
+}
+
+template <typename Getter>
+void WriteCameraHistogram(std::ostream& os, char const* name, char const* help,
+                          camera_snapshots_t const& snapshots, Getter getter)
+{
+    WriteHeader(os, name, "histogram", help);
+
+    auto const& bounds = IpFreelyLatencyHistogram::BucketBounds();
+
+    for (auto const& snapshot : snapshots)
+    {
+        LatencyHistogramSnapshot const& histogram = getter(snapshot.second);
+        uint64_t                        count     = 0;
+
+        // Prometheus buckets are cumulative, ours each count their own range.
+        for (size_t bucket = 0; bucket < bounds.size(); ++bucket)
+        {
+            count += histogram.bucketCounts[bucket];
+            os << name << "_bucket{camera=\"" << snapshot.first << "\",le=\"";
+            WriteSeconds(os, bounds[bucket]);
+            os << "\"} " << count << '\n';
+        }
+
+        count += histogram.bucketCounts[bounds.size()];
+        os << name << "_bucket{camera=\"" << snapshot.first << "\",le=\"+Inf\"} " << count
+           << '\n';
+        os << name << "_sum{camera=\"" << snapshot.first << "\"} ";
+        WriteSeconds(os, histogram.sumNanosecs);
+        os << '\n';
+        os << name << "_count{camera=\"" << snapshot.first << "\"} " << count << '\n';
+    }
+}
+
+} // namespace
+
+std::shared_ptr<IpFreelyStreamStats> IpFreelyMetrics::StreamStats(camera_id_t const camId)
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    auto&                       streamStats = m_streamStats[camId];
+
+    if (!streamStats)
+    {
+        streamStats = std::make_shared<IpFreelyStreamStats>();
+    }
+
+    return streamStats;
+}
+
+void IpFreelyMetrics::DiskSpaceFreed(uint64_t const bytes) noexcept
+{
+    m_diskBytesFreed.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void IpFreelyMetrics::SetDiskSpace(uint64_t const bytesAvailable,
+                                   uint64_t const bytesTotal) noexcept
+{
+    m_diskBytesAvailable.store(bytesAvailable, std::memory_order_relaxed);
+    m_diskBytesTotal.store(bytesTotal, std::memory_order_relaxed);
+}
+
+std::string IpFreelyMetrics::Exposition() const
+{
+    // Only the map is locked, the counters themselves are read lock-free.
+    camera_snapshots_t snapshots;
+
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+
+        for (auto const& streamStats : m_streamStats)
+        {
+            snapshots.emplace_back(streamStats.first, streamStats.second->Snapshot());
+        }
+    }
+
+    std::ostringstream os;
+
+    WriteCameraMetric(os,
+                      "ipfreely_camera_stream_fps",
+                      "gauge",
+                      "Frame rate reported by the camera's stream.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.streamFps; });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_capture_fps",
+                      "gauge",
+                      "Frame rate the camera's stream is captured and recorded at.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.captureFps; });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_bitrate_kbps",
+                      "gauge",
+                      "Bitrate of the camera's stream in kbit/s, 0 if not reported.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.bitrateKbps; });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_frames_grabbed_total",
+                      "counter",
+                      "Video frames grabbed and decoded from the camera's stream.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.framesGrabbed; });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_frames_dropped_total",
+                      "counter",
+                      "Failed grabs, i.e. video frames lost by the camera's stream.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.framesDropped; });
+    WriteCameraHistogram(os,
+                         "ipfreely_camera_decode_seconds",
+                         "Time taken to grab and decode a video frame.",
+                         snapshots,
+                         [](StreamStatsSnapshot const& s) { return s.decodeHistogram; });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_motion_queue_depth",
+                      "gauge",
+                      "Video frames waiting in the motion detector's queue.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.motionQueueDepth; });
+    WriteCameraHistogram(os,
+                         "ipfreely_camera_motion_seconds",
+                         "Time taken by the motion detector to process a video frame.",
+                         snapshots,
+                         [](StreamStatsSnapshot const& s) { return s.motionHistogram; });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_encoder_queue_depth",
+                      "gauge",
+                      "Video frames waiting to be encoded to a video file.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.encoderQueueDepth; });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_frames_encoded_total",
+                      "counter",
+                      "Video frames encoded to video files.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.framesEncoded; });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_encoded_bytes_total",
+                      "counter",
+                      "Bytes written to video files, sampled about once a second.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.bytesEncoded; });
+    WriteCameraHistogram(os,
+                         "ipfreely_camera_segment_open_seconds",
+                         "Time taken to open a new video file.",
+                         snapshots,
+                         [](StreamStatsSnapshot const& s) { return s.segmentOpenHistogram; });
+    WriteCameraHistogram(os,
+                         "ipfreely_camera_segment_close_seconds",
+                         "Time taken to close, i.e. finalise, a video file.",
+                         snapshots,
+                         [](StreamStatsSnapshot const& s) { return s.segmentCloseHistogram; });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_connection_attempts_total",
+                      "counter",
+                      "Attempts to connect to the camera.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.connectionAttempts; });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_reconnects_total",
+                      "counter",
+                      "Attempts to connect to the camera after the first.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) {
+                          return s.connectionAttempts > 0 ? s.connectionAttempts - 1 : 0;
+                      });
+    WriteCameraMetric(os,
+                      "ipfreely_camera_connection_failures_total",
+                      "counter",
+                      "Failed attempts to connect to the camera.",
+                      snapshots,
+                      [](StreamStatsSnapshot const& s) { return s.connectionFailures; });
+
+    auto const bytesAvailable = m_diskBytesAvailable.load(std::memory_order_relaxed);
+    auto const bytesTotal     = m_diskBytesTotal.load(std::memory_order_relaxed);
+
+    WriteHeader(os,
+                "ipfreely_disk_freed_bytes_total",
+                "counter",
+                "Bytes of old recordings deleted by the disk space manager.");
+    os << "ipfreely_disk_freed_bytes_total " << m_diskBytesFreed.load(std::memory_order_relaxed)
+       << '\n';
+
+    // The disk space is unknown until the disk space manager's first check.
+    if (bytesTotal > 0)
+    {
+        WriteHeader(os,
+                    "ipfreely_disk_available_bytes",
+                    "gauge",
+                    "Bytes available on the save folder's disk.");
+        os << "ipfreely_disk_available_bytes " << bytesAvailable << '\n';
+        WriteHeader(
+            os, "ipfreely_disk_size_bytes", "gauge", "Total size of the save folder's disk.");
+        os << "ipfreely_disk_size_bytes " << bytesTotal << '\n';
+        WriteHeader(os,
+                    "ipfreely_disk_free_percent",
+                    "gauge",
+                    "Percentage of the save folder's disk that is free.");
+        os << "ipfreely_disk_free_percent "
+           << 100.0 * static_cast<double>(bytesAvailable) / static_cast<double>(bytesTotal)
+           << '\n';
+    }
+
+    return os.str();
+}
+
+} // namespace ipfreely
@@ -0,0 +1,108 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyMetrics.h
+ * \brief File containing declaration of IpFreelyMetrics class.
+ */
+#ifndef IPFREELYMETRICS_H
+#define IPFREELYMETRICS_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include "IpFreelyCameraDatabase.h"
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+class IpFreelyStreamStats;
+
+/*! \brief Class defining the application's metrics registry. */
+class IpFreelyMetrics final
+{
+public:
+    /*!
+     * \brief IpFreelyMetrics constructor.
+     *
+     * The registry holds every camera's stream performance counters plus the disk space
+     * manager's counters. All counters are lock-free atomics updated in place by the threads
+     * that own them, so collecting metrics costs the pipeline nothing, and the registry only
+     * reads them when Exposition() is called, e.g. by a Prometheus scrape.
+     */
+    IpFreelyMetrics() = default;
+
+    /*! \brief IpFreelyMetrics destructor. */
+    ~IpFreelyMetrics() = default;
+
+    /*! \brief IpFreelyMetrics deleted copy constructor. */
+    IpFreelyMetrics(IpFreelyMetrics const&) = delete;
+
+    /*! \brief IpFreelyMetrics deleted copy assignment operator. */
+    IpFreelyMetrics& operator=(IpFreelyMetrics const&) = delete;
+
+    /*!
+     * \brief StreamStats gives access to a camera's stream performance counters.
+     * \param[in] camId - The camera's ID.
+     * \return The camera's counters, created the first time they are asked for.
+     *
+     * The counters outlive the camera's stream processors, so they keep counting across
+     * reconnections as a Prometheus counter should.
+     */
+    std::shared_ptr<IpFreelyStreamStats> StreamStats(camera_id_t const camId);
+
+    /*!
+     * \brief DiskSpaceFreed counts bytes deleted by the disk space manager.
+     * \param[in] bytes - The number of bytes deleted.
+     */
+    void DiskSpaceFreed(uint64_t const bytes) noexcept;
+
+    /*!
+     * \brief SetDiskSpace sets the save folder's disk space.
+     * \param[in] bytesAvailable - The number of bytes available.
+     * \param[in] bytesTotal - The disk's total size in bytes.
+     */
+    void SetDiskSpace(uint64_t const bytesAvailable, uint64_t const bytesTotal) noexcept;
+
+    /*!
+     * \brief Exposition renders the metrics in the Prometheus text exposition format.
+     * \return The metrics text, served as "text/plain; version=0.0.4".
+     *
+     * Camera metrics are labelled with the camera's ID. Rates, e.g. the input FPS actually
+     * achieved or the encoder's bytes per second, are left to the scraper to derive from the
+     * counters, e.g. using rate().
+     */
+    std::string Exposition() const;
+
+private:
+    mutable std::mutex                                          m_statsMutex;
+    std::map<camera_id_t, std::shared_ptr<IpFreelyStreamStats>> m_streamStats;
+    std::atomic<uint64_t>                                       m_diskBytesFreed{0};
+    std::atomic<uint64_t>                                       m_diskBytesAvailable{0};
+    std::atomic<uint64_t>                                       m_diskBytesTotal{0};
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYMETRICS_H
@@ -26,10 +26,13 @@
 #include <sstream>
 #include <cmath>
 #include <cstdint>
+#include <chrono>
 #include <boost/throw_exception.hpp>
 #include <boost/filesystem.hpp>
 #include "StringUtils/StringUtils.h"
 #include "DebugLog/DebugLogging.h"
+#include "IpFreelyStreamStats.h"
+#include "IpFreelyTrace.h"
 
 namespace bfs = boost::filesystem;
 
@@ -46,12 +49,11 @@ static constexpr int    BOUNDING_RECT_MARGIN = 1;
 static constexpr int CONTOUR_LINE_THICKNESS = 2;
 #endif
 
-IpFreelyMotionDetector::IpFreelyMotionDetector(std::string const& name,
-                                               IpCamera const&    cameraDetails,
-                                               std::string const& saveFolderPath,
-                                               double const       requiredFileDurationSecs,
-                                               double const fps, int const originalWidth,
-                                               int const originalHeight)
+IpFreelyMotionDetector::IpFreelyMotionDetector(
+    std::string const& name, IpCamera const& cameraDetails, std::string const& saveFolderPath,
+    double const requiredFileDurationSecs, double const fps, int const originalWidth,
+    int const originalHeight, std::shared_ptr<IpFreelyStreamStats> const& streamStats,
+    PipelineEnvironment const& environment)
     : m_name(core_lib::string_utils::RemoveIllegalChars(name))
     , m_cameraDetails(cameraDetails)
     , m_saveFolderPath(saveFolderPath)
@@ -62,6 +64,8 @@ IpFreelyMotionDetector::IpFreelyMotionDetector(std::string const& name,
     , m_updatePeriodMillisecs(static_cast<unsigned int>(1000.0 / m_fps))
     , m_erosionKernel(cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2, 2)))
     , m_holdOffFrameCountLimit(static_cast<size_t>(std::ceil(m_fps)) * HOLD_ON_OFF_SECS)
+    , m_streamStats(streamStats)
+    , m_environment(environment)
     , m_msgQueueThread(std::bind(&IpFreelyMotionDetector::MessageDecoder, std::placeholders::_1),
                        core_lib::threads::eOnDestroyOptions::processRemainingItems)
 {
@@ -90,9 +94,29 @@ IpFreelyMotionDetector::IpFreelyMotionDetector(std::string const& name,
         std::bind(&IpFreelyMotionDetector::MessageHandler, this, std::placeholders::_1));
 }
 
-void IpFreelyMotionDetector::AddNextFrame(cv::Mat const& videoFrame)
+void IpFreelyMotionDetector::AddNextFrame(cv::Mat const& videoFrame, cv::Mat const& greyFrame)
 {
-    m_msgQueueThread.Push(std::make_shared<cv::Mat>(videoFrame));
+    auto motionFrames        = std::make_shared<MotionFrames>();
+    motionFrames->videoFrame = videoFrame;
+    motionFrames->greyFrame  = greyFrame;
+
+    if (m_streamStats)
+    {
+        m_streamStats->MotionFrameQueued();
+    }
+
+    if (m_environment.manualStepping)
+    {
+        MessageHandler(motionFrames);
+        return;
+    }
+
+    m_msgQueueThread.Push(motionFrames);
+}
+
+cv::Size IpFreelyMotionDetector::MotionFrameSize() const noexcept
+{
+    return m_motionFrameSize;
 }
 
 QRect IpFreelyMotionDetector::CurrentMotionRect() const noexcept
@@ -128,6 +152,10 @@ void IpFreelyMotionDetector::Initialise()
         DEBUG_MESSAGE_EX_INFO("Full-size video frames for motion detection.");
     }
 
+    m_motionFrameSize =
+        cv::Size(cvRound(static_cast<double>(m_originalWidth) * m_motionFrameScalar),
+                 cvRound(static_cast<double>(m_originalHeight) * m_motionFrameScalar));
+
     double const motionFrameArea = static_cast<double>(m_originalHeight * m_originalWidth) *
                                    m_motionFrameScalar * m_motionFrameScalar;
 
@@ -164,60 +192,20 @@ void IpFreelyMotionDetector::InitialiseFrames()
 
     m_initialiseFrames = false;
 
-    if (m_cameraDetails.shrinkVideoFrames)
-    {
-        cv::resize(*m_originalFrame,
-                   m_prevGreyFrame,
-                   {},
-                   m_motionFrameScalar,
-                   m_motionFrameScalar,
-                   cv::INTER_AREA);
-    }
-    else
-    {
-        m_prevGreyFrame = *m_originalFrame;
-    }
-
-    cv::cvtColor(m_prevGreyFrame, m_prevGreyFrame, cv::COLOR_BGR2GRAY);
-
-    if (m_cameraDetails.shrinkVideoFrames)
-    {
-        cv::resize(*m_originalFrame,
-                   m_currentGreyFrame,
-                   {},
-                   m_motionFrameScalar,
-                   m_motionFrameScalar,
-                   cv::INTER_AREA);
-    }
-    else
-    {
-        m_currentGreyFrame = *m_originalFrame;
-    }
-
-    cv::cvtColor(m_currentGreyFrame, m_currentGreyFrame, cv::COLOR_BGR2GRAY);
+    // The grey frames are never modified in place so the first frame can be shared.
+    m_prevGreyFrame    = m_originalFrame->greyFrame;
+    m_currentGreyFrame = m_prevGreyFrame;
 }
 
 void IpFreelyMotionDetector::UpdateNextFrame()
 {
-    if (m_cameraDetails.shrinkVideoFrames)
-    {
-        cv::resize(m_nextGreyFrame,
-                   m_nextGreyFrame,
-                   {},
-                   m_motionFrameScalar,
-                   m_motionFrameScalar,
-                   cv::INTER_AREA);
-    }
-    else
-    {
-        m_nextGreyFrame = *m_originalFrame;
-    }
-
-    cv::cvtColor(m_nextGreyFrame, m_nextGreyFrame, cv::COLOR_BGR2GRAY);
+    m_nextGreyFrame = m_originalFrame->greyFrame;
 }
 
 bool IpFreelyMotionDetector::DetectMotion()
 {
+    IPFREELY_TRACE_SCOPE_ID("DetectMotion", m_cameraDetails.camId);
+
     // This algorithm is inspired by an example given here:
     // https://github.com/cedricve/motion-detection
     // However I have taken this basic idea and added
@@ -227,7 +215,27 @@ bool IpFreelyMotionDetector::DetectMotion()
     // less janky. I've also added a check to filter
     // out motion regions less than a configurable percentage
     // of the frame's total area.
+    auto motion = CreateMotionMask();
+    auto rect   = FindMotionBounds(motion);
 
+#if defined(MOTION_DETECTOR_DEBUG)
+    // Draw bounding rectangle on motion frame.
+    cv::rectangle(motion,
+                  rect.tl(),
+                  rect.br(),
+                  cv::Scalar(255, 255, 255),
+                  CONTOUR_LINE_THICKNESS,
+                  cv::LINE_8);
+    imshow("motion", motion);
+#endif
+
+    UpdateMotionBoundingRect(rect);
+
+    return CheckForIntersections();
+}
+
+cv::Mat IpFreelyMotionDetector::CreateMotionMask() const
+{
     // Calculate differences between the images and do AND-operation
     // then threshold image, low differences are ignored (ex. contrast
     // change due to sunlight).
@@ -238,116 +246,111 @@ bool IpFreelyMotionDetector::DetectMotion()
     cv::threshold(
         motion, motion, m_cameraDetails.pixelThreshold, DIFF_MAX_VALUE, cv::THRESH_BINARY);
     cv::erode(motion, motion, m_erosionKernel);
+    return motion;
+}
 
+cv::Rect IpFreelyMotionDetector::FindMotionBounds(cv::Mat const& motion) const
+{
     // Now work out the std dev of the motion frame.
     cv::Scalar mean, stddev;
     cv::meanStdDev(motion, mean, stddev);
 
-    // Initialise motion bounding rectangle variables.
-    cv::Rect maxBoundingRect;
-    int      min_x = motion.cols;
-    int      max_x = 0;
-    int      min_y = motion.rows;
-    int      max_y = 0;
-
     // This check guards against there being too much motion all at once,
     // e.g. changes related to rain, snow, sunlight flares etc.
-    if (stddev[0] < m_cameraDetails.maxMotionStdDev)
+    if (stddev[0] >= m_cameraDetails.maxMotionStdDev)
     {
-        size_t numChanges = 0;
+        return {};
+    }
 
-        // Loop over image and detect changes. This is better
-        // for CPU performance compared to using OpenCV's
-        // contour fitting algorithms.
-        for (int j = 0; j < motion.rows; j += 2)
+    // Initialise motion bounding rectangle variables.
+    int    min_x      = motion.cols;
+    int    max_x      = 0;
+    int    min_y      = motion.rows;
+    int    max_y      = 0;
+    size_t numChanges = 0;
+
+    // Loop over image and detect changes. This is better
+    // for CPU performance compared to using OpenCV's
+    // contour fitting algorithms.
+    for (int j = 0; j < motion.rows; j += 2)
+    {
+        for (int i = 0; i < motion.cols; i += 2)
         {
-            for (int i = 0; i < motion.cols; i += 2)
+            // check if at pixel (j,i) intensity is equal to 255
+            // this means that the pixel is different in the sequence
+            // of images (prev_frame, current_frame, next_frame)
+            if (static_cast<int>(motion.at<uint8_t>(j, i)) == 255)
             {
-                // check if at pixel (j,i) intensity is equal to 255
-                // this means that the pixel is different in the sequence
-                // of images (prev_frame, current_frame, next_frame)
-                if (static_cast<int>(motion.at<uint8_t>(j, i)) == 255)
+                ++numChanges;
+
+                // Track the boundary of the motion related changes.
+                if (min_x > i)
                 {
-                    ++numChanges;
-
-                    // Track the boundary of the motion related changes.
-                    if (min_x > i)
-                    {
-                        min_x = i;
-                    }
-
-                    if (max_x < i)
-                    {
-                        max_x = i;
-                    }
-
-                    if (min_y > j)
-                    {
-                        min_y = j;
-                    }
-
-                    if (max_y < j)
-                    {
-                        max_y = j;
-                    }
+                    min_x = i;
                 }
-            }
-        }
 
-        // If we have some changes create a bounding rectangle
-        // that encompasses all the motion detected.
-        if (numChanges > 0)
-        {
-            if (min_x - BOUNDING_RECT_MARGIN > 0)
-            {
-                min_x -= BOUNDING_RECT_MARGIN;
-            }
+                if (max_x < i)
+                {
+                    max_x = i;
+                }
 
-            if (min_y - BOUNDING_RECT_MARGIN > 0)
-            {
-                min_y -= BOUNDING_RECT_MARGIN;
-            }
+                if (min_y > j)
+                {
+                    min_y = j;
+                }
 
-            if (max_x + BOUNDING_RECT_MARGIN < (motion.cols - 1))
-            {
-                max_x += BOUNDING_RECT_MARGIN;
+                if (max_y < j)
+                {
+                    max_y = j;
+                }
             }
+        }
+    }
 
-            if (max_y + BOUNDING_RECT_MARGIN < (motion.rows - 1))
-            {
-                max_y += BOUNDING_RECT_MARGIN;
-            }
+    if (numChanges == 0)
+    {
+        return {};
+    }
 
-            cv::Point x(min_x, min_y);
-            cv::Point y(max_x, max_y);
-            maxBoundingRect = cv::Rect(x, y);
-        }
+    // We have some changes so create a bounding rectangle
+    // that encompasses all the motion detected.
+    if (min_x - BOUNDING_RECT_MARGIN > 0)
+    {
+        min_x -= BOUNDING_RECT_MARGIN;
+    }
 
-#if defined(MOTION_DETECTOR_DEBUG)
-        // Draw bounding rectangle on motion frame.
-        cv::rectangle(motion,
-                      maxBoundingRect.tl(),
-                      maxBoundingRect.br(),
-                      cv::Scalar(255, 255, 255),
-                      CONTOUR_LINE_THICKNESS,
-                      cv::LINE_8);
-#endif
+    if (min_y - BOUNDING_RECT_MARGIN > 0)
+    {
+        min_y -= BOUNDING_RECT_MARGIN;
     }
 
-#if defined(MOTION_DETECTOR_DEBUG)
-    imshow("motion", motion);
-#endif
+    if (max_x + BOUNDING_RECT_MARGIN < (motion.cols - 1))
+    {
+        max_x += BOUNDING_RECT_MARGIN;
+    }
+
+    if (max_y + BOUNDING_RECT_MARGIN < (motion.rows - 1))
+    {
+        max_y += BOUNDING_RECT_MARGIN;
+    }
+
+    return cv::Rect(cv::Point(min_x, min_y), cv::Point(max_x, max_y));
+}
 
+void IpFreelyMotionDetector::UpdateMotionBoundingRect(cv::Rect const& motionRect)
+{
     // Is the area of motion larger than our threshold. This means
     // we ignore small, most likely insignificnt motion.
-    if (maxBoundingRect.area() > m_minImageChangeArea)
+    if (motionRect.area() > m_minImageChangeArea)
     {
         // Create a motion bounding rectangle scaled to original
         // video frame's size.
-        cv::Point tl1(static_cast<int>(static_cast<double>(min_x) / m_motionFrameScalar),
-                      static_cast<int>(static_cast<double>(min_y) / m_motionFrameScalar));
-        cv::Point br1(static_cast<int>(static_cast<double>(max_x) / m_motionFrameScalar),
-                      static_cast<int>(static_cast<double>(max_y) / m_motionFrameScalar));
+        auto const tl = motionRect.tl();
+        auto const br = motionRect.br();
+        cv::Point  tl1(static_cast<int>(static_cast<double>(tl.x) / m_motionFrameScalar),
+                       static_cast<int>(static_cast<double>(tl.y) / m_motionFrameScalar));
+        cv::Point  br1(static_cast<int>(static_cast<double>(br.x) / m_motionFrameScalar),
+                       static_cast<int>(static_cast<double>(br.y) / m_motionFrameScalar));
 
         auto minBoundingRect = cv::Rect(tl1, br1);
 
@@ -395,8 +398,6 @@ bool IpFreelyMotionDetector::DetectMotion()
         m_motionBoundingRect = cv::Rect(
             static_cast<int>(l), static_cast<int>(t), static_cast<int>(w), static_cast<int>(h));
     }
-
-    return CheckForIntersections();
 }
 
 bool IpFreelyMotionDetector::CheckForIntersections()
@@ -452,10 +453,12 @@ int IpFreelyMotionDetector::MessageDecoder(video_frame_t const& /*msg*/)
 
 bool IpFreelyMotionDetector::MessageHandler(video_frame_t& msg)
 {
+    auto const startTime = std::chrono::steady_clock::now();
+
     m_originalFrame = msg;
 
     // Get current time stamp.
-    m_currentTime = time(nullptr);
+    m_currentTime = m_environment.Clock().Now();
 
     InitialiseFrames();
     UpdateNextFrame();
@@ -487,7 +490,7 @@ bool IpFreelyMotionDetector::MessageHandler(video_frame_t& msg)
                               << m_cameraDetails.streamUrl);
 
         m_holdOffFrameCount = 0;
-        m_videoWriter.release();
+        CloseVideoWriter();
         recording = false;
         SetWritingStream(false);
     }
@@ -500,6 +503,11 @@ bool IpFreelyMotionDetector::MessageHandler(video_frame_t& msg)
     WriteVideoFrame();
     RotateFrames();
 
+    if (m_streamStats)
+    {
+        m_streamStats->MotionFrameProcessed(std::chrono::steady_clock::now() - startTime);
+    }
+
     return true;
 }
 
@@ -516,13 +524,16 @@ void IpFreelyMotionDetector::CreateCaptureObjects()
             "Motion detector file duration reached for current video file, camera stream URL: "
             << m_cameraDetails.streamUrl << ", file writer being closed.");
 
-        m_videoWriter.release();
+        CloseVideoWriter();
         SetWritingStream(false);
     }
 
-    auto localTime = std::localtime(&m_currentTime);
-    char folderName[9];
-    std::strftime(folderName, sizeof(folderName), "%Y%m%d", localTime);
+    // Together with the close above this is a segment rollover.
+    IPFREELY_TRACE_SCOPE_ID("SegmentOpen", m_cameraDetails.camId);
+
+    auto const localTime = m_environment.Clock().LocalTime(m_currentTime);
+    char       folderName[9];
+    std::strftime(folderName, sizeof(folderName), "%Y%m%d", &localTime);
 
     bfs::path p(m_saveFolderPath);
     p /= folderName;
@@ -547,6 +558,8 @@ void IpFreelyMotionDetector::CreateCaptureObjects()
 
     m_fileDurationSecs = 0.0;
 
+    auto const openTime = std::chrono::steady_clock::now();
+
 #if BOOST_OS_WINDOWS
     m_videoWriter = cv::makePtr<cv::VideoWriter>(p.string().c_str(),
                                                  cv::VideoWriter::fourcc('D', 'I', 'V', 'X'),
@@ -566,6 +579,13 @@ void IpFreelyMotionDetector::CreateCaptureObjects()
         return;
     }
 
+    if (m_streamStats)
+    {
+        m_streamStats->SegmentOpened(std::chrono::steady_clock::now() - openTime);
+    }
+
+    m_videoFilePath  = p.string();
+    m_videoFileBytes = 0;
     SetWritingStream(true);
 }
 
@@ -573,8 +593,58 @@ void IpFreelyMotionDetector::WriteVideoFrame()
 {
     if (m_videoWriter)
     {
-        *m_videoWriter << *m_originalFrame;
+        IPFREELY_TRACE_SCOPE_ID("WriteVideoFrame", m_cameraDetails.camId);
+
+        auto const startTime = std::chrono::steady_clock::now();
+
+        *m_videoWriter << m_originalFrame->videoFrame;
+
+        auto const previousSecs = static_cast<uint64_t>(m_fileDurationSecs);
         m_fileDurationSecs += static_cast<double>(m_updatePeriodMillisecs) / 1000.0;
+
+        if (m_streamStats)
+        {
+            m_streamStats->FrameEncoded(std::chrono::steady_clock::now() - startTime);
+
+            // Measured about once a second, like the stream processor's own video files.
+            if (static_cast<uint64_t>(m_fileDurationSecs) != previousSecs)
+            {
+                UpdateVideoFileBytes();
+            }
+        }
+    }
+}
+
+void IpFreelyMotionDetector::CloseVideoWriter()
+{
+    IPFREELY_TRACE_SCOPE_ID("SegmentClose", m_cameraDetails.camId);
+
+    auto const startTime = std::chrono::steady_clock::now();
+    m_videoWriter.release();
+
+    if (m_streamStats)
+    {
+        m_streamStats->SegmentClosed(std::chrono::steady_clock::now() - startTime);
+        UpdateVideoFileBytes();
+    }
+
+    m_videoFilePath.clear();
+}
+
+void IpFreelyMotionDetector::UpdateVideoFileBytes()
+{
+    if (m_videoFilePath.empty())
+    {
+        return;
+    }
+
+    boost::system::error_code ec;
+    auto const                fileBytes = bfs::file_size(m_videoFilePath, ec);
+
+    if (!ec && (fileBytes > m_videoFileBytes))
+    {
+        m_streamStats->BytesEncoded(fileBytes - m_videoFileBytes);
+        m_videoFileBytes = fileBytes;
     }
 }
 
@@ -582,6 +652,11 @@ void IpFreelyMotionDetector::SetWritingStream(bool const writing) noexcept
 {
     std::lock_guard<std::mutex> lock(m_writingMutex);
     m_writingStream = writing;
+
+    if (m_streamStats)
+    {
+        m_streamStats->SetMotionRecording(writing);
+    }
 }
 
 } // namespace ipfreely
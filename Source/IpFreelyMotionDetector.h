@@ -29,19 +29,32 @@
 #include <string>
 #include <memory>
 #include <ctime>
+#include <cstdint>
 #include <opencv2/opencv.hpp>
 #include "Threads/MessageQueueThread.h"
 #include "IpFreelyCameraDatabase.h"
+#include "IpFreelyPipelineEnvironment.h"
 
 /*! \brief The ipfreely namespace. */
 namespace ipfreely
 {
 
+class IpFreelyStreamStats;
+
 /*! \brief Class defining a motion detector. */
 class IpFreelyMotionDetector final
 {
+    /*! \brief Structure holding a video frame and its motion-sized luma frame. */
+    struct MotionFrames
+    {
+        /*! \brief The full resolution video frame, used for recording. */
+        cv::Mat videoFrame{};
+        /*! \brief The 8-bit luma frame of size MotionFrameSize(), used for detection. */
+        cv::Mat greyFrame{};
+    };
+
     /*! \brief Typedef to queue object. */
-    typedef std::shared_ptr<cv::Mat> video_frame_t;
+    typedef std::shared_ptr<MotionFrames> video_frame_t;
 
 public:
     /*!
@@ -53,14 +66,22 @@ public:
      * \param[in] fps - The video's FPS.
      * \param[in] originalWidth - The video's original width.
      * \param[in] originalHeight - The video's original height.
+     * \param[in] streamStats - (Optional) The stream's performance counters to update.
+     * \param[in] environment - (Optional) The clock and threading to use, the system clock and
+     * a message queue thread if not given.
      *
      * The stream processor can be used to receive and thus display RTSP video streams but can also
      * record the stream in DivX format mp4 files to disk. Files are recorded with the given
      * duration. One recording session can span multiple back-to-back video files.
+     *
+     * With manual stepping frames are processed on the caller's thread by AddNextFrame(),
+     * rather than being queued for the message queue thread.
      */
     IpFreelyMotionDetector(std::string const& name, IpCamera const& cameraDetails,
                            std::string const& saveFolderPath, double const requiredFileDurationSecs,
-                           double const fps, int const originalWidth, int const originalHeight);
+                           double const fps, int const originalWidth, int const originalHeight,
+                           std::shared_ptr<IpFreelyStreamStats> const& streamStats = {},
+                           PipelineEnvironment const&                  environment = {});
 
     /*! \brief IpFreelyMotionDetector destructor. */
     ~IpFreelyMotionDetector() = default;
@@ -74,8 +95,18 @@ public:
     /*!
      * \brief AddNextFrame add next video frame to motion detector queue.
      * \param[in] videoFrame - Next video frame to process.
+     * \param[in] greyFrame - Next video frame as 8-bit luma of size MotionFrameSize().
+     *
+     * The stream processor takes the luma frame from its shared frame pyramid, so the motion
+     * detector never converts or resizes frames itself.
      */
-    void AddNextFrame(cv::Mat const& videoFrame);
+    void AddNextFrame(cv::Mat const& videoFrame, cv::Mat const& greyFrame);
+
+    /*!
+     * \brief MotionFrameSize gives the size of the luma frames the motion detector needs.
+     * \return The motion frame size, smaller than the video if shrinking frames is enabled.
+     */
+    cv::Size MotionFrameSize() const noexcept;
 
     /*!
      * \brief CurrentMotionRect gives acces to motion bounding rectangle.
@@ -91,16 +122,24 @@ public:
     bool WritingStream() const noexcept;
 
 private:
+    /*! \brief Lets the benchmarks drive the private motion detection stages directly. */
+    friend struct IpFreelyBenchmarkAccess;
+
     void       Initialise();
     void       InitialiseFrames();
     void       UpdateNextFrame();
     bool       DetectMotion();
+    cv::Mat    CreateMotionMask() const;
+    cv::Rect   FindMotionBounds(cv::Mat const& motion) const;
+    void       UpdateMotionBoundingRect(cv::Rect const& motionRect);
     bool       CheckForIntersections();
     void       RotateFrames();
     static int MessageDecoder(video_frame_t const& msg);
     bool       MessageHandler(video_frame_t& msg);
     void       CreateCaptureObjects();
     void       WriteVideoFrame();
+    void       CloseVideoWriter();
+    void       UpdateVideoFileBytes();
     void       SetWritingStream(bool const writing) noexcept;
 
 private:
@@ -121,6 +160,7 @@ private:
     size_t                                                    m_holdOffFrameCountLimit{0};
     size_t                                                    m_holdOffFrameCount{0};
     double                                                    m_motionFrameScalar{1.0};
+    cv::Size                                                  m_motionFrameSize{};
     int                                                       m_minImageChangeArea{0};
     size_t                                                    m_imageChangesThreshold{0};
     bool                                                      m_initialiseFrames{true};
@@ -131,7 +171,11 @@ private:
     double                                                    m_fileDurationSecs{0.0};
     time_t                                                    m_currentTime{};
     cv::Ptr<cv::VideoWriter>                                  m_videoWriter{};
+    std::string                                               m_videoFilePath{};
+    uint64_t                                                  m_videoFileBytes{0};
     bool                                                      m_writingStream{false};
+    std::shared_ptr<IpFreelyStreamStats>                      m_streamStats;
+    PipelineEnvironment                                       m_environment;
     core_lib::threads::MessageQueueThread<int, video_frame_t> m_msgQueueThread;
 };
 
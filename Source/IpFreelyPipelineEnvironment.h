@@ -0,0 +1,74 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyPipelineEnvironment.h
+ * \brief File containing declaration of PipelineEnvironment structure.
+ */
+#ifndef IPFREELYPIPELINEENVIRONMENT_H
+#define IPFREELYPIPELINEENVIRONMENT_H
+
+#include <memory>
+#include <functional>
+#include <opencv2/opencv.hpp>
+#include "IpFreelyCameraDatabase.h"
+#include "IpFreelyClock.h"
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*!
+ * \brief Typedef for a factory creating a camera's frame source.
+ *
+ * cv::VideoCapture's frame reading and property methods are virtual, so a frame source, e.g.
+ * one generating synthetic frames, derives from it. The factory must return an opened source.
+ */
+typedef std::function<cv::Ptr<cv::VideoCapture>(IpCamera const&)> capture_factory_t;
+
+/*!
+ * \brief Structure holding what the recording pipeline takes from its surroundings.
+ *
+ * The defaults are the real world: the system clock, each camera's stream URL and threads
+ * that run the pipeline in real time. Replacing them lets a harness drive the pipeline with
+ * simulated frames against a virtual clock, one frame at a time, as fast as it can.
+ */
+struct PipelineEnvironment
+{
+    /*! \brief The wall clock, the system clock if not set. */
+    std::shared_ptr<IpFreelyClock> clock{};
+    /*! \brief The frame source factory, a cv::VideoCapture of the stream URL if not set. */
+    capture_factory_t captureFactory{};
+    /*! \brief If true no threads are started and the owner calls Step() instead. */
+    bool manualStepping{false};
+
+    /*!
+     * \brief Clock gives access to the wall clock.
+     * \return The clock, the system clock if none was set.
+     */
+    IpFreelyClock const& Clock() const
+    {
+        return clock ? *clock : *IpFreelyClock::SystemClock();
+    }
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYPIPELINEENVIRONMENT_H
@@ -23,6 +23,8 @@
  * \brief File containing declaration of IpFreelyPreferences class.
  */
 #include "IpFreelyPreferences.h"
+#include <QHostAddress>
+#include <QString>
 #include <sstream>
 #include <fstream>
 #include <utility>
@@ -179,6 +181,211 @@ void IpFreelyPreferences::SetMaxUsedDiskSpacePercent(int const maxUsedPercent) n
     m_maxUsedDiskSpacePercent = maxUsedPercent;
 }
 
+int IpFreelyPreferences::TilesPerPage() const noexcept
+{
+    return m_tilesPerPage;
+}
+
+void IpFreelyPreferences::SetTilesPerPage(int const tilesPerPage)
+{
+    switch (tilesPerPage)
+    {
+    case 1:
+    case 4:
+    case 9:
+    case 16:
+        m_tilesPerPage = tilesPerPage;
+        break;
+    default:
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Unsupported number of tiles per page."));
+    }
+}
+
+int IpFreelyPreferences::HttpServerPort() const noexcept
+{
+    return m_httpServerPort;
+}
+
+void IpFreelyPreferences::SetHttpServerPort(int const port)
+{
+    if ((port < 0) || (port > 65535))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid web server port."));
+    }
+
+    m_httpServerPort = port;
+}
+
+std::string IpFreelyPreferences::HttpBindAddress() const noexcept
+{
+    return m_httpBindAddress;
+}
+
+void IpFreelyPreferences::SetHttpBindAddress(std::string const& bindAddress)
+{
+    QHostAddress address;
+
+    if (!address.setAddress(QString::fromStdString(bindAddress)))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid web server bind address."));
+    }
+
+    m_httpBindAddress = bindAddress;
+}
+
+int IpFreelyPreferences::HttpFrameWidth() const noexcept
+{
+    return m_httpFrameWidth;
+}
+
+int IpFreelyPreferences::HttpFrameHeight() const noexcept
+{
+    return m_httpFrameHeight;
+}
+
+void IpFreelyPreferences::SetHttpFrameSize(int const width, int const height) noexcept
+{
+    m_httpFrameWidth  = width;
+    m_httpFrameHeight = height;
+}
+
+int IpFreelyPreferences::HttpJpegQuality() const noexcept
+{
+    return m_httpJpegQuality;
+}
+
+void IpFreelyPreferences::SetHttpJpegQuality(int const quality) noexcept
+{
+    m_httpJpegQuality = quality;
+}
+
+int IpFreelyPreferences::HttpMaxFps() const noexcept
+{
+    return m_httpMaxFps;
+}
+
+void IpFreelyPreferences::SetHttpMaxFps(int const maxFps) noexcept
+{
+    m_httpMaxFps = maxFps;
+}
+
+int IpFreelyPreferences::RtspProxyPort() const noexcept
+{
+    return m_rtspProxyPort;
+}
+
+void IpFreelyPreferences::SetRtspProxyPort(int const port)
+{
+    if ((port < 0) || (port > 65535))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid RTSP proxy port."));
+    }
+
+    m_rtspProxyPort = port;
+}
+
+std::string IpFreelyPreferences::RtspProxyBindAddress() const noexcept
+{
+    return m_rtspProxyBindAddress;
+}
+
+void IpFreelyPreferences::SetRtspProxyBindAddress(std::string const& bindAddress)
+{
+    QHostAddress address;
+
+    if (!address.setAddress(QString::fromStdString(bindAddress)))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid RTSP proxy bind address."));
+    }
+
+    m_rtspProxyBindAddress = bindAddress;
+}
+
+int IpFreelyPreferences::MaxActiveDownloads() const noexcept
+{
+    return m_maxActiveDownloads;
+}
+
+void IpFreelyPreferences::SetMaxActiveDownloads(int const maxDownloads)
+{
+    if ((maxDownloads < 1) || (maxDownloads > 16))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid maximum active downloads."));
+    }
+
+    m_maxActiveDownloads = maxDownloads;
+}
+
+int IpFreelyPreferences::DownloadConnectionsPerCamera() const noexcept
+{
+    return m_downloadConnectionsPerCamera;
+}
+
+void IpFreelyPreferences::SetDownloadConnectionsPerCamera(int const maxConnections)
+{
+    if ((maxConnections < 1) || (maxConnections > 8))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid download connections per camera."));
+    }
+
+    m_downloadConnectionsPerCamera = maxConnections;
+}
+
+int IpFreelyPreferences::DownloadKiBPerSecPerCamera() const noexcept
+{
+    return m_downloadKiBPerSecPerCamera;
+}
+
+void IpFreelyPreferences::SetDownloadKiBPerSecPerCamera(int const kibPerSec)
+{
+    if (kibPerSec < 0)
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid download bandwidth cap."));
+    }
+
+    m_downloadKiBPerSecPerCamera = kibPerSec;
+}
+
+std::string IpFreelyPreferences::MirrorFolderPath() const noexcept
+{
+    return m_mirrorFolderPath;
+}
+
+void IpFreelyPreferences::SetMirrorFolderPath(std::string const& mirrorFolderPath)
+{
+    m_mirrorFolderPath = mirrorFolderPath;
+}
+
+int IpFreelyPreferences::MirrorIntervalMins() const noexcept
+{
+    return m_mirrorIntervalMins;
+}
+
+void IpFreelyPreferences::SetMirrorIntervalMins(int const intervalMins)
+{
+    if ((intervalMins < 1) || (intervalMins > 1440))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid mirror sync interval."));
+    }
+
+    m_mirrorIntervalMins = intervalMins;
+}
+
+int IpFreelyPreferences::MirrorRecordingKiBPerSecPerCamera() const noexcept
+{
+    return m_mirrorRecordingKiBPerSecPerCamera;
+}
+
+void IpFreelyPreferences::SetMirrorRecordingKiBPerSecPerCamera(int const kibPerSec)
+{
+    if (kibPerSec < 0)
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid mirror bandwidth cap."));
+    }
+
+    m_mirrorRecordingKiBPerSecPerCamera = kibPerSec;
+}
+
 void IpFreelyPreferences::Save() const
 {
     if (bfs::exists(m_cfgPath))
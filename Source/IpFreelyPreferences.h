@@ -148,6 +148,187 @@ public:
      */
     void SetMaxUsedDiskSpacePercent(int const maxUsedPercent) noexcept;
 
+    /*!
+     * \brief TilesPerPage returns the number of camera tiles shown per page of the video grid.
+     * \return The number of tiles per page, one of 1, 4, 9 or 16.
+     */
+    int TilesPerPage() const noexcept;
+
+    /*!
+     * \brief SetTilesPerPage sets the number of camera tiles shown per page of the video grid.
+     * \param[in] tilesPerPage - The number of tiles per page, one of 1, 4, 9 or 16.
+     */
+    void SetTilesPerPage(int const tilesPerPage);
+
+    /*!
+     * \brief HttpServerPort returns the TCP port the built-in web server listens on.
+     * \return The port number, 0 if the web server is disabled.
+     */
+    int HttpServerPort() const noexcept;
+
+    /*!
+     * \brief SetHttpServerPort sets the TCP port the built-in web server listens on.
+     * \param[in] port - The port number, 0 to disable the web server.
+     */
+    void SetHttpServerPort(int const port);
+
+    /*!
+     * \brief HttpBindAddress returns the local address the built-in web server listens on.
+     * \return The IP address, "127.0.0.1" by default so only this computer can connect.
+     */
+    std::string HttpBindAddress() const noexcept;
+
+    /*!
+     * \brief SetHttpBindAddress sets the local address the built-in web server listens on.
+     * \param[in] bindAddress - The IP address, e.g. "0.0.0.0" to accept connections from any
+     * computer on the network.
+     */
+    void SetHttpBindAddress(std::string const& bindAddress);
+
+    /*!
+     * \brief HttpFrameWidth returns the maximum width of frames served by the web server.
+     * \return The maximum frame width in pixels.
+     */
+    int HttpFrameWidth() const noexcept;
+
+    /*!
+     * \brief HttpFrameHeight returns the maximum height of frames served by the web server.
+     * \return The maximum frame height in pixels.
+     */
+    int HttpFrameHeight() const noexcept;
+
+    /*!
+     * \brief SetHttpFrameSize sets the maximum size of frames served by the web server.
+     * \param[in] width - The maximum frame width in pixels.
+     * \param[in] height - The maximum frame height in pixels.
+     */
+    void SetHttpFrameSize(int const width, int const height) noexcept;
+
+    /*!
+     * \brief HttpJpegQuality returns the JPEG quality of frames served by the web server.
+     * \return The JPEG quality, from 1 to 100.
+     */
+    int HttpJpegQuality() const noexcept;
+
+    /*!
+     * \brief SetHttpJpegQuality sets the JPEG quality of frames served by the web server.
+     * \param[in] quality - The JPEG quality, from 1 to 100.
+     */
+    void SetHttpJpegQuality(int const quality) noexcept;
+
+    /*!
+     * \brief HttpMaxFps returns the maximum frame rate of the web server's live streams.
+     * \return The maximum frame rate.
+     */
+    int HttpMaxFps() const noexcept;
+
+    /*!
+     * \brief SetHttpMaxFps sets the maximum frame rate of the web server's live streams.
+     * \param[in] maxFps - The maximum frame rate.
+     */
+    void SetHttpMaxFps(int const maxFps) noexcept;
+
+    /*!
+     * \brief RtspProxyPort returns the TCP port the built-in RTSP proxy listens on.
+     * \return The port number, 0 if the RTSP proxy is disabled.
+     */
+    int RtspProxyPort() const noexcept;
+
+    /*!
+     * \brief SetRtspProxyPort sets the TCP port the built-in RTSP proxy listens on.
+     * \param[in] port - The port number, 0 to disable the RTSP proxy.
+     */
+    void SetRtspProxyPort(int const port);
+
+    /*!
+     * \brief RtspProxyBindAddress returns the local address the built-in RTSP proxy listens on.
+     * \return The IP address, "127.0.0.1" by default so only this computer can connect.
+     */
+    std::string RtspProxyBindAddress() const noexcept;
+
+    /*!
+     * \brief SetRtspProxyBindAddress sets the local address the built-in RTSP proxy listens on.
+     * \param[in] bindAddress - The IP address, e.g. "0.0.0.0" to accept connections from any
+     * computer on the network.
+     */
+    void SetRtspProxyBindAddress(std::string const& bindAddress);
+
+    /*!
+     * \brief MaxActiveDownloads returns how many storage downloads may run at once.
+     * \return The maximum number of active downloads.
+     */
+    int MaxActiveDownloads() const noexcept;
+
+    /*!
+     * \brief SetMaxActiveDownloads sets how many storage downloads may run at once.
+     * \param[in] maxDownloads - The maximum number of active downloads, from 1 to 16.
+     */
+    void SetMaxActiveDownloads(int const maxDownloads);
+
+    /*!
+     * \brief DownloadConnectionsPerCamera returns the connections downloads may open to a
+     * camera.
+     * \return The maximum number of connections per camera.
+     */
+    int DownloadConnectionsPerCamera() const noexcept;
+
+    /*!
+     * \brief SetDownloadConnectionsPerCamera sets the connections downloads may open to a
+     * camera.
+     * \param[in] maxConnections - The maximum number of connections per camera, from 1 to 8.
+     */
+    void SetDownloadConnectionsPerCamera(int const maxConnections);
+
+    /*!
+     * \brief DownloadKiBPerSecPerCamera returns the download bandwidth cap per camera.
+     * \return The cap in KiB per second, 0 if downloads are not capped.
+     */
+    int DownloadKiBPerSecPerCamera() const noexcept;
+
+    /*!
+     * \brief SetDownloadKiBPerSecPerCamera sets the download bandwidth cap per camera.
+     * \param[in] kibPerSec - The cap in KiB per second, 0 to not cap downloads.
+     */
+    void SetDownloadKiBPerSecPerCamera(int const kibPerSec);
+
+    /*!
+     * \brief MirrorFolderPath returns the folder cameras' storage is mirrored to.
+     * \return The mirror folder path, empty if mirroring is disabled.
+     */
+    std::string MirrorFolderPath() const noexcept;
+
+    /*!
+     * \brief SetMirrorFolderPath sets the folder cameras' storage is mirrored to.
+     * \param[in] mirrorFolderPath - The mirror folder path, empty to disable mirroring.
+     */
+    void SetMirrorFolderPath(std::string const& mirrorFolderPath);
+
+    /*!
+     * \brief MirrorIntervalMins returns the time between syncs of a camera's storage.
+     * \return The sync interval in minutes.
+     */
+    int MirrorIntervalMins() const noexcept;
+
+    /*!
+     * \brief SetMirrorIntervalMins sets the time between syncs of a camera's storage.
+     * \param[in] intervalMins - The sync interval in minutes, from 1 to 1440.
+     */
+    void SetMirrorIntervalMins(int const intervalMins);
+
+    /*!
+     * \brief MirrorRecordingKiBPerSecPerCamera returns the mirror's bandwidth cap per camera
+     * while the camera is recording.
+     * \return The cap in KiB per second, 0 if mirroring is not capped while recording.
+     */
+    int MirrorRecordingKiBPerSecPerCamera() const noexcept;
+
+    /*!
+     * \brief SetMirrorRecordingKiBPerSecPerCamera sets the mirror's bandwidth cap per camera
+     * while the camera is recording.
+     * \param[in] kibPerSec - The cap in KiB per second, 0 to not cap mirroring while recording.
+     */
+    void SetMirrorRecordingKiBPerSecPerCamera(int const kibPerSec);
+
     /*!
      * \brief Save the preferences to disk from memory.
      */
@@ -176,6 +357,49 @@ private:
            CEREAL_NVP(m_mtSchedule),
            CEREAL_NVP(m_maxNumDaysData),
            CEREAL_NVP(m_maxUsedDiskSpacePercent));
+
+        if (version > 1)
+        {
+            ar(CEREAL_NVP(m_tilesPerPage));
+        }
+
+        if (version > 2)
+        {
+            ar(CEREAL_NVP(m_httpServerPort),
+               CEREAL_NVP(m_httpFrameWidth),
+               CEREAL_NVP(m_httpFrameHeight),
+               CEREAL_NVP(m_httpJpegQuality),
+               CEREAL_NVP(m_httpMaxFps));
+        }
+
+        if (version > 3)
+        {
+            ar(CEREAL_NVP(m_rtspProxyPort));
+        }
+
+        if (version > 4)
+        {
+            ar(CEREAL_NVP(m_maxActiveDownloads),
+               CEREAL_NVP(m_downloadConnectionsPerCamera),
+               CEREAL_NVP(m_downloadKiBPerSecPerCamera));
+        }
+
+        if (version > 5)
+        {
+            ar(CEREAL_NVP(m_mirrorFolderPath),
+               CEREAL_NVP(m_mirrorIntervalMins),
+               CEREAL_NVP(m_mirrorRecordingKiBPerSecPerCamera));
+        }
+
+        if (version > 6)
+        {
+            ar(CEREAL_NVP(m_httpBindAddress));
+        }
+
+        if (version > 7)
+        {
+            ar(CEREAL_NVP(m_rtspProxyBindAddress));
+        }
     }
 
 private:
@@ -191,10 +415,25 @@ private:
             true, true, true, true, true, true, true, true, true, true, true, true}};
     int m_maxNumDaysData{7};
     int m_maxUsedDiskSpacePercent{90};
+    int m_tilesPerPage{4};
+    int m_httpServerPort{0};
+    int m_httpFrameWidth{640};
+    int m_httpFrameHeight{480};
+    int m_httpJpegQuality{75};
+    int m_httpMaxFps{10};
+    int m_rtspProxyPort{0};
+    int m_maxActiveDownloads{4};
+    int m_downloadConnectionsPerCamera{2};
+    int m_downloadKiBPerSecPerCamera{0};
+    std::string m_mirrorFolderPath{};
+    int m_mirrorIntervalMins{60};
+    int m_mirrorRecordingKiBPerSecPerCamera{256};
+    std::string m_httpBindAddress{"127.0.0.1"};
+    std::string m_rtspProxyBindAddress{"127.0.0.1"};
 };
 
 } // namespace ipfreely
 
-CEREAL_CLASS_VERSION(ipfreely::IpFreelyPreferences, 1);
+CEREAL_CLASS_VERSION(ipfreely::IpFreelyPreferences, 8);
 
 #endif // IPFREELYPREFERENCES_H
@@ -25,6 +25,8 @@
 #include "IpFreelyPreferencesDialog.h"
 #include "ui_IpFreelyPreferencesDialog.h"
 #include <QFileDialog>
+#include <QMessageBox>
+#include <QHostAddress>
 #include <QScreen>
 #include <boost/filesystem.hpp>
 #include "IpFreelyPreferences.h"
@@ -50,6 +52,21 @@ IpFreelyPreferencesDialog::IpFreelyPreferencesDialog(ipfreely::IpFreelyPreferenc
     ui->connectOnStartupCheckBox->setChecked(m_prefs.ConnectToCamerasOnStartup());
     ui->maxDaysOfDataSpinBox->setValue(m_prefs.MaxNumDaysData());
     ui->percentDiskUsedSpinBox->setValue(m_prefs.MaxUsedDiskSpacePercent());
+    ui->httpServerPortSpinBox->setValue(m_prefs.HttpServerPort());
+    ui->httpBindAddressLineEdit->setText(QString::fromStdString(m_prefs.HttpBindAddress()));
+    ui->httpFrameWidthSpinBox->setValue(m_prefs.HttpFrameWidth());
+    ui->httpFrameHeightSpinBox->setValue(m_prefs.HttpFrameHeight());
+    ui->httpJpegQualitySpinBox->setValue(m_prefs.HttpJpegQuality());
+    ui->httpMaxFpsSpinBox->setValue(m_prefs.HttpMaxFps());
+    ui->rtspProxyPortSpinBox->setValue(m_prefs.RtspProxyPort());
+    ui->rtspProxyBindAddressLineEdit->setText(
+        QString::fromStdString(m_prefs.RtspProxyBindAddress()));
+    ui->maxActiveDownloadsSpinBox->setValue(m_prefs.MaxActiveDownloads());
+    ui->downloadConnectionsSpinBox->setValue(m_prefs.DownloadConnectionsPerCamera());
+    ui->downloadLimitSpinBox->setValue(m_prefs.DownloadKiBPerSecPerCamera());
+    ui->mirrorFolderPathLineEdit->setText(QString::fromStdString(m_prefs.MirrorFolderPath()));
+    ui->mirrorIntervalSpinBox->setValue(m_prefs.MirrorIntervalMins());
+    ui->mirrorRecordingLimitSpinBox->setValue(m_prefs.MirrorRecordingKiBPerSecPerCamera());
     SetDisplaySize();
 
     InitialisSchedules();
@@ -62,6 +79,15 @@ IpFreelyPreferencesDialog::~IpFreelyPreferencesDialog()
 
 void IpFreelyPreferencesDialog::on_buttonBox_accepted()
 {
+    QString httpBindAddress;
+    QString rtspBindAddress;
+
+    if (!CheckBindAddress(ui->httpBindAddressLineEdit, tr("web server"), httpBindAddress) ||
+        !CheckBindAddress(ui->rtspProxyBindAddressLineEdit, tr("RTSP proxy"), rtspBindAddress))
+    {
+        return;
+    }
+
     m_prefs.SetSaveFolderPath(ui->saveFolderPathLineEdit->text().toStdString());
     m_prefs.SetFileDurationInSecs(ui->fileDurationDoubleSpinBox->value());
     m_prefs.SetConnectToCamerasOnStartup(ui->connectOnStartupCheckBox->isChecked());
@@ -93,11 +119,53 @@ void IpFreelyPreferencesDialog::on_buttonBox_accepted()
     m_prefs.SetMotionTrackingSchedule(schedule);
     m_prefs.SetMaxNumDaysData(ui->maxDaysOfDataSpinBox->value());
     m_prefs.SetMaxUsedDiskSpacePercent(ui->percentDiskUsedSpinBox->value());
+    m_prefs.SetHttpServerPort(ui->httpServerPortSpinBox->value());
+    m_prefs.SetHttpBindAddress(httpBindAddress.toStdString());
+    m_prefs.SetHttpFrameSize(ui->httpFrameWidthSpinBox->value(),
+                             ui->httpFrameHeightSpinBox->value());
+    m_prefs.SetHttpJpegQuality(ui->httpJpegQualitySpinBox->value());
+    m_prefs.SetHttpMaxFps(ui->httpMaxFpsSpinBox->value());
+    m_prefs.SetRtspProxyPort(ui->rtspProxyPortSpinBox->value());
+    m_prefs.SetRtspProxyBindAddress(rtspBindAddress.toStdString());
+    m_prefs.SetMaxActiveDownloads(ui->maxActiveDownloadsSpinBox->value());
+    m_prefs.SetDownloadConnectionsPerCamera(ui->downloadConnectionsSpinBox->value());
+    m_prefs.SetDownloadKiBPerSecPerCamera(ui->downloadLimitSpinBox->value());
+    m_prefs.SetMirrorFolderPath(ui->mirrorFolderPathLineEdit->text().trimmed().toStdString());
+    m_prefs.SetMirrorIntervalMins(ui->mirrorIntervalSpinBox->value());
+    m_prefs.SetMirrorRecordingKiBPerSecPerCamera(ui->mirrorRecordingLimitSpinBox->value());
 
     m_prefs.Save();
     accept();
 }
 
+bool IpFreelyPreferencesDialog::CheckBindAddress(QLineEdit* lineEdit, QString const& serverName,
+                                                 QString& bindAddress)
+{
+    bindAddress = lineEdit->text().trimmed();
+
+    if (bindAddress.isEmpty())
+    {
+        bindAddress = lineEdit->placeholderText();
+    }
+
+    if (!QHostAddress(bindAddress).isNull())
+    {
+        return true;
+    }
+
+    auto const message =
+        tr("The %1's address must be an IP address, e.g. 127.0.0.1.").arg(serverName);
+
+    QMessageBox::warning(this,
+                         tr("Preferences"),
+                         message,
+                         QMessageBox::Ok,
+                         QMessageBox::Ok);
+    ui->tabWidget->setCurrentIndex(0);
+    lineEdit->setFocus();
+    return false;
+}
+
 void IpFreelyPreferencesDialog::on_buttonBox_rejected()
 {
     reject();
@@ -126,6 +194,24 @@ void IpFreelyPreferencesDialog::on_saveFolderPathToolButton_clicked()
     ui->saveFolderPathLineEdit->setText(QString::fromStdWString(p.wstring()));
 }
 
+void IpFreelyPreferencesDialog::on_mirrorFolderPathToolButton_clicked()
+{
+    QString dir = QFileDialog::getExistingDirectory(
+        this,
+        tr("Select storage mirror folder..."),
+        ui->mirrorFolderPathLineEdit->text(),
+        QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+
+    if (dir.isEmpty())
+    {
+        return;
+    }
+
+    bfs::path p(dir.toStdWString());
+    p = bfs::system_complete(p);
+    ui->mirrorFolderPathLineEdit->setText(QString::fromStdWString(p.wstring()));
+}
+
 void IpFreelyPreferencesDialog::on_selectNonePushButton_clicked()
 {
     for (int row = 0; row < ui->scheduleTableWidget->rowCount(); ++row)
@@ -38,6 +38,9 @@ namespace ipfreely
 class IpFreelyPreferences;
 } // namespace ipfreely
 
+class QLineEdit;
+class QString;
+
 /*! \brief The IpFreelyPreferencesDialog class. */
 class IpFreelyPreferencesDialog : public QDialog
 {
@@ -59,6 +62,7 @@ private slots:
     void on_buttonBox_accepted();
     void on_buttonBox_rejected();
     void on_saveFolderPathToolButton_clicked();
+    void on_mirrorFolderPathToolButton_clicked();
     void on_selectNonePushButton_clicked();
     void on_selectAllPushButton_clicked();
     void on_revertSchedulePushButton_clicked();
@@ -69,6 +73,7 @@ private slots:
 private:
     void SetDisplaySize();
     void InitialisSchedules();
+    bool CheckBindAddress(QLineEdit* lineEdit, QString const& serverName, QString& bindAddress);
 
 private:
     Ui::IpFreelyPreferencesDialog* ui;
@@ -0,0 +1,344 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyRecorderService.cpp
+ * \brief File containing definition of IpFreelyRecorderService class.
+ */
+#include "IpFreelyRecorderService.h"
+#include <exception>
+#include <string>
+#include <vector>
+#include <boost/exception/all.hpp>
+#include <boost/filesystem.hpp>
+#include "IpFreelyStreamProcessor.h"
+#include "IpFreelyDiskSpaceManager.h"
+#include "IpFreelyHttpServer.h"
+#include "IpFreelyRtspProxy.h"
+#include "IpFreelyStorageMirror.h"
+#include "IpFreelySchedule.h"
+#include "IpFreelyMetrics.h"
+#include "IpFreelyStreamStats.h"
+#include "DebugLog/DebugLogging.h"
+
+namespace bfs = boost::filesystem;
+
+namespace ipfreely
+{
+
+// How long to wait before retrying a camera that failed to connect.
+static constexpr std::chrono::seconds CONNECT_RETRY_PERIOD{30};
+
+// How long a connected stream may go without a new frame before it is reconnected.
+static constexpr std::chrono::seconds STREAM_STALL_PERIOD{30};
+
+IpFreelyRecorderService::IpFreelyRecorderService()
+    : m_metrics(std::make_shared<IpFreelyMetrics>())
+{
+    DEBUG_MESSAGE_EX_INFO("Recorder service created, camera count: "
+                          << m_camDb.GetCameraIds().size());
+}
+
+IpFreelyRecorderService::~IpFreelyRecorderService()
+{
+    Stop();
+}
+
+void IpFreelyRecorderService::Start()
+{
+    DEBUG_MESSAGE_EX_INFO("Starting recorder service, save folder: " << m_prefs.SaveFolderPath());
+
+    m_diskSpaceMgr = std::make_shared<IpFreelyDiskSpaceManager>(m_prefs.SaveFolderPath(),
+                                                                m_prefs.MaxNumDaysData(),
+                                                                m_prefs.MaxUsedDiskSpacePercent(),
+                                                                m_metrics);
+
+    if (m_prefs.HttpServerPort() > 0)
+    {
+        m_httpServer = std::make_shared<IpFreelyHttpServer>(
+            static_cast<uint16_t>(m_prefs.HttpServerPort()),
+            m_prefs.HttpBindAddress(),
+            QSize(m_prefs.HttpFrameWidth(), m_prefs.HttpFrameHeight()),
+            m_prefs.HttpJpegQuality(),
+            m_prefs.HttpMaxFps(),
+            m_metrics);
+    }
+
+    std::vector<IpCamera> cameras;
+
+    for (auto const camId : m_camDb.GetCameraIds())
+    {
+        auto const camera = m_camDb.GetCamera(camId);
+
+        if (camera)
+        {
+            cameras.emplace_back(*camera);
+        }
+    }
+
+    if (m_prefs.RtspProxyPort() > 0)
+    {
+        m_rtspProxy = std::make_shared<IpFreelyRtspProxy>(
+            static_cast<uint16_t>(m_prefs.RtspProxyPort()), m_prefs.RtspProxyBindAddress());
+        m_rtspProxy->SetCameras(cameras);
+    }
+
+    if (!m_prefs.MirrorFolderPath().empty())
+    {
+        MirrorSettings settings;
+        settings.mirrorFolderPath            = m_prefs.MirrorFolderPath();
+        settings.syncIntervalMins            = m_prefs.MirrorIntervalMins();
+        settings.maxActiveDownloads          = m_prefs.MaxActiveDownloads();
+        settings.connectionsPerCamera        = m_prefs.DownloadConnectionsPerCamera();
+        settings.kibPerSecPerCamera          = m_prefs.DownloadKiBPerSecPerCamera();
+        settings.recordingKiBPerSecPerCamera = m_prefs.MirrorRecordingKiBPerSecPerCamera();
+        settings.recordingSchedule =
+            IpFreelySchedule::FromHourlySchedule(m_prefs.RecordingSchedule());
+        settings.motionSchedule =
+            IpFreelySchedule::FromHourlySchedule(m_prefs.MotionTrackingSchedule());
+
+        m_storageMirror = std::make_shared<IpFreelyStorageMirror>(settings);
+        m_storageMirror->SetCameras(cameras);
+    }
+
+    for (auto const& camera : cameras)
+    {
+        ConnectCamera(camera, m_cameraStreams[camera.camId]);
+    }
+}
+
+void IpFreelyRecorderService::Stop()
+{
+    if (m_cameraStreams.empty() && !m_diskSpaceMgr && !m_httpServer && !m_rtspProxy &&
+        !m_storageMirror)
+    {
+        return;
+    }
+
+    DEBUG_MESSAGE_EX_INFO("Stopping recorder service.");
+
+    // Wait for cameras that are still connecting so their stream processors are stopped
+    // here too, rather than recording on unnoticed.
+    for (auto& cameraStream : m_cameraStreams)
+    {
+        if (cameraStream.second.pendingConnection.valid())
+        {
+            cameraStream.second.pendingConnection.wait();
+        }
+    }
+
+    // Stop serving clients before the stream processors go, so the last reference to a
+    // stream processor is never dropped by the web server's thread.
+    m_httpServer.reset();
+    m_rtspProxy.reset();
+
+    // Stopping the mirror saves its manifests, partial downloads are resumed next time.
+    m_storageMirror.reset();
+
+    // Destroying the stream processors stops their threads and closes any open video files.
+    m_cameraStreams.clear();
+    m_diskSpaceMgr.reset();
+}
+
+void IpFreelyRecorderService::Reload()
+{
+    DEBUG_MESSAGE_EX_INFO("Reloading recorder service configuration.");
+
+    Stop();
+
+    m_prefs = IpFreelyPreferences();
+    m_camDb = IpFreelyCameraDatabase();
+
+    try
+    {
+        Start();
+    }
+    catch (...)
+    {
+        // Don't leave the service half started, e.g. serving cameras it is not recording.
+        Stop();
+        throw;
+    }
+}
+
+void IpFreelyRecorderService::CheckStreams()
+{
+    auto const now = std::chrono::steady_clock::now();
+
+    for (auto& cameraStreamEntry : m_cameraStreams)
+    {
+        auto const camId        = cameraStreamEntry.first;
+        auto&      cameraStream = cameraStreamEntry.second;
+
+        if (cameraStream.pendingConnection.valid())
+        {
+            if (cameraStream.pendingConnection.wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready)
+            {
+                CompleteConnection(camId, cameraStream);
+            }
+
+            continue;
+        }
+
+        if (cameraStream.streamProcessor)
+        {
+            auto const frameSequence = cameraStream.streamProcessor->VideoFrameSequence();
+
+            if (frameSequence != cameraStream.lastFrameSequence)
+            {
+                cameraStream.lastFrameSequence = frameSequence;
+                cameraStream.lastActivityTime  = now;
+                continue;
+            }
+
+            if (now - cameraStream.lastActivityTime < STREAM_STALL_PERIOD)
+            {
+                continue;
+            }
+
+            DEBUG_MESSAGE_EX_WARNING("No new video frames, reconnecting camera: "
+                                     << CameraName(camId));
+
+            ReleaseStreamProcessor(camId, cameraStream);
+        }
+        else if (now - cameraStream.lastActivityTime < CONNECT_RETRY_PERIOD)
+        {
+            continue;
+        }
+
+        auto const camera = m_camDb.GetCamera(camId);
+
+        if (camera)
+        {
+            ConnectCamera(*camera, cameraStream);
+        }
+    }
+}
+
+void IpFreelyRecorderService::ConnectCamera(IpCamera const& camera, CameraStream& cameraStream)
+{
+    auto const camName = CameraName(camera.camId);
+
+    DEBUG_MESSAGE_EX_INFO("Connecting to camera: " << camName);
+
+    bfs::path p(m_prefs.SaveFolderPath());
+    p = bfs::system_complete(p);
+
+    IpFreelySchedule schedule;
+
+    if (camera.enableScheduledRecording)
+    {
+        schedule = IpFreelySchedule::FromHourlySchedule(m_prefs.RecordingSchedule());
+        schedule.SetPrewarmSecs(DEFAULT_SCHEDULE_PREWARM_SECS);
+    }
+
+    IpFreelySchedule motionSchedule;
+
+    if (camera.enabledMotionRecording)
+    {
+        motionSchedule = IpFreelySchedule::FromHourlySchedule(m_prefs.MotionTrackingSchedule());
+        motionSchedule.SetPrewarmSecs(DEFAULT_SCHEDULE_PREWARM_SECS);
+    }
+
+    auto const saveFolderPath   = p.string();
+    auto const fileDurationSecs = m_prefs.FileDurationInSecs();
+    auto const streamStats      = m_metrics->StreamStats(camera.camId);
+
+    streamStats->ConnectionAttempted();
+
+    ReleaseStreamProcessor(camera.camId, cameraStream);
+    cameraStream.lastFrameSequence = 0;
+    cameraStream.lastActivityTime  = std::chrono::steady_clock::now();
+
+    // Opening an RTSP session can take several seconds so is done on a worker thread, there
+    // is no display callback as nothing ever subscribes to display frames.
+    cameraStream.pendingConnection = std::async(std::launch::async, [=]() {
+        try
+        {
+            return std::make_shared<IpFreelyStreamProcessor>(camName,
+                                                             camera,
+                                                             saveFolderPath,
+                                                             fileDurationSecs,
+                                                             schedule,
+                                                             motionSchedule,
+                                                             nullptr,
+                                                             streamStats);
+        }
+        catch (...)
+        {
+            streamStats->ConnectionFailed();
+            throw;
+        }
+    });
+}
+
+void IpFreelyRecorderService::ReleaseStreamProcessor(camera_id_t const camId,
+                                                     CameraStream&     cameraStream)
+{
+    if (!cameraStream.streamProcessor)
+    {
+        return;
+    }
+
+    // Wait for the web server to finish with the stream processor so it is destroyed here,
+    // stopping its thread and closing its video file, not on the web server's thread.
+    if (m_httpServer)
+    {
+        m_httpServer->RemoveStreamProcessor(camId);
+    }
+
+    cameraStream.streamProcessor.reset();
+}
+
+void IpFreelyRecorderService::CompleteConnection(camera_id_t const camId,
+                                                 CameraStream&     cameraStream)
+{
+    auto const camName = CameraName(camId);
+
+    try
+    {
+        cameraStream.streamProcessor = cameraStream.pendingConnection.get();
+
+        if (m_httpServer)
+        {
+            m_httpServer->SetStreamProcessor(camId, cameraStream.streamProcessor);
+        }
+
+        DEBUG_MESSAGE_EX_INFO("Connected to camera: " << camName);
+    }
+    catch (std::exception& e)
+    {
+        DEBUG_MESSAGE_EX_ERROR("Stream Error, camera: "
+                               << camName << ", error message: " << e.what()
+                               << ", retrying in " << CONNECT_RETRY_PERIOD.count() << "s");
+    }
+
+    // Stall and retry periods are measured from when the connection attempt completed.
+    cameraStream.lastActivityTime = std::chrono::steady_clock::now();
+}
+
+std::string IpFreelyRecorderService::CameraName(camera_id_t const camId)
+{
+    // Must match the GUI's camera names so recordings from both are named alike.
+    return "Camera" + std::to_string(camId);
+}
+
+} // namespace ipfreely
@@ -0,0 +1,138 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyRecorderService.h
+ * \brief File containing declaration of IpFreelyRecorderService class.
+ */
+#ifndef IPFREELYRECORDERSERVICE_H
+#define IPFREELYRECORDERSERVICE_H
+
+#include <map>
+#include <memory>
+#include <future>
+#include <chrono>
+#include <cstdint>
+#include "IpFreelyPreferences.h"
+#include "IpFreelyCameraDatabase.h"
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+class IpFreelyStreamProcessor;
+class IpFreelyDiskSpaceManager;
+class IpFreelyHttpServer;
+class IpFreelyRtspProxy;
+class IpFreelyStorageMirror;
+class IpFreelyMetrics;
+
+/*! \brief Class defining a headless recording service for all cameras in the database. */
+class IpFreelyRecorderService final
+{
+public:
+    /*!
+     * \brief IpFreelyRecorderService constructor.
+     *
+     * The service runs the same stream processors, motion detectors and disk space manager as
+     * the GUI, configured from the same preferences and camera database files, but has no
+     * display targets so captured frames are never converted or scaled for display.
+     *
+     * Cameras record according to their scheduled and motion recording settings, manual
+     * recording is a GUI only feature.
+     */
+    IpFreelyRecorderService();
+
+    /*! \brief IpFreelyRecorderService destructor. */
+    ~IpFreelyRecorderService();
+
+    /*! \brief IpFreelyRecorderService deleted copy constructor. */
+    IpFreelyRecorderService(IpFreelyRecorderService const&) = delete;
+
+    /*! \brief IpFreelyRecorderService deleted copy assignment operator. */
+    IpFreelyRecorderService& operator=(IpFreelyRecorderService const&) = delete;
+
+    /*!
+     * \brief Start loads the configuration and starts connecting to all cameras.
+     *
+     * Cameras are connected to asynchronously so a slow or unreachable camera never delays
+     * the others. Call CheckStreams() periodically to complete connections.
+     */
+    void Start();
+
+    /*! \brief Stop disconnects from all cameras and stops the disk space manager. */
+    void Stop();
+
+    /*!
+     * \brief Reload stops the service, reloads the configuration from disk and restarts it.
+     *
+     * Used to pick up changes made to the preferences or camera database, e.g. by the GUI.
+     * If the new configuration cannot be loaded or started the service is left stopped and
+     * the error is thrown, so the caller can report it and try again later.
+     */
+    void Reload();
+
+    /*!
+     * \brief CheckStreams completes pending connections and restarts failed streams.
+     *
+     * Cameras that failed to connect are retried and streams that have not captured a new
+     * frame for a while are reconnected, so the service recovers from cameras rebooting or
+     * dropping off the network without intervention.
+     */
+    void CheckStreams();
+
+private:
+    /*! \brief Typedef for stream processor pointer. */
+    typedef std::shared_ptr<IpFreelyStreamProcessor> stream_proc_t;
+
+    /*! \brief Structure holding the state of a single camera's stream. */
+    struct CameraStream
+    {
+        /*! \brief The connected stream processor, null while connecting or disconnected. */
+        stream_proc_t streamProcessor{};
+        /*! \brief The stream processor being created, valid while connecting. */
+        std::future<stream_proc_t> pendingConnection{};
+        /*! \brief The sequence number of the last frame seen from the stream. */
+        uint64_t lastFrameSequence{0};
+        /*! \brief When the last new frame or connection attempt was seen. */
+        std::chrono::steady_clock::time_point lastActivityTime{};
+    };
+
+private:
+    void               ConnectCamera(IpCamera const& camera, CameraStream& cameraStream);
+    void               CompleteConnection(camera_id_t const camId, CameraStream& cameraStream);
+    void               ReleaseStreamProcessor(camera_id_t const camId,
+                                              CameraStream&     cameraStream);
+    static std::string CameraName(camera_id_t const camId);
+
+private:
+    IpFreelyPreferences                       m_prefs;
+    IpFreelyCameraDatabase                    m_camDb;
+    std::shared_ptr<IpFreelyMetrics>          m_metrics;
+    std::shared_ptr<IpFreelyDiskSpaceManager> m_diskSpaceMgr;
+    std::shared_ptr<IpFreelyHttpServer>       m_httpServer;
+    std::shared_ptr<IpFreelyRtspProxy>        m_rtspProxy;
+    std::shared_ptr<IpFreelyStorageMirror>    m_storageMirror;
+    std::map<camera_id_t, CameraStream>       m_cameraStreams;
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYRECORDERSERVICE_H
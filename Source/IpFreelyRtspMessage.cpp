@@ -0,0 +1,117 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyRtspMessage.cpp
+ * \brief File containing definitions of the RTSP message parsing helpers.
+ */
+#include "IpFreelyRtspMessage.h"
+
+namespace ipfreely
+{
+
+QByteArray HeaderValue(RtspMessage const& message, QByteArray const& name)
+{
+    for (auto const& header : message.headers)
+    {
+        if (header.first == name)
+        {
+            return header.second;
+        }
+    }
+
+    return {};
+}
+
+bool TakeRtspMessage(QByteArray& buffer, RtspMessage& message)
+{
+    auto const headerEnd = buffer.indexOf("\r\n\r\n");
+
+    if (headerEnd < 0)
+    {
+        return false;
+    }
+
+    RtspMessage parsedMessage;
+    auto const  lines = buffer.left(headerEnd).split('\n');
+
+    parsedMessage.startLine = lines.front().trimmed();
+
+    for (int i = 1; i < lines.size(); ++i)
+    {
+        auto const colon = lines[i].indexOf(':');
+
+        if (colon > 0)
+        {
+            parsedMessage.headers.emplace_back(lines[i].left(colon).trimmed().toLower(),
+                                               lines[i].mid(colon + 1).trimmed());
+        }
+    }
+
+    auto const contentLength = HeaderValue(parsedMessage, "content-length").toInt();
+    auto const messageSize   = headerEnd + 4 + contentLength;
+
+    if (buffer.size() < messageSize)
+    {
+        return false;
+    }
+
+    parsedMessage.body = buffer.mid(headerEnd + 4, contentLength);
+    buffer.remove(0, messageSize);
+    message = std::move(parsedMessage);
+    return true;
+}
+
+bool TakeInterleavedFrame(QByteArray& buffer, QByteArray& frame)
+{
+    if (buffer.size() < 4)
+    {
+        return false;
+    }
+
+    auto const length = (static_cast<int>(static_cast<uint8_t>(buffer[2])) << 8) |
+                        static_cast<int>(static_cast<uint8_t>(buffer[3]));
+
+    if (buffer.size() < 4 + length)
+    {
+        return false;
+    }
+
+    frame = buffer.left(4 + length);
+    buffer.remove(0, 4 + length);
+    return true;
+}
+
+bool InterleavedChannel(QByteArray const& transport, int& channel)
+{
+    for (auto const& parameter : transport.split(';'))
+    {
+        if (parameter.trimmed().startsWith("interleaved="))
+        {
+            bool ok = false;
+            channel = parameter.trimmed().mid(12).split('-').front().toInt(&ok);
+            return ok && (channel >= 0) && (channel < 255);
+        }
+    }
+
+    return false;
+}
+
+} // namespace ipfreely
@@ -0,0 +1,81 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyRtspMessage.h
+ * \brief File containing declarations of the RTSP message parsing helpers.
+ */
+#ifndef IPFREELYRTSPMESSAGE_H
+#define IPFREELYRTSPMESSAGE_H
+
+#include <QByteArray>
+#include <vector>
+#include <utility>
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*! \brief Structure holding a parsed RTSP request or response. */
+struct RtspMessage
+{
+    /*! \brief The request or status line. */
+    QByteArray startLine{};
+    /*! \brief The headers, with lower case names, in the order received. */
+    std::vector<std::pair<QByteArray, QByteArray>> headers{};
+    /*! \brief The message body, e.g. an SDP description. */
+    QByteArray body{};
+};
+
+/*!
+ * \brief HeaderValue finds a message header's value.
+ * \param[in] message - The message.
+ * \param[in] name - The header's lower case name.
+ * \return The first matching header's value, empty if there is no such header.
+ */
+QByteArray HeaderValue(RtspMessage const& message, QByteArray const& name);
+
+/*!
+ * \brief TakeRtspMessage takes one complete RTSP message from the front of a buffer.
+ * \param[in,out] buffer - Received data, the message's bytes are removed from it.
+ * \param[out] message - The parsed message.
+ * \return True if a complete message was taken, false if more data is needed.
+ */
+bool TakeRtspMessage(QByteArray& buffer, RtspMessage& message);
+
+/*!
+ * \brief TakeInterleavedFrame takes one "$<channel><length><payload>" frame from a buffer.
+ * \param[in,out] buffer - Received data, the frame's bytes are removed from it.
+ * \param[out] frame - The whole frame, including its 4 byte header.
+ * \return True if a complete frame was taken, false if more data is needed.
+ */
+bool TakeInterleavedFrame(QByteArray& buffer, QByteArray& frame);
+
+/*!
+ * \brief InterleavedChannel parses "interleaved=<first>-<second>" from a Transport header.
+ * \param[in] transport - The Transport header's value.
+ * \param[out] channel - The first interleaved channel.
+ * \return True if a valid channel was found, false otherwise.
+ */
+bool InterleavedChannel(QByteArray const& transport, int& channel);
+
+} // namespace ipfreely
+
+#endif // IPFREELYRTSPMESSAGE_H
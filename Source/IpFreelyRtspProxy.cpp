@@ -0,0 +1,1237 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyRtspProxy.cpp
+ * \brief File containing definition of IpFreelyRtspProxy class.
+ */
+#include "IpFreelyRtspProxy.h"
+#include <QThread>
+#include <QTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QPointer>
+#include <QUrl>
+#include <QCryptographicHash>
+#include <QRandomGenerator>
+#include <functional>
+#include <utility>
+#include <string>
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+#include <boost/exception/all.hpp>
+#include "IpFreelyRtspMessage.h"
+#include "DebugLog/DebugLogging.h"
+
+namespace ipfreely
+{
+
+namespace
+{
+
+// RTSP requests and responses, excluding an SDP body, are never this large.
+static constexpr int MAX_MESSAGE_SIZE = 16384;
+
+// Upper limit on the data queued for a single client before its packets are dropped.
+static constexpr qint64 MAX_CLIENT_QUEUE_BYTES = 4 * 1024 * 1024;
+
+// How long a camera has to start playing once a session to it is opened.
+static constexpr int UPSTREAM_START_TIMEOUT_MS = 10000;
+
+// How long a camera session is kept open after its last client leaves.
+static constexpr int UPSTREAM_IDLE_TIMEOUT_MS = 10000;
+
+// Fallback keep alive period if the camera does not give a session timeout.
+static constexpr int DEFAULT_KEEP_ALIVE_MS = 30000;
+
+// The session timeout, in seconds, given to clients.
+static constexpr int CLIENT_SESSION_TIMEOUT_SECS = 60;
+
+QByteArray Md5Hex(QByteArray const& data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
+}
+
+QByteArray ResolveUrl(QByteArray const& baseUrl, QByteArray const& control)
+{
+    if (control.toLower().startsWith("rtsp://"))
+    {
+        return control;
+    }
+
+    if (control.isEmpty() || (control == "*"))
+    {
+        return baseUrl;
+    }
+
+    return baseUrl.endsWith('/') ? baseUrl + control : baseUrl + "/" + control;
+}
+
+// Rewrites a camera's SDP so its tracks are controlled through the proxy as "track<index>".
+QByteArray ProxySdp(QByteArray const& sdp)
+{
+    QByteArray proxySdp;
+    int        trackIndex = 0;
+
+    for (auto line : sdp.split('\n'))
+    {
+        line = line.trimmed();
+
+        if (line.isEmpty() || line.startsWith("a=control:"))
+        {
+            continue;
+        }
+
+        if (line.startsWith("m="))
+        {
+            if (trackIndex == 0)
+            {
+                proxySdp += "a=control:*\r\n";
+            }
+
+            proxySdp += line + "\r\na=control:track" + QByteArray::number(trackIndex++) + "\r\n";
+            continue;
+        }
+
+        proxySdp += line + "\r\n";
+    }
+
+    return proxySdp;
+}
+
+/*! \brief Class defining a RTSP session to a camera, playing RTP interleaved over TCP. */
+class RtspUpstream final : public QObject
+{
+public:
+    /*! \brief Typedef for the callback fired when the session starts playing. */
+    typedef std::function<void()> ready_callback_t;
+    /*! \brief Typedef for the callback fired for every interleaved frame received. */
+    typedef std::function<void(QByteArray const&)> packet_callback_t;
+    /*! \brief Typedef for the callback fired when the session fails or is closed. */
+    typedef std::function<void()> closed_callback_t;
+
+    RtspUpstream(IpCamera const& camera, ready_callback_t const& readyCallback,
+                 packet_callback_t const& packetCallback, closed_callback_t const& closedCallback,
+                 QObject* parent);
+    ~RtspUpstream() = default;
+
+    void              Start();
+    bool              IsPlaying() const noexcept;
+    QByteArray const& Sdp() const noexcept;
+    int               TrackCount() const noexcept;
+    int               TrackChannel(int const trackIndex) const noexcept;
+
+private:
+    enum class eState
+    {
+        connecting,
+        describing,
+        settingUp,
+        playing,
+        closed
+    };
+
+private:
+    void       SendRequest(QByteArray const& method, QByteArray const& url,
+                           QByteArray const& headers = {});
+    QByteArray AuthorizationHeader(QByteArray const& method, QByteArray const& url);
+    bool       SetAuthChallenge(RtspMessage const& response);
+    void       ReadData();
+    void       HandleResponse(RtspMessage const& response);
+    void       ParseSdp(QByteArray const& baseUrl);
+    void       SetupNextTrack();
+    void       Fail(std::string const& reason);
+
+private:
+    std::string             m_name;
+    QUrl                    m_url;
+    QByteArray              m_requestUrl;
+    QByteArray              m_username;
+    QByteArray              m_password;
+    ready_callback_t        m_readyCallback;
+    packet_callback_t       m_packetCallback;
+    closed_callback_t       m_closedCallback;
+    QTcpSocket*             m_socket;
+    QTimer*                 m_keepAliveTimer;
+    eState                  m_state;
+    QByteArray              m_buffer;
+    int                     m_cseq;
+    QByteArray              m_session;
+    QByteArray              m_lastMethod;
+    QByteArray              m_lastUrl;
+    QByteArray              m_lastHeaders;
+    bool                    m_authRetried;
+    QByteArray              m_authScheme;
+    QByteArray              m_realm;
+    QByteArray              m_nonce;
+    QByteArray              m_qop;
+    int                     m_nonceCount;
+    QByteArray              m_sdp;
+    QByteArray              m_playUrl;
+    std::vector<QByteArray> m_trackUrls;
+    std::vector<int>        m_trackChannels;
+};
+
+RtspUpstream::RtspUpstream(IpCamera const& camera, ready_callback_t const& readyCallback,
+                           packet_callback_t const& packetCallback,
+                           closed_callback_t const& closedCallback, QObject* parent)
+    : QObject(parent)
+    , m_name("Camera" + std::to_string(camera.camId))
+    , m_url(QString::fromStdString(camera.streamUrl))
+    , m_username(QByteArray::fromStdString(camera.username))
+    , m_password(QByteArray::fromStdString(camera.password))
+    , m_readyCallback(readyCallback)
+    , m_packetCallback(packetCallback)
+    , m_closedCallback(closedCallback)
+    , m_socket(new QTcpSocket(this))
+    , m_keepAliveTimer(new QTimer(this))
+    , m_state(eState::connecting)
+    , m_cseq(0)
+    , m_authRetried(false)
+    , m_nonceCount(0)
+{
+    // Credentials are sent in Authorization headers, never in request URLs.
+    if (m_username.isEmpty())
+    {
+        m_username = m_url.userName().toUtf8();
+        m_password = m_url.password().toUtf8();
+    }
+
+    m_url.setUserInfo(QString());
+    m_requestUrl = m_url.toEncoded();
+
+    connect(m_socket, &QTcpSocket::connected, this, [this]() {
+        m_state = eState::describing;
+        SendRequest("DESCRIBE", m_requestUrl, "Accept: application/sdp\r\n");
+    });
+    connect(m_socket, &QTcpSocket::readyRead, this, &RtspUpstream::ReadData);
+    connect(m_socket, &QTcpSocket::disconnected, this, [this]() { Fail("connection closed"); });
+    connect(m_socket,
+            static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(
+                &QAbstractSocket::error),
+            this,
+            [this](QAbstractSocket::SocketError) { Fail(m_socket->errorString().toStdString()); });
+    connect(m_keepAliveTimer, &QTimer::timeout, this, [this]() {
+        SendRequest("OPTIONS", m_requestUrl);
+    });
+}
+
+void RtspUpstream::Start()
+{
+    DEBUG_MESSAGE_EX_INFO("RTSP proxy opening session to: " << m_name);
+
+    m_socket->connectToHost(m_url.host(), static_cast<quint16>(m_url.port(554)));
+
+    QTimer::singleShot(UPSTREAM_START_TIMEOUT_MS, this, [this]() {
+        if (m_state != eState::playing)
+        {
+            Fail("timed out starting session");
+        }
+    });
+}
+
+bool RtspUpstream::IsPlaying() const noexcept
+{
+    return m_state == eState::playing;
+}
+
+QByteArray const& RtspUpstream::Sdp() const noexcept
+{
+    return m_sdp;
+}
+
+int RtspUpstream::TrackCount() const noexcept
+{
+    return static_cast<int>(m_trackChannels.size());
+}
+
+int RtspUpstream::TrackChannel(int const trackIndex) const noexcept
+{
+    return m_trackChannels[static_cast<size_t>(trackIndex)];
+}
+
+void RtspUpstream::SendRequest(QByteArray const& method, QByteArray const& url,
+                               QByteArray const& headers)
+{
+    m_lastMethod  = method;
+    m_lastUrl     = url;
+    m_lastHeaders = headers;
+
+    QByteArray request = method + " " + url + " RTSP/1.0\r\n";
+    request += "CSeq: " + QByteArray::number(++m_cseq) + "\r\n";
+    request += "User-Agent: IpFreely\r\n";
+
+    if (!m_session.isEmpty())
+    {
+        request += "Session: " + m_session + "\r\n";
+    }
+
+    request += AuthorizationHeader(method, url);
+    request += headers;
+    request += "\r\n";
+
+    m_socket->write(request);
+}
+
+QByteArray RtspUpstream::AuthorizationHeader(QByteArray const& method, QByteArray const& url)
+{
+    if (m_authScheme == "basic")
+    {
+        return "Authorization: Basic " + (m_username + ":" + m_password).toBase64() + "\r\n";
+    }
+
+    if (m_authScheme != "digest")
+    {
+        return {};
+    }
+
+    auto const ha1 = Md5Hex(m_username + ":" + m_realm + ":" + m_password);
+    auto const ha2 = Md5Hex(method + ":" + url);
+
+    QByteArray header = "Authorization: Digest username=\"" + m_username + "\", realm=\"" +
+                        m_realm + "\", nonce=\"" + m_nonce + "\", uri=\"" + url + "\"";
+
+    if (m_qop.isEmpty())
+    {
+        header += ", response=\"" + Md5Hex(ha1 + ":" + m_nonce + ":" + ha2) + "\"";
+    }
+    else
+    {
+        auto const nc     = QByteArray::number(++m_nonceCount, 16).rightJustified(8, '0');
+        auto const cnonce = QByteArray::number(QRandomGenerator::global()->generate64(), 16);
+        header += ", qop=auth, nc=" + nc + ", cnonce=\"" + cnonce + "\", response=\"" +
+                  Md5Hex(ha1 + ":" + m_nonce + ":" + nc + ":" + cnonce + ":auth:" + ha2) + "\"";
+    }
+
+    return header + "\r\n";
+}
+
+bool RtspUpstream::SetAuthChallenge(RtspMessage const& response)
+{
+    // Prefer digest authentication, cameras often offer both.
+    QByteArray challenge;
+
+    for (auto const& header : response.headers)
+    {
+        if (header.first != "www-authenticate")
+        {
+            continue;
+        }
+
+        if (header.second.toLower().startsWith("digest") || challenge.isEmpty())
+        {
+            challenge = header.second;
+        }
+    }
+
+    auto const schemeEnd = challenge.indexOf(' ');
+
+    if (schemeEnd < 0)
+    {
+        return false;
+    }
+
+    m_authScheme = challenge.left(schemeEnd).toLower();
+    m_nonceCount = 0;
+    m_qop.clear();
+
+    for (auto parameter : challenge.mid(schemeEnd + 1).split(','))
+    {
+        parameter        = parameter.trimmed();
+        auto const equal = parameter.indexOf('=');
+
+        if (equal < 0)
+        {
+            continue;
+        }
+
+        auto const name  = parameter.left(equal).trimmed().toLower();
+        auto       value = parameter.mid(equal + 1).trimmed();
+
+        if (value.startsWith('"') && value.endsWith('"'))
+        {
+            value = value.mid(1, value.size() - 2);
+        }
+
+        if (name == "realm")
+        {
+            m_realm = value;
+        }
+        else if (name == "nonce")
+        {
+            m_nonce = value;
+        }
+        else if ((name == "qop") && value.split(',').contains("auth"))
+        {
+            m_qop = "auth";
+        }
+    }
+
+    return (m_authScheme == "basic") || (m_authScheme == "digest");
+}
+
+void RtspUpstream::ReadData()
+{
+    m_buffer += m_socket->readAll();
+
+    while (!m_buffer.isEmpty() && (m_state != eState::closed))
+    {
+        if (m_buffer[0] == '$')
+        {
+            QByteArray frame;
+
+            if (!TakeInterleavedFrame(m_buffer, frame))
+            {
+                break;
+            }
+
+            if (m_state == eState::playing)
+            {
+                m_packetCallback(frame);
+            }
+
+            continue;
+        }
+
+        if (!m_buffer.startsWith("RTSP/"))
+        {
+            // Resynchronise on the next interleaved frame after unexpected data.
+            auto const nextFrame = m_buffer.indexOf('$');
+            m_buffer.remove(0, nextFrame < 0 ? m_buffer.size() : nextFrame);
+            continue;
+        }
+
+        RtspMessage response;
+
+        if (!TakeRtspMessage(m_buffer, response))
+        {
+            if (m_buffer.size() > MAX_MESSAGE_SIZE * 4)
+            {
+                Fail("response too large");
+            }
+
+            break;
+        }
+
+        HandleResponse(response);
+    }
+}
+
+void RtspUpstream::HandleResponse(RtspMessage const& response)
+{
+    auto const statusFields = response.startLine.split(' ');
+    auto const statusCode   = statusFields.size() > 1 ? statusFields[1].toInt() : 0;
+
+    // Keep alive responses need no handling, some cameras reject OPTIONS within a session.
+    if (m_state == eState::playing)
+    {
+        return;
+    }
+
+    if ((statusCode == 401) && !m_authRetried && SetAuthChallenge(response))
+    {
+        m_authRetried = true;
+        SendRequest(m_lastMethod, m_lastUrl, m_lastHeaders);
+        return;
+    }
+
+    if (statusCode != 200)
+    {
+        Fail(m_lastMethod.toStdString() + " failed: " + response.startLine.toStdString());
+        return;
+    }
+
+    m_authRetried = false;
+
+    if (m_lastMethod == "DESCRIBE")
+    {
+        auto baseUrl = HeaderValue(response, "content-base");
+
+        if (baseUrl.isEmpty())
+        {
+            baseUrl = HeaderValue(response, "content-location");
+        }
+
+        m_sdp = response.body;
+        ParseSdp(baseUrl.isEmpty() ? m_requestUrl : baseUrl);
+
+        if (m_trackUrls.empty())
+        {
+            Fail("no media tracks");
+            return;
+        }
+
+        m_state = eState::settingUp;
+        SetupNextTrack();
+    }
+    else if (m_lastMethod == "SETUP")
+    {
+        auto const session     = HeaderValue(response, "session").split(';');
+        int        keepAliveMs = DEFAULT_KEEP_ALIVE_MS;
+
+        if (!session.front().trimmed().isEmpty())
+        {
+            m_session = session.front().trimmed();
+        }
+
+        for (int i = 1; i < session.size(); ++i)
+        {
+            if (session[i].trimmed().startsWith("timeout="))
+            {
+                keepAliveMs = session[i].trimmed().mid(8).toInt() * 1000 / 2;
+            }
+        }
+
+        m_keepAliveTimer->setInterval(keepAliveMs > 0 ? keepAliveMs : DEFAULT_KEEP_ALIVE_MS);
+
+        // The camera may choose different channels to the ones we asked for.
+        int channel = static_cast<int>(m_trackChannels.size()) * 2;
+        InterleavedChannel(HeaderValue(response, "transport"), channel);
+        m_trackChannels.emplace_back(channel);
+
+        if (m_trackChannels.size() < m_trackUrls.size())
+        {
+            SetupNextTrack();
+        }
+        else
+        {
+            SendRequest("PLAY", m_playUrl, "Range: npt=0.000-\r\n");
+        }
+    }
+    else if (m_lastMethod == "PLAY")
+    {
+        DEBUG_MESSAGE_EX_INFO("RTSP proxy session playing, camera: "
+                              << m_name << ", tracks: " << m_trackChannels.size());
+
+        m_state = eState::playing;
+        m_keepAliveTimer->start();
+        m_readyCallback();
+    }
+}
+
+void RtspUpstream::ParseSdp(QByteArray const& baseUrl)
+{
+    m_playUrl = baseUrl;
+    m_trackUrls.clear();
+
+    bool inMedia = false;
+
+    for (auto line : m_sdp.split('\n'))
+    {
+        line = line.trimmed();
+
+        if (line.startsWith("m="))
+        {
+            inMedia = true;
+            m_trackUrls.emplace_back(baseUrl);
+        }
+        else if (line.startsWith("a=control:"))
+        {
+            auto const url = ResolveUrl(baseUrl, line.mid(10));
+
+            if (inMedia)
+            {
+                m_trackUrls.back() = url;
+            }
+            else
+            {
+                m_playUrl = url;
+            }
+        }
+    }
+}
+
+void RtspUpstream::SetupNextTrack()
+{
+    auto const trackIndex = m_trackChannels.size();
+    auto const channel    = QByteArray::number(static_cast<int>(trackIndex) * 2);
+    auto const transport  = "Transport: RTP/AVP/TCP;unicast;interleaved=" + channel + "-" +
+                           QByteArray::number(static_cast<int>(trackIndex) * 2 + 1) + "\r\n";
+
+    SendRequest("SETUP", m_trackUrls[trackIndex], transport);
+}
+
+void RtspUpstream::Fail(std::string const& reason)
+{
+    if (m_state == eState::closed)
+    {
+        return;
+    }
+
+    DEBUG_MESSAGE_EX_WARNING("RTSP proxy session closed, camera: " << m_name
+                                                                    << ", reason: " << reason);
+
+    m_state = eState::closed;
+    m_keepAliveTimer->stop();
+    m_socket->abort();
+    m_closedCallback();
+}
+
+/*! \brief Class defining the RTSP proxy's worker, which lives on the proxy's thread. */
+class RtspProxyWorker final : public QObject
+{
+public:
+    /*! \brief Typedef for the function used to find a camera's details. */
+    typedef std::function<bool(camera_id_t, IpCamera&)> camera_lookup_t;
+
+    RtspProxyWorker(uint16_t const port, QHostAddress const& bindAddress,
+                    camera_lookup_t const& cameraLookup);
+    ~RtspProxyWorker() = default;
+
+    void Start();
+
+private:
+    /*! \brief Structure holding a client's session state. */
+    struct ClientSession
+    {
+        /*! \brief The camera the client is viewing. */
+        camera_id_t camId{NO_CAMERA_ID};
+        /*! \brief The client's session ID. */
+        QByteArray sessionId{};
+        /*! \brief Maps the camera's interleaved channels to the client's. */
+        std::map<int, int> channels{};
+        /*! \brief Whether the client is playing. */
+        bool playing{false};
+        /*! \brief Whether the client's packets are being dropped while its queue drains. */
+        bool dropping{false};
+        /*! \brief The number of packets dropped since the client last caught up. */
+        uint64_t droppedPackets{0};
+        /*! \brief Received data not yet parsed. */
+        QByteArray buffer{};
+    };
+
+    /*! \brief Structure holding a DESCRIBE request waiting for a camera session to start. */
+    struct PendingDescribe
+    {
+        /*! \brief The client that sent the request. */
+        QPointer<QTcpSocket> socket{};
+        /*! \brief The request. */
+        RtspMessage request{};
+    };
+
+private:
+    void AcceptConnections();
+    void ReadRequests(QTcpSocket* socket);
+    void HandleRequest(QTcpSocket* socket, RtspMessage const& request);
+    void Describe(QTcpSocket* socket, RtspMessage const& request, camera_id_t const camId);
+    void SendDescription(QTcpSocket* socket, RtspMessage const& request);
+    void Setup(QTcpSocket* socket, RtspMessage const& request, camera_id_t const camId,
+               int const trackIndex);
+    void Play(QTcpSocket* socket, RtspMessage const& request, camera_id_t const camId);
+    void RemoveClient(QTcpSocket* socket);
+    void UpstreamReady(camera_id_t const camId);
+    void ForwardPacket(camera_id_t const camId, QByteArray const& frame);
+    void CloseUpstream(camera_id_t const camId);
+    bool HasClients(camera_id_t const camId) const;
+    static void SendResponse(QTcpSocket* socket, RtspMessage const& request,
+                             QByteArray const& status, QByteArray const& headers = {},
+                             QByteArray const& body = {});
+    static bool ParseCameraUrl(QByteArray const& url, camera_id_t& camId, int& trackIndex);
+
+private:
+    uint16_t                                            m_port;
+    QHostAddress                                        m_bindAddress;
+    camera_lookup_t                                     m_cameraLookup;
+    QTcpServer*                                         m_server;
+    std::map<QTcpSocket*, ClientSession>                m_clients;
+    std::map<camera_id_t, RtspUpstream*>                m_upstreams;
+    std::map<camera_id_t, std::vector<PendingDescribe>> m_pendingDescribes;
+};
+
+RtspProxyWorker::RtspProxyWorker(uint16_t const port, QHostAddress const& bindAddress,
+                                 camera_lookup_t const& cameraLookup)
+    : m_port(port)
+    , m_bindAddress(bindAddress)
+    , m_cameraLookup(cameraLookup)
+    , m_server(nullptr)
+{
+}
+
+void RtspProxyWorker::Start()
+{
+    // Created here rather than in the constructor so it belongs to the proxy's thread.
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &RtspProxyWorker::AcceptConnections);
+
+    if (!m_server->listen(m_bindAddress, m_port))
+    {
+        DEBUG_MESSAGE_EX_ERROR("RTSP proxy failed to listen on address: "
+                               << m_bindAddress.toString().toStdString() << ", port: " << m_port
+                               << ", error: " << m_server->errorString().toStdString());
+        return;
+    }
+
+    DEBUG_MESSAGE_EX_INFO("RTSP proxy listening on address: "
+                          << m_bindAddress.toString().toStdString() << ", port: " << m_port);
+}
+
+void RtspProxyWorker::AcceptConnections()
+{
+    while (m_server->hasPendingConnections())
+    {
+        auto socket = m_server->nextPendingConnection();
+        m_clients.emplace(socket, ClientSession());
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { ReadRequests(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            RemoveClient(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void RtspProxyWorker::ReadRequests(QTcpSocket* socket)
+{
+    auto clientIter = m_clients.find(socket);
+
+    if (clientIter == m_clients.end())
+    {
+        return;
+    }
+
+    auto& buffer = clientIter->second.buffer;
+    buffer += socket->readAll();
+
+    while (!buffer.isEmpty())
+    {
+        // Clients' RTCP receiver reports are interleaved with their requests, we discard them.
+        if (buffer[0] == '$')
+        {
+            QByteArray frame;
+
+            if (!TakeInterleavedFrame(buffer, frame))
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        RtspMessage request;
+
+        if (!TakeRtspMessage(buffer, request))
+        {
+            if (buffer.size() > MAX_MESSAGE_SIZE)
+            {
+                socket->abort();
+            }
+
+            break;
+        }
+
+        try
+        {
+            HandleRequest(socket, request);
+        }
+        catch (...)
+        {
+            auto exceptionMsg = boost::current_exception_diagnostic_information();
+            DEBUG_MESSAGE_EX_ERROR(exceptionMsg);
+            SendResponse(socket, request, "500 Internal Server Error");
+        }
+
+        // Handling a request may have closed the connection.
+        if (m_clients.count(socket) == 0)
+        {
+            break;
+        }
+    }
+}
+
+void RtspProxyWorker::HandleRequest(QTcpSocket* socket, RtspMessage const& request)
+{
+    auto const fields = request.startLine.split(' ');
+
+    if (fields.size() != 3)
+    {
+        SendResponse(socket, request, "400 Bad Request");
+        return;
+    }
+
+    auto const& method = fields[0];
+
+    if (method == "OPTIONS")
+    {
+        SendResponse(socket,
+                     request,
+                     "200 OK",
+                     "Public: OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN, GET_PARAMETER\r\n");
+        return;
+    }
+
+    if ((method == "GET_PARAMETER") || (method == "SET_PARAMETER"))
+    {
+        // Used by clients to keep their sessions alive.
+        SendResponse(socket, request, "200 OK");
+        return;
+    }
+
+    if (method == "TEARDOWN")
+    {
+        SendResponse(socket, request, "200 OK");
+        socket->disconnectFromHost();
+        return;
+    }
+
+    camera_id_t camId      = NO_CAMERA_ID;
+    int         trackIndex = -1;
+
+    if (!ParseCameraUrl(fields[1], camId, trackIndex))
+    {
+        SendResponse(socket, request, "404 Not Found");
+        return;
+    }
+
+    if (method == "DESCRIBE")
+    {
+        Describe(socket, request, camId);
+    }
+    else if (method == "SETUP")
+    {
+        Setup(socket, request, camId, trackIndex);
+    }
+    else if (method == "PLAY")
+    {
+        Play(socket, request, camId);
+    }
+    else
+    {
+        SendResponse(socket, request, "501 Not Implemented");
+    }
+}
+
+void RtspProxyWorker::Describe(QTcpSocket* socket, RtspMessage const& request,
+                               camera_id_t const camId)
+{
+    auto& client = m_clients[socket];
+
+    if ((client.camId != NO_CAMERA_ID) && (client.camId != camId))
+    {
+        SendResponse(socket, request, "455 Method Not Valid in This State");
+        return;
+    }
+
+    auto const upstreamIter = m_upstreams.find(camId);
+    IpCamera   camera;
+
+    if ((upstreamIter == m_upstreams.end()) && !m_cameraLookup(camId, camera))
+    {
+        SendResponse(socket, request, "404 Not Found");
+        return;
+    }
+
+    client.camId = camId;
+
+    if ((upstreamIter != m_upstreams.end()) && upstreamIter->second->IsPlaying())
+    {
+        SendDescription(socket, request);
+        return;
+    }
+
+    // Answered once the camera's session is playing and its SDP is known.
+    m_pendingDescribes[camId].emplace_back(PendingDescribe{socket, request});
+
+    if (upstreamIter != m_upstreams.end())
+    {
+        return;
+    }
+
+    auto upstream = new RtspUpstream(
+        camera,
+        [this, camId]() { UpstreamReady(camId); },
+        [this, camId](QByteArray const& frame) { ForwardPacket(camId, frame); },
+        [this, camId]() { CloseUpstream(camId); },
+        this);
+
+    m_upstreams.emplace(camId, upstream);
+
+    // Must be last, starting may fail immediately and close the session and this client.
+    upstream->Start();
+}
+
+void RtspProxyWorker::SendDescription(QTcpSocket* socket, RtspMessage const& request)
+{
+    auto const& client = m_clients[socket];
+    auto const  sdp    = ProxySdp(m_upstreams[client.camId]->Sdp());
+    auto        url    = request.startLine.split(' ')[1];
+
+    if (!url.endsWith('/'))
+    {
+        url += '/';
+    }
+
+    SendResponse(socket,
+                 request,
+                 "200 OK",
+                 "Content-Base: " + url + "\r\nContent-Type: application/sdp\r\n",
+                 sdp);
+}
+
+void RtspProxyWorker::Setup(QTcpSocket* socket, RtspMessage const& request,
+                            camera_id_t const camId, int const trackIndex)
+{
+    auto& client       = m_clients[socket];
+    auto  upstreamIter = m_upstreams.find(camId);
+
+    if ((client.camId != camId) || (upstreamIter == m_upstreams.end()) ||
+        !upstreamIter->second->IsPlaying())
+    {
+        SendResponse(socket, request, "455 Method Not Valid in This State");
+        return;
+    }
+
+    if ((trackIndex < 0) || (trackIndex >= upstreamIter->second->TrackCount()))
+    {
+        SendResponse(socket, request, "404 Not Found");
+        return;
+    }
+
+    auto const transport = HeaderValue(request, "transport");
+
+    if (!transport.contains("RTP/AVP/TCP"))
+    {
+        SendResponse(socket, request, "461 Unsupported Transport");
+        return;
+    }
+
+    int clientChannel = trackIndex * 2;
+    InterleavedChannel(transport, clientChannel);
+
+    auto const upstreamChannel           = upstreamIter->second->TrackChannel(trackIndex);
+    client.channels[upstreamChannel]     = clientChannel;
+    client.channels[upstreamChannel + 1] = clientChannel + 1;
+
+    if (client.sessionId.isEmpty())
+    {
+        client.sessionId = QByteArray::number(QRandomGenerator::global()->generate64(), 16);
+    }
+
+    SendResponse(socket,
+                 request,
+                 "200 OK",
+                 "Transport: RTP/AVP/TCP;unicast;interleaved=" + QByteArray::number(clientChannel) +
+                     "-" + QByteArray::number(clientChannel + 1) + "\r\nSession: " +
+                     client.sessionId + ";timeout=" +
+                     QByteArray::number(CLIENT_SESSION_TIMEOUT_SECS) + "\r\n");
+}
+
+void RtspProxyWorker::Play(QTcpSocket* socket, RtspMessage const& request,
+                           camera_id_t const camId)
+{
+    auto& client = m_clients[socket];
+
+    if ((client.camId != camId) || client.channels.empty() || (m_upstreams.count(camId) == 0))
+    {
+        SendResponse(socket, request, "455 Method Not Valid in This State");
+        return;
+    }
+
+    SendResponse(socket,
+                 request,
+                 "200 OK",
+                 "Session: " + client.sessionId + "\r\nRange: npt=0.000-\r\n");
+
+    // Live streams have no start, the client joins at the camera's next packet and its
+    // decoder starts at the next key frame.
+    client.playing = true;
+}
+
+void RtspProxyWorker::RemoveClient(QTcpSocket* socket)
+{
+    auto clientIter = m_clients.find(socket);
+
+    if (clientIter == m_clients.end())
+    {
+        return;
+    }
+
+    auto const camId = clientIter->second.camId;
+    m_clients.erase(clientIter);
+
+    auto upstreamIter = m_upstreams.find(camId);
+
+    if ((upstreamIter == m_upstreams.end()) || HasClients(camId))
+    {
+        return;
+    }
+
+    // Keep the camera's session open for a while in case the client is reconnecting.
+    QTimer::singleShot(UPSTREAM_IDLE_TIMEOUT_MS, upstreamIter->second, [this, camId]() {
+        if (!HasClients(camId))
+        {
+            CloseUpstream(camId);
+        }
+    });
+}
+
+void RtspProxyWorker::UpstreamReady(camera_id_t const camId)
+{
+    auto pendingDescribes = std::move(m_pendingDescribes[camId]);
+    m_pendingDescribes.erase(camId);
+
+    for (auto const& pendingDescribe : pendingDescribes)
+    {
+        if (pendingDescribe.socket && (m_clients.count(pendingDescribe.socket.data()) > 0))
+        {
+            SendDescription(pendingDescribe.socket.data(), pendingDescribe.request);
+        }
+    }
+}
+
+void RtspProxyWorker::ForwardPacket(camera_id_t const camId, QByteArray const& frame)
+{
+    auto const upstreamChannel = static_cast<int>(static_cast<uint8_t>(frame[1]));
+
+    for (auto& clientEntry : m_clients)
+    {
+        auto  socket = clientEntry.first;
+        auto& client = clientEntry.second;
+
+        if (!client.playing || (client.camId != camId))
+        {
+            continue;
+        }
+
+        auto const channelIter = client.channels.find(upstreamChannel);
+
+        if (channelIter == client.channels.end())
+        {
+            continue;
+        }
+
+        // Each client's queue is bounded. A client that falls behind has its packets dropped
+        // until its queue has half drained, rather than delaying the other clients or
+        // buffering without limit.
+        auto const queuedBytes = socket->bytesToWrite();
+
+        if (client.dropping && (queuedBytes > MAX_CLIENT_QUEUE_BYTES / 2))
+        {
+            ++client.droppedPackets;
+            continue;
+        }
+
+        if (!client.dropping && (queuedBytes + frame.size() > MAX_CLIENT_QUEUE_BYTES))
+        {
+            client.dropping = true;
+            ++client.droppedPackets;
+            continue;
+        }
+
+        if (client.dropping)
+        {
+            DEBUG_MESSAGE_EX_WARNING("RTSP proxy client fell behind, camera: "
+                                     << camId << ", packets dropped: " << client.droppedPackets);
+
+            client.dropping       = false;
+            client.droppedPackets = 0;
+        }
+
+        // The frame's bytes are shared rather than copied unless the channel differs.
+        if (channelIter->second == upstreamChannel)
+        {
+            socket->write(frame);
+        }
+        else
+        {
+            auto clientFrame = frame;
+            clientFrame[1]   = static_cast<char>(channelIter->second);
+            socket->write(clientFrame);
+        }
+    }
+}
+
+void RtspProxyWorker::CloseUpstream(camera_id_t const camId)
+{
+    auto upstreamIter = m_upstreams.find(camId);
+
+    if (upstreamIter == m_upstreams.end())
+    {
+        return;
+    }
+
+    // May be called from the upstream's own callback so it must not be deleted immediately.
+    upstreamIter->second->deleteLater();
+    m_upstreams.erase(upstreamIter);
+
+    for (auto const& pendingDescribe : m_pendingDescribes[camId])
+    {
+        if (pendingDescribe.socket)
+        {
+            SendResponse(pendingDescribe.socket.data(),
+                         pendingDescribe.request,
+                         "503 Service Unavailable");
+        }
+    }
+
+    m_pendingDescribes.erase(camId);
+
+    // Clients of a failed session are disconnected so they reconnect and open a new one.
+    std::vector<QTcpSocket*> sockets;
+
+    for (auto const& clientEntry : m_clients)
+    {
+        if (clientEntry.second.camId == camId)
+        {
+            sockets.emplace_back(clientEntry.first);
+        }
+    }
+
+    for (auto socket : sockets)
+    {
+        socket->disconnectFromHost();
+    }
+}
+
+bool RtspProxyWorker::HasClients(camera_id_t const camId) const
+{
+    for (auto const& clientEntry : m_clients)
+    {
+        if (clientEntry.second.camId == camId)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void RtspProxyWorker::SendResponse(QTcpSocket* socket, RtspMessage const& request,
+                                   QByteArray const& status, QByteArray const& headers,
+                                   QByteArray const& body)
+{
+    QByteArray response = "RTSP/1.0 " + status + "\r\n";
+    response += "CSeq: " + HeaderValue(request, "cseq") + "\r\n";
+    response += "Server: IpFreely\r\n";
+    response += headers;
+
+    if (!body.isEmpty())
+    {
+        response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    }
+
+    response += "\r\n";
+    response += body;
+
+    socket->write(response);
+}
+
+bool RtspProxyWorker::ParseCameraUrl(QByteArray const& url, camera_id_t& camId,
+                                     int& trackIndex)
+{
+    // URLs have the form "rtsp://<host>:<port>/cam<ID>[/track<index>]".
+    static QString const CAMERA_PREFIX = "cam";
+    static QString const TRACK_PREFIX  = "track";
+
+    auto const segments = QUrl::fromEncoded(url).path().split('/', QString::SkipEmptyParts);
+
+    if (segments.isEmpty() || (segments.size() > 2) || !segments[0].startsWith(CAMERA_PREFIX))
+    {
+        return false;
+    }
+
+    bool       ok = false;
+    auto const id = segments[0].mid(CAMERA_PREFIX.size()).toInt(&ok);
+
+    if (!ok || (id <= NO_CAMERA_ID))
+    {
+        return false;
+    }
+
+    camId      = id;
+    trackIndex = -1;
+
+    if (segments.size() == 2)
+    {
+        if (!segments[1].startsWith(TRACK_PREFIX))
+        {
+            return false;
+        }
+
+        trackIndex = segments[1].mid(TRACK_PREFIX.size()).toInt(&ok);
+        return ok;
+    }
+
+    return true;
+}
+
+} // namespace
+
+IpFreelyRtspProxy::IpFreelyRtspProxy(uint16_t const port, std::string const& bindAddress)
+    : m_thread(new QThread)
+{
+    QHostAddress address;
+
+    if (!address.setAddress(QString::fromStdString(bindAddress)))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid RTSP proxy bind address."));
+    }
+
+    auto worker =
+        new RtspProxyWorker(port, address, [this](camera_id_t const camId, IpCamera& camera) {
+            return FindCamera(camId, camera);
+        });
+
+    // The worker, its sockets and the camera sessions all live on the proxy's thread.
+    worker->moveToThread(m_thread.get());
+    QObject::connect(m_thread.get(), &QThread::started, worker, &RtspProxyWorker::Start);
+    QObject::connect(m_thread.get(), &QThread::finished, worker, &QObject::deleteLater);
+
+    m_thread->setObjectName("IpFreelyRtspProxy");
+    m_thread->start();
+}
+
+IpFreelyRtspProxy::~IpFreelyRtspProxy()
+{
+    // The worker is deleted, closing all sessions, as its thread finishes.
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void IpFreelyRtspProxy::SetCameras(std::vector<IpCamera> const& cameras)
+{
+    std::lock_guard<std::mutex> lock(m_camerasMutex);
+    m_cameras.clear();
+
+    for (auto const& camera : cameras)
+    {
+        if (QUrl(QString::fromStdString(camera.streamUrl)).scheme().toLower() == "rtsp")
+        {
+            m_cameras[camera.camId] = camera;
+        }
+    }
+}
+
+bool IpFreelyRtspProxy::FindCamera(camera_id_t const camId, IpCamera& camera) const
+{
+    std::lock_guard<std::mutex> lock(m_camerasMutex);
+    auto                        cameraIter = m_cameras.find(camId);
+
+    if (cameraIter == m_cameras.end())
+    {
+        return false;
+    }
+
+    camera = cameraIter->second;
+    return true;
+}
+
+} // namespace ipfreely
@@ -0,0 +1,100 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyRtspProxy.h
+ * \brief File containing declaration of IpFreelyRtspProxy class.
+ */
+#ifndef IPFREELYRTSPPROXY_H
+#define IPFREELYRTSPPROXY_H
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <string>
+#include "IpFreelyCameraDatabase.h"
+
+// Forward declarations.
+class QThread;
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*! \brief Class defining a built-in RTSP server that re-streams the cameras' RTSP streams. */
+class IpFreelyRtspProxy final
+{
+public:
+    /*!
+     * \brief IpFreelyRtspProxy constructor.
+     * \param[in] port - The TCP port to listen on.
+     * \param[in] bindAddress - The local IP address to listen on, e.g. "127.0.0.1".
+     *
+     * Each camera with an RTSP stream URL is re-published at rtsp://<host>:<port>/camN, where N
+     * is the camera's ID. The camera's RTP packets, e.g. H.264 or H.265, are forwarded as
+     * they are, without being decoded or transcoded.
+     *
+     * The proxy opens one session to a camera when the first client asks for its stream and
+     * every further client shares it. The session is closed shortly after the last client
+     * leaves. Every client has its own bounded send queue, a client that falls too far behind
+     * has packets dropped until it catches up, so it never delays the other clients.
+     *
+     * Both the camera session and the clients' sessions use RTP interleaved over the RTSP TCP
+     * connection, clients asking for UDP transport are refused.
+     *
+     * Clients are not authenticated, the proxy logs in to the cameras with their stored
+     * credentials, so anyone who can reach the bind address can play the cameras' streams.
+     * Binding to the loopback address keeps the proxy private to this computer. Throws
+     * std::invalid_argument if the bind address is not an IP address.
+     */
+    IpFreelyRtspProxy(uint16_t const port, std::string const& bindAddress);
+
+    /*! \brief IpFreelyRtspProxy destructor. */
+    ~IpFreelyRtspProxy();
+
+    /*! \brief IpFreelyRtspProxy deleted copy constructor. */
+    IpFreelyRtspProxy(IpFreelyRtspProxy const&) = delete;
+
+    /*! \brief IpFreelyRtspProxy deleted copy assignment operator. */
+    IpFreelyRtspProxy& operator=(IpFreelyRtspProxy const&) = delete;
+
+    /*!
+     * \brief SetCameras sets the cameras the proxy re-streams.
+     * \param[in] cameras - The cameras' details, cameras without an RTSP stream are ignored.
+     *
+     * Sessions already open to a camera are not affected, new settings are used the next time
+     * a session is opened.
+     */
+    void SetCameras(std::vector<IpCamera> const& cameras);
+
+private:
+    bool FindCamera(camera_id_t const camId, IpCamera& camera) const;
+
+private:
+    mutable std::mutex              m_camerasMutex;
+    std::map<camera_id_t, IpCamera> m_cameras;
+    std::unique_ptr<QThread>        m_thread;
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYRTSPPROXY_H
@@ -0,0 +1,239 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelySchedule.cpp
+ * \brief File containing definition of IpFreelySchedule classes.
+ */
+#include "IpFreelySchedule.h"
+#include <limits>
+#include <stdexcept>
+#include <boost/exception/all.hpp>
+
+namespace ipfreely
+{
+
+static constexpr int    MINUTES_PER_HOUR = 60;
+static constexpr time_t SECS_PER_MINUTE  = 60;
+
+IpFreelySchedule::IpFreelySchedule(int const slotMinutes)
+    : m_slotMinutes(slotMinutes)
+{
+    if ((m_slotMinutes <= 0) || (SCHEDULE_MINUTES_PER_DAY % m_slotMinutes != 0))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Schedule slots must divide a day evenly."));
+    }
+}
+
+IpFreelySchedule
+IpFreelySchedule::FromHourlySchedule(std::vector<std::vector<bool>> const& hourlySchedule)
+{
+    IpFreelySchedule schedule(MINUTES_PER_HOUR);
+
+    if (hourlySchedule.empty())
+    {
+        return schedule;
+    }
+
+    if (hourlySchedule.size() != SCHEDULE_DAYS_PER_WEEK)
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Incorrect number of days in schedule."));
+    }
+
+    for (size_t day = 0; day < hourlySchedule.size(); ++day)
+    {
+        auto const& hours = hourlySchedule[day];
+
+        if (hours.size() != static_cast<size_t>(schedule.SlotsPerDay()))
+        {
+            BOOST_THROW_EXCEPTION(std::invalid_argument("Incorrect number of hours in schedule."));
+        }
+
+        for (size_t hour = 0; hour < hours.size(); ++hour)
+        {
+            schedule.SetSlot(static_cast<int>(day), static_cast<int>(hour), hours[hour]);
+        }
+    }
+
+    return schedule;
+}
+
+int IpFreelySchedule::SlotMinutes() const noexcept
+{
+    return m_slotMinutes;
+}
+
+int IpFreelySchedule::SlotsPerDay() const noexcept
+{
+    return SCHEDULE_MINUTES_PER_DAY / m_slotMinutes;
+}
+
+void IpFreelySchedule::SetSlot(int const day, int const slot, bool const enabled)
+{
+    if ((day < 0) || (day >= SCHEDULE_DAYS_PER_WEEK) || (slot < 0) || (slot >= SlotsPerDay()))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid schedule day or slot."));
+    }
+
+    auto const firstMinute = (day * SCHEDULE_MINUTES_PER_DAY) + (slot * m_slotMinutes);
+
+    for (int minute = firstMinute; minute < firstMinute + m_slotMinutes; ++minute)
+    {
+        m_minutes.set(static_cast<size_t>(minute), enabled);
+    }
+}
+
+bool IpFreelySchedule::Slot(int const day, int const slot) const
+{
+    if ((day < 0) || (day >= SCHEDULE_DAYS_PER_WEEK) || (slot < 0) || (slot >= SlotsPerDay()))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid schedule day or slot."));
+    }
+
+    return m_minutes.test(
+        static_cast<size_t>((day * SCHEDULE_MINUTES_PER_DAY) + (slot * m_slotMinutes)));
+}
+
+bool IpFreelySchedule::IsEnabled() const noexcept
+{
+    return m_minutes.any();
+}
+
+int IpFreelySchedule::PrewarmSecs() const noexcept
+{
+    return m_prewarmSecs;
+}
+
+void IpFreelySchedule::SetPrewarmSecs(int const prewarmSecs)
+{
+    if (prewarmSecs < 0)
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Schedule pre-warm cannot be negative."));
+    }
+
+    m_prewarmSecs = prewarmSecs;
+}
+
+bool IpFreelySchedule::IsActive(time_t const time, IpFreelyClock const& clock) const
+{
+    return m_minutes.test(static_cast<size_t>(MinuteOfWeek(time, clock)));
+}
+
+time_t IpFreelySchedule::NextChange(time_t const time, IpFreelyClock const& clock) const
+{
+    auto const localTime   = clock.LocalTime(time);
+    auto const minute      = MinuteOfWeek(time, clock);
+    auto const minuteStart = time - static_cast<time_t>(localTime.tm_sec);
+    auto const state       = m_minutes.test(static_cast<size_t>(minute));
+
+    // Count the wall clock minutes to the next minute in the other state, a week at most.
+    int minutesAhead = 1;
+
+    while ((minutesAhead < SCHEDULE_MINUTES_PER_WEEK) &&
+           (m_minutes.test(static_cast<size_t>((minute + minutesAhead) %
+                                               SCHEDULE_MINUTES_PER_WEEK)) == state))
+    {
+        ++minutesAhead;
+    }
+
+    // The wall clock keeps pace with real time unless the UTC offset changes on the way.
+    auto const wallClockKeptPace = [&](int const minutes) {
+        auto const expectedMinute = (minute + minutes) % SCHEDULE_MINUTES_PER_WEEK;
+        return MinuteOfWeek(minuteStart + (minutes * SECS_PER_MINUTE), clock) == expectedMinute;
+    };
+
+    if (wallClockKeptPace(minutesAhead))
+    {
+        return minuteStart + (minutesAhead * SECS_PER_MINUTE);
+    }
+
+    // Otherwise the schedule must be checked again when the wall clock jumps, which is found
+    // by bisection as there is at most one daylight saving change in a week.
+    int keptPace = 0;
+    int jumped   = minutesAhead;
+
+    while (jumped - keptPace > 1)
+    {
+        auto const middle = keptPace + ((jumped - keptPace) / 2);
+
+        if (wallClockKeptPace(middle))
+        {
+            keptPace = middle;
+        }
+        else
+        {
+            jumped = middle;
+        }
+    }
+
+    return minuteStart + (jumped * SECS_PER_MINUTE);
+}
+
+int IpFreelySchedule::MinuteOfWeek(time_t const time, IpFreelyClock const& clock) const
+{
+    auto const localTime = clock.LocalTime(time);
+    return (localTime.tm_wday * SCHEDULE_MINUTES_PER_DAY) +
+           (localTime.tm_hour * MINUTES_PER_HOUR) + localTime.tm_min;
+}
+
+IpFreelyScheduleTracker::IpFreelyScheduleTracker(IpFreelySchedule const& schedule)
+    : m_schedule(schedule)
+{
+}
+
+IpFreelySchedule const& IpFreelyScheduleTracker::Schedule() const noexcept
+{
+    return m_schedule;
+}
+
+void IpFreelyScheduleTracker::Evaluate(time_t const time, IpFreelyClock const& clock)
+{
+    m_validFrom = time;
+
+    // An empty schedule never changes.
+    if (!m_schedule.IsEnabled())
+    {
+        m_active    = false;
+        m_validSecs = std::numeric_limits<uint64_t>::max();
+        return;
+    }
+
+    m_active = m_schedule.IsActive(time, clock);
+
+    auto       nextChange  = m_schedule.NextChange(time, clock);
+    auto const prewarmSecs = static_cast<time_t>(m_schedule.PrewarmSecs());
+
+    // While inactive, the next window, if that is what the change is, starts early.
+    if (!m_active && (prewarmSecs > 0))
+    {
+        if (nextChange - time <= prewarmSecs)
+        {
+            m_active = m_schedule.IsActive(nextChange, clock);
+        }
+        else
+        {
+            nextChange -= prewarmSecs;
+        }
+    }
+
+    m_validSecs = static_cast<uint64_t>(nextChange - time);
+}
+
+} // namespace ipfreely
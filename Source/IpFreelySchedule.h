@@ -0,0 +1,235 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelySchedule.h
+ * \brief File containing declaration of IpFreelySchedule classes.
+ */
+#ifndef IPFREELYSCHEDULE_H
+#define IPFREELYSCHEDULE_H
+
+#include <bitset>
+#include <vector>
+#include <ctime>
+#include <cstdint>
+#include "IpFreelyClock.h"
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*! \brief Number of days in a schedule's week, Sunday first as in std::tm::tm_wday. */
+static constexpr int SCHEDULE_DAYS_PER_WEEK = 7;
+
+/*! \brief Number of minutes in a schedule's day. */
+static constexpr int SCHEDULE_MINUTES_PER_DAY = 24 * 60;
+
+/*! \brief Number of minutes in a schedule's week. */
+static constexpr int SCHEDULE_MINUTES_PER_WEEK = SCHEDULE_DAYS_PER_WEEK * SCHEDULE_MINUTES_PER_DAY;
+
+/*! \brief Seconds by which scheduled recording and motion detection start early by default. */
+static constexpr int DEFAULT_SCHEDULE_PREWARM_SECS = 5;
+
+/*!
+ * \brief Class defining a weekly schedule of time slots.
+ *
+ * The week is held as one packed bit per minute, whatever the slot size, so checking a time
+ * is a single bit lookup and slots of different sizes could be mixed later. Times are matched
+ * against the local wall clock, so a slot from 09:00 to 10:00 is always 09:00 to 10:00 local
+ * time, on either side of a daylight saving change.
+ */
+class IpFreelySchedule final
+{
+public:
+    /*!
+     * \brief IpFreelySchedule constructor.
+     * \param[in] slotMinutes - (Optional) The slot size in minutes, e.g. 1, 15 or 60.
+     *
+     * All slots start disabled. Throws std::invalid_argument if the slot size does not divide
+     * a day evenly.
+     */
+    explicit IpFreelySchedule(int const slotMinutes = 60);
+
+    /*! \brief IpFreelySchedule destructor. */
+    ~IpFreelySchedule() = default;
+
+    /*! \brief IpFreelySchedule default copy constructor. */
+    IpFreelySchedule(IpFreelySchedule const&) = default;
+
+    /*! \brief IpFreelySchedule default copy assignment operator. */
+    IpFreelySchedule& operator=(IpFreelySchedule const&) = default;
+
+    /*!
+     * \brief FromHourlySchedule creates a schedule from the preferences' hourly schedule.
+     * \param[in] hourlySchedule - A matrix of flags per hour per day, Sunday first.
+     * \return The equivalent schedule with 60 minute slots, disabled if the matrix is empty.
+     *
+     * Throws std::invalid_argument if the matrix is not 7 days of 24 hours.
+     */
+    static IpFreelySchedule
+    FromHourlySchedule(std::vector<std::vector<bool>> const& hourlySchedule);
+
+    /*!
+     * \brief SlotMinutes gives the slot size.
+     * \return The slot size in minutes.
+     */
+    int SlotMinutes() const noexcept;
+
+    /*!
+     * \brief SlotsPerDay gives the number of slots in each day.
+     * \return The number of slots per day.
+     */
+    int SlotsPerDay() const noexcept;
+
+    /*!
+     * \brief SetSlot enables or disables a time slot.
+     * \param[in] day - The day of the week, 0 for Sunday.
+     * \param[in] slot - The slot within the day, 0 for the slot starting at midnight.
+     * \param[in] enabled - True to enable, false to disable.
+     *
+     * Throws std::invalid_argument for an invalid day or slot.
+     */
+    void SetSlot(int const day, int const slot, bool const enabled);
+
+    /*!
+     * \brief Slot tells if a time slot is enabled.
+     * \param[in] day - The day of the week, 0 for Sunday.
+     * \param[in] slot - The slot within the day, 0 for the slot starting at midnight.
+     * \return True if enabled, false otherwise.
+     *
+     * Throws std::invalid_argument for an invalid day or slot.
+     */
+    bool Slot(int const day, int const slot) const;
+
+    /*!
+     * \brief IsEnabled tells if any time slot is enabled.
+     * \return True if at least one slot is enabled, false otherwise.
+     */
+    bool IsEnabled() const noexcept;
+
+    /*!
+     * \brief PrewarmSecs gives how early the schedule's windows start.
+     * \return The pre-warm period in seconds.
+     */
+    int PrewarmSecs() const noexcept;
+
+    /*!
+     * \brief SetPrewarmSecs sets how early the schedule's windows start.
+     * \param[in] prewarmSecs - The pre-warm period in seconds, 0 to start exactly on time.
+     *
+     * Starting a few seconds early gives the consumer time to get ready, e.g. to open its
+     * video file and encoder, so the first frames of the window are not lost to doing so.
+     * Windows still end on time. Throws std::invalid_argument if the period is negative.
+     */
+    void SetPrewarmSecs(int const prewarmSecs);
+
+    /*!
+     * \brief IsActive tells if the schedule is active at a given time.
+     * \param[in] time - The time in seconds since the epoch.
+     * \param[in] clock - The clock giving the local wall clock time.
+     * \return True if the time's slot is enabled, ignoring pre-warm, false otherwise.
+     */
+    bool IsActive(time_t const time, IpFreelyClock const& clock) const;
+
+    /*!
+     * \brief NextChange gives when the schedule's state may next change.
+     * \param[in] time - The time in seconds since the epoch.
+     * \param[in] clock - The clock giving the local wall clock time.
+     * \return The first time after the given time at which it must be checked again.
+     *
+     * This is the start of the next slot in a different state, or an earlier daylight saving
+     * change between here and there, as the wall clock then jumps to a different slot. With
+     * no change all week the schedule is checked again a week later.
+     */
+    time_t NextChange(time_t const time, IpFreelyClock const& clock) const;
+
+private:
+    int MinuteOfWeek(time_t const time, IpFreelyClock const& clock) const;
+
+private:
+    int                                    m_slotMinutes{60};
+    int                                    m_prewarmSecs{0};
+    std::bitset<SCHEDULE_MINUTES_PER_WEEK> m_minutes{};
+};
+
+/*!
+ * \brief Class defining a tracker caching a schedule's state between its changes.
+ *
+ * The schedule is only evaluated when its state may change, so the per-frame check is a
+ * single integer comparison.
+ */
+class IpFreelyScheduleTracker final
+{
+public:
+    /*!
+     * \brief IpFreelyScheduleTracker constructor.
+     * \param[in] schedule - (Optional) The schedule to track, never active if not given.
+     */
+    explicit IpFreelyScheduleTracker(IpFreelySchedule const& schedule = IpFreelySchedule());
+
+    /*! \brief IpFreelyScheduleTracker destructor. */
+    ~IpFreelyScheduleTracker() = default;
+
+    /*! \brief IpFreelyScheduleTracker default copy constructor. */
+    IpFreelyScheduleTracker(IpFreelyScheduleTracker const&) = default;
+
+    /*! \brief IpFreelyScheduleTracker default copy assignment operator. */
+    IpFreelyScheduleTracker& operator=(IpFreelyScheduleTracker const&) = default;
+
+    /*!
+     * \brief Schedule gives access to the tracked schedule.
+     * \return The schedule.
+     */
+    IpFreelySchedule const& Schedule() const noexcept;
+
+    /*!
+     * \brief IsActive tells if the schedule is active, including its pre-warm period.
+     * \param[in] time - The time in seconds since the epoch.
+     * \param[in] clock - The clock giving the local wall clock time.
+     * \return True if active, false otherwise.
+     *
+     * The state is cached until the next time it can change. A time outside of the cached
+     * period, including one earlier than it after the clock was set back, evaluates the
+     * schedule again.
+     */
+    bool IsActive(time_t const time, IpFreelyClock const& clock)
+    {
+        // Unsigned so that times before the cached period also fail the comparison.
+        if (static_cast<uint64_t>(time - m_validFrom) >= m_validSecs)
+        {
+            Evaluate(time, clock);
+        }
+
+        return m_active;
+    }
+
+private:
+    void Evaluate(time_t const time, IpFreelyClock const& clock);
+
+private:
+    IpFreelySchedule m_schedule;
+    bool             m_active{false};
+    time_t           m_validFrom{0};
+    uint64_t         m_validSecs{0};
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYSCHEDULE_H
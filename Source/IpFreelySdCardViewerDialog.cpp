@@ -30,17 +30,36 @@
 #include <QWebEngineDownloadItem>
 #include <QWebEngineProfile>
 #include <QVBoxLayout>
+#include <QScrollArea>
+#include <QMessageBox>
 #include "IpFreelyDownloadWidget.h"
+#include "IpFreelyDownloadManager.h"
 #include "IpFreelyCameraDatabase.h"
+#include "IpFreelyPreferences.h"
 
-IpFreelySdCardViewerDialog::IpFreelySdCardViewerDialog(ipfreely::IpCamera const& camera,
-                                                       QWidget*                  parent)
+IpFreelySdCardViewerDialog::IpFreelySdCardViewerDialog(ipfreely::IpCamera const&            camera,
+                                                       ipfreely::IpFreelyPreferences const& prefs,
+                                                       QWidget*                             parent)
     : QDialog(parent)
     , ui(new Ui::IpFreelySdCardViewerDialog)
     , m_webView(nullptr)
+    , m_downloadsArea(nullptr)
+    , m_downloadsLayout(nullptr)
+    , m_downloadManager(new ipfreely::IpFreelyDownloadManager(this))
+    , m_storageUrl(QString::fromStdString(camera.CompleteStorageHttpUrl()))
 {
     ui->setupUi(this);
 
+    ipfreely::HostLimits limits;
+    limits.maxConnections = prefs.DownloadConnectionsPerCamera();
+    limits.maxBytesPerSec = static_cast<int64_t>(prefs.DownloadKiBPerSecPerCamera()) * 1024;
+    m_downloadManager->SetMaxActiveDownloads(prefs.MaxActiveDownloads());
+    m_downloadManager->SetDefaultHostLimits(limits);
+
+    // Only split large files when we may open more than one connection per camera.
+    static constexpr int64_t SEGMENT_MIN_BYTES = 32 * 1024 * 1024;
+    m_downloadManager->SetSegmentation(SEGMENT_MIN_BYTES, limits.maxConnections);
+
     connect(QWebEngineProfile::defaultProfile(),
             &QWebEngineProfile::downloadRequested,
             this,
@@ -56,6 +75,21 @@ IpFreelySdCardViewerDialog::IpFreelySdCardViewerDialog(ipfreely::IpCamera const&
 
     layout()->addWidget(m_webView);
 
+    // Downloads are listed below the web view, which stays usable while they run.
+    static constexpr int DOWNLOADS_MAX_HEIGHT = 240;
+    auto downloadsWidget = new QWidget;
+    m_downloadsLayout    = new QVBoxLayout(downloadsWidget);
+    m_downloadsLayout->setContentsMargins(0, 0, 0, 0);
+    m_downloadsLayout->addStretch(1);
+    m_downloadsArea = new QScrollArea;
+    m_downloadsArea->setWidgetResizable(true);
+    m_downloadsArea->setMaximumHeight(DOWNLOADS_MAX_HEIGHT);
+    m_downloadsArea->setWidget(downloadsWidget);
+    m_downloadsArea->setVisible(false);
+    layout()->addWidget(m_downloadsArea);
+    qobject_cast<QVBoxLayout*>(layout())->setStretch(0, 1);
+    qobject_cast<QVBoxLayout*>(layout())->setStretch(1, 0);
+
     SetDisplaySize();
 }
 
@@ -73,28 +107,54 @@ void IpFreelySdCardViewerDialog::downloadRequested(QWebEngineDownloadItem* downl
     if (path.isEmpty())
         return;
 
-    download->setPath(path);
-    download->accept();
+    // We download the file ourselves, adding the camera's credentials as the web view's
+    // session is not shared with our network requests.
+    auto url = download->url();
+    download->cancel();
 
-    m_webView->setEnabled(false);
+    if (url.userInfo().isEmpty() && (url.host() == m_storageUrl.host()))
+    {
+        url.setUserName(m_storageUrl.userName());
+        url.setPassword(m_storageUrl.password());
+    }
 
-    auto downloadWidget = new IpFreelyDownloadWidget(download);
+    auto const downloadId = m_downloadManager->Enqueue(url, path);
+    auto downloadWidget   = new IpFreelyDownloadWidget(m_downloadManager, downloadId);
 
     connect(downloadWidget,
             &IpFreelyDownloadWidget::removeClicked,
             this,
             &IpFreelySdCardViewerDialog::removeClicked);
 
-    layout()->addWidget(downloadWidget);
-    qobject_cast<QVBoxLayout*>(layout())->setStretch(0, 1);
-    qobject_cast<QVBoxLayout*>(layout())->setStretch(1, 0);
+    // Insert before the stretch so downloads stack from the top in the order requested.
+    m_downloadsLayout->insertWidget(m_downloadsLayout->count() - 1, downloadWidget);
+    m_downloadsArea->setVisible(true);
 }
 
 void IpFreelySdCardViewerDialog::removeClicked(IpFreelyDownloadWidget* downloadWidget)
 {
-    layout()->removeWidget(downloadWidget);
+    m_downloadManager->Remove(downloadWidget->DownloadId());
+    m_downloadsLayout->removeWidget(downloadWidget);
     downloadWidget->deleteLater();
-    m_webView->setEnabled(true);
+
+    // Only the stretch is left when there are no downloads.
+    m_downloadsArea->setVisible(m_downloadsLayout->count() > 1);
+}
+
+void IpFreelySdCardViewerDialog::reject()
+{
+    if (!m_downloadManager->IsIdle() &&
+        (QMessageBox::question(this,
+                               tr("Downloads In Progress"),
+                               tr("Stop the downloads and close? Partially downloaded files "
+                                  "are kept and resume if downloaded to the same file again."),
+                               QMessageBox::Yes | QMessageBox::No,
+                               QMessageBox::No) == QMessageBox::No))
+    {
+        return;
+    }
+
+    QDialog::reject();
 }
 
 void IpFreelySdCardViewerDialog::SetDisplaySize()
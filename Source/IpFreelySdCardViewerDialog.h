@@ -26,6 +26,7 @@
 #define IPFREELYSDCARDVIEWERDIALOG_H
 
 #include <QDialog>
+#include <QUrl>
 
 // Forward declarations.
 namespace Ui
@@ -36,10 +37,14 @@ class IpFreelySdCardViewerDialog;
 namespace ipfreely
 {
 struct IpCamera;
+class IpFreelyPreferences;
+class IpFreelyDownloadManager;
 } // namespace ipfreely
 
 class QWebEngineDownloadItem;
 class QWebEngineView;
+class QScrollArea;
+class QVBoxLayout;
 class IpFreelyDownloadWidget;
 
 /*! \brief The IpFreelySdCardViewerDialog class. */
@@ -51,14 +56,23 @@ public:
     /*!
      * \brief Initialising constructor.
      * \param[in] camera - The camera details.
+     * \param[in] prefs - The preferences holding the download limits.
      * \param[in] parent - (Optional) The parent QWidget object.
+     *
+     * Files are downloaded by our own download manager rather than the web view, so several
+     * can download at once, interrupted downloads resume and the camera's storage can still
+     * be browsed while they run.
      */
-    explicit IpFreelySdCardViewerDialog(ipfreely::IpCamera const& camera,
-                                        QWidget*                  parent = nullptr);
+    IpFreelySdCardViewerDialog(ipfreely::IpCamera const&            camera,
+                               ipfreely::IpFreelyPreferences const& prefs,
+                               QWidget*                             parent = nullptr);
 
     /*! \brief IpFreelyDownloadWidget destructor. */
     virtual ~IpFreelySdCardViewerDialog();
 
+public slots:
+    virtual void reject();
+
 private slots:
     void removeClicked(IpFreelyDownloadWidget* downloadWidget);
     void downloadRequested(QWebEngineDownloadItem* download);
@@ -67,8 +81,12 @@ private:
     void SetDisplaySize();
 
 private:
-    Ui::IpFreelySdCardViewerDialog* ui;
-    QWebEngineView*                 m_webView;
+    Ui::IpFreelySdCardViewerDialog*    ui;
+    QWebEngineView*                    m_webView;
+    QScrollArea*                       m_downloadsArea;
+    QVBoxLayout*                       m_downloadsLayout;
+    ipfreely::IpFreelyDownloadManager* m_downloadManager;
+    QUrl                               m_storageUrl;
 };
 
 #endif // IPFREELYSDCARDVIEWERDIALOG_H
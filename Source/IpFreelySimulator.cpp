@@ -0,0 +1,258 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelySimulator.cpp
+ * \brief File containing definition of camera simulator's main entry point.
+ */
+#include <csignal>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QString>
+#include <QStringList>
+#include <QHostInfo>
+#include <boost/exception/all.hpp>
+#include "DebugLog/DebugLogging.h"
+#include "IpFreelyCameraSimulator.h"
+
+#define IPFREELY_VERSION "1.2.0.0"
+
+namespace
+{
+
+volatile std::sig_atomic_t g_stopRequested = 0;
+
+extern "C" void OnStopSignal(int)
+{
+    g_stopRequested = 1;
+}
+
+double ToDouble(QCommandLineParser const& parser, QCommandLineOption const& option,
+                double const defaultValue)
+{
+    if (!parser.isSet(option))
+    {
+        return defaultValue;
+    }
+
+    bool       ok    = false;
+    auto const value = parser.value(option).toDouble(&ok);
+
+    if (!ok)
+    {
+        auto const msg = "Invalid value for --" + option.names().front() + ": " +
+                         parser.value(option);
+        BOOST_THROW_EXCEPTION(std::invalid_argument(msg.toStdString()));
+    }
+
+    return value;
+}
+
+int ToInt(QCommandLineParser const& parser, QCommandLineOption const& option,
+          int const defaultValue)
+{
+    auto const value = ToDouble(parser, option, defaultValue);
+
+    if (value != static_cast<double>(static_cast<int>(value)))
+    {
+        auto const msg = "Invalid value for --" + option.names().front() + ": " +
+                         parser.value(option);
+        BOOST_THROW_EXCEPTION(std::invalid_argument(msg.toStdString()));
+    }
+
+    return static_cast<int>(value);
+}
+
+ipfreely::SimulatorSettings ParseSettings(QCoreApplication const& app)
+{
+    ipfreely::SimulatorSettings settings;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Serves synthetic RTSP and MJPEG cameras for load testing IpFreely.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption camerasOption("cameras", "Number of cameras.", "count");
+    QCommandLineOption rtspPortOption("rtsp-port", "RTSP port, 0 to disable.", "port");
+    QCommandLineOption httpPortOption("http-port", "HTTP MJPEG port, 0 to disable.", "port");
+    QCommandLineOption inputOption("input", "Video file to loop instead of a pattern.", "file");
+    QCommandLineOption sizeOption("size", "Frame size, e.g. 1920x1080.", "WxH");
+    QCommandLineOption fpsOption("fps", "Frame rate.", "fps");
+    QCommandLineOption gopOption("gop", "Frames from one key frame to the next.", "frames");
+    QCommandLineOption qualityOption("quality", "Key frames' JPEG quality, 1-100.", "quality");
+    QCommandLineOption motionPeriodOption(
+        "motion-period", "Seconds between motion events, 0 for none.", "secs");
+    QCommandLineOption motionDurationOption(
+        "motion-duration", "Seconds each motion event lasts.", "secs");
+    QCommandLineOption lossOption("loss", "Percentage of packets dropped.", "percent");
+    QCommandLineOption stallPeriodOption(
+        "stall-period", "Average seconds between stalls, 0 for none.", "secs");
+    QCommandLineOption stallDurationOption("stall-duration", "Seconds each stall lasts.", "secs");
+    QCommandLineOption disconnectPeriodOption(
+        "disconnect-period", "Average seconds between disconnects, 0 for none.", "secs");
+
+    parser.addOptions({camerasOption,
+                       rtspPortOption,
+                       httpPortOption,
+                       inputOption,
+                       sizeOption,
+                       fpsOption,
+                       gopOption,
+                       qualityOption,
+                       motionPeriodOption,
+                       motionDurationOption,
+                       lossOption,
+                       stallPeriodOption,
+                       stallDurationOption,
+                       disconnectPeriodOption});
+
+    // Handles --help and --version by exiting.
+    parser.process(app);
+
+    settings.numCameras  = ToInt(parser, camerasOption, settings.numCameras);
+    settings.rtspPort    = static_cast<uint16_t>(ToInt(parser, rtspPortOption, settings.rtspPort));
+    settings.httpPort    = static_cast<uint16_t>(ToInt(parser, httpPortOption, settings.httpPort));
+    settings.fps         = ToDouble(parser, fpsOption, settings.fps);
+    settings.gopLength   = ToInt(parser, gopOption, settings.gopLength);
+    settings.jpegQuality = ToInt(parser, qualityOption, settings.jpegQuality);
+
+    settings.motionPeriodSecs   = ToDouble(parser, motionPeriodOption, settings.motionPeriodSecs);
+    settings.motionDurationSecs =
+        ToDouble(parser, motionDurationOption, settings.motionDurationSecs);
+    settings.packetLossPercent  = ToDouble(parser, lossOption, settings.packetLossPercent);
+    settings.stallPeriodSecs    = ToDouble(parser, stallPeriodOption, settings.stallPeriodSecs);
+    settings.stallDurationSecs  =
+        ToDouble(parser, stallDurationOption, settings.stallDurationSecs);
+    settings.disconnectPeriodSecs =
+        ToDouble(parser, disconnectPeriodOption, settings.disconnectPeriodSecs);
+
+    if (parser.isSet(inputOption))
+    {
+        settings.videoFilePath = parser.value(inputOption).toStdString();
+    }
+
+    if (parser.isSet(sizeOption))
+    {
+        auto const dimensions = parser.value(sizeOption).split('x');
+        bool       widthOk    = false;
+        bool       heightOk   = false;
+
+        if (dimensions.size() == 2)
+        {
+            settings.width  = dimensions[0].toInt(&widthOk);
+            settings.height = dimensions[1].toInt(&heightOk);
+        }
+
+        if (!widthOk || !heightOk)
+        {
+            auto const msg = "Invalid value for --size: " + parser.value(sizeOption);
+            BOOST_THROW_EXCEPTION(std::invalid_argument(msg.toStdString()));
+        }
+    }
+
+    return settings;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // How often to check for signals.
+    static constexpr std::chrono::milliseconds POLL_PERIOD{250};
+
+    int  retCode        = EXIT_SUCCESS;
+    bool logInitialised = false;
+
+    try
+    {
+        // As with the headless recorder no event loop is run on this thread, the simulator
+        // runs its own event loop on its own thread.
+        QCoreApplication a(argc, argv);
+        QString          appVersion = IPFREELY_VERSION;
+        a.setApplicationVersion(appVersion);
+
+        auto const settings = ParseSettings(a);
+
+        DEBUG_MESSAGE_INSTANTIATE_EX(appVersion.toStdString(),
+                                     "",
+                                     "IpFreelySimulator",
+                                     core_lib::log::BYTES_IN_MEBIBYTE * 25);
+
+        logInitialised = true;
+
+        std::signal(SIGINT, OnStopSignal);
+        std::signal(SIGTERM, OnStopSignal);
+
+        DEBUG_MESSAGE_EX_INFO("Starting camera simulator.");
+        ipfreely::IpFreelyCameraSimulator simulator(settings);
+
+        // Lists the URLs so they can be pasted into IpFreely's camera settings.
+        auto const host = QHostInfo::localHostName().toStdString();
+
+        for (int camId = 1; camId <= settings.numCameras; ++camId)
+        {
+            std::cout << "Camera " << camId << ":";
+
+            if (settings.rtspPort != 0)
+            {
+                std::cout << " rtsp://" << host << ":" << settings.rtspPort << "/cam" << camId;
+            }
+
+            if (settings.httpPort != 0)
+            {
+                std::cout << " http://" << host << ":" << settings.httpPort << "/cam" << camId
+                          << "/live.mjpeg";
+            }
+
+            std::cout << std::endl;
+        }
+
+        while (!g_stopRequested)
+        {
+            std::this_thread::sleep_for(POLL_PERIOD);
+        }
+
+        DEBUG_MESSAGE_EX_INFO("Stop requested, stopping camera simulator.");
+    }
+    catch (...)
+    {
+        auto exceptionMsg = boost::current_exception_diagnostic_information();
+
+        if (logInitialised)
+        {
+            DEBUG_MESSAGE_EX_FATAL(exceptionMsg);
+        }
+
+        std::cerr << exceptionMsg << std::endl;
+        retCode = EXIT_FAILURE;
+    }
+
+    if (logInitialised)
+    {
+        DEBUG_MESSAGE_EX_INFO("Application closing");
+    }
+
+    return retCode;
+}
@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Synthetic camera simulator, serves many RTSP and
+# MJPEG cameras for load testing IpFreely.
+#
+#-------------------------------------------------
+
+QT       = core gui
+
+TARGET = IpFreelySimulator
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+include(IpFreelyCore.pri)
+
+SOURCES += \
+    IpFreelySimulator.cpp \
+    IpFreelyCameraSimulator.cpp
+
+HEADERS += \
+    IpFreelyCameraSimulator.h
@@ -0,0 +1,134 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+
+/*!
+ * \file IpFreelyStorageBrowser.cpp
+ * \brief File containing definition of the storage browser's main entry point.
+ */
+#include <cstdlib>
+#include <stdexcept>
+#include <sstream>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QMessageBox>
+#include <QString>
+#include <boost/exception/all.hpp>
+#include "DebugLog/DebugLogging.h"
+#include "IpFreelyCameraDatabase.h"
+#include "IpFreelyPreferences.h"
+#include "IpFreelySdCardViewerDialog.h"
+
+#define IPFREELY_VERSION "1.2.0.0"
+
+/*
+ * The storage browser is the only part of IpFreely that needs QtWebEngine, which loads the
+ * Chromium libraries at process start. It is built as this separate executable and started
+ * by IpFreely when a storage button is clicked, so IpFreely itself never loads them.
+ */
+int main(int argc, char* argv[])
+{
+    int  retCode        = EXIT_SUCCESS;
+    bool logInitialised = false;
+
+    // QtWebEngine needs OpenGL contexts to be shared, which must be set before the
+    // application object is created.
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+
+    QApplication a(argc, argv);
+    QString      appVersion = IPFREELY_VERSION;
+    a.setApplicationVersion(appVersion);
+
+    try
+    {
+        DEBUG_MESSAGE_INSTANTIATE_EX(appVersion.toStdString(),
+                                     "",
+                                     "IpFreelyStorageBrowser",
+                                     core_lib::log::BYTES_IN_MEBIBYTE * 5);
+
+        logInitialised = true;
+
+        QCommandLineParser parser;
+        parser.setApplicationDescription("Browses an IpFreely camera's on-board storage.");
+        parser.addHelpOption();
+        parser.addVersionOption();
+
+        QCommandLineOption cameraOption(
+            "camera", "ID of the camera in IpFreely's camera database.", "id");
+        parser.addOption(cameraOption);
+        parser.process(a);
+
+        bool       ok    = false;
+        auto const camId = static_cast<ipfreely::camera_id_t>(
+            parser.value(cameraOption).toInt(&ok));
+
+        if (!ok || (camId <= ipfreely::NO_CAMERA_ID))
+        {
+            BOOST_THROW_EXCEPTION(std::invalid_argument("A valid --camera ID is required."));
+        }
+
+        // Started from IpFreely's working folder, so this is the same database it uses.
+        ipfreely::IpFreelyCameraDatabase camDb(false);
+        camDb.Load();
+
+        auto const camera = camDb.GetCamera(camId);
+
+        if (!camera || camera->storageHttpUrl.empty())
+        {
+            std::ostringstream oss;
+            oss << "No storage URL is set up for camera, ID: " << camId;
+            BOOST_THROW_EXCEPTION(std::invalid_argument(oss.str()));
+        }
+
+        DEBUG_MESSAGE_EX_INFO("Browsing storage of camera, ID: " << camId);
+
+        // The download limits are set in IpFreely's preferences.
+        ipfreely::IpFreelyPreferences prefs;
+
+        IpFreelySdCardViewerDialog sdCardDlg(*camera, prefs);
+        sdCardDlg.show();
+
+        retCode = a.exec();
+    }
+    catch (...)
+    {
+        auto exceptionMsg = boost::current_exception_diagnostic_information();
+
+        if (logInitialised)
+        {
+            DEBUG_MESSAGE_EX_FATAL(exceptionMsg);
+        }
+
+        QMessageBox::critical(nullptr,
+                              QObject::tr("Storage Browser Error"),
+                              QString::fromStdString(exceptionMsg),
+                              QMessageBox::Ok,
+                              QMessageBox::Ok);
+        retCode = EXIT_FAILURE;
+    }
+
+    if (logInitialised)
+    {
+        DEBUG_MESSAGE_EX_INFO("Application closing");
+    }
+
+    return retCode;
+}
@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# Camera storage browser, started by IpFreely so
+# QtWebEngine is only loaded when it is needed.
+#
+#-------------------------------------------------
+
+QT       += core gui network widgets webenginewidgets
+
+TARGET = IpFreelyStorageBrowser
+TEMPLATE = app
+
+include(IpFreelyCore.pri)
+
+SOURCES += \
+    IpFreelyStorageBrowser.cpp \
+    IpFreelySdCardViewerDialog.cpp \
+    IpFreelyDownloadWidget.cpp
+
+HEADERS += \
+    IpFreelySdCardViewerDialog.h \
+    IpFreelyDownloadWidget.h
+
+FORMS += \
+    IpFreelySdCardViewerDialog.ui \
+    IpFreelyDownloadWidget.ui
@@ -0,0 +1,1013 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+
+/*!
+ * \file IpFreelyStorageMirror.cpp
+ * \brief File containing definition of the camera storage mirror.
+ */
+#include "IpFreelyStorageMirror.h"
+#include <QThread>
+#include <QTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QDir>
+#include <QUrl>
+#include <deque>
+#include <set>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/exception/all.hpp>
+#include <boost/algorithm/string.hpp>
+#include "IpFreelyDownloadManager.h"
+#include "IpFreelyClock.h"
+#include "DebugLog/DebugLogging.h"
+
+namespace bfs = boost::filesystem;
+
+namespace ipfreely
+{
+
+static constexpr int    TICK_PERIOD_MS            = 5000;
+static constexpr size_t MAX_LISTING_REQUESTS      = 2;
+static constexpr int    MAX_SKIPPED_SYNCS         = 7;
+static constexpr time_t MANIFEST_SAVE_PERIOD_SECS = 60;
+static constexpr int    MAX_ROW_CHARS             = 512;
+static constexpr char   MANIFEST_FILE_NAME[]      = ".IpFreelyMirror.manifest";
+
+void MirrorManifest::Load(std::string const& path)
+{
+    MirrorManifest manifest;
+
+    if (bfs::exists(path))
+    {
+        std::ifstream ifs(path.c_str());
+
+        if (!ifs)
+        {
+            std::ostringstream oss;
+            oss << "failed to create std::ifstream to: " << path;
+            BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
+        }
+
+        core_lib::serialize::archives::in_port_bin_t ia(ifs);
+        ia(CEREAL_NVP(manifest));
+    }
+
+    *this = std::move(manifest);
+}
+
+void MirrorManifest::Save(std::string const& path) const
+{
+    auto parentPath = bfs::path(path).parent_path();
+
+    if (!bfs::exists(parentPath))
+    {
+        if (!bfs::create_directories(parentPath))
+        {
+            std::ostringstream oss;
+            oss << "failed to create directories for file: " << path;
+            BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
+        }
+    }
+
+    auto const tempPath = path + ".tmp";
+
+    {
+        std::ofstream ofs(tempPath.c_str());
+
+        if (!ofs)
+        {
+            std::ostringstream oss;
+            oss << "failed to create std::ofstream to: " << tempPath;
+            BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
+        }
+
+        {
+            core_lib::serialize::archives::out_port_bin_t oa(ofs);
+            oa(cereal::make_nvp("manifest", *this));
+        }
+
+        ofs.close();
+
+        if (!ofs)
+        {
+            std::ostringstream oss;
+            oss << "failed to write file: " << tempPath;
+            BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
+        }
+    }
+
+    // Replace the old manifest in one step so a crash never leaves a truncated one.
+    boost::system::error_code ec;
+    bfs::rename(tempPath, path, ec);
+
+    if (ec)
+    {
+        boost::system::error_code removeEc;
+        bfs::remove(tempPath, removeEc);
+
+        std::ostringstream oss;
+        oss << "failed to replace file: " << path << ", error: " << ec.message();
+        BOOST_THROW_EXCEPTION(std::runtime_error(oss.str()));
+    }
+}
+
+namespace
+{
+
+using camera_lookup_t = std::function<std::map<camera_id_t, IpCamera>()>;
+
+int SkipLimit(int const unchangedFetches) noexcept
+{
+    // 0, 1, 3 then 7 syncs skipped between fetches as a listing stays unchanged.
+    return std::min((1 << std::min(unchangedFetches, 3)) - 1, MAX_SKIPPED_SYNCS);
+}
+
+int64_t ListedSize(QString const& number, QString const& unit)
+{
+    static QString const UNITS = "KMGT";
+    auto                 size  = number.toDouble();
+
+    if (!unit.isEmpty())
+    {
+        for (int i = 0; i <= UNITS.indexOf(unit.toUpper()); ++i)
+        {
+            size *= 1024.0;
+        }
+    }
+
+    return static_cast<int64_t>(size);
+}
+
+/*
+ * Parses the usual HTML directory listing of a web server or camera: a link per entry, with
+ * directories' links ending in '/', and the entry's date and size as text after the link.
+ * Only links to the directory's direct children are used, so parent, sorting and external
+ * links are ignored.
+ */
+void ParseListing(QByteArray const& html, QUrl const& dirUrl, MirrorListing& listing)
+{
+    static QRegularExpression const anchorRegex(R"(<a\s[^>]*?href\s*=\s*["']([^"']*)["'][^>]*>)",
+                                                QRegularExpression::CaseInsensitiveOption);
+    static QRegularExpression const tagRegex("<[^>]*>");
+    static QRegularExpression const dateRegex(
+        R"(\d{4}-\d{2}-\d{2}[ T]\d{2}:\d{2}(?::\d{2})?|)"
+        R"(\d{1,2}-[A-Za-z]{3}-\d{4} \d{2}:\d{2}(?::\d{2})?)");
+    static QRegularExpression const sizeRegex(R"((?:^|\s)(\d+(?:\.\d+)?)\s?([KMGT]?)i?B?(?=\s|$))",
+                                              QRegularExpression::CaseInsensitiveOption);
+
+    auto const text    = QString::fromUtf8(html);
+    auto const dirPath = dirUrl.path(QUrl::FullyDecoded);
+    auto       anchors = anchorRegex.globalMatch(text);
+    std::vector<QRegularExpressionMatch> matches;
+
+    while (anchors.hasNext())
+    {
+        matches.emplace_back(anchors.next());
+    }
+
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        auto const& match = matches[i];
+        auto const  href  = match.captured(1).trimmed();
+
+        if (href.isEmpty() || href.contains('?'))
+        {
+            continue;
+        }
+
+        auto const url = dirUrl.resolved(QUrl(href));
+
+        if ((url.host() != dirUrl.host()) || (url.port() != dirUrl.port()))
+        {
+            continue;
+        }
+
+        auto const path = url.path(QUrl::FullyDecoded);
+
+        if (!path.startsWith(dirPath) || (path.size() == dirPath.size()))
+        {
+            continue;
+        }
+
+        auto       name  = path.mid(dirPath.size());
+        auto const isDir = name.endsWith('/');
+
+        if (isDir)
+        {
+            name.chop(1);
+        }
+
+        if (name.isEmpty() || name.contains('/'))
+        {
+            continue;
+        }
+
+        if (isDir)
+        {
+            listing.directories.emplace_back(name.toStdString());
+            continue;
+        }
+
+        // The text after the link, up to the next link, holds the entry's date and size.
+        auto const rowEnd =
+            i + 1 < matches.size() ? matches[i + 1].capturedStart() : text.size();
+        auto rowStart = text.indexOf("</a>", match.capturedEnd(), Qt::CaseInsensitive);
+        rowStart      = (rowStart < 0) || (rowStart > rowEnd) ? match.capturedEnd() : rowStart + 4;
+        auto row      = text.mid(rowStart, std::min(rowEnd - rowStart, MAX_ROW_CHARS));
+        row.replace(tagRegex, " ");
+        row = row.simplified();
+
+        MirrorFile file;
+        auto const date = dateRegex.match(row);
+
+        if (date.hasMatch())
+        {
+            file.modified = date.captured().toStdString();
+            row.remove(date.capturedStart(), date.capturedLength());
+        }
+
+        auto                    sizes = sizeRegex.globalMatch(row);
+        QRegularExpressionMatch size;
+
+        while (sizes.hasNext())
+        {
+            size = sizes.next();
+        }
+
+        if (size.hasMatch())
+        {
+            file.size = ListedSize(size.captured(1), size.captured(2));
+        }
+
+        // Fancy listings link each entry twice, an icon then the name, keep the detailed one.
+        auto& listed = listing.files[name.toStdString()];
+
+        if ((file.size >= 0) || !file.modified.empty())
+        {
+            listed = file;
+        }
+    }
+
+    std::sort(listing.directories.begin(), listing.directories.end());
+    listing.directories.erase(std::unique(listing.directories.begin(), listing.directories.end()),
+                              listing.directories.end());
+}
+
+class StorageMirrorWorker final : public QObject
+{
+public:
+    StorageMirrorWorker(MirrorSettings const& settings, camera_lookup_t const& cameraLookup);
+    ~StorageMirrorWorker();
+
+    void Start();
+
+private:
+    /*! \brief Structure holding a listing or file details request waiting to be sent. */
+    struct Request
+    {
+        /*! \brief The directory's path. */
+        std::string dirPath{};
+        /*! \brief The file's name for a file details request, empty for a listing. */
+        std::string fileName{};
+    };
+
+    /*! \brief Structure holding a listing waiting for its files' details. */
+    struct PendingListing
+    {
+        /*! \brief The parsed listing. */
+        MirrorListing listing{};
+        /*! \brief File details requests not yet answered. */
+        int outstandingRequests{0};
+    };
+
+    /*! \brief Structure holding a camera's mirror state. */
+    struct CameraJob
+    {
+        /*! \brief The complete storage URL, to notice when it changes. */
+        std::string completeUrl{};
+        /*! \brief The storage URL, including credentials. */
+        QUrl baseUrl{};
+        /*! \brief The storage URL's decoded path, ending in '/'. */
+        QString basePath{};
+        /*! \brief The local mirror folder. */
+        QString folder{};
+        /*! \brief The manifest file's path. */
+        std::string manifestPath{};
+        /*! \brief The manifest. */
+        MirrorManifest manifest{};
+        /*! \brief Whether the manifest changed since it was last saved. */
+        bool manifestChanged{false};
+        /*! \brief When the manifest was last saved. */
+        time_t lastSaveTime{0};
+        /*! \brief Whether the camera records on the recording schedule. */
+        bool recordsOnSchedule{false};
+        /*! \brief Whether the camera records motion on the motion schedule. */
+        bool recordsOnMotion{false};
+        /*! \brief The recording schedule's tracker. */
+        IpFreelyScheduleTracker recordingTracker{};
+        /*! \brief The motion schedule's tracker. */
+        IpFreelyScheduleTracker motionTracker{};
+        /*! \brief Whether the camera's download limits have been set. */
+        bool limitsSet{false};
+        /*! \brief Whether downloads are throttled as the camera is recording. */
+        bool throttled{false};
+        /*! \brief Whether a sync is running. */
+        bool syncing{false};
+        /*! \brief When the next sync is due. */
+        time_t nextSyncTime{0};
+        /*! \brief Requests waiting to be sent. */
+        std::deque<Request> requests{};
+        /*! \brief Requests sent but not yet answered. */
+        std::set<QNetworkReply*> replies{};
+        /*! \brief Directories found by this sync. */
+        std::set<std::string> visitedDirs{};
+        /*! \brief Listings waiting for their files' details, by directory path. */
+        std::map<std::string, PendingListing> pendingListings{};
+        /*! \brief Active downloads' file paths and listed details, by download ID. */
+        std::map<int, std::pair<std::string, MirrorFile>> downloads{};
+        /*! \brief Listings fetched by this sync. */
+        int numFetched{0};
+        /*! \brief Listings found unchanged or not fetched by this sync. */
+        int numCached{0};
+        /*! \brief Listing requests that failed during this sync. */
+        int numListingErrors{0};
+        /*! \brief Files downloaded by this sync. */
+        int numDownloaded{0};
+        /*! \brief Downloads that failed during this sync. */
+        int numDownloadErrors{0};
+    };
+
+    using job_map_t = std::map<camera_id_t, CameraJob>;
+
+private:
+    void                Tick();
+    job_map_t::iterator CreateJob(IpCamera const& camera);
+    void                StopJob(CameraJob& job);
+    void                UpdateLimits(camera_id_t const camId, CameraJob& job, time_t const now);
+    void                StartSync(camera_id_t const camId, CameraJob& job);
+    void                StartRequests(camera_id_t const camId, CameraJob& job);
+    void ListingFinished(camera_id_t const camId, std::string const& dirPath, QNetworkReply* reply);
+    void FileDetailsFinished(camera_id_t const camId, Request const& request, QNetworkReply* reply);
+    void CompleteListing(camera_id_t const camId, CameraJob& job, std::string const& dirPath,
+                         MirrorListing&& listing);
+    void MirrorDirectory(camera_id_t const camId, CameraJob& job, std::string const& dirPath,
+                         MirrorListing const& listing);
+    void DownloadFinished(int downloadId);
+    void CheckSyncFinished(camera_id_t const camId, CameraJob& job);
+    static void SaveManifest(CameraJob& job);
+    static QUrl ResourceUrl(CameraJob const& job, std::string const& path);
+
+private:
+    MirrorSettings              m_settings;
+    camera_lookup_t             m_cameraLookup;
+    QNetworkAccessManager*      m_network;
+    IpFreelyDownloadManager*    m_downloadManager;
+    QTimer*                     m_tickTimer;
+    job_map_t                   m_jobs;
+    std::map<int, camera_id_t>  m_downloadCameras;
+};
+
+StorageMirrorWorker::StorageMirrorWorker(MirrorSettings const&  settings,
+                                         camera_lookup_t const& cameraLookup)
+    : m_settings(settings)
+    , m_cameraLookup(cameraLookup)
+    , m_network(nullptr)
+    , m_downloadManager(nullptr)
+    , m_tickTimer(nullptr)
+{
+}
+
+StorageMirrorWorker::~StorageMirrorWorker()
+{
+    // The download manager keeps partial files, so interrupted downloads resume next time.
+    for (auto& job : m_jobs)
+    {
+        if (job.second.manifestChanged)
+        {
+            SaveManifest(job.second);
+        }
+    }
+}
+
+void StorageMirrorWorker::Start()
+{
+    m_network         = new QNetworkAccessManager(this);
+    m_downloadManager = new IpFreelyDownloadManager(this);
+    m_downloadManager->SetMaxActiveDownloads(m_settings.maxActiveDownloads);
+
+    HostLimits limits;
+    limits.maxConnections = m_settings.connectionsPerCamera;
+    limits.maxBytesPerSec = static_cast<int64_t>(m_settings.kibPerSecPerCamera) * 1024;
+    m_downloadManager->SetDefaultHostLimits(limits);
+
+    // Recordings are downloaded in one piece, as segmenting them would cost the camera a
+    // HEAD request per file for little gain on a link it shares with its live stream.
+    m_downloadManager->SetSegmentation(1, 1);
+
+    connect(m_downloadManager,
+            &IpFreelyDownloadManager::DownloadFinished,
+            this,
+            &StorageMirrorWorker::DownloadFinished);
+
+    m_tickTimer = new QTimer(this);
+    m_tickTimer->setInterval(TICK_PERIOD_MS);
+    connect(m_tickTimer, &QTimer::timeout, this, &StorageMirrorWorker::Tick);
+    m_tickTimer->start();
+
+    DEBUG_MESSAGE_EX_INFO("Storage mirror started, folder: " << m_settings.mirrorFolderPath);
+    Tick();
+}
+
+void StorageMirrorWorker::Tick()
+{
+    auto const cameras = m_cameraLookup();
+    auto const now     = IpFreelyClock::SystemClock()->Now();
+
+    for (auto jobIter = m_jobs.begin(); jobIter != m_jobs.end();)
+    {
+        auto const cameraIter = cameras.find(jobIter->first);
+
+        if ((cameraIter == cameras.end()) ||
+            (cameraIter->second.storageHttpUrl.empty()) ||
+            (cameraIter->second.CompleteStorageHttpUrl(boost::istarts_with(
+                 cameraIter->second.storageHttpUrl, "https")) != jobIter->second.completeUrl))
+        {
+            DEBUG_MESSAGE_EX_INFO("Stopped mirroring storage of camera, ID: " << jobIter->first);
+            StopJob(jobIter->second);
+            jobIter = m_jobs.erase(jobIter);
+        }
+        else
+        {
+            ++jobIter;
+        }
+    }
+
+    for (auto const& camera : cameras)
+    {
+        if (camera.second.storageHttpUrl.empty())
+        {
+            continue;
+        }
+
+        auto jobIter = m_jobs.find(camera.first);
+
+        if (jobIter == m_jobs.end())
+        {
+            jobIter = CreateJob(camera.second);
+        }
+
+        auto& job             = jobIter->second;
+        job.recordsOnSchedule = camera.second.enableScheduledRecording;
+        job.recordsOnMotion   = camera.second.enabledMotionRecording;
+        UpdateLimits(camera.first, job, now);
+
+        if (!job.syncing && (now >= job.nextSyncTime))
+        {
+            StartSync(camera.first, job);
+        }
+
+        if (job.manifestChanged && (now - job.lastSaveTime >= MANIFEST_SAVE_PERIOD_SECS))
+        {
+            SaveManifest(job);
+        }
+    }
+}
+
+StorageMirrorWorker::job_map_t::iterator StorageMirrorWorker::CreateJob(IpCamera const& camera)
+{
+    CameraJob job;
+    job.completeUrl =
+        camera.CompleteStorageHttpUrl(boost::istarts_with(camera.storageHttpUrl, "https"));
+    job.baseUrl  = QUrl(QString::fromStdString(job.completeUrl));
+    job.basePath = job.baseUrl.path(QUrl::FullyDecoded);
+
+    // The storage URL is a directory even if given without a trailing '/'.
+    if (!job.basePath.endsWith('/'))
+    {
+        job.basePath += '/';
+    }
+
+    bfs::path folder(m_settings.mirrorFolderPath);
+    folder /= "Camera" + std::to_string(camera.camId);
+    folder           = bfs::system_complete(folder);
+    job.folder       = QString::fromStdWString(folder.wstring());
+    job.manifestPath = (folder / MANIFEST_FILE_NAME).string();
+
+    try
+    {
+        job.manifest.Load(job.manifestPath);
+    }
+    catch (...)
+    {
+        // Without a manifest everything is downloaded again, replacing the mirrored files.
+        DEBUG_MESSAGE_EX_ERROR("Failed to load mirror manifest, camera ID: "
+                               << camera.camId << ", error: "
+                               << boost::current_exception_diagnostic_information());
+        job.manifest = MirrorManifest();
+    }
+
+    job.recordingTracker = IpFreelyScheduleTracker(m_settings.recordingSchedule);
+    job.motionTracker    = IpFreelyScheduleTracker(m_settings.motionSchedule);
+
+    DEBUG_MESSAGE_EX_INFO("Mirroring storage of camera, ID: "
+                          << camera.camId << ", to: " << folder.string());
+
+    return m_jobs.emplace(camera.camId, std::move(job)).first;
+}
+
+void StorageMirrorWorker::StopJob(CameraJob& job)
+{
+    for (auto reply : job.replies)
+    {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+
+    job.replies.clear();
+
+    // Removing a download can emit signals for others, so stop tracking them all first.
+    auto const downloads = std::move(job.downloads);
+    job.downloads.clear();
+
+    for (auto const& download : downloads)
+    {
+        m_downloadCameras.erase(download.first);
+    }
+
+    for (auto const& download : downloads)
+    {
+        m_downloadManager->Remove(download.first);
+    }
+
+    if (job.manifestChanged)
+    {
+        SaveManifest(job);
+    }
+}
+
+void StorageMirrorWorker::UpdateLimits(camera_id_t const camId, CameraJob& job, time_t const now)
+{
+    auto const& clock = *IpFreelyClock::SystemClock();
+    auto const  throttled =
+        (job.recordsOnSchedule && job.recordingTracker.IsActive(now, clock)) ||
+        (job.recordsOnMotion && job.motionTracker.IsActive(now, clock));
+
+    if (job.limitsSet && (throttled == job.throttled))
+    {
+        return;
+    }
+
+    auto const kibPerSec =
+        throttled ? m_settings.recordingKiBPerSecPerCamera : m_settings.kibPerSecPerCamera;
+
+    HostLimits limits;
+    limits.maxConnections = m_settings.connectionsPerCamera;
+    limits.maxBytesPerSec = static_cast<int64_t>(kibPerSec) * 1024;
+    m_downloadManager->SetHostLimits(job.baseUrl.host(), limits);
+    job.limitsSet = true;
+    job.throttled = throttled;
+
+    DEBUG_MESSAGE_EX_INFO("Storage mirror bandwidth limit for camera, ID: "
+                          << camId << ", set to: " << kibPerSec << " KiB/s"
+                          << (throttled ? " while recording" : ""));
+}
+
+void StorageMirrorWorker::StartSync(camera_id_t const camId, CameraJob& job)
+{
+    DEBUG_MESSAGE_EX_INFO("Syncing storage of camera, ID: " << camId);
+
+    job.syncing           = true;
+    job.numFetched        = 0;
+    job.numCached         = 0;
+    job.numListingErrors  = 0;
+    job.numDownloaded     = 0;
+    job.numDownloadErrors = 0;
+    job.requests.clear();
+    job.pendingListings.clear();
+    job.visitedDirs = {""};
+    job.requests.push_back(Request{"", ""});
+
+    StartRequests(camId, job);
+    CheckSyncFinished(camId, job);
+}
+
+void StorageMirrorWorker::StartRequests(camera_id_t const camId, CameraJob& job)
+{
+    // Only a couple of requests at a time, as generating listings is slow for a camera.
+    while ((job.replies.size() < MAX_LISTING_REQUESTS) && !job.requests.empty())
+    {
+        auto const request = job.requests.front();
+        job.requests.pop_front();
+
+        if (!request.fileName.empty())
+        {
+            QNetworkRequest netRequest(ResourceUrl(job, request.dirPath + request.fileName));
+            netRequest.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+            auto reply = m_network->head(netRequest);
+            job.replies.insert(reply);
+
+            connect(reply, &QNetworkReply::finished, this, [this, camId, request, reply] {
+                FileDetailsFinished(camId, request, reply);
+            });
+
+            continue;
+        }
+
+        auto const cachedIter = job.manifest.listings.find(request.dirPath);
+        auto const isCached   = cachedIter != job.manifest.listings.end();
+
+        // A listing that has not changed for a while is not fetched every sync, the storage
+        // URL's own listing always is so that new directories are found.
+        if (isCached && !request.dirPath.empty() &&
+            (cachedIter->second.skippedSyncs < SkipLimit(cachedIter->second.unchangedFetches)))
+        {
+            ++cachedIter->second.skippedSyncs;
+            ++job.numCached;
+            job.manifestChanged = true;
+            MirrorDirectory(camId, job, request.dirPath, cachedIter->second);
+            continue;
+        }
+
+        QNetworkRequest netRequest(ResourceUrl(job, request.dirPath));
+        netRequest.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+
+        if (isCached && !cachedIter->second.etag.empty())
+        {
+            netRequest.setRawHeader("If-None-Match",
+                                    QByteArray::fromStdString(cachedIter->second.etag));
+        }
+
+        if (isCached && !cachedIter->second.lastModified.empty())
+        {
+            netRequest.setRawHeader("If-Modified-Since",
+                                    QByteArray::fromStdString(cachedIter->second.lastModified));
+        }
+
+        auto reply = m_network->get(netRequest);
+        job.replies.insert(reply);
+        auto const dirPath = request.dirPath;
+
+        connect(reply, &QNetworkReply::finished, this, [this, camId, dirPath, reply] {
+            ListingFinished(camId, dirPath, reply);
+        });
+    }
+}
+
+void StorageMirrorWorker::ListingFinished(camera_id_t const camId, std::string const& dirPath,
+                                          QNetworkReply* reply)
+{
+    reply->deleteLater();
+    auto jobIter = m_jobs.find(camId);
+
+    if ((jobIter == m_jobs.end()) || (jobIter->second.replies.erase(reply) == 0))
+    {
+        return;
+    }
+
+    auto&      job        = jobIter->second;
+    auto const status     = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    auto       cachedIter = job.manifest.listings.find(dirPath);
+    auto const isCached   = cachedIter != job.manifest.listings.end();
+
+    if (reply->error() != QNetworkReply::NoError)
+    {
+        ++job.numListingErrors;
+        DEBUG_MESSAGE_EX_WARNING("Failed to list storage of camera, ID: "
+                                 << camId << ", path: " << dirPath
+                                 << ", error: " << reply->errorString().toStdString());
+    }
+    else if (isCached && (status == 304))
+    {
+        auto& cached = cachedIter->second;
+        ++cached.unchangedFetches;
+        cached.skippedSyncs = 0;
+        ++job.numCached;
+        job.manifestChanged = true;
+        MirrorDirectory(camId, job, dirPath, cached);
+    }
+    else
+    {
+        auto const html = reply->readAll();
+        auto const contentHash =
+            QCryptographicHash::hash(html, QCryptographicHash::Sha1).toHex().toStdString();
+        ++job.numFetched;
+        job.manifestChanged = true;
+
+        if (isCached && (cachedIter->second.contentHash == contentHash))
+        {
+            // Unchanged but without validators, the cached listing has any details requested.
+            auto& cached = cachedIter->second;
+            ++cached.unchangedFetches;
+            cached.skippedSyncs = 0;
+            cached.etag         = reply->rawHeader("ETag").toStdString();
+            cached.lastModified = reply->rawHeader("Last-Modified").toStdString();
+            MirrorDirectory(camId, job, dirPath, cached);
+        }
+        else
+        {
+            PendingListing pending;
+            pending.listing.etag         = reply->rawHeader("ETag").toStdString();
+            pending.listing.lastModified = reply->rawHeader("Last-Modified").toStdString();
+            pending.listing.contentHash  = contentHash;
+            ParseListing(html, reply->url().resolved(QUrl(".")), pending.listing);
+
+            // Files listed without a size or date have them requested, once per change of
+            // the listing, so changes to them can still be found.
+            for (auto const& file : pending.listing.files)
+            {
+                if ((file.second.size < 0) && file.second.modified.empty())
+                {
+                    job.requests.push_back(Request{dirPath, file.first});
+                    ++pending.outstandingRequests;
+                }
+            }
+
+            if (pending.outstandingRequests == 0)
+            {
+                CompleteListing(camId, job, dirPath, std::move(pending.listing));
+            }
+            else
+            {
+                job.pendingListings[dirPath] = std::move(pending);
+            }
+        }
+    }
+
+    StartRequests(camId, job);
+    CheckSyncFinished(camId, job);
+}
+
+void StorageMirrorWorker::FileDetailsFinished(camera_id_t const camId, Request const& request,
+                                              QNetworkReply* reply)
+{
+    reply->deleteLater();
+    auto jobIter = m_jobs.find(camId);
+
+    if ((jobIter == m_jobs.end()) || (jobIter->second.replies.erase(reply) == 0))
+    {
+        return;
+    }
+
+    auto& job         = jobIter->second;
+    auto  pendingIter = job.pendingListings.find(request.dirPath);
+
+    if (pendingIter != job.pendingListings.end())
+    {
+        auto& pending = pendingIter->second;
+
+        if (reply->error() == QNetworkReply::NoError)
+        {
+            auto&      file   = pending.listing.files[request.fileName];
+            auto const length = reply->header(QNetworkRequest::ContentLengthHeader);
+
+            if (length.isValid())
+            {
+                file.size = length.toLongLong();
+            }
+
+            file.modified = reply->rawHeader("Last-Modified").toStdString();
+        }
+
+        if (--pending.outstandingRequests == 0)
+        {
+            auto listing = std::move(pending.listing);
+            job.pendingListings.erase(pendingIter);
+            CompleteListing(camId, job, request.dirPath, std::move(listing));
+        }
+    }
+
+    StartRequests(camId, job);
+    CheckSyncFinished(camId, job);
+}
+
+void StorageMirrorWorker::CompleteListing(camera_id_t const camId, CameraJob& job,
+                                          std::string const& dirPath, MirrorListing&& listing)
+{
+    auto& cached = job.manifest.listings[dirPath];
+    cached       = std::move(listing);
+    MirrorDirectory(camId, job, dirPath, cached);
+}
+
+void StorageMirrorWorker::MirrorDirectory(camera_id_t const camId, CameraJob& job,
+                                          std::string const& dirPath, MirrorListing const& listing)
+{
+    for (auto const& directory : listing.directories)
+    {
+        auto const path = dirPath + directory + "/";
+
+        if (job.visitedDirs.insert(path).second)
+        {
+            job.requests.push_back(Request{path, ""});
+        }
+    }
+
+    for (auto const& file : listing.files)
+    {
+        auto const path         = dirPath + file.first;
+        auto const localPath    = job.folder + "/" + QString::fromStdString(path);
+        auto const mirroredIter = job.manifest.files.find(path);
+        auto const mirrored     = mirroredIter != job.manifest.files.end();
+
+        if (mirrored && (mirroredIter->second == file.second) && QFileInfo::exists(localPath))
+        {
+            continue;
+        }
+
+        // A file that changed since it was mirrored must not resume a partial download of its
+        // old version. Partial downloads of files never mirrored are checked with If-Range.
+        auto const changed = mirrored && (mirroredIter->second != file.second);
+        QDir().mkpath(QFileInfo(localPath).absolutePath());
+        auto const downloadId =
+            m_downloadManager->Enqueue(ResourceUrl(job, path), localPath, changed);
+        job.downloads[downloadId]     = std::make_pair(path, file.second);
+        m_downloadCameras[downloadId] = camId;
+    }
+}
+
+void StorageMirrorWorker::DownloadFinished(int downloadId)
+{
+    auto cameraIter = m_downloadCameras.find(downloadId);
+
+    if (cameraIter == m_downloadCameras.end())
+    {
+        return;
+    }
+
+    auto const camId = cameraIter->second;
+    m_downloadCameras.erase(cameraIter);
+    auto& job          = m_jobs.at(camId);
+    auto  downloadIter = job.downloads.find(downloadId);
+
+    if (downloadIter == job.downloads.end())
+    {
+        return;
+    }
+
+    auto const info = m_downloadManager->Info(downloadId);
+
+    // A failed download keeps its partial file and is resumed by the next sync.
+    if (info.state == eDownloadState::completed)
+    {
+        job.manifest.files[downloadIter->second.first] = downloadIter->second.second;
+        job.manifestChanged                            = true;
+        ++job.numDownloaded;
+    }
+    else
+    {
+        ++job.numDownloadErrors;
+    }
+
+    job.downloads.erase(downloadIter);
+    m_downloadManager->Remove(downloadId);
+    CheckSyncFinished(camId, job);
+}
+
+void StorageMirrorWorker::CheckSyncFinished(camera_id_t const camId, CameraJob& job)
+{
+    if (!job.syncing || !job.requests.empty() || !job.replies.empty() ||
+        !job.pendingListings.empty() || !job.downloads.empty())
+    {
+        return;
+    }
+
+    // Forget the listings of directories no longer on the camera, unless a failed listing
+    // may have hidden some that are.
+    if (job.numListingErrors == 0)
+    {
+        for (auto listingIter = job.manifest.listings.begin();
+             listingIter != job.manifest.listings.end();)
+        {
+            if (job.visitedDirs.count(listingIter->first) == 0)
+            {
+                listingIter = job.manifest.listings.erase(listingIter);
+            }
+            else
+            {
+                ++listingIter;
+            }
+        }
+    }
+
+    job.syncing      = false;
+    job.nextSyncTime = IpFreelyClock::SystemClock()->Now() + m_settings.syncIntervalMins * 60;
+    SaveManifest(job);
+
+    DEBUG_MESSAGE_EX_INFO("Synced storage of camera, ID: "
+                          << camId << ", listings fetched: " << job.numFetched
+                          << ", listings cached: " << job.numCached
+                          << ", listing errors: " << job.numListingErrors
+                          << ", files downloaded: " << job.numDownloaded
+                          << ", download errors: " << job.numDownloadErrors);
+}
+
+void StorageMirrorWorker::SaveManifest(CameraJob& job)
+{
+    try
+    {
+        job.manifest.Save(job.manifestPath);
+        job.manifestChanged = false;
+        job.lastSaveTime    = IpFreelyClock::SystemClock()->Now();
+    }
+    catch (...)
+    {
+        DEBUG_MESSAGE_EX_ERROR("Failed to save mirror manifest: "
+                               << job.manifestPath << ", error: "
+                               << boost::current_exception_diagnostic_information());
+    }
+}
+
+QUrl StorageMirrorWorker::ResourceUrl(CameraJob const& job, std::string const& path)
+{
+    auto url = job.baseUrl;
+    url.setPath(job.basePath + QString::fromStdString(path), QUrl::DecodedMode);
+    return url;
+}
+
+} // namespace
+
+IpFreelyStorageMirror::IpFreelyStorageMirror(MirrorSettings const& settings)
+    : m_thread(new QThread)
+{
+    if (settings.mirrorFolderPath.empty())
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Mirror folder path must not be empty."));
+    }
+
+    if ((settings.syncIntervalMins < 1) || (settings.maxActiveDownloads < 1) ||
+        (settings.connectionsPerCamera < 1) || (settings.kibPerSecPerCamera < 0) ||
+        (settings.recordingKiBPerSecPerCamera < 0))
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid storage mirror settings."));
+    }
+
+    auto worker = new StorageMirrorWorker(settings, [this] { return GetCameras(); });
+
+    // The worker, its requests and its downloads all live on the mirror's thread, which runs
+    // its own event loop, so the mirror works the same in the GUI and the daemon.
+    worker->moveToThread(m_thread.get());
+    QObject::connect(m_thread.get(), &QThread::started, worker, &StorageMirrorWorker::Start);
+    QObject::connect(m_thread.get(), &QThread::finished, worker, &QObject::deleteLater);
+
+    m_thread->setObjectName("IpFreelyStorageMirror");
+    m_thread->start();
+}
+
+IpFreelyStorageMirror::~IpFreelyStorageMirror()
+{
+    // The worker is deleted, saving the manifests, as its thread finishes.
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void IpFreelyStorageMirror::SetCameras(std::vector<IpCamera> const& cameras)
+{
+    std::lock_guard<std::mutex> lock(m_camerasMutex);
+    m_cameras.clear();
+
+    for (auto const& camera : cameras)
+    {
+        if (!camera.storageHttpUrl.empty())
+        {
+            m_cameras[camera.camId] = camera;
+        }
+    }
+}
+
+std::map<camera_id_t, IpCamera> IpFreelyStorageMirror::GetCameras() const
+{
+    std::lock_guard<std::mutex> lock(m_camerasMutex);
+    return m_cameras;
+}
+
+} // namespace ipfreely
@@ -0,0 +1,262 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+
+/*!
+ * \file IpFreelyStorageMirror.h
+ * \brief File containing declaration of the camera storage mirror.
+ */
+#ifndef IPFREELYSTORAGEMIRROR_H
+#define IPFREELYSTORAGEMIRROR_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cereal/types/map.hpp>
+#include <cereal/types/vector.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/access.hpp>
+#include "Serialization/SerializationIncludes.h"
+#include "IpFreelyCameraDatabase.h"
+#include "IpFreelySchedule.h"
+
+// Forward declarations.
+class QThread;
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*! \brief Structure holding a file's details as shown by a camera's storage listing. */
+struct MirrorFile
+{
+    /*!
+     * \brief The file's size in bytes, -1 if unknown.
+     *
+     * Listings often abbreviate sizes, e.g. "1.2M", so this can be approximate. It is only
+     * compared with the size from the same camera's listings.
+     */
+    int64_t size{-1};
+    /*! \brief The file's modification time as shown, empty if unknown. */
+    std::string modified{};
+
+    /*!
+     * \brief Equality operator.
+     * \param[in] other - The details to compare with.
+     * \return True if equal, false otherwise.
+     */
+    bool operator==(MirrorFile const& other) const noexcept
+    {
+        return (size == other.size) && (modified == other.modified);
+    }
+
+    /*!
+     * \brief Inequality operator.
+     * \param[in] other - The details to compare with.
+     * \return True if not equal, false otherwise.
+     */
+    bool operator!=(MirrorFile const& other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+    /*!
+     * \brief Serialize the details.
+     * \param[in] ar - Archive to serialize to/from.
+     * \param[in] version - Version of the class.
+     */
+    template <class Archive> void serialize(Archive& ar, const unsigned int version)
+    {
+        if (version < 1)
+        {
+            return;
+        }
+
+        ar(CEREAL_NVP(size), CEREAL_NVP(modified));
+    }
+};
+
+/*! \brief Structure holding a cached storage directory listing. */
+struct MirrorListing
+{
+    /*! \brief The listing's ETag header, empty if none. */
+    std::string etag{};
+    /*! \brief The listing's Last-Modified header, empty if none. */
+    std::string lastModified{};
+    /*! \brief Hash of the listing's HTML, to tell if it changed without validators. */
+    std::string contentHash{};
+    /*! \brief The directory's files, by name. */
+    std::map<std::string, MirrorFile> files{};
+    /*! \brief The directory's sub-directories' names. */
+    std::vector<std::string> directories{};
+    /*! \brief Consecutive fetches that found the listing unchanged. */
+    int unchangedFetches{0};
+    /*! \brief Consecutive syncs that used the cached listing rather than fetching it. */
+    int skippedSyncs{0};
+
+    /*!
+     * \brief Serialize the listing.
+     * \param[in] ar - Archive to serialize to/from.
+     * \param[in] version - Version of the class.
+     */
+    template <class Archive> void serialize(Archive& ar, const unsigned int version)
+    {
+        if (version < 1)
+        {
+            return;
+        }
+
+        ar(CEREAL_NVP(etag),
+           CEREAL_NVP(lastModified),
+           CEREAL_NVP(contentHash),
+           CEREAL_NVP(files),
+           CEREAL_NVP(directories),
+           CEREAL_NVP(unchangedFetches),
+           CEREAL_NVP(skippedSyncs));
+    }
+};
+
+/*!
+ * \brief Structure holding a camera mirror's manifest.
+ *
+ * Paths are relative to the camera's storage URL, using '/' separators, and directory paths
+ * end with '/', the storage URL itself being "".
+ */
+struct MirrorManifest
+{
+    /*! \brief The mirrored files' details as listed when they were downloaded, by path. */
+    std::map<std::string, MirrorFile> files{};
+    /*! \brief The cached directory listings, by path. */
+    std::map<std::string, MirrorListing> listings{};
+
+    /*!
+     * \brief Load the manifest from disk.
+     * \param[in] path - The manifest file's path, the manifest is empty if it does not exist.
+     */
+    void Load(std::string const& path);
+
+    /*!
+     * \brief Save the manifest to disk, replacing the file in one step.
+     * \param[in] path - The manifest file's path.
+     */
+    void Save(std::string const& path) const;
+
+    /*!
+     * \brief Serialize the manifest.
+     * \param[in] ar - Archive to serialize to/from.
+     * \param[in] version - Version of the class.
+     */
+    template <class Archive> void serialize(Archive& ar, const unsigned int version)
+    {
+        if (version < 1)
+        {
+            return;
+        }
+
+        ar(CEREAL_NVP(files), CEREAL_NVP(listings));
+    }
+};
+
+/*! \brief Structure holding the storage mirror's settings. */
+struct MirrorSettings
+{
+    /*! \brief The folder cameras are mirrored to, each in a "Camera<ID>" sub-folder. */
+    std::string mirrorFolderPath{};
+    /*! \brief Minutes from the end of one sync of a camera to the start of the next. */
+    int syncIntervalMins{60};
+    /*! \brief Maximum files downloaded at once, across all cameras. */
+    int maxActiveDownloads{4};
+    /*! \brief Maximum connections to each camera. */
+    int connectionsPerCamera{2};
+    /*! \brief Bandwidth cap per camera in KiB per second, 0 for no cap. */
+    int kibPerSecPerCamera{0};
+    /*! \brief Bandwidth cap per camera while it is recording, in KiB per second, 0 for none. */
+    int recordingKiBPerSecPerCamera{256};
+    /*! \brief The schedule of cameras with scheduled recording enabled. */
+    IpFreelySchedule recordingSchedule{};
+    /*! \brief The schedule of cameras with motion recording enabled. */
+    IpFreelySchedule motionSchedule{};
+};
+
+/*!
+ * \brief Class defining a background mirror of the cameras' on-board storage.
+ *
+ * Each camera with a storage URL is synced to its own folder every sync interval. A sync
+ * crawls the camera's HTTP directory listings, a few at a time, and downloads the files
+ * that are new or whose listed size or date changed since they were mirrored. Files deleted
+ * from the camera, e.g. by it overwriting its oldest recordings, are kept.
+ *
+ * Listings are cached in the camera's manifest, with the mirrored files' details, so repeat
+ * syncs are cheap for the camera: listings are fetched conditionally, and a directory whose
+ * listing has not changed for several fetches is only fetched every few syncs, up to every
+ * eighth, using its cached listing in between. The storage URL's own listing is always
+ * fetched so new directories are found straight away.
+ *
+ * Downloads resume where they stopped, and are capped to a lower bandwidth while the camera
+ * is recording so its live stream is not starved.
+ */
+class IpFreelyStorageMirror final
+{
+public:
+    /*!
+     * \brief IpFreelyStorageMirror constructor.
+     * \param[in] settings - The mirror's settings.
+     *
+     * Throws std::invalid_argument if there is no mirror folder.
+     */
+    explicit IpFreelyStorageMirror(MirrorSettings const& settings);
+
+    /*! \brief IpFreelyStorageMirror destructor, stopping syncs and keeping partial files. */
+    ~IpFreelyStorageMirror();
+
+    /*! \brief IpFreelyStorageMirror deleted copy constructor. */
+    IpFreelyStorageMirror(IpFreelyStorageMirror const&) = delete;
+
+    /*! \brief IpFreelyStorageMirror deleted copy assignment operator. */
+    IpFreelyStorageMirror& operator=(IpFreelyStorageMirror const&) = delete;
+
+    /*!
+     * \brief SetCameras sets the cameras to mirror.
+     * \param[in] cameras - The cameras, those without a storage URL are ignored.
+     *
+     * A camera whose storage URL changes is synced again from its new URL, a camera that is
+     * removed stops syncing. Changes are picked up within a few seconds.
+     */
+    void SetCameras(std::vector<IpCamera> const& cameras);
+
+private:
+    std::map<camera_id_t, IpCamera> GetCameras() const;
+
+private:
+    mutable std::mutex              m_camerasMutex;
+    std::map<camera_id_t, IpCamera> m_cameras;
+    std::unique_ptr<QThread>        m_thread;
+};
+
+} // namespace ipfreely
+
+CEREAL_CLASS_VERSION(ipfreely::MirrorFile, 1);
+CEREAL_CLASS_VERSION(ipfreely::MirrorListing, 1);
+CEREAL_CLASS_VERSION(ipfreely::MirrorManifest, 1);
+
+#endif // IPFREELYSTORAGEMIRROR_H
@@ -23,11 +23,20 @@
  * \brief File containing definition of IpFreelyStreamProcessor threaded class.
  */
 #include "IpFreelyStreamProcessor.h"
+#include <QPainter>
+#include <QPen>
+#include <QBrush>
+#include <QFont>
 #include <sstream>
 #include <cmath>
+#include <algorithm>
 #include <boost/exception/all.hpp>
 #include <boost/filesystem.hpp>
 #include "IpFreelyMotionDetector.h"
+#include "IpFreelyFramePool.h"
+#include "IpFreelyFramePyramid.h"
+#include "IpFreelyImageUtils.h"
+#include "IpFreelyTrace.h"
 #include "Threads/EventThread.h"
 #include "StringUtils/StringUtils.h"
 #include "DebugLog/DebugLogging.h"
@@ -37,68 +46,34 @@ namespace bfs = boost::filesystem;
 namespace ipfreely
 {
 
-namespace utils
-{
-
-inline bool CvMatToQImage(cv::Mat const& inMat, QImage& image)
-{
-    switch (inMat.type())
-    {
-    // 8-bit, 4 channel
-    case CV_8UC4:
-    {
-        image = QImage(inMat.data,
-                       inMat.cols,
-                       inMat.rows,
-                       static_cast<int>(inMat.step),
-                       QImage::Format_ARGB32);
-        return true;
-    }
-
-    // 8-bit, 3 channel
-    case CV_8UC3:
-    {
-        image = QImage(inMat.data,
-                       inMat.cols,
-                       inMat.rows,
-                       static_cast<int>(inMat.step),
-                       QImage::Format_RGB888)
-                    .rgbSwapped();
-        return true;
-    }
-    // 8-bit, 1 channel
-    case CV_8UC1:
-    {
-        image = QImage(inMat.data,
-                       inMat.cols,
-                       inMat.rows,
-                       static_cast<int>(inMat.step),
-                       QImage::Format_Grayscale8);
-        return true;
-    }
-
-    default:
-        DEBUG_MESSAGE_EX_ERROR("unsupported cv::Mat format");
-        return false;
-    }
-}
-
-} // namespace utils
+// Enough buffers for a captured frame and its pyramid levels while the previous frame's are
+// still referenced by slower consumers, e.g. the motion detector's queue or the video writer.
+static constexpr size_t MAX_POOLED_FRAMES = 16;
 
 IpFreelyStreamProcessor::IpFreelyStreamProcessor(
     std::string const& name, IpCamera const& cameraDetails, std::string const& saveFolderPath,
-    double const requiredFileDurationSecs, std::vector<std::vector<bool>> const& recordingSchedule,
-    std::vector<std::vector<bool>> const& motionSchedule)
+    double const requiredFileDurationSecs, IpFreelySchedule const& recordingSchedule,
+    IpFreelySchedule const& motionSchedule, display_callback_t const& displayCallback,
+    std::shared_ptr<IpFreelyStreamStats> const& streamStats, PipelineEnvironment const& environment)
     : m_name(core_lib::string_utils::RemoveIllegalChars(name))
     , m_cameraDetails(cameraDetails)
+    , m_updatedCameraDetails(cameraDetails)
     , m_saveFolderPath(saveFolderPath)
     , m_requiredFileDurationSecs(requiredFileDurationSecs)
     , m_recordingSchedule(recordingSchedule)
     , m_motionSchedule(motionSchedule)
     , m_fps(m_cameraDetails.cameraMaxFps)
+    , m_framePool(std::make_shared<IpFreelyFramePool>(MAX_POOLED_FRAMES))
+    , m_streamStats(streamStats ? streamStats : std::make_shared<IpFreelyStreamStats>())
+    , m_displayCallback(displayCallback)
+    , m_environment(environment)
 {
-    m_useRecordingSchedule = VerifySchedule("Recording", m_recordingSchedule);
-    m_useMotionSchedule    = VerifySchedule("Motion", m_motionSchedule);
+    m_useRecordingSchedule = VerifySchedule("Recording", recordingSchedule);
+    m_useMotionSchedule    = VerifySchedule("Motion", motionSchedule);
+
+    // The counters may have been used by a previous stream processor for this camera, whose
+    // motion detector may have left frames that failed to process counted as queued.
+    m_streamStats->MotionDetectorStopped();
 
     bfs::path p(m_saveFolderPath);
     p = bfs::system_complete(p);
@@ -129,12 +104,28 @@ IpFreelyStreamProcessor::IpFreelyStreamProcessor(
                           << m_cameraDetails.streamUrl << ", recording with FPS of: " << m_fps
                           << ", thread update period (ms): " << m_updatePeriodMillisecs);
 
+    if (m_environment.manualStepping)
+    {
+        return;
+    }
+
     DEBUG_MESSAGE_EX_INFO("Creating event thread for stream URL: " << m_cameraDetails.streamUrl);
 
     m_eventThread = std::make_shared<core_lib::threads::EventThread>(
         std::bind(&IpFreelyStreamProcessor::ThreadEventCallback, this), m_updatePeriodMillisecs);
 }
 
+void IpFreelyStreamProcessor::Step()
+{
+    if (m_eventThread)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error(
+            "Stream processor is run by its event thread, it cannot be stepped."));
+    }
+
+    ThreadEventCallback();
+}
+
 void IpFreelyStreamProcessor::StartVideoWriting() noexcept
 {
     if (m_useRecordingSchedule)
@@ -173,10 +164,10 @@ bool IpFreelyStreamProcessor::VideoWritingEnabled() const noexcept
     return isWriting;
 }
 
-bool IpFreelyStreamProcessor::VideoFrameUpdated() const noexcept
+uint64_t IpFreelyStreamProcessor::VideoFrameSequence() const noexcept
 {
     std::lock_guard<std::mutex> lock(m_frameMutex);
-    return m_videoFrameUpdated;
+    return m_videoFrameSequence;
 }
 
 double IpFreelyStreamProcessor::GetAspectRatioAndSize(int& width, int& height) const
@@ -186,7 +177,8 @@ double IpFreelyStreamProcessor::GetAspectRatioAndSize(int& width, int& height) c
     return static_cast<double>(m_videoWidth) / static_cast<double>(m_videoHeight);
 }
 
-QImage IpFreelyStreamProcessor::CurrentVideoFrame(QRect* motionRectangle) const
+QImage IpFreelyStreamProcessor::CurrentVideoFrame(QRect*    motionRectangle,
+                                                  uint64_t* frameSequence) const
 {
     if (motionRectangle)
     {
@@ -194,71 +186,184 @@ QImage IpFreelyStreamProcessor::CurrentVideoFrame(QRect* motionRectangle) const
         *motionRectangle = m_motionRectangle;
     }
 
-    std::lock_guard<std::mutex> lockF(m_frameMutex);
-    return m_currentFrame;
+    return ConvertedVideoFrame(frameSequence);
 }
 
-double IpFreelyStreamProcessor::OriginalFps() const noexcept
+QImage IpFreelyStreamProcessor::ThumbnailVideoFrame(QSize const& maxSize) const
 {
-    return m_originalFps;
-}
+    std::shared_ptr<IpFreelyFramePyramid> framePyramid;
 
-double IpFreelyStreamProcessor::CurrentFps() const noexcept
-{
-    return m_fps;
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        framePyramid = m_framePyramid;
+    }
+
+    if (!framePyramid)
+    {
+        return {};
+    }
+
+    auto const fullSize      = framePyramid->FullSize();
+    auto const thumbnailSize = utils::ScaledDisplaySize(
+        QSize(fullSize.width, fullSize.height), maxSize, false);
+    QImage thumbnail;
+
+    if (!utils::CvMatToDisplayImage(
+            framePyramid->NearestLevel(cv::Size(thumbnailSize.width(), thumbnailSize.height())),
+            thumbnailSize,
+            thumbnail))
+    {
+        return {};
+    }
+
+    return thumbnail;
 }
 
-bool IpFreelyStreamProcessor::IsScheduleEnabled(std::vector<std::vector<bool>> const& schedule)
+QByteArray IpFreelyStreamProcessor::JpegVideoFrame(QSize const& maxSize, int const quality,
+                                                   uint64_t* frameSequence) const
 {
-    bool recordEnabled = false;
+    // Serialise encodes so each frame is encoded at most once, however
+    // many consumers ask for it.
+    std::lock_guard<std::mutex>           lockJ(m_jpegMutex);
+    std::shared_ptr<IpFreelyFramePyramid> framePyramid;
 
-    for (auto const& day : schedule)
     {
-        for (auto hour : day)
-        {
-            if (hour)
-            {
-                recordEnabled = true;
-                break;
-            }
-        }
+        std::lock_guard<std::mutex> lockF(m_frameMutex);
+        framePyramid = m_framePyramid;
+    }
 
-        if (recordEnabled)
+    if (framePyramid && ((framePyramid->FrameSequence() != m_jpegFrame.frameSequence) ||
+                         (maxSize != m_jpegFrame.maxSize) || (quality != m_jpegFrame.quality)))
+    {
+        auto const fullSize  = framePyramid->FullSize();
+        auto const frameSize = QSize(fullSize.width, fullSize.height);
+        auto const jpegSize =
+            utils::ScaledDisplaySize(frameSize, maxSize.isEmpty() ? frameSize : maxSize, false);
+        QByteArray jpeg;
+
+        if (!jpegSize.isEmpty())
         {
-            break;
+            utils::CvMatToJpeg(
+                framePyramid->NearestLevel(cv::Size(jpegSize.width(), jpegSize.height())),
+                jpegSize,
+                quality,
+                jpeg);
         }
+
+        m_jpegFrame.maxSize       = maxSize;
+        m_jpegFrame.quality       = quality;
+        m_jpegFrame.frameSequence = framePyramid->FrameSequence();
+        m_jpegFrame.data          = jpeg;
     }
 
-    return recordEnabled;
+    if (frameSequence)
+    {
+        *frameSequence = m_jpegFrame.frameSequence;
+    }
+
+    return m_jpegFrame.data;
 }
 
-bool IpFreelyStreamProcessor::VerifySchedule(std::string const&                    scheduleId,
-                                             std::vector<std::vector<bool>> const& schedule)
+void IpFreelyStreamProcessor::SetDisplaySize(eDisplayTarget const target, QSize const& size)
 {
-    bool scheduleOk = false;
+    std::lock_guard<std::mutex> lock(m_displayMutex);
+    auto&                       displayTarget = m_displayTargets[target];
+    displayTarget.requestedSize               = size;
 
-    if (!schedule.empty())
+    // Release the unused frame so the next frame is rendered when the target is reused.
+    if (size.isEmpty())
     {
-        if (schedule.size() != 7)
-        {
-            std::ostringstream oss;
-            oss << "Incorrect number of days in schedule: " << scheduleId;
-            BOOST_THROW_EXCEPTION(std::invalid_argument(oss.str()));
-        }
+        displayTarget.displayFrame  = QImage();
+        displayTarget.frameSequence = 0;
+    }
+}
+
+void IpFreelyStreamProcessor::SetDisplayRegion(eDisplayTarget const target, QRectF const& region)
+{
+    std::lock_guard<std::mutex> lock(m_displayMutex);
+    m_displayTargets[target].requestedRegion = region;
+}
 
-        if (schedule.front().size() != 24)
+void IpFreelyStreamProcessor::SetMotionRegionsOverlay(IpCamera::regions_t const& motionRegions)
+{
+    std::lock_guard<std::mutex> lock(m_displayMutex);
+    m_overlayRegions = motionRegions;
+    ++m_overlayRegionsVersion;
+}
+
+QImage IpFreelyStreamProcessor::DisplayVideoFrame(eDisplayTarget const target,
+                                                  uint64_t*            frameSequence) const
+{
+    std::lock_guard<std::mutex> lock(m_displayMutex);
+    auto                        targetIter = m_displayTargets.find(target);
+
+    if (targetIter == m_displayTargets.end())
+    {
+        if (frameSequence)
         {
-            std::ostringstream oss;
-            oss << "Incorrect number of hours in schedule: " << scheduleId;
-            BOOST_THROW_EXCEPTION(std::invalid_argument(oss.str()));
+            *frameSequence = 0;
         }
 
-        scheduleOk = IsScheduleEnabled(schedule);
+        return {};
     }
 
+    if (frameSequence)
+    {
+        *frameSequence = targetIter->second.frameSequence;
+    }
+
+    return targetIter->second.displayFrame;
+}
+
+double IpFreelyStreamProcessor::OriginalFps() const noexcept
+{
+    return m_originalFps;
+}
+
+double IpFreelyStreamProcessor::CurrentFps() const noexcept
+{
+    return m_fps;
+}
+
+StreamStatsSnapshot IpFreelyStreamProcessor::PerformanceStats() const noexcept
+{
+    return m_streamStats->Snapshot();
+}
+
+bool IpFreelyStreamProcessor::UpdateCameraDetails(IpCamera const& camera)
+{
+    std::lock_guard<std::mutex> lock(m_cameraMutex);
+
+    // The stream's connection, recording FPS and schedules are fixed when the processor is
+    // created, so changing any of them needs a new stream processor.
+    if ((camera.camId != m_updatedCameraDetails.camId) ||
+        (camera.streamUrl != m_updatedCameraDetails.streamUrl) ||
+        (camera.username != m_updatedCameraDetails.username) ||
+        (camera.password != m_updatedCameraDetails.password) ||
+        (camera.cameraMaxFps != m_updatedCameraDetails.cameraMaxFps) ||
+        (camera.enableScheduledRecording != m_updatedCameraDetails.enableScheduledRecording) ||
+        (camera.enabledMotionRecording != m_updatedCameraDetails.enabledMotionRecording))
+    {
+        return false;
+    }
+
+    // Picked up by the stream's own thread with the next video frame.
+    m_updatedCameraDetails = camera;
+    m_cameraDetailsUpdated = true;
+
+    return true;
+}
+
+bool IpFreelyStreamProcessor::VerifySchedule(std::string const&      scheduleId,
+                                             IpFreelySchedule const& schedule)
+{
+    bool scheduleOk = schedule.IsEnabled();
+
     if (scheduleOk)
     {
-        DEBUG_MESSAGE_EX_INFO(scheduleId << " is enabled");
+        DEBUG_MESSAGE_EX_INFO(scheduleId << " is enabled, slot size (minutes): "
+                                         << schedule.SlotMinutes()
+                                         << ", pre-warm (secs): " << schedule.PrewarmSecs());
     }
     else
     {
@@ -270,18 +375,36 @@ bool IpFreelyStreamProcessor::VerifySchedule(std::string const&
     return scheduleOk;
 }
 
+bool IpFreelyStreamProcessor::SameMotionSettings(IpCamera const& lhs, IpCamera const& rhs)
+{
+    return (lhs.motionDectorMode == rhs.motionDectorMode) &&
+           (lhs.shrinkVideoFrames == rhs.shrinkVideoFrames) &&
+           (lhs.pixelThreshold == rhs.pixelThreshold) &&
+           (lhs.maxMotionStdDev == rhs.maxMotionStdDev) &&
+           (lhs.minMotionAreaPercentFactor == rhs.minMotionAreaPercentFactor) &&
+           (lhs.motionAreaAveFactor == rhs.motionAreaAveFactor) &&
+           (lhs.motionRegions == rhs.motionRegions);
+}
+
 void IpFreelyStreamProcessor::ThreadEventCallback() noexcept
 {
     // Get current time stamp.
-    m_currentTime = time(nullptr);
+    m_currentTime = m_environment.Clock().Now();
 
     try
     {
+        ApplyCameraDetails();
         GrabVideoFrame();
         CheckRecordingSchedule();
         CheckMotionDetector();
         CreateCaptureObjects();
         WriteVideoFrame();
+
+        if (RenderDisplayFrames() && m_displayCallback)
+        {
+            m_displayCallback();
+        }
+
         CheckFps();
     }
     catch (...)
@@ -291,6 +414,37 @@ void IpFreelyStreamProcessor::ThreadEventCallback() noexcept
     }
 }
 
+void IpFreelyStreamProcessor::ApplyCameraDetails()
+{
+    IpCamera camera;
+
+    {
+        std::lock_guard<std::mutex> lock(m_cameraMutex);
+
+        if (!m_cameraDetailsUpdated)
+        {
+            return;
+        }
+
+        camera                 = m_updatedCameraDetails;
+        m_cameraDetailsUpdated = false;
+    }
+
+    auto const restartMotionDetector = !SameMotionSettings(camera, m_cameraDetails);
+    m_cameraDetails                  = std::move(camera);
+
+    DEBUG_MESSAGE_EX_INFO("Camera details updated for stream URL: " << m_cameraDetails.streamUrl);
+
+    // The motion detector copied the old settings, it is recreated with the new ones by
+    // CheckMotionDetector() if the motion schedule is still active.
+    if (restartMotionDetector && m_motionDetector)
+    {
+        m_motionDetector.reset();
+        m_motionRectangle = QRect();
+        m_streamStats->MotionDetectorStopped();
+    }
+}
+
 void IpFreelyStreamProcessor::SetEnableVideoWriting(bool enable) noexcept
 {
     std::lock_guard<std::mutex> lock(m_writingMutex);
@@ -305,15 +459,12 @@ bool IpFreelyStreamProcessor::GetEnableVideoWriting() const noexcept
 
 void IpFreelyStreamProcessor::CheckRecordingSchedule()
 {
-    if (m_recordingSchedule.empty())
+    if (!m_useRecordingSchedule)
     {
         return;
     }
 
-    auto localTime = std::localtime(&m_currentTime);
-
-    bool needToRecord = (m_recordingSchedule[static_cast<size_t>(
-        localTime->tm_wday)])[static_cast<size_t>(localTime->tm_hour)];
+    bool needToRecord = m_recordingSchedule.IsActive(m_currentTime, m_environment.Clock());
 
     std::lock_guard<std::mutex> lock(m_writingMutex);
 
@@ -344,14 +495,17 @@ void IpFreelyStreamProcessor::CreateCaptureObjects()
                 return;
             }
 
-            m_videoWriter.release();
+            CloseVideoWriter();
         }
 
+        // Together with the close above this is a segment rollover.
+        IPFREELY_TRACE_SCOPE_ID("SegmentOpen", m_cameraDetails.camId);
+
         m_fileDurationSecs = 0.0;
 
-        auto localTime = std::localtime(&m_currentTime);
-        char folderName[9];
-        std::strftime(folderName, sizeof(folderName), "%Y%m%d", localTime);
+        auto const localTime = m_environment.Clock().LocalTime(m_currentTime);
+        char       folderName[9];
+        std::strftime(folderName, sizeof(folderName), "%Y%m%d", &localTime);
 
         bfs::path p(m_saveFolderPath);
         p /= folderName;
@@ -374,6 +528,8 @@ void IpFreelyStreamProcessor::CreateCaptureObjects()
         DEBUG_MESSAGE_EX_INFO("Creating new output video file: " << p.string()
                                                                  << ", FPS: " << m_fps);
 
+        auto const openTime = std::chrono::steady_clock::now();
+
 #if BOOST_OS_WINDOWS
         m_videoWriter = cv::makePtr<cv::VideoWriter>(p.string().c_str(),
                                                      cv::VideoWriter::fourcc('D', 'I', 'V', 'X'),
@@ -392,6 +548,10 @@ void IpFreelyStreamProcessor::CreateCaptureObjects()
             DEBUG_MESSAGE_EX_ERROR("Failed to open VideoWriter object for: " << p.string());
             return;
         }
+
+        m_streamStats->SegmentOpened(std::chrono::steady_clock::now() - openTime);
+        m_videoFilePath  = p.string();
+        m_videoFileBytes = 0;
     }
     else
     {
@@ -399,43 +559,411 @@ void IpFreelyStreamProcessor::CreateCaptureObjects()
         {
             DEBUG_MESSAGE_EX_INFO(
                 "Video writing disabled, releasing video writer, camera: " << m_name);
-            m_videoWriter.release();
+            CloseVideoWriter();
         }
     }
 }
 
 void IpFreelyStreamProcessor::GrabVideoFrame()
 {
-    *m_videoCapture >> m_videoFrame;
+    IPFREELY_TRACE_SCOPE_ID("GrabVideoFrame", m_cameraDetails.camId);
+
+    // Grab into a pooled buffer the size of the previous frame. The pool never hands out a
+    // buffer that is still referenced, e.g. by a consumer converting a previous frame on
+    // demand, so the capture can safely write into it.
+    cv::Mat videoFrame;
+
+    if (!m_videoFrame.empty())
+    {
+        videoFrame = m_framePool->Acquire(m_videoFrame.size(), m_videoFrame.type());
+    }
+
+    auto const grabTime = std::chrono::steady_clock::now();
+    *m_videoCapture >> videoFrame;
+    m_captureTime = std::chrono::steady_clock::now();
+
+    if (videoFrame.empty())
+    {
+        m_streamStats->FrameDropped();
+    }
+    else
+    {
+        m_streamStats->FrameGrabbed(m_captureTime - grabTime);
+    }
+
+    // We only keep the native frame here, every other level of the pyramid is deferred
+    // until a consumer actually asks for it.
+    std::shared_ptr<IpFreelyFramePyramid> framePyramid;
+
+    if (!videoFrame.empty())
+    {
+        framePyramid = std::make_shared<IpFreelyFramePyramid>(
+            videoFrame, m_videoFrameSequence + 1, m_framePool);
+    }
 
     std::lock_guard<std::mutex> lock(m_frameMutex);
-    utils::CvMatToQImage(m_videoFrame, m_currentFrame);
-    m_videoFrameUpdated = true;
+    m_videoFrame   = videoFrame;
+    m_framePyramid = framePyramid;
+
+    if (!m_videoFrame.empty())
+    {
+        ++m_videoFrameSequence;
+    }
 }
 
 void IpFreelyStreamProcessor::WriteVideoFrame()
 {
     if (m_videoWriter)
     {
+        IPFREELY_TRACE_SCOPE_ID("WriteVideoFrame", m_cameraDetails.camId);
+
+        auto const startTime = std::chrono::steady_clock::now();
+        *m_videoWriter << m_videoFrame;
+        m_streamStats->FrameEncoded(std::chrono::steady_clock::now() - startTime);
+
+        auto const previousSecs = static_cast<uint64_t>(m_fileDurationSecs);
+        m_fileDurationSecs += static_cast<double>(m_updatePeriodMillisecs) / 1000.0;
+
+        // Measure the file about once a second so the encoded byte rate does not jump by a
+        // whole file at a time.
+        if (static_cast<uint64_t>(m_fileDurationSecs) != previousSecs)
         {
-            *m_videoWriter << m_videoFrame;
+            UpdateVideoFileBytes();
         }
+    }
+}
 
-        m_fileDurationSecs += static_cast<double>(m_updatePeriodMillisecs) / 1000.0;
+void IpFreelyStreamProcessor::CloseVideoWriter()
+{
+    IPFREELY_TRACE_SCOPE_ID("SegmentClose", m_cameraDetails.camId);
+
+    auto const startTime = std::chrono::steady_clock::now();
+    m_videoWriter.release();
+    m_streamStats->SegmentClosed(std::chrono::steady_clock::now() - startTime);
+
+    // Closing the file flushes the last of its bytes.
+    UpdateVideoFileBytes();
+    m_videoFilePath.clear();
+}
+
+void IpFreelyStreamProcessor::UpdateVideoFileBytes()
+{
+    if (m_videoFilePath.empty())
+    {
+        return;
+    }
+
+    boost::system::error_code ec;
+    auto const                fileBytes = bfs::file_size(m_videoFilePath, ec);
+
+    if (!ec && (fileBytes > m_videoFileBytes))
+    {
+        m_streamStats->BytesEncoded(fileBytes - m_videoFileBytes);
+        m_videoFileBytes = fileBytes;
+    }
+}
+
+QImage IpFreelyStreamProcessor::ConvertedVideoFrame(uint64_t* frameSequence) const
+{
+    // Serialise conversions so each frame is converted at most once, however
+    // many consumers ask for it.
+    std::lock_guard<std::mutex>           lockC(m_convertMutex);
+    std::shared_ptr<IpFreelyFramePyramid> framePyramid;
+
+    {
+        // Only hold the frame mutex while taking a reference to the frame's
+        // pyramid so the capture thread is never blocked by a conversion.
+        std::lock_guard<std::mutex> lockF(m_frameMutex);
+        framePyramid = m_framePyramid;
+    }
+
+    if (framePyramid && (framePyramid->FrameSequence() != m_convertedFrameSequence))
+    {
+        QImage convertedFrame;
+
+        if (utils::CvMatToQImage(framePyramid->Level(ePyramidLevel::full), convertedFrame))
+        {
+            m_convertedFrame = convertedFrame;
+        }
+
+        m_convertedFrameSequence = framePyramid->FrameSequence();
     }
+
+    if (frameSequence)
+    {
+        *frameSequence = m_convertedFrameSequence;
+    }
+
+    return m_convertedFrame;
 }
 
-bool IpFreelyStreamProcessor::CheckMotionSchedule() const
+bool IpFreelyStreamProcessor::RenderDisplayFrames()
 {
-    if (!m_useMotionSchedule || m_motionSchedule.empty())
+    auto const                              now = std::chrono::steady_clock::now();
+    std::map<eDisplayTarget, DisplayTarget> requestedTargets;
+    IpCamera::regions_t                     motionRegions;
+    uint64_t                                motionRegionsVersion = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_displayMutex);
+
+        for (auto const& displayTarget : m_displayTargets)
+        {
+            auto const& target = displayTarget.second;
+
+            if (target.requestedSize.isEmpty())
+            {
+                continue;
+            }
+
+            // Size, region and overlay changes are picked up lazily with the next video frame.
+            if (target.frameSequence == m_videoFrameSequence)
+            {
+                continue;
+            }
+
+            if ((displayTarget.first == eDisplayTarget::feed) &&
+                (m_cameraDetails.displayMaxFps > 0.0))
+            {
+                auto const minPeriod =
+                    std::chrono::duration<double>(1.0 / m_cameraDetails.displayMaxFps);
+
+                if (now - target.renderTime < minPeriod)
+                {
+                    continue;
+                }
+            }
+
+            auto& requestedTarget           = requestedTargets[displayTarget.first];
+            requestedTarget.requestedSize   = target.requestedSize;
+            requestedTarget.requestedRegion = target.requestedRegion;
+        }
+
+        motionRegions        = m_overlayRegions;
+        motionRegionsVersion = m_overlayRegionsVersion;
+    }
+
+    // With no subscribed display targets we never touch the native frame.
+    if (requestedTargets.empty())
     {
         return false;
     }
 
-    auto localTime = std::localtime(&m_currentTime);
+    // Only this thread ever writes to the frame's pyramid so we can
+    // safely read it here without holding the frame mutex.
+    if (!m_framePyramid)
+    {
+        return false;
+    }
+
+    QRect motionBoundingRect;
+
+    {
+        std::lock_guard<std::mutex> lock(m_motionMutex);
+        motionBoundingRect = m_motionRectangle;
+    }
+
+    auto const isWriting = VideoWritingEnabled();
+
+    for (auto const& requestedTarget : requestedTargets)
+    {
+        auto displayFrame = RenderDisplayFrame(*m_framePyramid,
+                                               requestedTarget.first,
+                                               requestedTarget.second.requestedSize,
+                                               requestedTarget.second.requestedRegion,
+                                               motionBoundingRect,
+                                               isWriting,
+                                               motionRegions,
+                                               motionRegionsVersion,
+                                               m_overlayLayers[requestedTarget.first]);
+
+        m_streamStats->FrameRendered(requestedTarget.first == eDisplayTarget::expanded,
+                                     std::chrono::steady_clock::now() - m_captureTime);
+
+        std::lock_guard<std::mutex> lock(m_displayMutex);
+        auto&                       displayTarget = m_displayTargets[requestedTarget.first];
+        displayTarget.displayFrame                = displayFrame;
+        displayTarget.frameSequence               = m_videoFrameSequence;
+        displayTarget.renderTime                  = now;
+    }
+
+    return true;
+}
+
+QImage IpFreelyStreamProcessor::RenderDisplayFrame(IpFreelyFramePyramid&      framePyramid,
+                                                   eDisplayTarget const       target,
+                                                   QSize const&               requestedSize,
+                                                   QRectF const&              requestedRegion,
+                                                   QRect const&               motionBoundingRect,
+                                                   bool const                 isWriting,
+                                                   IpCamera::regions_t const& motionRegions,
+                                                   uint64_t const             motionRegionsVersion,
+                                                   OverlayLayer&              overlay)
+{
+    auto const fullSize    = framePyramid.FullSize();
+    auto const videoSize   = QSize(fullSize.width, fullSize.height);
+    auto const roi         = utils::RegionOfInterest(videoSize, requestedRegion);
+    auto const displaySize = utils::ScaledDisplaySize(
+        roi.size(), requestedSize, target == eDisplayTarget::expanded);
+
+    if (displaySize.isEmpty())
+    {
+        return {};
+    }
+
+    // Scale from the smallest pyramid level that still has at least the display's resolution
+    // within the region of interest, e.g. a grid of small tiles shares the quarter level
+    // rather than each shrinking the full frame, whereas a zoomed in view uses the full frame.
+    double const scalar =
+        static_cast<double>(displaySize.width()) / static_cast<double>(roi.width());
+    auto const sourceFrame =
+        framePyramid.NearestLevel(cv::Size(cvCeil(static_cast<double>(fullSize.width) * scalar),
+                                           cvCeil(static_cast<double>(fullSize.height) * scalar)));
+
+    // Crop the region of interest before scaling, the cropped matrix is only a view
+    // onto the level's buffer so no pixels are copied.
+    double const levelScalar =
+        static_cast<double>(sourceFrame.cols) / static_cast<double>(fullSize.width);
+    auto const levelRoi =
+        cv::Rect(cvFloor(static_cast<double>(roi.x()) * levelScalar),
+                 cvFloor(static_cast<double>(roi.y()) * levelScalar),
+                 std::max(cvRound(static_cast<double>(roi.width()) * levelScalar), 1),
+                 std::max(cvRound(static_cast<double>(roi.height()) * levelScalar), 1)) &
+        cv::Rect(0, 0, sourceFrame.cols, sourceFrame.rows);
+
+    QImage displayFrame;
+
+    if (!utils::CvMatToDisplayImage(cv::Mat(sourceFrame, levelRoi), displaySize, displayFrame))
+    {
+        return {};
+    }
+
+    bool const showRegions = !motionRegions.empty();
+
+    if (motionBoundingRect.isNull() && !isWriting && !showRegions)
+    {
+        return displayFrame;
+    }
+
+    QPainter p(&displayFrame);
+    bool     intersectsMotionRegion = false;
+    auto     rect                   = motionBoundingRect;
+
+    if (!motionBoundingRect.isNull())
+    {
+        // Only the visible part of the motion bounding rect is drawn and tested against the
+        // motion regions, motion outside of the region of interest is not shown.
+        rect = utils::ScaleRect(motionBoundingRect.translated(-roi.topLeft()), scalar)
+                   .intersected(displayFrame.rect());
+
+        if (rect.isEmpty())
+        {
+            rect = QRect();
+        }
+    }
+
+    if (showRegions)
+    {
+        if ((overlay.size != displayFrame.size()) || (overlay.regionOfInterest != roi) ||
+            (overlay.version != motionRegionsVersion))
+        {
+            RenderOverlayLayer(
+                overlay, displayFrame.size(), roi, videoSize, motionRegions, motionRegionsVersion);
+        }
+
+        p.drawImage(0, 0, overlay.layer);
+
+        for (auto const& regionRect : overlay.regionRects)
+        {
+            if (rect.intersects(regionRect))
+            {
+                intersectsMotionRegion = true;
+                break;
+            }
+        }
+    }
+
+    if (!rect.isNull())
+    {
+        auto pen = QPen(intersectsMotionRegion ? Qt::red : Qt::green);
+        pen.setWidth(2);
+        p.setPen(pen);
+        p.setBackground(QBrush(Qt::NoBrush));
+        p.setBackgroundMode(Qt::TransparentMode);
+        p.setBrush(QBrush(Qt::NoBrush));
+        p.drawRect(rect);
+    }
+
+    if (isWriting)
+    {
+        p.setPen(QPen(Qt::red));
+        p.setBackground(QBrush(Qt::white, Qt::SolidPattern));
+        p.setBackgroundMode(Qt::OpaqueMode);
+        p.setFont(QFont("Segoe UI", 16, QFont::Bold));
+        auto posRec = displayFrame.rect();
+        posRec.setTop(posRec.top() + 16);
+        p.drawText(posRec, Qt::AlignHCenter | Qt::AlignTop, QObject::tr("Recording"));
+    }
+
+    return displayFrame;
+}
+
+void IpFreelyStreamProcessor::RenderOverlayLayer(OverlayLayer& overlay, QSize const& size,
+                                                 QRect const&               regionOfInterest,
+                                                 QSize const&               videoSize,
+                                                 IpCamera::regions_t const& motionRegions,
+                                                 uint64_t const             motionRegionsVersion)
+{
+    overlay.size             = size;
+    overlay.regionOfInterest = regionOfInterest;
+    overlay.version          = motionRegionsVersion;
+    overlay.layer   = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    overlay.layer.fill(Qt::transparent);
+    overlay.regionRects.clear();
+
+    QPainter p(&overlay.layer);
+    auto     pen = QPen(Qt::cyan);
+    pen.setWidth(2);
+    p.setPen(pen);
+    p.setBackground(QBrush(Qt::NoBrush));
+    p.setBackgroundMode(Qt::TransparentMode);
+    p.setBrush(QBrush(Qt::NoBrush));
+
+    // Lay the regions out over the whole frame as it would be at the overlay's scale, then
+    // shift them so the region of interest's top left corner is at the overlay's origin.
+    double const scalar =
+        static_cast<double>(size.width()) / static_cast<double>(regionOfInterest.width());
+    auto const scaledFrameSize =
+        QSize(static_cast<int>(static_cast<double>(videoSize.width()) * scalar),
+              static_cast<int>(static_cast<double>(videoSize.height()) * scalar));
+    auto const offset = utils::ScaleRect(regionOfInterest, scalar).topLeft();
+
+    for (auto const& motionRegion : motionRegions)
+    {
+        auto r = CreateQRectFromVideoFrameDims(
+                     scaledFrameSize.width(), scaledFrameSize.height(), motionRegion)
+                     .translated(-offset)
+                     .intersected(overlay.layer.rect());
+
+        // Regions outside of the region of interest are neither drawn nor tested.
+        if (r.isEmpty())
+        {
+            continue;
+        }
 
-    return (m_motionSchedule[static_cast<size_t>(localTime->tm_wday)])[static_cast<size_t>(
-        localTime->tm_hour)];
+        p.drawRect(r);
+        overlay.regionRects.emplace_back(r);
+    }
+}
+
+bool IpFreelyStreamProcessor::CheckMotionSchedule()
+{
+    if (!m_useMotionSchedule)
+    {
+        return false;
+    }
+
+    return m_motionSchedule.IsActive(m_currentTime, m_environment.Clock());
 }
 
 void IpFreelyStreamProcessor::InitialiseMotionDetector()
@@ -448,7 +976,9 @@ void IpFreelyStreamProcessor::InitialiseMotionDetector()
                                                                     m_requiredFileDurationSecs,
                                                                     m_fps,
                                                                     m_videoWidth,
-                                                                    m_videoHeight);
+                                                                    m_videoHeight,
+                                                                    m_streamStats,
+                                                                    m_environment);
         m_motionRectangle = QRect();
     }
 }
@@ -461,12 +991,19 @@ void IpFreelyStreamProcessor::CheckMotionDetector()
     {
         m_motionDetector.reset();
         m_motionRectangle = QRect();
+        m_streamStats->MotionDetectorStopped();
+        return;
+    }
+
+    if (!m_framePyramid)
+    {
         return;
     }
 
     InitialiseMotionDetector();
 
-    m_motionDetector->AddNextFrame(m_videoFrame);
+    m_motionDetector->AddNextFrame(
+        m_videoFrame, m_framePyramid->MotionLevel(m_motionDetector->MotionFrameSize()));
 
     std::lock_guard<std::mutex> lockM(m_motionMutex);
     m_motionRectangle = m_motionDetector->CurrentMotionRect();
@@ -482,7 +1019,11 @@ void IpFreelyStreamProcessor::CreateVideoCapture()
     bool isId;
     auto completeStreamUrl = m_cameraDetails.CompleteStreamUrl(isId);
 
-    if (isId)
+    if (m_environment.captureFactory)
+    {
+        m_videoCapture = m_environment.captureFactory(m_cameraDetails);
+    }
+    else if (isId)
     {
         m_videoCapture = cv::makePtr<cv::VideoCapture>(std::stoi(completeStreamUrl));
     }
@@ -491,7 +1032,7 @@ void IpFreelyStreamProcessor::CreateVideoCapture()
         m_videoCapture = cv::makePtr<cv::VideoCapture>(completeStreamUrl.c_str());
     }
 
-    if (!m_videoCapture->isOpened())
+    if (!m_videoCapture || !m_videoCapture->isOpened())
     {
         std::ostringstream oss;
         oss << "Failed to open VideoCapture object, url: " << m_cameraDetails.streamUrl;
@@ -500,6 +1041,12 @@ void IpFreelyStreamProcessor::CreateVideoCapture()
 
     m_videoWidth  = static_cast<int>(m_videoCapture->get(cv::CAP_PROP_FRAME_WIDTH));
     m_videoHeight = static_cast<int>(m_videoCapture->get(cv::CAP_PROP_FRAME_HEIGHT));
+
+#if (CV_VERSION_MAJOR > 4) || ((CV_VERSION_MAJOR == 4) && (CV_VERSION_MINOR >= 1))
+    // The stream's bitrate is only reported by OpenCV 4.1 onwards and only by some backends.
+    auto const bitrateKbps = m_videoCapture->get(cv::CAP_PROP_BITRATE);
+    m_streamStats->SetBitrate(bitrateKbps > 0.0 ? static_cast<uint64_t>(bitrateKbps) : 0);
+#endif
 }
 
 bool IpFreelyStreamProcessor::ComputeFps()
@@ -533,6 +1080,8 @@ bool IpFreelyStreamProcessor::ComputeFps()
                                  << m_cameraDetails.streamUrl << ", FPS: " << m_fps);
     }
 
+    m_streamStats->SetFps(m_originalFps, m_fps);
+
     return std::abs(fps - m_fps) > 0.1;
 }
 
@@ -565,7 +1114,7 @@ void IpFreelyStreamProcessor::CheckFps()
             {
                 DEBUG_MESSAGE_EX_INFO("Releasing video writer due to FPS change, stream URL: "
                                       << m_cameraDetails.streamUrl);
-                m_videoWriter.release();
+                CloseVideoWriter();
             }
 
             // And recreate the motion detector.
@@ -575,6 +1124,7 @@ void IpFreelyStreamProcessor::CheckFps()
                                       << m_cameraDetails.streamUrl);
                 m_motionDetector.reset();
                 m_motionRectangle = QRect();
+                m_streamStats->MotionDetectorStopped();
                 m_motionDetector =
                     std::make_shared<IpFreelyMotionDetector>(m_name,
                                                              m_cameraDetails,
@@ -582,10 +1132,17 @@ void IpFreelyStreamProcessor::CheckFps()
                                                              m_requiredFileDurationSecs,
                                                              m_fps,
                                                              m_videoWidth,
-                                                             m_videoHeight);
+                                                             m_videoHeight,
+                                                             m_streamStats,
+                                                             m_environment);
+            }
+
+            // Finally recreate the event thread, if we have one.
+            if (m_environment.manualStepping)
+            {
+                return;
             }
 
-            // Finally recreate the event thread.
             DEBUG_MESSAGE_EX_INFO(
                 "Recreating event thread for stream URL: " << m_cameraDetails.streamUrl);
 
@@ -26,13 +26,24 @@
 #define IPFREELYSTREAMPROCESSOR_H
 
 #include <QImage>
+#include <QByteArray>
+#include <QSize>
+#include <QRect>
+#include <QRectF>
 #include <string>
 #include <vector>
+#include <map>
 #include <ctime>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <functional>
+#include <chrono>
 #include <opencv2/opencv.hpp>
 #include "IpFreelyCameraDatabase.h"
+#include "IpFreelyStreamStats.h"
+#include "IpFreelyPipelineEnvironment.h"
+#include "IpFreelySchedule.h"
 
 namespace core_lib
 {
@@ -49,29 +60,59 @@ namespace ipfreely
 {
 
 class IpFreelyMotionDetector;
+class IpFreelyFramePool;
+class IpFreelyFramePyramid;
+
+/*! \brief Display target enumeration. */
+enum class eDisplayTarget
+{
+    feed,
+    expanded
+};
 
 /*! \brief Class defining a RTSP stream processor. */
 class IpFreelyStreamProcessor final
 {
 public:
+    /*! \brief Typedef for the callback fired when new display frames are ready. */
+    typedef std::function<void()> display_callback_t;
+
     /*!
      * \brief IpFreelyStreamProcessor constructor.
      * \param[in] name - A name for the stream, used to name output video files.
      * \param[in] cameraDetails - Camera details we want to stream from.
      * \param[in] saveFolderPath - A local folder to save captured videos to.
      * \param[in] requiredFileDurationSecs - Duration to use for captured video files.
-     * \param[in] recordingSchedule - (Optional) The daily/hourly recording schedule.
-     * \param[in] motionSchedule - (Optional) The daily/hourly motion detector schedule.
+     * \param[in] recordingSchedule - (Optional) The weekly recording schedule.
+     * \param[in] motionSchedule - (Optional) The weekly motion detector schedule.
+     * \param[in] displayCallback - (Optional) Callback fired when new display frames are ready.
+     * \param[in] streamStats - (Optional) Performance counters to update, e.g. a camera's
+     * counters from the metrics registry, new counters are created if not given.
+     * \param[in] environment - (Optional) The clock, frame source and threading to use, the
+     * system clock, the camera's stream URL and a real time event thread if not given.
      *
      * The stream processor can be used to receive and thus display RTSP video streams but can also
      * record the stream in DivX format mp4 files to disk. Files are recorded with the given
      * duration. One recording session can span multiple back-to-back video files.
+     *
+     * Each schedule's state is cached until it next changes, so checking the schedules costs
+     * an integer comparison per frame. A schedule's pre-warm period starts recording, or the
+     * motion detector, that many seconds before its windows.
+     *
+     * The display callback is fired on the stream processor's thread so it should do no more
+     * than notify the consumer, which then fetches the frames using DisplayVideoFrame().
+     *
+     * With manual stepping no event thread is created, the owner calls Step() once per frame
+     * period instead, and the motion detector processes each frame before Step() returns.
      */
     IpFreelyStreamProcessor(std::string const& name, IpCamera const& cameraDetails,
-                            std::string const&                    saveFolderPath,
-                            double const                          requiredFileDurationSecs,
-                            std::vector<std::vector<bool>> const& recordingSchedule = {},
-                            std::vector<std::vector<bool>> const& motionSchedule    = {});
+                            std::string const&      saveFolderPath,
+                            double const            requiredFileDurationSecs,
+                            IpFreelySchedule const& recordingSchedule = IpFreelySchedule(),
+                            IpFreelySchedule const& motionSchedule    = IpFreelySchedule(),
+                            display_callback_t const&                   displayCallback = {},
+                            std::shared_ptr<IpFreelyStreamStats> const& streamStats     = {},
+                            PipelineEnvironment const&                  environment     = {});
 
     /*! \brief IpFreelyStreamProcessor destructor. */
     ~IpFreelyStreamProcessor() = default;
@@ -82,6 +123,15 @@ public:
     /*! \brief IpFreelyStreamProcessor deleted copy assignment operator. */
     IpFreelyStreamProcessor& operator=(IpFreelyStreamProcessor const&) = delete;
 
+    /*!
+     * \brief Step runs one frame period of the stream processor on the caller's thread.
+     *
+     * Grabs the next frame then checks the schedules, rolls over video files, writes the frame
+     * and renders the display frames, exactly as the event thread does. Only allowed when the
+     * environment asks for manual stepping.
+     */
+    void Step();
+
     /*! \brief StartVideoWriting begins recording video to disk. */
     void StartVideoWriting() noexcept;
 
@@ -94,11 +144,15 @@ public:
      */
     bool VideoWritingEnabled() const noexcept;
 
-    /*!c
-     * \brief VideoFrameUpdated monitors stream activity.
-     * \return A flag denoting if the captured videdo stream is being updated.
+    /*!
+     * \brief VideoFrameSequence monitors stream activity.
+     * \return The sequence number of the most recently captured video frame.
+     *
+     * The sequence number starts at 0, meaning no frame has been captured yet, and is
+     * incremented every time a new video frame is successfully grabbed. Consumers can
+     * remember the last sequence number they handled and skip work until it changes.
      */
-    bool VideoFrameUpdated() const noexcept;
+    uint64_t VideoFrameSequence() const noexcept;
 
     /*!
      * \brief GetAspectRatioAndSize return s the aspect ratio.
@@ -111,9 +165,107 @@ public:
     /*!
      * \brief CurrentVideoFrame gives acces to current video frame.
      * \param[out] motionRectangle - (Optional) Used to get motion bounding rect.
+     * \param[out] frameSequence - (Optional) Used to get the frame's sequence number.
      * \return A QImage of the current video frame at full stream resolution.
+     *
+     * Captured frames are kept in their native format and only converted to a QImage on
+     * demand, at most once per frame, so repeated calls for the same frame are cheap.
+     *
+     * Every captured frame is wrapped in a frame pyramid shared by all of its consumers. The
+     * display targets, motion detector and on demand conversions each take the pyramid level
+     * nearest the size they need, and each level is computed at most once per frame.
+     */
+    QImage CurrentVideoFrame(QRect* motionRectangle = nullptr,
+                             uint64_t* frameSequence = nullptr) const;
+
+    /*!
+     * \brief ThumbnailVideoFrame gives access to a small copy of the current video frame.
+     * \param[in] maxSize - The size the thumbnail must fit within.
+     * \return A QImage of the current video frame, null if no frame has been captured yet.
+     *
+     * The thumbnail is scaled from the frame pyramid's nearest level, so it is cheap enough
+     * to take periodically, and has no overlays drawn on it.
+     */
+    QImage ThumbnailVideoFrame(QSize const& maxSize) const;
+
+    /*!
+     * \brief JpegVideoFrame gives access to the current video frame encoded as a JPEG.
+     * \param[in] maxSize - The size the encoded frame must fit within, empty for full size.
+     * \param[in] quality - The JPEG quality, from 0 to 100.
+     * \param[out] frameSequence - (Optional) Used to get the encoded frame's sequence number.
+     * \return The JPEG file's bytes, empty if no frame has been captured yet.
+     *
+     * The frame is scaled from the frame pyramid's nearest level and encoded on the caller's
+     * thread, at most once per frame for a given size and quality, so any number of consumers,
+     * e.g. HTTP clients, share the same encoded bytes. No overlays are drawn on the frame.
+     */
+    QByteArray JpegVideoFrame(QSize const& maxSize, int const quality,
+                              uint64_t* frameSequence = nullptr) const;
+
+    /*!
+     * \brief SetDisplaySize sets the size a display target wants its video frames to be.
+     * \param[in] target - The display target.
+     * \param[in] size - The size of the display area, an empty size stops rendering.
+     *
+     * A display target subscribes to video frames by setting a non-empty size and unsubscribes
+     * by setting an empty size, e.g. when its tile is off screen or its window is minimised.
+     * While no target is subscribed captured frames are never converted or scaled.
+     *
+     * Display frames are scaled and have their overlays drawn on the stream processor's
+     * thread so that the GUI thread only has to blit the resulting image. The native frame is
+     * scaled before it is converted, directly into QImage::Format_RGB32, so the colour
+     * conversion runs at display size and painting the frame needs no further conversion.
+     * The feed target only ever shrinks frames whereas the expanded target scales frames to
+     * fit. The feed target is also limited to the camera's maximum display FPS, if one is set.
+     *
+     * A new size only takes effect when the next video frame is rendered, so a stream of
+     * size changes, e.g. while the user drags a window edge, causes no extra rendering.
+     */
+    void SetDisplaySize(eDisplayTarget const target, QSize const& size);
+
+    /*!
+     * \brief SetDisplayRegion sets the region of the video frame a display target shows.
+     * \param[in] target - The display target.
+     * \param[in] region - The region as fractions of the video frame, empty for the whole frame.
+     *
+     * The region is cropped from the frame pyramid's nearest level, the full resolution frame
+     * when zoomed in, before it is scaled to the display size, so the cost of rendering a
+     * zoomed in frame follows the display size rather than the video frame size. Motion
+     * overlays are mapped into the region and clipped to it.
+     *
+     * Like the display size, a new region only takes effect when the next video frame is
+     * rendered.
      */
-    QImage CurrentVideoFrame(QRect* motionRectangle = nullptr) const;
+    void SetDisplayRegion(eDisplayTarget const target, QRectF const& region);
+
+    /*!
+     * \brief SetMotionRegionsOverlay sets the motion regions drawn on the display frames.
+     * \param[in] motionRegions - The motion regions to draw, empty to draw none.
+     *
+     * The regions are pre-rendered into an overlay layer that is only redrawn when the
+     * regions or the display size change.
+     */
+    void SetMotionRegionsOverlay(IpCamera::regions_t const& motionRegions);
+
+    /*!
+     * \brief UpdateCameraDetails applies a camera's edited settings to the running stream.
+     * \param[in] camera - The camera's new details.
+     * \return True if the new settings are used from the next frame on, false if the change
+     * needs a new stream processor, e.g. the stream URL or a schedule was changed.
+     *
+     * Description, display and motion detection settings are changed without reconnecting.
+     * The motion detector, and any motion video file it has open, is only restarted if its
+     * own settings changed.
+     */
+    bool UpdateCameraDetails(IpCamera const& camera);
+
+    /*!
+     * \brief DisplayVideoFrame gives access to the current display-ready video frame.
+     * \param[in] target - The display target.
+     * \param[out] frameSequence - (Optional) Used to get the frame's sequence number.
+     * \return A QImage scaled to the target's display size with overlays drawn on it.
+     */
+    QImage DisplayVideoFrame(eDisplayTarget const target, uint64_t* frameSequence = nullptr) const;
 
     /*!
      * \brief OriginalFps gives acces to camera stream's reported FPS.
@@ -127,34 +279,109 @@ public:
      */
     double CurrentFps() const noexcept;
 
+    /*!
+     * \brief PerformanceStats gives access to the stream's performance counters.
+     * \return A snapshot of the counters.
+     *
+     * The counters are updated lock-free by the stream's threads so taking a snapshot never
+     * blocks them. Rates and averages are derived from the difference between two snapshots.
+     */
+    StreamStatsSnapshot PerformanceStats() const noexcept;
+
+private:
+    /*! \brief Lets the benchmarks drive the private display rendering stage directly. */
+    friend struct IpFreelyBenchmarkAccess;
+
+    /*! \brief Structure holding a display target's requested size and latest frame. */
+    struct DisplayTarget
+    {
+        /*! \brief The size the display target wants its frames to be. */
+        QSize requestedSize{};
+        /*! \brief The region of the video frame to display, empty for the whole frame. */
+        QRectF requestedRegion{};
+        /*! \brief The latest display-ready frame. */
+        QImage displayFrame{};
+        /*! \brief The sequence number of the frame used to create the display frame. */
+        uint64_t frameSequence{0};
+        /*! \brief When the display frame was rendered. */
+        std::chrono::steady_clock::time_point renderTime{};
+    };
+
+    /*! \brief Structure holding a pre-rendered motion regions overlay layer. */
+    struct OverlayLayer
+    {
+        /*! \brief The size the overlay was rendered at. */
+        QSize size{};
+        /*! \brief The region of the video frame, in pixels, the overlay was rendered for. */
+        QRect regionOfInterest{};
+        /*! \brief The version of the motion regions the overlay was rendered from. */
+        uint64_t version{0};
+        /*! \brief The transparent overlay image. */
+        QImage layer{};
+        /*! \brief The motion regions scaled to the overlay's size. */
+        std::vector<QRect> regionRects{};
+    };
+
+    /*! \brief Structure holding the most recently encoded JPEG frame. */
+    struct JpegFrame
+    {
+        /*! \brief The size the frame was requested to fit within. */
+        QSize maxSize{};
+        /*! \brief The JPEG quality the frame was encoded with. */
+        int quality{0};
+        /*! \brief The sequence number of the encoded frame. */
+        uint64_t frameSequence{0};
+        /*! \brief The JPEG file's bytes. */
+        QByteArray data{};
+    };
+
 private:
-    static bool IsScheduleEnabled(std::vector<std::vector<bool>> const& schedule);
-    static bool VerifySchedule(std::string const&                    scheduleId,
-                               std::vector<std::vector<bool>> const& schedule);
-    void        ThreadEventCallback() noexcept;
-    void        SetEnableVideoWriting(bool enable) noexcept;
-    bool        GetEnableVideoWriting() const noexcept;
-    void        CheckRecordingSchedule();
-    void        CreateCaptureObjects();
-    void        GrabVideoFrame();
-    void        WriteVideoFrame();
-    bool        CheckMotionSchedule() const;
-    void        InitialiseMotionDetector();
-    void        CheckMotionDetector();
-    void        CreateVideoCapture();
-    bool        ComputeFps();
-    void        CheckFps();
+    static bool   VerifySchedule(std::string const& scheduleId, IpFreelySchedule const& schedule);
+    static bool   SameMotionSettings(IpCamera const& lhs, IpCamera const& rhs);
+    void          ThreadEventCallback() noexcept;
+    void          ApplyCameraDetails();
+    void          SetEnableVideoWriting(bool enable) noexcept;
+    bool          GetEnableVideoWriting() const noexcept;
+    void          CheckRecordingSchedule();
+    void          CreateCaptureObjects();
+    void          GrabVideoFrame();
+    void          WriteVideoFrame();
+    void          CloseVideoWriter();
+    void          UpdateVideoFileBytes();
+    bool          CheckMotionSchedule();
+    void          InitialiseMotionDetector();
+    void          CheckMotionDetector();
+    void          CreateVideoCapture();
+    bool          ComputeFps();
+    void          CheckFps();
+    bool          RenderDisplayFrames();
+    QImage        ConvertedVideoFrame(uint64_t* frameSequence) const;
+    static QImage RenderDisplayFrame(IpFreelyFramePyramid& framePyramid,
+                                     eDisplayTarget const target, QSize const& requestedSize,
+                                     QRectF const& requestedRegion, QRect const& motionBoundingRect,
+                                     bool const isWriting, IpCamera::regions_t const& motionRegions,
+                                     uint64_t const motionRegionsVersion, OverlayLayer& overlay);
+    static void   RenderOverlayLayer(OverlayLayer& overlay, QSize const& size,
+                                     QRect const& regionOfInterest, QSize const& videoSize,
+                                     IpCamera::regions_t const& motionRegions,
+                                     uint64_t const             motionRegionsVersion);
 
 private:
     mutable std::mutex                              m_writingMutex{};
     mutable std::mutex                              m_frameMutex{};
     mutable std::mutex                              m_motionMutex{};
+    mutable std::mutex                              m_displayMutex{};
+    mutable std::mutex                              m_convertMutex{};
+    mutable std::mutex                              m_jpegMutex{};
+    mutable std::mutex                              m_cameraMutex{};
     std::string                                     m_name{"cam"};
     IpCamera                                        m_cameraDetails{};
+    IpCamera                                        m_updatedCameraDetails{};
+    bool                                            m_cameraDetailsUpdated{false};
     std::string                                     m_saveFolderPath{};
     double                                          m_requiredFileDurationSecs{0.0};
-    std::vector<std::vector<bool>>                  m_recordingSchedule{};
-    std::vector<std::vector<bool>>                  m_motionSchedule{};
+    IpFreelyScheduleTracker                         m_recordingSchedule{};
+    IpFreelyScheduleTracker                         m_motionSchedule{};
     unsigned int                                    m_updatePeriodMillisecs{0};
     double                                          m_originalFps{0.0};
     double                                          m_fps{0.0};
@@ -165,11 +392,25 @@ private:
     int                                             m_videoHeight{0};
     cv::Ptr<cv::VideoCapture>                       m_videoCapture{};
     cv::Mat                                         m_videoFrame{};
-    QImage                                          m_currentFrame{};
+    std::shared_ptr<IpFreelyFramePool>              m_framePool{};
+    std::shared_ptr<IpFreelyFramePyramid>           m_framePyramid{};
+    std::chrono::steady_clock::time_point           m_captureTime{};
+    std::shared_ptr<IpFreelyStreamStats>            m_streamStats{};
+    mutable QImage                                  m_convertedFrame{};
+    mutable uint64_t                                m_convertedFrameSequence{0};
+    mutable JpegFrame                               m_jpegFrame{};
     QRect                                           m_motionRectangle{};
     cv::Ptr<cv::VideoWriter>                        m_videoWriter{};
+    std::string                                     m_videoFilePath{};
+    uint64_t                                        m_videoFileBytes{0};
     double                                          m_fileDurationSecs{0.0};
-    bool                                            m_videoFrameUpdated{false};
+    uint64_t                                        m_videoFrameSequence{0};
+    std::map<eDisplayTarget, DisplayTarget>         m_displayTargets{};
+    IpCamera::regions_t                             m_overlayRegions{};
+    uint64_t                                        m_overlayRegionsVersion{0};
+    std::map<eDisplayTarget, OverlayLayer>          m_overlayLayers{};
+    display_callback_t                              m_displayCallback{};
+    PipelineEnvironment                             m_environment{};
     time_t                                          m_currentTime{};
     std::shared_ptr<IpFreelyMotionDetector>         m_motionDetector;
     std::shared_ptr<core_lib::threads::EventThread> m_eventThread;
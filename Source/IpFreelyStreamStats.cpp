@@ -0,0 +1,214 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyStreamStats.cpp
+ * \brief File containing definition of IpFreelyLatencyHistogram and IpFreelyStreamStats classes.
+ */
+#include "IpFreelyStreamStats.h"
+#include <algorithm>
+
+namespace ipfreely
+{
+
+namespace
+{
+
+uint64_t ToNanosecs(IpFreelyStreamStats::duration_t const duration) noexcept
+{
+    auto const nanosecs = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    return nanosecs > 0 ? static_cast<uint64_t>(nanosecs) : 0;
+}
+
+} // namespace
+
+IpFreelyLatencyHistogram::bucket_bounds_t const& IpFreelyLatencyHistogram::BucketBounds() noexcept
+{
+    static constexpr uint64_t NANOSECS_PER_MS = 1000000;
+
+    static bucket_bounds_t const BUCKET_BOUNDS = {{1 * NANOSECS_PER_MS,
+                                                   2 * NANOSECS_PER_MS,
+                                                   5 * NANOSECS_PER_MS,
+                                                   10 * NANOSECS_PER_MS,
+                                                   20 * NANOSECS_PER_MS,
+                                                   50 * NANOSECS_PER_MS,
+                                                   100 * NANOSECS_PER_MS,
+                                                   200 * NANOSECS_PER_MS,
+                                                   500 * NANOSECS_PER_MS,
+                                                   1000 * NANOSECS_PER_MS,
+                                                   2000 * NANOSECS_PER_MS,
+                                                   5000 * NANOSECS_PER_MS}};
+    return BUCKET_BOUNDS;
+}
+
+void IpFreelyLatencyHistogram::Observe(duration_t const duration) noexcept
+{
+    auto const  nanosecs = ToNanosecs(duration);
+    auto const& bounds   = BucketBounds();
+
+    // Observations above the last bound fall into the final, unbounded, bucket.
+    auto const bucket = static_cast<size_t>(
+        std::lower_bound(bounds.begin(), bounds.end(), nanosecs) - bounds.begin());
+
+    m_bucketCounts[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sumNanosecs.fetch_add(nanosecs, std::memory_order_relaxed);
+}
+
+LatencyHistogramSnapshot IpFreelyLatencyHistogram::Snapshot() const noexcept
+{
+    LatencyHistogramSnapshot snapshot;
+
+    for (size_t bucket = 0; bucket < m_bucketCounts.size(); ++bucket)
+    {
+        snapshot.bucketCounts[bucket] = m_bucketCounts[bucket].load(std::memory_order_relaxed);
+    }
+
+    snapshot.sumNanosecs = m_sumNanosecs.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void IpFreelyStreamStats::FrameGrabbed(duration_t const decodeTime) noexcept
+{
+    m_framesGrabbed.fetch_add(1, std::memory_order_relaxed);
+    m_decodeNanosecs.fetch_add(ToNanosecs(decodeTime), std::memory_order_relaxed);
+    m_decodeHistogram.Observe(decodeTime);
+}
+
+void IpFreelyStreamStats::FrameDropped() noexcept
+{
+    m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void IpFreelyStreamStats::FrameRendered(bool const expanded, duration_t const latency) noexcept
+{
+    if (expanded)
+    {
+        m_expandedFramesRendered.fetch_add(1, std::memory_order_relaxed);
+        m_expandedLatencyNanosecs.store(ToNanosecs(latency), std::memory_order_relaxed);
+    }
+    else
+    {
+        m_feedFramesRendered.fetch_add(1, std::memory_order_relaxed);
+        m_feedLatencyNanosecs.store(ToNanosecs(latency), std::memory_order_relaxed);
+    }
+}
+
+void IpFreelyStreamStats::MotionFrameQueued() noexcept
+{
+    m_motionQueueDepth.fetch_add(1, std::memory_order_relaxed);
+}
+
+void IpFreelyStreamStats::MotionFrameProcessed(duration_t const processTime) noexcept
+{
+    m_motionQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+    m_motionFramesProcessed.fetch_add(1, std::memory_order_relaxed);
+    m_motionNanosecs.fetch_add(ToNanosecs(processTime), std::memory_order_relaxed);
+    m_motionHistogram.Observe(processTime);
+}
+
+void IpFreelyStreamStats::SetMotionRecording(bool const recording) noexcept
+{
+    m_motionRecording.store(recording, std::memory_order_relaxed);
+}
+
+void IpFreelyStreamStats::MotionDetectorStopped() noexcept
+{
+    m_motionQueueDepth.store(0, std::memory_order_relaxed);
+    m_motionRecording.store(false, std::memory_order_relaxed);
+}
+
+void IpFreelyStreamStats::FrameEncoded(duration_t const encodeTime) noexcept
+{
+    m_framesEncoded.fetch_add(1, std::memory_order_relaxed);
+    m_encodeNanosecs.fetch_add(ToNanosecs(encodeTime), std::memory_order_relaxed);
+}
+
+void IpFreelyStreamStats::SetBitrate(uint64_t const bitrateKbps) noexcept
+{
+    m_bitrateKbps.store(bitrateKbps, std::memory_order_relaxed);
+}
+
+void IpFreelyStreamStats::SetFps(double const streamFps, double const captureFps) noexcept
+{
+    m_streamFps.store(streamFps, std::memory_order_relaxed);
+    m_captureFps.store(captureFps, std::memory_order_relaxed);
+}
+
+void IpFreelyStreamStats::SegmentOpened(duration_t const openTime) noexcept
+{
+    m_segmentOpenHistogram.Observe(openTime);
+}
+
+void IpFreelyStreamStats::SegmentClosed(duration_t const closeTime) noexcept
+{
+    m_segmentCloseHistogram.Observe(closeTime);
+}
+
+void IpFreelyStreamStats::BytesEncoded(uint64_t const bytes) noexcept
+{
+    m_bytesEncoded.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void IpFreelyStreamStats::ConnectionAttempted() noexcept
+{
+    m_connectionAttempts.fetch_add(1, std::memory_order_relaxed);
+}
+
+void IpFreelyStreamStats::ConnectionFailed() noexcept
+{
+    m_connectionFailures.fetch_add(1, std::memory_order_relaxed);
+}
+
+StreamStatsSnapshot IpFreelyStreamStats::Snapshot() const noexcept
+{
+    StreamStatsSnapshot snapshot;
+    snapshot.sampleTime              = std::chrono::steady_clock::now();
+    snapshot.framesGrabbed           = m_framesGrabbed.load(std::memory_order_relaxed);
+    snapshot.framesDropped           = m_framesDropped.load(std::memory_order_relaxed);
+    snapshot.decodeNanosecs          = m_decodeNanosecs.load(std::memory_order_relaxed);
+    snapshot.feedFramesRendered      = m_feedFramesRendered.load(std::memory_order_relaxed);
+    snapshot.expandedFramesRendered  = m_expandedFramesRendered.load(std::memory_order_relaxed);
+    snapshot.feedLatencyNanosecs     = m_feedLatencyNanosecs.load(std::memory_order_relaxed);
+    snapshot.expandedLatencyNanosecs = m_expandedLatencyNanosecs.load(std::memory_order_relaxed);
+    snapshot.motionQueueDepth        = m_motionQueueDepth.load(std::memory_order_relaxed);
+    snapshot.motionFramesProcessed   = m_motionFramesProcessed.load(std::memory_order_relaxed);
+    snapshot.motionNanosecs          = m_motionNanosecs.load(std::memory_order_relaxed);
+    snapshot.framesEncoded           = m_framesEncoded.load(std::memory_order_relaxed);
+    snapshot.encodeNanosecs          = m_encodeNanosecs.load(std::memory_order_relaxed);
+    snapshot.bitrateKbps             = m_bitrateKbps.load(std::memory_order_relaxed);
+    snapshot.bytesEncoded            = m_bytesEncoded.load(std::memory_order_relaxed);
+    snapshot.streamFps               = m_streamFps.load(std::memory_order_relaxed);
+    snapshot.captureFps              = m_captureFps.load(std::memory_order_relaxed);
+    snapshot.connectionAttempts      = m_connectionAttempts.load(std::memory_order_relaxed);
+    snapshot.connectionFailures      = m_connectionFailures.load(std::memory_order_relaxed);
+    snapshot.decodeHistogram         = m_decodeHistogram.Snapshot();
+    snapshot.motionHistogram         = m_motionHistogram.Snapshot();
+    snapshot.segmentOpenHistogram    = m_segmentOpenHistogram.Snapshot();
+    snapshot.segmentCloseHistogram   = m_segmentCloseHistogram.Snapshot();
+
+    // Frames queued for the motion detector while it records are all waiting to be encoded,
+    // the stream processor's own recordings are encoded synchronously so never queue.
+    snapshot.encoderQueueDepth =
+        m_motionRecording.load(std::memory_order_relaxed) ? snapshot.motionQueueDepth : 0;
+
+    return snapshot;
+}
+
+} // namespace ipfreely
@@ -0,0 +1,298 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyStreamStats.h
+ * \brief File containing declaration of IpFreelyLatencyHistogram and IpFreelyStreamStats classes.
+ */
+#ifndef IPFREELYSTREAMSTATS_H
+#define IPFREELYSTREAMSTATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*! \brief Number of latency histogram buckets, excluding the final unbounded bucket. */
+static constexpr size_t LATENCY_BUCKET_COUNT = 12;
+
+/*! \brief Structure holding a point in time copy of a latency histogram. */
+struct LatencyHistogramSnapshot
+{
+    /*! \brief Number of observations in each bucket, the last bucket being unbounded. */
+    std::array<uint64_t, LATENCY_BUCKET_COUNT + 1> bucketCounts{};
+    /*! \brief Total of all observations in nanoseconds. */
+    uint64_t sumNanosecs{0};
+};
+
+/*! \brief Class defining a lock-free fixed bucket latency histogram. */
+class IpFreelyLatencyHistogram final
+{
+public:
+    /*! \brief Typedef for the durations observed by the histogram. */
+    typedef std::chrono::steady_clock::duration duration_t;
+
+    /*! \brief Typedef for the buckets' upper bounds in nanoseconds. */
+    typedef std::array<uint64_t, LATENCY_BUCKET_COUNT> bucket_bounds_t;
+
+    /*! \brief IpFreelyLatencyHistogram constructor. */
+    IpFreelyLatencyHistogram() = default;
+
+    /*! \brief IpFreelyLatencyHistogram destructor. */
+    ~IpFreelyLatencyHistogram() = default;
+
+    /*! \brief IpFreelyLatencyHistogram deleted copy constructor. */
+    IpFreelyLatencyHistogram(IpFreelyLatencyHistogram const&) = delete;
+
+    /*! \brief IpFreelyLatencyHistogram deleted copy assignment operator. */
+    IpFreelyLatencyHistogram& operator=(IpFreelyLatencyHistogram const&) = delete;
+
+    /*!
+     * \brief BucketBounds gives access to the buckets' upper bounds.
+     * \return The upper bounds in nanoseconds, from 1ms to 5s in 1-2-5 steps.
+     */
+    static bucket_bounds_t const& BucketBounds() noexcept;
+
+    /*!
+     * \brief Observe counts a duration in the bucket it falls in.
+     * \param[in] duration - The observed duration.
+     */
+    void Observe(duration_t const duration) noexcept;
+
+    /*!
+     * \brief Snapshot takes a copy of the histogram.
+     * \return The current bucket counts and sum.
+     */
+    LatencyHistogramSnapshot Snapshot() const noexcept;
+
+private:
+    std::array<std::atomic<uint64_t>, LATENCY_BUCKET_COUNT + 1> m_bucketCounts{};
+    std::atomic<uint64_t>                                       m_sumNanosecs{0};
+};
+
+/*! \brief Structure holding a point in time copy of a stream's performance counters. */
+struct StreamStatsSnapshot
+{
+    /*! \brief When the counters were copied. */
+    std::chrono::steady_clock::time_point sampleTime{};
+    /*! \brief Total number of video frames successfully grabbed and decoded. */
+    uint64_t framesGrabbed{0};
+    /*! \brief Total number of failed grabs, i.e. frames lost by the stream. */
+    uint64_t framesDropped{0};
+    /*! \brief Total time spent grabbing and decoding frames in nanoseconds. */
+    uint64_t decodeNanosecs{0};
+    /*! \brief Total number of frames rendered for the grid tile. */
+    uint64_t feedFramesRendered{0};
+    /*! \brief Total number of frames rendered for the expanded view. */
+    uint64_t expandedFramesRendered{0};
+    /*! \brief Most recent capture to display-ready latency of a grid tile frame. */
+    uint64_t feedLatencyNanosecs{0};
+    /*! \brief Most recent capture to display-ready latency of an expanded view frame. */
+    uint64_t expandedLatencyNanosecs{0};
+    /*! \brief Number of frames waiting in the motion detector's queue. */
+    int64_t motionQueueDepth{0};
+    /*! \brief Total number of frames processed by the motion detector. */
+    uint64_t motionFramesProcessed{0};
+    /*! \brief Total time spent processing motion detector frames in nanoseconds. */
+    uint64_t motionNanosecs{0};
+    /*! \brief Number of frames waiting to be encoded to a video file. */
+    int64_t encoderQueueDepth{0};
+    /*! \brief Total number of frames encoded to video files. */
+    uint64_t framesEncoded{0};
+    /*! \brief Total time spent encoding frames in nanoseconds. */
+    uint64_t encodeNanosecs{0};
+    /*! \brief The stream's bitrate in kbits/s, 0 if not reported by the stream. */
+    uint64_t bitrateKbps{0};
+    /*! \brief Total number of bytes written to video files. */
+    uint64_t bytesEncoded{0};
+    /*! \brief The frame rate reported by the stream. */
+    double streamFps{0.0};
+    /*! \brief The frame rate the stream is captured and recorded at. */
+    double captureFps{0.0};
+    /*! \brief Total number of attempts to connect to the camera. */
+    uint64_t connectionAttempts{0};
+    /*! \brief Total number of failed attempts to connect to the camera. */
+    uint64_t connectionFailures{0};
+    /*! \brief Histogram of the time taken to grab and decode each frame. */
+    LatencyHistogramSnapshot decodeHistogram{};
+    /*! \brief Histogram of the time taken to process each motion detector frame. */
+    LatencyHistogramSnapshot motionHistogram{};
+    /*! \brief Histogram of the time taken to open each video file. */
+    LatencyHistogramSnapshot segmentOpenHistogram{};
+    /*! \brief Histogram of the time taken to close, i.e. finalise, each video file. */
+    LatencyHistogramSnapshot segmentCloseHistogram{};
+};
+
+/*! \brief Class defining a set of lock-free stream performance counters. */
+class IpFreelyStreamStats final
+{
+public:
+    /*! \brief Typedef for the durations passed to the counters. */
+    typedef std::chrono::steady_clock::duration duration_t;
+
+    /*!
+     * \brief IpFreelyStreamStats constructor.
+     *
+     * The counters are updated by the stream processor's and motion detector's threads using
+     * relaxed atomic operations and never take a lock, so they are cheap enough to leave on
+     * permanently. Consumers take a Snapshot() periodically and derive rates and averages
+     * from the difference between two snapshots.
+     */
+    IpFreelyStreamStats() = default;
+
+    /*! \brief IpFreelyStreamStats destructor. */
+    ~IpFreelyStreamStats() = default;
+
+    /*! \brief IpFreelyStreamStats deleted copy constructor. */
+    IpFreelyStreamStats(IpFreelyStreamStats const&) = delete;
+
+    /*! \brief IpFreelyStreamStats deleted copy assignment operator. */
+    IpFreelyStreamStats& operator=(IpFreelyStreamStats const&) = delete;
+
+    /*!
+     * \brief FrameGrabbed counts a successfully grabbed video frame.
+     * \param[in] decodeTime - Time taken to grab and decode the frame.
+     */
+    void FrameGrabbed(duration_t const decodeTime) noexcept;
+
+    /*! \brief FrameDropped counts a failed grab. */
+    void FrameDropped() noexcept;
+
+    /*!
+     * \brief FrameRendered counts a display frame rendered for a grid tile or expanded view.
+     * \param[in] expanded - True if rendered for the expanded view, false for a grid tile.
+     * \param[in] latency - Time from the frame being captured to it being display-ready.
+     */
+    void FrameRendered(bool const expanded, duration_t const latency) noexcept;
+
+    /*! \brief MotionFrameQueued counts a frame added to the motion detector's queue. */
+    void MotionFrameQueued() noexcept;
+
+    /*!
+     * \brief MotionFrameProcessed counts a frame taken off the motion detector's queue.
+     * \param[in] processTime - Time taken to process the frame.
+     */
+    void MotionFrameProcessed(duration_t const processTime) noexcept;
+
+    /*!
+     * \brief SetMotionRecording sets whether the motion detector is recording.
+     * \param[in] recording - True if recording, false otherwise.
+     *
+     * While the motion detector records, every frame in its queue is waiting to be encoded.
+     */
+    void SetMotionRecording(bool const recording) noexcept;
+
+    /*!
+     * \brief MotionDetectorStopped clears the motion detector's queue depth and recording flag.
+     *
+     * A motion detector processes any frames still queued before its destructor returns, so
+     * the depth normally drops to zero by itself. A frame whose processing threw is never
+     * counted as processed though, which would leave the depth stuck above zero for as long as
+     * the counters live, so it is forced to zero here. Must only be called once no motion
+     * detector is using the counters.
+     */
+    void MotionDetectorStopped() noexcept;
+
+    /*!
+     * \brief FrameEncoded counts a frame encoded to a video file.
+     * \param[in] encodeTime - Time taken to encode the frame.
+     */
+    void FrameEncoded(duration_t const encodeTime) noexcept;
+
+    /*!
+     * \brief SetBitrate sets the stream's bitrate.
+     * \param[in] bitrateKbps - The bitrate in kbits/s.
+     */
+    void SetBitrate(uint64_t const bitrateKbps) noexcept;
+
+    /*!
+     * \brief SetFps sets the stream's frame rates.
+     * \param[in] streamFps - The frame rate reported by the stream.
+     * \param[in] captureFps - The frame rate the stream is captured and recorded at.
+     */
+    void SetFps(double const streamFps, double const captureFps) noexcept;
+
+    /*!
+     * \brief SegmentOpened counts a video file opened for writing.
+     * \param[in] openTime - Time taken to open the file.
+     */
+    void SegmentOpened(duration_t const openTime) noexcept;
+
+    /*!
+     * \brief SegmentClosed counts a video file closed after writing.
+     * \param[in] closeTime - Time taken to close the file.
+     */
+    void SegmentClosed(duration_t const closeTime) noexcept;
+
+    /*!
+     * \brief BytesEncoded counts bytes written to a video file.
+     * \param[in] bytes - The number of bytes written since the file was last measured.
+     */
+    void BytesEncoded(uint64_t const bytes) noexcept;
+
+    /*! \brief ConnectionAttempted counts an attempt to connect to the camera. */
+    void ConnectionAttempted() noexcept;
+
+    /*! \brief ConnectionFailed counts a failed attempt to connect to the camera. */
+    void ConnectionFailed() noexcept;
+
+    /*!
+     * \brief Snapshot takes a copy of the counters.
+     * \return The current counter values.
+     *
+     * The counters are read individually so a snapshot taken while they are being updated may
+     * mix values from consecutive frames, which is fine for display purposes.
+     */
+    StreamStatsSnapshot Snapshot() const noexcept;
+
+private:
+    std::atomic<uint64_t>    m_framesGrabbed{0};
+    std::atomic<uint64_t>    m_framesDropped{0};
+    std::atomic<uint64_t>    m_decodeNanosecs{0};
+    std::atomic<uint64_t>    m_feedFramesRendered{0};
+    std::atomic<uint64_t>    m_expandedFramesRendered{0};
+    std::atomic<uint64_t>    m_feedLatencyNanosecs{0};
+    std::atomic<uint64_t>    m_expandedLatencyNanosecs{0};
+    std::atomic<int64_t>     m_motionQueueDepth{0};
+    std::atomic<uint64_t>    m_motionFramesProcessed{0};
+    std::atomic<uint64_t>    m_motionNanosecs{0};
+    std::atomic<bool>        m_motionRecording{false};
+    std::atomic<uint64_t>    m_framesEncoded{0};
+    std::atomic<uint64_t>    m_encodeNanosecs{0};
+    std::atomic<uint64_t>    m_bitrateKbps{0};
+    std::atomic<uint64_t>    m_bytesEncoded{0};
+    std::atomic<double>      m_streamFps{0.0};
+    std::atomic<double>      m_captureFps{0.0};
+    std::atomic<uint64_t>    m_connectionAttempts{0};
+    std::atomic<uint64_t>    m_connectionFailures{0};
+    IpFreelyLatencyHistogram m_decodeHistogram;
+    IpFreelyLatencyHistogram m_motionHistogram;
+    IpFreelyLatencyHistogram m_segmentOpenHistogram;
+    IpFreelyLatencyHistogram m_segmentCloseHistogram;
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYSTREAMSTATS_H
@@ -0,0 +1,279 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyTrace.cpp
+ * \brief File containing definition of IpFreelyTracer class.
+ */
+#include "IpFreelyTrace.h"
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdint>
+#include "DebugLog/DebugLogging.h"
+
+namespace ipfreely
+{
+
+namespace
+{
+
+// Spans kept per thread, about 20s worth for a GUI thread drawing 16 cameras at 25 FPS.
+static constexpr size_t THREAD_BUFFER_CAPACITY = 8192;
+
+// How long the buffers of threads that have exited are kept for.
+static constexpr std::chrono::minutes EXITED_THREAD_RETENTION{1};
+
+/*! \brief Structure holding a single recorded span. */
+struct TraceEvent
+{
+    /*! \brief The span's name, a string literal. */
+    char const* name{nullptr};
+    /*! \brief The span's camera ID, 0 if not specific to a camera. */
+    int cameraId{0};
+    /*! \brief When the span began. */
+    IpFreelyTracer::time_point_t begin{};
+    /*! \brief When the span ended. */
+    IpFreelyTracer::time_point_t end{};
+};
+
+/*! \brief Structure holding a thread's ring buffer of spans. */
+struct ThreadBuffer
+{
+    /*!
+     * \brief Only contended while a trace is being saved, the owning thread is the only
+     * writer.
+     */
+    std::mutex mutex{};
+    /*! \brief Sequential ID used as the trace's thread ID. */
+    int threadId{0};
+    /*! \brief The recorded spans. */
+    std::vector<TraceEvent> events{};
+    /*! \brief Index of the slot the next span is written to. */
+    size_t nextEvent{0};
+    /*! \brief Whether the owning thread has exited. */
+    bool exited{false};
+};
+
+/*! \brief Structure holding a thread's buffer, marking it exited when the thread exits. */
+struct ThreadBufferHandle
+{
+    ~ThreadBufferHandle()
+    {
+        if (buffer)
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            buffer->exited = true;
+        }
+    }
+
+    /*! \brief The thread's buffer, created by its first span. */
+    std::shared_ptr<ThreadBuffer> buffer{};
+};
+
+std::atomic<bool>                          g_tracingEnabled{false};
+std::mutex                                 g_buffersMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> g_buffers;
+int                                        g_nextThreadId{1};
+
+bool IsStale(ThreadBuffer const& buffer, IpFreelyTracer::time_point_t const now)
+{
+    if (!buffer.exited)
+    {
+        return false;
+    }
+
+    if (buffer.events.empty())
+    {
+        return true;
+    }
+
+    auto const lastEvent = (buffer.nextEvent + buffer.events.size() - 1) % buffer.events.size();
+    return now - buffer.events[lastEvent].end > EXITED_THREAD_RETENTION;
+}
+
+ThreadBuffer& LocalBuffer()
+{
+    static thread_local ThreadBufferHandle handle;
+
+    if (!handle.buffer)
+    {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        buffer->events.reserve(THREAD_BUFFER_CAPACITY);
+
+        auto const now = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(g_buffersMutex);
+
+        // Threads come and go as cameras reconnect, so drop the buffers of threads that
+        // exited too long ago to appear in a trace.
+        g_buffers.erase(std::remove_if(g_buffers.begin(),
+                                       g_buffers.end(),
+                                       [now](std::shared_ptr<ThreadBuffer> const& oldBuffer) {
+                                           std::lock_guard<std::mutex> oldLock(oldBuffer->mutex);
+                                           return IsStale(*oldBuffer, now);
+                                       }),
+                        g_buffers.end());
+
+        buffer->threadId = g_nextThreadId++;
+        g_buffers.emplace_back(buffer);
+        handle.buffer = buffer;
+    }
+
+    return *handle.buffer;
+}
+
+void WriteMicrosecs(std::ostream& os, int64_t const nanosecs)
+{
+    // Chrome trace timestamps are in microseconds, fractions keep nanosecond precision.
+    os << nanosecs / 1000 << '.' << std::setfill('0') << std::setw(3) << nanosecs % 1000
+       << std::setfill(' ');
+}
+
+} // namespace
+
+void IpFreelyTracer::SetEnabled(bool const enable) noexcept
+{
+    g_tracingEnabled.store(enable, std::memory_order_relaxed);
+}
+
+bool IpFreelyTracer::Enabled() noexcept
+{
+    return g_tracingEnabled.load(std::memory_order_relaxed);
+}
+
+void IpFreelyTracer::Record(char const* name, int const cameraId, time_point_t const begin,
+                            time_point_t const end) noexcept
+{
+    try
+    {
+        auto&                       buffer = LocalBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+
+        TraceEvent event;
+        event.name     = name;
+        event.cameraId = cameraId;
+        event.begin    = begin;
+        event.end      = end;
+
+        if (buffer.events.size() < THREAD_BUFFER_CAPACITY)
+        {
+            buffer.events.emplace_back(event);
+        }
+        else
+        {
+            buffer.events[buffer.nextEvent] = event;
+        }
+
+        buffer.nextEvent = (buffer.nextEvent + 1) % THREAD_BUFFER_CAPACITY;
+    }
+    catch (...)
+    {
+        // Only creating a thread's buffer can throw, in which case the span is lost.
+    }
+}
+
+std::string IpFreelyTracer::ChromeTraceJson(std::chrono::steady_clock::duration const window)
+{
+    auto const now        = std::chrono::steady_clock::now();
+    auto const windowFrom = now - window;
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+    {
+        std::lock_guard<std::mutex> lock(g_buffersMutex);
+        buffers = g_buffers;
+    }
+
+    std::ostringstream os;
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool firstEvent = true;
+
+    for (auto const& buffer : buffers)
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+
+        for (auto const& event : buffer->events)
+        {
+            if (event.begin < windowFrom)
+            {
+                continue;
+            }
+
+            auto const beginNanosecs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                           event.begin.time_since_epoch())
+                                           .count();
+            auto const durationNanosecs =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(event.end - event.begin)
+                    .count();
+
+            os << (firstEvent ? "\n" : ",\n");
+            os << "{\"name\":\"" << event.name << "\",\"cat\":\"ipfreely\",\"ph\":\"X\",\"ts\":";
+            firstEvent = false;
+
+            WriteMicrosecs(os, beginNanosecs);
+            os << ",\"dur\":";
+            WriteMicrosecs(os, durationNanosecs);
+            os << ",\"pid\":1,\"tid\":" << buffer->threadId;
+
+            if (event.cameraId != 0)
+            {
+                os << ",\"args\":{\"camera\":" << event.cameraId << '}';
+            }
+
+            os << '}';
+        }
+    }
+
+    os << "\n]}\n";
+    return os.str();
+}
+
+bool IpFreelyTracer::SaveChromeTrace(std::string const&                        filePath,
+                                     std::chrono::steady_clock::duration const window)
+{
+    std::ofstream file(filePath, std::ios::out | std::ios::trunc);
+
+    if (!file)
+    {
+        DEBUG_MESSAGE_EX_ERROR("Failed to open trace file: " << filePath);
+        return false;
+    }
+
+    file << ChromeTraceJson(window);
+    file.close();
+
+    if (!file)
+    {
+        DEBUG_MESSAGE_EX_ERROR("Failed to write trace file: " << filePath);
+        return false;
+    }
+
+    DEBUG_MESSAGE_EX_INFO("Saved trace file: " << filePath);
+    return true;
+}
+
+} // namespace ipfreely
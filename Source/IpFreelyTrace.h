@@ -0,0 +1,162 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyTrace.h
+ * \brief File containing declaration of IpFreelyTracer and IpFreelyTraceScope classes.
+ */
+#ifndef IPFREELYTRACE_H
+#define IPFREELYTRACE_H
+
+#include <chrono>
+#include <string>
+
+/*!
+ * \def IPFREELY_TRACE_SCOPE(name)
+ * \brief Traces the enclosing scope as a span named by the given string literal.
+ *
+ * \def IPFREELY_TRACE_SCOPE_ID(name, cameraId)
+ * \brief Traces the enclosing scope as a span of the given camera.
+ *
+ * Both expand to nothing unless IPFREELY_ENABLE_TRACING is defined. When compiled in, a trace
+ * point costs a single relaxed atomic load while recording is stopped.
+ */
+#ifdef IPFREELY_ENABLE_TRACING
+#define IPFREELY_TRACE_CONCAT_IMPL(a, b) a##b
+#define IPFREELY_TRACE_CONCAT(a, b) IPFREELY_TRACE_CONCAT_IMPL(a, b)
+#define IPFREELY_TRACE_SCOPE(name)                                                           \
+    ipfreely::IpFreelyTraceScope IPFREELY_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define IPFREELY_TRACE_SCOPE_ID(name, cameraId)                                              \
+    ipfreely::IpFreelyTraceScope IPFREELY_TRACE_CONCAT(traceScope, __LINE__)(name, cameraId)
+#else
+#define IPFREELY_TRACE_SCOPE(name)
+#define IPFREELY_TRACE_SCOPE_ID(name, cameraId)
+#endif
+
+/*! \brief The ipfreely namespace. */
+namespace ipfreely
+{
+
+/*! \brief Default length of time covered by a saved trace. */
+static constexpr std::chrono::seconds DEFAULT_TRACE_WINDOW{10};
+
+/*! \brief Class defining the process wide recorder of trace spans. */
+class IpFreelyTracer final
+{
+public:
+    /*! \brief Typedef for the trace clock's time points. */
+    typedef std::chrono::steady_clock::time_point time_point_t;
+
+    /*! \brief IpFreelyTracer deleted constructor, the class only has static members. */
+    IpFreelyTracer() = delete;
+
+    /*!
+     * \brief SetEnabled starts or stops recording spans.
+     * \param[in] enable - True to start recording, false to stop.
+     *
+     * Spans already recorded are kept when recording stops, so they can still be saved.
+     */
+    static void SetEnabled(bool const enable) noexcept;
+
+    /*!
+     * \brief Enabled reports if spans are being recorded.
+     * \return True if recording, false otherwise.
+     *
+     * This is the only work a trace point does while recording is stopped.
+     */
+    static bool Enabled() noexcept;
+
+    /*!
+     * \brief Record adds a span to the calling thread's ring buffer.
+     * \param[in] name - The span's name, must be a string literal.
+     * \param[in] cameraId - The span's camera ID, 0 if it is not specific to a camera.
+     * \param[in] begin - When the span began.
+     * \param[in] end - When the span ended.
+     *
+     * Every thread records into its own fixed size ring buffer, so recording never allocates
+     * after a thread's first span and threads never contend with each other. The oldest
+     * spans are overwritten once a thread's buffer is full.
+     */
+    static void Record(char const* name, int const cameraId, time_point_t const begin,
+                       time_point_t const end) noexcept;
+
+    /*!
+     * \brief ChromeTraceJson renders recent spans in the Chrome trace event format.
+     * \param[in] window - How far back from now to include spans.
+     * \return The JSON text, which can be opened in chrome://tracing or Perfetto.
+     */
+    static std::string ChromeTraceJson(std::chrono::steady_clock::duration const window);
+
+    /*!
+     * \brief SaveChromeTrace saves recent spans to a Chrome trace event format file.
+     * \param[in] filePath - The file to write.
+     * \param[in] window - How far back from now to include spans.
+     * \return True if the file was written, false otherwise.
+     */
+    static bool SaveChromeTrace(std::string const&                        filePath,
+                                std::chrono::steady_clock::duration const window);
+};
+
+/*! \brief Class defining a scoped trace span, normally created using IPFREELY_TRACE_SCOPE. */
+class IpFreelyTraceScope final
+{
+public:
+    /*!
+     * \brief IpFreelyTraceScope constructor.
+     * \param[in] name - The span's name, must be a string literal.
+     * \param[in] cameraId - (Optional) The span's camera ID.
+     *
+     * The span begins now and ends when the scope is destroyed. Nothing is recorded, and the
+     * clock is never read, if recording was stopped when the scope was created.
+     */
+    explicit IpFreelyTraceScope(char const* name, int const cameraId = 0) noexcept
+        : m_name(IpFreelyTracer::Enabled() ? name : nullptr)
+        , m_cameraId(cameraId)
+    {
+        if (m_name)
+        {
+            m_begin = std::chrono::steady_clock::now();
+        }
+    }
+
+    /*! \brief IpFreelyTraceScope destructor. */
+    ~IpFreelyTraceScope()
+    {
+        if (m_name)
+        {
+            IpFreelyTracer::Record(m_name, m_cameraId, m_begin, std::chrono::steady_clock::now());
+        }
+    }
+
+    /*! \brief IpFreelyTraceScope deleted copy constructor. */
+    IpFreelyTraceScope(IpFreelyTraceScope const&) = delete;
+
+    /*! \brief IpFreelyTraceScope deleted copy assignment operator. */
+    IpFreelyTraceScope& operator=(IpFreelyTraceScope const&) = delete;
+
+private:
+    char const*                  m_name;
+    int                          m_cameraId;
+    IpFreelyTracer::time_point_t m_begin{};
+};
+
+} // namespace ipfreely
+
+#endif // IPFREELYTRACE_H
@@ -28,22 +28,47 @@
 #include <QLayoutItem>
 #include <QLabel>
 #include <QShowEvent>
+#include <QEvent>
 #include <QScreen>
-#include <QPainter>
-#include <QPen>
-#include <QBrush>
-#include "IpFreelyCameraDatabase.h"
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+// Maximum digital zoom, beyond this the video's own resolution is the limiting factor.
+constexpr double MAX_ZOOM = 8.0;
+
+// Zoom factor applied per standard mouse wheel step.
+constexpr double ZOOM_STEP = 1.25;
+
+// Offset of the performance overlay from the video's top left corner.
+constexpr int HUD_MARGIN = 8;
+
+} // namespace
 
 IpFreelyVideoForm::IpFreelyVideoForm(QWidget* parent)
     : QWidget(parent)
     , ui(new Ui::IpFreelyVideoForm)
     , m_resetSize(true)
     , m_videoFrame(new QLabel(this))
-
+    , m_hudLabel(new QLabel(m_videoFrame))
+    , m_zoom(1.0)
+    , m_zoomCentre(0.5, 0.5)
+    , m_panning(false)
 {
     ui->setupUi(this);
+    m_videoFrame->setAlignment(Qt::AlignCenter);
     layout()->addWidget(m_videoFrame);
 
+    // The overlay is a child of the video label so it is always drawn on top of the video.
+    m_hudLabel->setStyleSheet("QLabel { background-color: rgba(0, 0, 0, 160); color: white; "
+                              "padding: 4px; }");
+    m_hudLabel->move(HUD_MARGIN, HUD_MARGIN);
+    m_hudLabel->hide();
+
     Qt::WindowFlags flags = this->windowFlags();
     flags                 = flags & ~Qt::WindowContextHelpButtonHint;
     this->setWindowFlags(flags);
@@ -54,16 +79,21 @@ IpFreelyVideoForm::~IpFreelyVideoForm()
     delete ui;
 }
 
-void IpFreelyVideoForm::SetVideoFrame(QImage const& videoFrame, double fps, double originalFps,
-                                      QRect const& motionBoundingRect, bool streamBeingWritten,
-                                      regions_t const& motionRegions)
+void IpFreelyVideoForm::SetVideoFrame(QImage const& displayFrame, QSize const& videoSize,
+                                      double fps, double originalFps)
 {
     auto title = m_title + ": " + QString::number(fps) + tr(" Recording FPS, ") +
                  QString::number(originalFps) + tr(" Stream FPS");
+
+    if (m_zoom > 1.0)
+    {
+        title += tr(", Zoom x") + QString::number(m_zoom, 'f', 1);
+    }
+
     setWindowTitle(title);
 
     double frameAspectRatio =
-        static_cast<double>(videoFrame.width()) / static_cast<double>(videoFrame.height());
+        static_cast<double>(videoSize.width()) / static_cast<double>(videoSize.height());
 
     if (m_resetSize)
     {
@@ -76,13 +106,13 @@ void IpFreelyVideoForm::SetVideoFrame(QImage const& videoFrame, double fps, doub
                                            (layout()->contentsMargins().top() +
                                             layout()->contentsMargins().bottom() + 2));
 
-        if (videoFrame.height() >= static_cast<int>(h))
+        if (videoSize.height() >= static_cast<int>(h))
         {
             w = h * frameAspectRatio;
         }
         else
         {
-            h = videoFrame.height() + layout()->contentsMargins().top() +
+            h = videoSize.height() + layout()->contentsMargins().top() +
                 layout()->contentsMargins().bottom() + 2;
             w = h * frameAspectRatio;
         }
@@ -91,72 +121,45 @@ void IpFreelyVideoForm::SetVideoFrame(QImage const& videoFrame, double fps, doub
         setMaximumSize(static_cast<int>(w), static_cast<int>(h));
     }
 
-    double scalar =
-        static_cast<double>(m_videoFrame->height()) / static_cast<double>(videoFrame.height());
-
-    auto resizedImage = videoFrame.scaled(m_videoFrame->width(),
-                                          m_videoFrame->height(),
-                                          Qt::KeepAspectRatio,
-                                          Qt::SmoothTransformation);
+    m_displayFrameSize = displayFrame.size();
+    m_videoFrame->setPixmap(QPixmap::fromImage(displayFrame));
+}
 
-    QPainter p(&resizedImage);
-    auto     rect                   = motionBoundingRect;
-    bool     intersectsMotionRegion = false;
+QSize IpFreelyVideoForm::DisplaySize() const
+{
+    return m_videoFrame->size();
+}
 
-    if (!motionBoundingRect.isNull())
+void IpFreelyVideoForm::SetHudText(QString const& hudText)
+{
+    if (hudText.isEmpty())
     {
-        rect.setTop(static_cast<int>(static_cast<double>(motionBoundingRect.top()) * scalar));
-        rect.setLeft(static_cast<int>(static_cast<double>(motionBoundingRect.left()) * scalar));
-        rect.setRight(static_cast<int>(static_cast<double>(motionBoundingRect.right()) * scalar));
-        rect.setBottom(static_cast<int>(static_cast<double>(motionBoundingRect.bottom()) * scalar));
+        m_hudLabel->hide();
+        return;
     }
 
-    if (!motionRegions.empty())
+    if (m_hudLabel->text() != hudText)
     {
-        auto pen = QPen(Qt::cyan);
-        pen.setWidth(2);
-        p.setPen(pen);
-        p.setBackground(QBrush(Qt::NoBrush));
-        p.setBackgroundMode(Qt::TransparentMode);
-        p.setBrush(QBrush(Qt::NoBrush));
-
-        for (auto const& motionRegion : motionRegions)
-        {
-            auto r = ipfreely::CreateQRectFromVideoFrameDims(
-                resizedImage.width(), resizedImage.height(), motionRegion);
-
-            if (rect.intersects(r))
-            {
-                intersectsMotionRegion = true;
-            }
-
-            p.drawRect(r);
-        }
+        m_hudLabel->setText(hudText);
+        m_hudLabel->adjustSize();
     }
 
-    if (!rect.isNull())
-    {
-        auto pen = QPen(intersectsMotionRegion ? Qt::red : Qt::green);
-        pen.setWidth(2);
-        p.setPen(pen);
-        p.setBackground(QBrush(Qt::NoBrush));
-        p.setBackgroundMode(Qt::TransparentMode);
-        p.setBrush(QBrush(Qt::NoBrush));
-        p.drawRect(rect);
-    }
+    m_hudLabel->show();
+}
 
-    if (streamBeingWritten)
+QRectF IpFreelyVideoForm::DisplayRegion() const
+{
+    if (m_zoom <= 1.0)
     {
-        p.setPen(QPen(Qt::red));
-        p.setBackground(QBrush(Qt::white, Qt::SolidPattern));
-        p.setBackgroundMode(Qt::OpaqueMode);
-        p.setFont(QFont("Segoe UI", 16, QFont::Bold));
-        auto posRec = resizedImage.rect();
-        posRec.setTop(posRec.top() + 16);
-        p.drawText(posRec, Qt::AlignHCenter | Qt::AlignTop, tr("Recording").toLocal8Bit());
+        return QRectF();
     }
 
-    m_videoFrame->setPixmap(QPixmap::fromImage(resizedImage));
+    auto const regionSize = 1.0 / m_zoom;
+
+    return QRectF(m_zoomCentre.x() - (regionSize / 2.0),
+                  m_zoomCentre.y() - (regionSize / 2.0),
+                  regionSize,
+                  regionSize);
 }
 
 void IpFreelyVideoForm::SetTitle(QString const& title)
@@ -168,6 +171,150 @@ void IpFreelyVideoForm::SetTitle(QString const& title)
 void IpFreelyVideoForm::showEvent(QShowEvent* event)
 {
     m_resetSize = true;
+    ResetZoom();
 
     QWidget::showEvent(event);
 }
+
+void IpFreelyVideoForm::changeEvent(QEvent* event)
+{
+    QWidget::changeEvent(event);
+
+    if (event->type() == QEvent::WindowStateChange)
+    {
+        emit WindowStateChanged();
+    }
+}
+
+void IpFreelyVideoForm::wheelEvent(QWheelEvent* event)
+{
+    auto const steps = static_cast<double>(event->angleDelta().y()) / 120.0;
+
+    if (steps == 0.0)
+    {
+        event->ignore();
+        return;
+    }
+
+    auto const zoom = std::min(std::max(m_zoom * std::pow(ZOOM_STEP, steps), 1.0), MAX_ZOOM);
+
+    // Keep the part of the video under the cursor fixed while zooming.
+    auto const cursorPos     = DisplayFramePosition(event->pos());
+    auto const oldRegionSize = 1.0 / m_zoom;
+    auto const framePos =
+        QPointF(m_zoomCentre.x() + ((cursorPos.x() - 0.5) * oldRegionSize),
+                m_zoomCentre.y() + ((cursorPos.y() - 0.5) * oldRegionSize));
+    auto const regionSize = 1.0 / zoom;
+
+    SetZoom(zoom,
+            QPointF(framePos.x() + ((0.5 - cursorPos.x()) * regionSize),
+                    framePos.y() + ((0.5 - cursorPos.y()) * regionSize)));
+
+    event->accept();
+}
+
+void IpFreelyVideoForm::mousePressEvent(QMouseEvent* event)
+{
+    if ((event->button() != Qt::LeftButton) || (m_zoom <= 1.0))
+    {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+
+    m_panning         = true;
+    m_panOrigin       = event->pos();
+    m_panOriginCentre = m_zoomCentre;
+    setCursor(Qt::ClosedHandCursor);
+}
+
+void IpFreelyVideoForm::mouseMoveEvent(QMouseEvent* event)
+{
+    if (!m_panning || m_displayFrameSize.isEmpty())
+    {
+        QWidget::mouseMoveEvent(event);
+        return;
+    }
+
+    // Dragging moves the video with the cursor so the region moves the opposite way.
+    auto const delta      = event->pos() - m_panOrigin;
+    auto const regionSize = 1.0 / m_zoom;
+
+    SetZoom(m_zoom,
+            QPointF(m_panOriginCentre.x() - (static_cast<double>(delta.x()) * regionSize /
+                                             static_cast<double>(m_displayFrameSize.width())),
+                    m_panOriginCentre.y() - (static_cast<double>(delta.y()) * regionSize /
+                                             static_cast<double>(m_displayFrameSize.height()))));
+}
+
+void IpFreelyVideoForm::mouseReleaseEvent(QMouseEvent* event)
+{
+    if (!m_panning || (event->button() != Qt::LeftButton))
+    {
+        QWidget::mouseReleaseEvent(event);
+        return;
+    }
+
+    m_panning = false;
+    setCursor(Qt::OpenHandCursor);
+}
+
+void IpFreelyVideoForm::mouseDoubleClickEvent(QMouseEvent* event)
+{
+    if (event->button() != Qt::LeftButton)
+    {
+        QWidget::mouseDoubleClickEvent(event);
+        return;
+    }
+
+    ResetZoom();
+}
+
+void IpFreelyVideoForm::ResetZoom()
+{
+    m_panning = false;
+    SetZoom(1.0, QPointF(0.5, 0.5));
+}
+
+void IpFreelyVideoForm::SetZoom(double const zoom, QPointF const& zoomCentre)
+{
+    m_zoom = zoom;
+
+    // Keep the whole region within the video frame.
+    auto const halfRegionSize = 0.5 / m_zoom;
+    m_zoomCentre =
+        QPointF(std::min(std::max(zoomCentre.x(), halfRegionSize), 1.0 - halfRegionSize),
+                std::min(std::max(zoomCentre.y(), halfRegionSize), 1.0 - halfRegionSize));
+
+    if (m_panning)
+    {
+        return;
+    }
+
+    if (m_zoom > 1.0)
+    {
+        setCursor(Qt::OpenHandCursor);
+    }
+    else
+    {
+        unsetCursor();
+    }
+}
+
+QPointF IpFreelyVideoForm::DisplayFramePosition(QPoint const& pos) const
+{
+    if (m_displayFrameSize.isEmpty())
+    {
+        return QPointF(0.5, 0.5);
+    }
+
+    // The display frame is centred within the video label.
+    auto frameRect = QRect(QPoint(0, 0), m_displayFrameSize);
+    frameRect.moveCenter(m_videoFrame->geometry().center());
+
+    auto const x = static_cast<double>(pos.x() - frameRect.left()) /
+                   static_cast<double>(frameRect.width());
+    auto const y = static_cast<double>(pos.y() - frameRect.top()) /
+                   static_cast<double>(frameRect.height());
+
+    return QPointF(std::min(std::max(x, 0.0), 1.0), std::min(std::max(y, 0.0), 1.0));
+}
@@ -26,8 +26,10 @@
 #define IPFREELYVIDEOFORM_H
 
 #include <QWidget>
-#include <utility>
-#include <vector>
+#include <QSize>
+#include <QPoint>
+#include <QPointF>
+#include <QRectF>
 
 // Forward declarations.
 namespace Ui
@@ -37,22 +39,16 @@ class IpFreelyVideoForm;
 
 class QImage;
 class QShowEvent;
+class QEvent;
 class QLabel;
+class QWheelEvent;
+class QMouseEvent;
 
 /*! \brief Class defining a expanded video display form. */
 class IpFreelyVideoForm : public QWidget
 {
     Q_OBJECT
 
-    /*! \brief Typedef to a point pair. */
-    typedef std::pair<double, double> point_t;
-
-    /*! \brief Typedef to a region pair. */
-    typedef std::pair<point_t /*left,top*/, point_t /*width,height*/> region_t;
-
-    /*! \brief Typedef to a a vector of region pairs. */
-    typedef std::vector<region_t> regions_t;
-
 public:
     /*!
      * \brief IpFreelyVideoForm constructor.
@@ -65,16 +61,31 @@ public:
 
     /*!
      * \brief SetVideoFrame sets the current frame of video in the display.
-     * \param[in] videoFrame - The frame of video to display.
+     * \param[in] displayFrame - The display-ready frame of video to display.
+     * \param[in] videoSize - The video stream's full frame size.
      * \param[in] fps - The video stream's recording FPS.
      * \param[in] originalFps - The video stream's actual FPS.
-     * \param[in] motionBoundingRect - The video stream's detected motion bounding rectangle.
-     * \param[in] streamBeingWritten - The video stream is currently having data recorded.
-     * \param[in] motionRegions - (Optional) The motion rectangles being monitored.
+     *
+     * The display frame is expected to have already been scaled to DisplaySize() and to
+     * have had any overlays drawn on it by the stream processor.
      */
-    void SetVideoFrame(QImage const& videoFrame, double fps, double originalFps,
-                       QRect const& motionBoundingRect, bool streamBeingWritten,
-                       regions_t const& motionRegions = {});
+    void SetVideoFrame(QImage const& displayFrame, QSize const& videoSize, double fps,
+                       double originalFps);
+
+    /*!
+     * \brief DisplaySize gives the size of the area available to display video.
+     * \return The display area's size.
+     */
+    QSize DisplaySize() const;
+
+    /*!
+     * \brief DisplayRegion gives the region of the video frame the user has zoomed in to.
+     * \return The region as fractions of the video frame, empty when not zoomed in.
+     *
+     * The mouse wheel zooms in and out about the cursor, dragging pans the zoomed in view and
+     * double clicking resets the zoom. The zoom is also reset whenever the form is shown.
+     */
+    QRectF DisplayRegion() const;
 
     /*!
      * \brief SetTitle sets title text of the form.
@@ -82,17 +93,43 @@ public:
      */
     void SetTitle(QString const& title);
 
+    /*!
+     * \brief SetHudText sets the performance overlay text drawn over the video.
+     * \param[in] hudText - The overlay's text, one statistic per line, empty to hide it.
+     */
+    void SetHudText(QString const& hudText);
+
+signals:
+    /*! \brief WindowStateChanged is emitted when the form is minimised or restored. */
+    void WindowStateChanged();
+
 protected:
     virtual void showEvent(QShowEvent* event);
+    virtual void changeEvent(QEvent* event);
+    virtual void wheelEvent(QWheelEvent* event);
+    virtual void mousePressEvent(QMouseEvent* event);
+    virtual void mouseMoveEvent(QMouseEvent* event);
+    virtual void mouseReleaseEvent(QMouseEvent* event);
+    virtual void mouseDoubleClickEvent(QMouseEvent* event);
 
 private:
-    void SetDisplaySize();
+    void    SetDisplaySize();
+    void    ResetZoom();
+    void    SetZoom(double const zoom, QPointF const& zoomCentre);
+    QPointF DisplayFramePosition(QPoint const& pos) const;
 
 private:
     Ui::IpFreelyVideoForm* ui;
     bool                   m_resetSize;
     QLabel*                m_videoFrame;
+    QLabel*                m_hudLabel;
     QString                m_title;
+    QSize                  m_displayFrameSize;
+    double                 m_zoom;
+    QPointF                m_zoomCentre;
+    bool                   m_panning;
+    QPoint                 m_panOrigin;
+    QPointF                m_panOriginCentre;
 };
 
 #endif // IPFREELYVIDEOFORM_H
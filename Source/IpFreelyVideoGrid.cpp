@@ -0,0 +1,602 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyVideoGrid.cpp
+ * \brief File containing definition of IpFreelyVideoGrid widget.
+ */
+#include "IpFreelyVideoGrid.h"
+#include <QApplication>
+#include <QPainter>
+#include <QPen>
+#include <QColor>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QMouseEvent>
+#include <QHelpEvent>
+#include <QToolTip>
+#include <QRubberBand>
+#include <QTimer>
+#include <QScreen>
+#include <QRectF>
+#include <QSize>
+#include <algorithm>
+#include <cmath>
+#include "IpFreelyTrace.h"
+
+namespace
+{
+
+static constexpr int    AREA_RECT_LINE_WIDTH = 2;
+static constexpr int    TILE_SPACING         = 4;
+static constexpr int    TILE_BORDER_WIDTH    = 2;
+static constexpr int    CAPTION_PADDING      = 4;
+static constexpr int    HUD_PADDING          = 4;
+static constexpr int    HUD_BACKGROUND_ALPHA = 160;
+static constexpr int    STALE_DIM_ALPHA      = 128;
+static constexpr double DEFAULT_REFRESH_RATE = 60.0;
+
+int RefreshPeriodMs(QWidget const* widget)
+{
+    auto screen = qApp->screenAt(widget->mapToGlobal(widget->rect().center()));
+
+    if (!screen)
+    {
+        screen = qApp->primaryScreen();
+    }
+
+    auto refreshRate = screen ? screen->refreshRate() : DEFAULT_REFRESH_RATE;
+
+    if (refreshRate < 1.0)
+    {
+        refreshRate = DEFAULT_REFRESH_RATE;
+    }
+
+    return static_cast<int>(std::ceil(1000.0 / refreshRate));
+}
+
+QPoint ClampToRect(QPoint const& pos, QRect const& rect)
+{
+    return QPoint(std::min(std::max(pos.x(), rect.left()), rect.right()),
+                  std::min(std::max(pos.y(), rect.top()), rect.bottom()));
+}
+
+} // namespace
+
+IpFreelyVideoGrid::IpFreelyVideoGrid(QWidget* parent)
+    : QWidget(parent)
+    , m_numSlots(0)
+    , m_currentCameraId(0)
+    , m_selectionCameraId(0)
+    , m_rubberBand(nullptr)
+    , m_repaintTimer(new QTimer(this))
+{
+    // We paint every pixel ourselves so Qt need not erase the background first.
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+    m_repaintTimer->setSingleShot(true);
+    connect(m_repaintTimer, &QTimer::timeout, this, &IpFreelyVideoGrid::FlushDirtyRegion);
+}
+
+void IpFreelyVideoGrid::SetCameraIds(std::vector<int> const& cameraIds, int const numSlots)
+{
+    std::vector<Tile> tiles;
+    tiles.reserve(cameraIds.size());
+
+    for (auto cameraId : cameraIds)
+    {
+        auto existingTile = FindTile(cameraId);
+
+        if (existingTile)
+        {
+            tiles.emplace_back(std::move(*existingTile));
+        }
+        else
+        {
+            Tile tile;
+            tile.cameraId = cameraId;
+            tiles.emplace_back(std::move(tile));
+        }
+    }
+
+    m_tiles.swap(tiles);
+    m_numSlots = numSlots;
+
+    if (!FindTile(m_currentCameraId))
+    {
+        m_currentCameraId = m_tiles.empty() ? 0 : m_tiles.front().cameraId;
+    }
+
+    if (!FindTile(m_selectionCameraId))
+    {
+        m_selectionCameraId = 0;
+
+        if (m_rubberBand)
+        {
+            m_rubberBand->hide();
+        }
+    }
+
+    LayoutTiles();
+    update();
+}
+
+void IpFreelyVideoGrid::SetVideoFrame(int const cameraId, QImage const& videoFrame)
+{
+    auto tile = FindTile(cameraId);
+
+    if (!tile)
+    {
+        return;
+    }
+
+    tile->videoFrame = videoFrame;
+    tile->stale      = false;
+    tile->staleText.clear();
+    InvalidateTile(*tile);
+}
+
+void IpFreelyVideoGrid::ClearVideoFrame(int const cameraId)
+{
+    auto tile = FindTile(cameraId);
+
+    if (!tile || tile->videoFrame.isNull())
+    {
+        return;
+    }
+
+    tile->videoFrame = QImage();
+    tile->stale      = false;
+    tile->staleText.clear();
+    InvalidateTile(*tile);
+}
+
+void IpFreelyVideoGrid::SetStaleVideoFrame(int const cameraId, QImage const& videoFrame,
+                                           QString const& staleText)
+{
+    auto tile = FindTile(cameraId);
+
+    if (!tile)
+    {
+        return;
+    }
+
+    tile->videoFrame = videoFrame;
+    tile->stale      = !videoFrame.isNull();
+    tile->staleText  = tile->stale ? staleText : QString();
+    InvalidateTile(*tile);
+}
+
+void IpFreelyVideoGrid::SetTitle(int const cameraId, QString const& title)
+{
+    auto tile = FindTile(cameraId);
+
+    if (!tile || (tile->title == title))
+    {
+        return;
+    }
+
+    tile->title = title;
+    InvalidateTile(*tile);
+}
+
+void IpFreelyVideoGrid::SetToolTip(int const cameraId, QString const& toolTip)
+{
+    auto tile = FindTile(cameraId);
+
+    if (tile)
+    {
+        tile->toolTip = toolTip;
+    }
+}
+
+void IpFreelyVideoGrid::SetHudText(int const cameraId, QString const& hudText)
+{
+    auto tile = FindTile(cameraId);
+
+    if (!tile || (tile->hudText == hudText))
+    {
+        return;
+    }
+
+    tile->hudText = hudText;
+    InvalidateTile(*tile);
+}
+
+void IpFreelyVideoGrid::SetEnableSelection(int const cameraId, bool const enable)
+{
+    auto tile = FindTile(cameraId);
+
+    if (!tile)
+    {
+        return;
+    }
+
+    tile->enableSelection = enable;
+
+    if (!enable && (m_selectionCameraId == cameraId))
+    {
+        m_selectionCameraId = 0;
+
+        if (m_rubberBand)
+        {
+            m_rubberBand->hide();
+        }
+    }
+}
+
+void IpFreelyVideoGrid::SetCurrentCameraId(int const cameraId)
+{
+    if (cameraId == m_currentCameraId)
+    {
+        return;
+    }
+
+    auto tile = FindTile(cameraId);
+
+    if (!tile)
+    {
+        return;
+    }
+
+    auto previousTile = FindTile(m_currentCameraId);
+    m_currentCameraId = cameraId;
+
+    if (previousTile)
+    {
+        InvalidateTile(*previousTile);
+    }
+
+    InvalidateTile(*tile);
+}
+
+int IpFreelyVideoGrid::CurrentCameraId() const
+{
+    return m_currentCameraId;
+}
+
+QSize IpFreelyVideoGrid::VideoDisplaySize(int const cameraId) const
+{
+    auto tile = FindTile(cameraId);
+    return tile ? tile->videoRect.size() : QSize();
+}
+
+bool IpFreelyVideoGrid::event(QEvent* event)
+{
+    if (event->type() == QEvent::ToolTip)
+    {
+        auto helpEvent = static_cast<QHelpEvent*>(event);
+        auto tile      = TileAt(helpEvent->pos());
+
+        if (tile && !tile->toolTip.isEmpty())
+        {
+            QToolTip::showText(helpEvent->globalPos(), tile->toolTip, this, tile->tileRect);
+        }
+        else
+        {
+            QToolTip::hideText();
+            event->ignore();
+        }
+
+        return true;
+    }
+
+    return QWidget::event(event);
+}
+
+void IpFreelyVideoGrid::paintEvent(QPaintEvent* event)
+{
+    IPFREELY_TRACE_SCOPE("PaintVideoGrid");
+
+    QPainter p(this);
+    p.fillRect(event->rect(), palette().window());
+
+    auto const captionHeight = fontMetrics().height() + CAPTION_PADDING;
+
+    for (auto const& tile : m_tiles)
+    {
+        if (!event->region().intersects(tile.tileRect))
+        {
+            continue;
+        }
+
+        p.fillRect(tile.videoRect, Qt::black);
+
+        if (!tile.videoFrame.isNull())
+        {
+            // Frames normally arrive already scaled to the tile so this is a straight blit.
+            p.drawImage(FrameRect(tile), tile.videoFrame);
+
+            if (tile.stale)
+            {
+                auto const frameRect = FrameRect(tile);
+                p.fillRect(frameRect, QColor(0, 0, 0, STALE_DIM_ALPHA));
+                p.setPen(Qt::white);
+                p.drawText(frameRect.adjusted(HUD_PADDING, HUD_PADDING, -HUD_PADDING, -HUD_PADDING),
+                           Qt::AlignHCenter | Qt::AlignBottom | Qt::TextWordWrap,
+                           tile.staleText);
+            }
+        }
+
+        if (!tile.hudText.isEmpty())
+        {
+            auto const textRect = p.boundingRect(
+                tile.videoRect.adjusted(HUD_PADDING, HUD_PADDING, -HUD_PADDING, -HUD_PADDING),
+                Qt::AlignLeft | Qt::AlignTop,
+                tile.hudText);
+
+            p.fillRect(textRect.adjusted(-HUD_PADDING, -HUD_PADDING, HUD_PADDING, HUD_PADDING)
+                           .intersected(tile.videoRect),
+                       QColor(0, 0, 0, HUD_BACKGROUND_ALPHA));
+            p.setPen(Qt::white);
+            p.drawText(textRect, Qt::AlignLeft | Qt::AlignTop, tile.hudText);
+        }
+
+        QRect captionRect(tile.tileRect.left() + TILE_BORDER_WIDTH + CAPTION_PADDING,
+                          tile.tileRect.top() + TILE_BORDER_WIDTH,
+                          tile.tileRect.width() - (2 * (TILE_BORDER_WIDTH + CAPTION_PADDING)),
+                          captionHeight);
+
+        p.setPen(palette().windowText().color());
+        p.drawText(captionRect,
+                   Qt::AlignLeft | Qt::AlignVCenter,
+                   fontMetrics().elidedText(tile.title, Qt::ElideRight, captionRect.width()));
+
+        bool const isCurrent = tile.cameraId == m_currentCameraId;
+        QPen       pen(isCurrent ? palette().highlight().color() : palette().mid().color());
+        pen.setWidth(TILE_BORDER_WIDTH);
+        p.setPen(pen);
+        p.setBrush(Qt::NoBrush);
+        p.drawRect(tile.tileRect.adjusted(1, 1, -1, -1));
+    }
+}
+
+void IpFreelyVideoGrid::resizeEvent(QResizeEvent* event)
+{
+    LayoutTiles();
+
+    QWidget::resizeEvent(event);
+}
+
+void IpFreelyVideoGrid::mousePressEvent(QMouseEvent* event)
+{
+    auto tile = TileAt(event->pos());
+
+    if (!tile)
+    {
+        return;
+    }
+
+    if (tile->cameraId != m_currentCameraId)
+    {
+        SetCurrentCameraId(tile->cameraId);
+        emit CurrentCameraChanged(tile->cameraId);
+    }
+
+    auto const frameRect = FrameRect(*tile);
+
+    if (!tile->enableSelection || (event->button() != Qt::LeftButton) || frameRect.isEmpty())
+    {
+        return;
+    }
+
+    m_selectionCameraId = tile->cameraId;
+    m_origin            = ClampToRect(event->pos(), frameRect);
+
+    if (!m_rubberBand)
+    {
+        m_rubberBand = new QRubberBand(QRubberBand::Rectangle, this);
+    }
+
+    m_rubberBand->setGeometry(QRect(m_origin, QSize()));
+    m_rubberBand->show();
+}
+
+void IpFreelyVideoGrid::mouseMoveEvent(QMouseEvent* event)
+{
+    auto tile = FindTile(m_selectionCameraId);
+
+    if (!tile || !m_rubberBand)
+    {
+        return;
+    }
+
+    auto const pos = ClampToRect(event->pos(), FrameRect(*tile));
+    m_rubberBand->setGeometry(QRect(m_origin, pos).normalized());
+}
+
+void IpFreelyVideoGrid::mouseReleaseEvent(QMouseEvent* /*event*/)
+{
+    auto tile           = FindTile(m_selectionCameraId);
+    m_selectionCameraId = 0;
+
+    if (!tile || !m_rubberBand)
+    {
+        return;
+    }
+
+    auto selection = m_rubberBand->geometry();
+    m_rubberBand->hide();
+
+    auto const frameRect = FrameRect(*tile);
+
+    if (frameRect.isEmpty())
+    {
+        return;
+    }
+
+    // Make the selection relative to the video frame's origin.
+    selection.translate(-frameRect.topLeft());
+
+    auto const maxHeight    = frameRect.height() - selection.top() - AREA_RECT_LINE_WIDTH;
+    auto       actualHeight = selection.height();
+
+    if (actualHeight > maxHeight)
+    {
+        actualHeight = maxHeight;
+    }
+
+    auto const maxWidth    = frameRect.width() - selection.left() - AREA_RECT_LINE_WIDTH;
+    auto       actualWidth = selection.width();
+
+    if (actualWidth > maxWidth)
+    {
+        actualWidth = maxWidth;
+    }
+
+    double t = static_cast<double>(selection.top()) / static_cast<double>(frameRect.height());
+    double l = static_cast<double>(selection.left()) / static_cast<double>(frameRect.width());
+    double h = static_cast<double>(actualHeight) / static_cast<double>(frameRect.height());
+    double w = static_cast<double>(actualWidth) / static_cast<double>(frameRect.width());
+
+    if ((t >= 1.0) || (l >= 1.0) || (h >= 1.0) || (w >= 1.0) || (t + h > 1.0) || (l + w) > 1.0 ||
+        (h <= 0.0) || (w <= 0.0))
+    {
+        return;
+    }
+
+    emit AreaSelected(tile->cameraId, QRectF(l, t, w, h));
+}
+
+void IpFreelyVideoGrid::mouseDoubleClickEvent(QMouseEvent* event)
+{
+    auto tile = TileAt(event->pos());
+
+    if (tile)
+    {
+        emit CameraActivated(tile->cameraId);
+    }
+}
+
+void IpFreelyVideoGrid::LayoutTiles()
+{
+    if (m_tiles.empty())
+    {
+        return;
+    }
+
+    auto const numTiles = static_cast<int>(m_tiles.size());
+    auto const numSlots = std::max(numTiles, m_numSlots);
+    auto const columns =
+        static_cast<int>(std::ceil(std::sqrt(static_cast<double>(numSlots))));
+    auto const rows          = (numSlots + columns - 1) / columns;
+    auto const tileWidth     = (width() - ((columns - 1) * TILE_SPACING)) / columns;
+    auto const tileHeight    = (height() - ((rows - 1) * TILE_SPACING)) / rows;
+    auto const captionHeight = fontMetrics().height() + CAPTION_PADDING;
+    bool       sizesChanged  = false;
+
+    for (int i = 0; i < numTiles; ++i)
+    {
+        auto& tile = m_tiles[static_cast<size_t>(i)];
+
+        tile.tileRect = QRect((i % columns) * (tileWidth + TILE_SPACING),
+                              (i / columns) * (tileHeight + TILE_SPACING),
+                              tileWidth,
+                              tileHeight);
+
+        auto const videoRect = tile.tileRect.adjusted(TILE_BORDER_WIDTH,
+                                                      TILE_BORDER_WIDTH + captionHeight,
+                                                      -TILE_BORDER_WIDTH,
+                                                      -TILE_BORDER_WIDTH);
+
+        sizesChanged   = sizesChanged || (videoRect.size() != tile.videoRect.size());
+        tile.videoRect = videoRect;
+    }
+
+    if (sizesChanged)
+    {
+        emit TileLayoutChanged();
+    }
+}
+
+IpFreelyVideoGrid::Tile* IpFreelyVideoGrid::FindTile(int const cameraId)
+{
+    auto tileIter = std::find_if(m_tiles.begin(), m_tiles.end(), [cameraId](Tile const& tile) {
+        return tile.cameraId == cameraId;
+    });
+
+    return tileIter == m_tiles.end() ? nullptr : &(*tileIter);
+}
+
+IpFreelyVideoGrid::Tile const* IpFreelyVideoGrid::FindTile(int const cameraId) const
+{
+    auto tileIter = std::find_if(m_tiles.begin(), m_tiles.end(), [cameraId](Tile const& tile) {
+        return tile.cameraId == cameraId;
+    });
+
+    return tileIter == m_tiles.end() ? nullptr : &(*tileIter);
+}
+
+IpFreelyVideoGrid::Tile* IpFreelyVideoGrid::TileAt(QPoint const& pos)
+{
+    auto tileIter = std::find_if(m_tiles.begin(), m_tiles.end(), [&pos](Tile const& tile) {
+        return tile.tileRect.contains(pos);
+    });
+
+    return tileIter == m_tiles.end() ? nullptr : &(*tileIter);
+}
+
+QRect IpFreelyVideoGrid::FrameRect(Tile const& tile)
+{
+    if (tile.videoFrame.isNull() || tile.videoRect.isEmpty())
+    {
+        return QRect();
+    }
+
+    auto frameSize = tile.videoFrame.size();
+
+    // A frame rendered for the previous tile size may still be current just after a resize,
+    // in which case it is shrunk to fit until the stream processor catches up. Stale frames
+    // are small thumbnails so are always scaled to fill the tile.
+    if (tile.stale || (frameSize.width() > tile.videoRect.width()) ||
+        (frameSize.height() > tile.videoRect.height()))
+    {
+        frameSize.scale(tile.videoRect.size(), Qt::KeepAspectRatio);
+    }
+
+    QRect frameRect(QPoint(), frameSize);
+    frameRect.moveCenter(tile.videoRect.center());
+    return frameRect;
+}
+
+void IpFreelyVideoGrid::InvalidateTile(Tile const& tile)
+{
+    m_dirtyRegion += tile.tileRect;
+
+    if (m_repaintTimer->isActive())
+    {
+        return;
+    }
+
+    // Coalesce tile updates so we repaint at most once per screen refresh.
+    auto const refreshPeriodMs = RefreshPeriodMs(this);
+    auto const elapsedMs =
+        m_lastRepaint.isValid() ? static_cast<int>(m_lastRepaint.elapsed()) : refreshPeriodMs;
+
+    m_repaintTimer->start(elapsedMs >= refreshPeriodMs ? 0 : refreshPeriodMs - elapsedMs);
+}
+
+void IpFreelyVideoGrid::FlushDirtyRegion()
+{
+    update(m_dirtyRegion);
+    m_dirtyRegion = QRegion();
+    m_lastRepaint.start();
+}
@@ -0,0 +1,231 @@
+// This file is part of IpFreely application.
+//
+// Copyright (C) 2018, Duncan Crutchley
+// Contact <dac1976github@outlook.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License and GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// and GNU Lesser General Public License along with this program. If
+// not, see <http://www.gnu.org/licenses/>.
+
+/*!
+ * \file IpFreelyVideoGrid.h
+ * \brief File containing declaration of IpFreelyVideoGrid widget.
+ */
+#ifndef IPFREELYVIDEOGRID_H
+#define IPFREELYVIDEOGRID_H
+
+#include <QWidget>
+#include <QImage>
+#include <QString>
+#include <QRect>
+#include <QRegion>
+#include <QPoint>
+#include <QElapsedTimer>
+#include <vector>
+
+// Forward declarations.
+class QPaintEvent;
+class QResizeEvent;
+class QMouseEvent;
+class QRubberBand;
+class QTimer;
+class QRectF;
+class QEvent;
+
+/*! \brief Class defining a widget that composites all camera video tiles in one paint pass. */
+class IpFreelyVideoGrid : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /*!
+     * \brief IpFreelyVideoGrid constructor.
+     * \param[in] parent - (Optional) Pointer to parent widget.
+     */
+    explicit IpFreelyVideoGrid(QWidget* parent = nullptr);
+
+    /*! \brief IpFreelyVideoGrid destructor. */
+    virtual ~IpFreelyVideoGrid() = default;
+
+    /*!
+     * \brief SetCameraIds sets the cameras shown in the grid, one tile per camera.
+     * \param[in] cameraIds - Unique integer camera IDs in display order.
+     * \param[in] numSlots - (Optional) Minimum number of tile slots to lay out.
+     *
+     * The number of columns is chosen so the slots form the squarest grid possible. Passing a
+     * fixed number of slots keeps the tile size constant when fewer cameras are shown, e.g. on
+     * the last page of a paged layout; unused slots are left blank.
+     */
+    void SetCameraIds(std::vector<int> const& cameraIds, int const numSlots = 0);
+
+    /*!
+     * \brief SetVideoFrame sets the current video frame to be displayed in a tile.
+     * \param[in] cameraId - The tile's camera ID.
+     * \param[in] videoFrame - A QImage containing the display-ready video frame.
+     *
+     * Only the tile's rectangle is invalidated and repaints are throttled to the screen's
+     * refresh rate, so several tiles updating together are drawn in a single paint pass.
+     */
+    void SetVideoFrame(int const cameraId, QImage const& videoFrame);
+
+    /*!
+     * \brief ClearVideoFrame removes the current video frame from a tile.
+     * \param[in] cameraId - The tile's camera ID.
+     */
+    void ClearVideoFrame(int const cameraId);
+
+    /*!
+     * \brief SetStaleVideoFrame sets an old video frame to be displayed in a tile.
+     * \param[in] cameraId - The tile's camera ID.
+     * \param[in] videoFrame - A QImage containing the old video frame, e.g. a thumbnail.
+     * \param[in] staleText - Text drawn over the frame, e.g. when the frame was captured.
+     *
+     * The frame is scaled to fit the tile and drawn dimmed with the text over it, so it is
+     * clear that it is not live video. It is replaced by the next call to SetVideoFrame().
+     */
+    void SetStaleVideoFrame(int const cameraId, QImage const& videoFrame,
+                            QString const& staleText);
+
+    /*!
+     * \brief SetTitle sets the caption text drawn above a tile's video.
+     * \param[in] cameraId - The tile's camera ID.
+     * \param[in] title - The caption text.
+     */
+    void SetTitle(int const cameraId, QString const& title);
+
+    /*!
+     * \brief SetToolTip sets the tool tip shown when hovering over a tile.
+     * \param[in] cameraId - The tile's camera ID.
+     * \param[in] toolTip - The tool tip text.
+     */
+    void SetToolTip(int const cameraId, QString const& toolTip);
+
+    /*!
+     * \brief SetHudText sets the performance overlay text drawn over a tile's video.
+     * \param[in] cameraId - The tile's camera ID.
+     * \param[in] hudText - The overlay's text, one statistic per line, empty to hide it.
+     */
+    void SetHudText(int const cameraId, QString const& hudText);
+
+    /*!
+     * \brief SetEnableSelection enables the motion region selection rubberband on a tile.
+     * \param[in] cameraId - The tile's camera ID.
+     * \param[in] enable - Flag to enable/disable selection rubberband.
+     */
+    void SetEnableSelection(int const cameraId, bool const enable);
+
+    /*!
+     * \brief SetCurrentCameraId sets the highlighted tile.
+     * \param[in] cameraId - The tile's camera ID.
+     */
+    void SetCurrentCameraId(int const cameraId);
+
+    /*!
+     * \brief CurrentCameraId gives access to the highlighted tile's camera ID.
+     * \return The highlighted tile's camera ID or 0 if there are no tiles.
+     */
+    int CurrentCameraId() const;
+
+    /*!
+     * \brief VideoDisplaySize gives the size available to display video in a tile.
+     * \param[in] cameraId - The tile's camera ID.
+     * \return The tile's video area size, empty if the camera ID is unknown.
+     */
+    QSize VideoDisplaySize(int const cameraId) const;
+
+signals:
+    /*!
+     * \brief CurrentCameraChanged is emitted when the user clicks on a different tile.
+     * \param[in] cameraId - The newly highlighted tile's camera ID.
+     */
+    void CurrentCameraChanged(int cameraId);
+
+    /*!
+     * \brief CameraActivated is emitted when the user double clicks on a tile.
+     * \param[in] cameraId - The tile's camera ID.
+     */
+    void CameraActivated(int cameraId);
+
+    /*!
+     * \brief AreaSelected is emitted when dragging of a motion region selection box finishes.
+     * \param[in] cameraId - The tile's camera ID.
+     * \param[in] percentageSelection - The selected area as fractions of the video frame.
+     */
+    void AreaSelected(int cameraId, QRectF const& percentageSelection);
+
+    /*!
+     * \brief TileLayoutChanged is emitted when the tiles' video display sizes change.
+     *
+     * Moving tiles without resizing them, or resizing the grid by less than a pixel per
+     * tile, does not emit this signal.
+     */
+    void TileLayoutChanged();
+
+protected:
+    virtual bool event(QEvent* event);
+    virtual void paintEvent(QPaintEvent* event);
+    virtual void resizeEvent(QResizeEvent* event);
+    virtual void mousePressEvent(QMouseEvent* event);
+    virtual void mouseMoveEvent(QMouseEvent* event);
+    virtual void mouseReleaseEvent(QMouseEvent* event);
+    virtual void mouseDoubleClickEvent(QMouseEvent* event);
+
+private:
+    /*! \brief Structure holding a single tile's state. */
+    struct Tile
+    {
+        /*! \brief The tile's camera ID. */
+        int cameraId{0};
+        /*! \brief The tile's rectangle within the grid, including its caption. */
+        QRect tileRect{};
+        /*! \brief The tile's area available to display video. */
+        QRect videoRect{};
+        /*! \brief The latest video frame. */
+        QImage videoFrame{};
+        /*! \brief The caption text. */
+        QString title{};
+        /*! \brief The tool tip text. */
+        QString toolTip{};
+        /*! \brief The performance overlay text. */
+        QString hudText{};
+        /*! \brief Whether the video frame is an old frame rather than live video. */
+        bool stale{false};
+        /*! \brief The text drawn over a stale video frame. */
+        QString staleText{};
+        /*! \brief Whether the motion region selection rubberband is enabled. */
+        bool enableSelection{false};
+    };
+
+private:
+    void         LayoutTiles();
+    Tile*        FindTile(int const cameraId);
+    Tile const*  FindTile(int const cameraId) const;
+    Tile*        TileAt(QPoint const& pos);
+    static QRect FrameRect(Tile const& tile);
+    void         InvalidateTile(Tile const& tile);
+    void         FlushDirtyRegion();
+
+private:
+    std::vector<Tile> m_tiles;
+    int               m_numSlots;
+    int               m_currentCameraId;
+    int               m_selectionCameraId;
+    QPoint            m_origin;
+    QRubberBand*      m_rubberBand;
+    QRegion           m_dirtyRegion;
+    QTimer*           m_repaintTimer;
+    QElapsedTimer     m_lastRepaint;
+};
+
+#endif // IPFREELYVIDEOGRID_H
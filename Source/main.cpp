@@ -26,14 +26,19 @@
 
 #if BOOST_OS_WINDOWS
 #include <Windows.h>
+#include <Psapi.h>
+#else
+#include <unistd.h>
 #endif
 
 #include <sstream>
 #include <memory>
 #include <string>
 #include <cstring>
+#include <fstream>
 #include <QApplication>
 #include <QLocalSocket>
+#include <QTimer>
 #include <boost/exception/all.hpp>
 #include "DebugLog/DebugLogging.h"
 #include "singleapplication.h"
@@ -78,6 +83,102 @@ std::string GetAppVersion(const std::string& appFilePath)
 #define IPFREELY_VERSION "1.2.0.0"
 #endif
 
+#if BOOST_OS_WINDOWS
+// Link to psapi.dll using the lib from the Windows SDK.
+#pragma comment(lib, "psapi")
+
+bool GetStartupCost(double& elapsedMs, size_t& residentBytes)
+{
+    FILETIME creationTime, exitTime, kernelTime, userTime, now;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        return false;
+    }
+
+    GetSystemTimeAsFileTime(&now);
+
+    ULARGE_INTEGER start, end;
+    start.LowPart  = creationTime.dwLowDateTime;
+    start.HighPart = creationTime.dwHighDateTime;
+    end.LowPart    = now.dwLowDateTime;
+    end.HighPart   = now.dwHighDateTime;
+
+    // File times count 100ns intervals.
+    elapsedMs = static_cast<double>(end.QuadPart - start.QuadPart) / 10000.0;
+
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+    {
+        return false;
+    }
+
+    residentBytes = memoryCounters.WorkingSetSize;
+    return true;
+}
+#else
+bool GetStartupCost(double& elapsedMs, size_t& residentBytes)
+{
+    std::ifstream statFile("/proc/self/stat");
+    std::string   stat;
+    std::getline(statFile, stat);
+
+    // The command name, field 2, may contain spaces so fields are counted from its ')'.
+    auto const commandEnd = stat.rfind(')');
+
+    if (commandEnd == std::string::npos)
+    {
+        return false;
+    }
+
+    std::istringstream fields(stat.substr(commandEnd + 1));
+    std::string        field;
+
+    for (int i = 3; i < 22; ++i)
+    {
+        fields >> field;
+    }
+
+    // Field 22 is the process start time in clock ticks since boot.
+    unsigned long long startTicks = 0;
+    fields >> startTicks;
+
+    std::ifstream uptimeFile("/proc/uptime");
+    double        uptimeSecs = 0.0;
+    uptimeFile >> uptimeSecs;
+
+    std::ifstream statmFile("/proc/self/statm");
+    size_t        totalPages    = 0;
+    size_t        residentPages = 0;
+    statmFile >> totalPages >> residentPages;
+
+    if (!fields || !uptimeFile || !statmFile)
+    {
+        return false;
+    }
+
+    auto const startSecs =
+        static_cast<double>(startTicks) / static_cast<double>(sysconf(_SC_CLK_TCK));
+    elapsedMs     = (uptimeSecs - startSecs) * 1000.0;
+    residentBytes = residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return true;
+}
+#endif
+
+void LogStartupCost()
+{
+    double elapsedMs     = 0.0;
+    size_t residentBytes = 0;
+
+    if (GetStartupCost(elapsedMs, residentBytes))
+    {
+        DEBUG_MESSAGE_EX_INFO("Startup time (ms): "
+                              << elapsedMs << ", resident memory (MiB): "
+                              << static_cast<double>(residentBytes) / (1024.0 * 1024.0));
+    }
+}
+
 int main(int argc, char* argv[])
 {
     int  retCode        = EXIT_SUCCESS;
@@ -104,6 +205,10 @@ int main(int argc, char* argv[])
         DEBUG_MESSAGE_EX_INFO("Showing main form.");
         w.show();
 
+        // Measured once the message loop is running and the main form has been shown, from
+        // when the process was created so library loading is included.
+        QTimer::singleShot(0, &LogStartupCost);
+
         DEBUG_MESSAGE_EX_INFO("Executing application message loop.");
         retCode = a.exec();
     }
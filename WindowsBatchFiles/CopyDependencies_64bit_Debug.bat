@@ -6,3 +6,4 @@ copy "C:\Program Files (x86)\Microsoft Visual Studio 14.0\VC\redist\debug_nonred
 copy "C:\Program Files (x86)\Microsoft Visual Studio 14.0\VC\redist\debug_nonredist\x64\Microsoft.VC140.DebugCRT\vcruntime140d.dll" "D:\Projects\IP-Freely\build-IpFreely-Desktop_Qt_5_10_1_MSVC2015_64bit-Debug\debug"
 copy "C:\Program Files (x86)\Microsoft Visual Studio 14.0\VC\redist\debug_nonredist\x64\Microsoft.VC140.DebugCRT\vccorlib140d.dll" "D:\Projects\IP-Freely\build-IpFreely-Desktop_Qt_5_10_1_MSVC2015_64bit-Debug\debug"
 "C:\Applications\Qt\5.10.1\msvc2015_64\bin\windeployqt" --debug "D:\Projects\IP-Freely\build-IpFreely-Desktop_Qt_5_10_1_MSVC2015_64bit-Debug\debug\IpFreely.exe"
+if exist "D:\Projects\IP-Freely\build-IpFreely-Desktop_Qt_5_10_1_MSVC2015_64bit-Debug\debug\IpFreelyStorageBrowser.exe" "C:\Applications\Qt\5.10.1\msvc2015_64\bin\windeployqt" --debug "D:\Projects\IP-Freely\build-IpFreely-Desktop_Qt_5_10_1_MSVC2015_64bit-Debug\debug\IpFreelyStorageBrowser.exe"
@@ -6,3 +6,4 @@ copy "C:\Program Files (x86)\Microsoft Visual Studio 14.0\VC\redist\x64\Microsof
 copy "C:\Program Files (x86)\Microsoft Visual Studio 14.0\VC\redist\x64\Microsoft.VC140.CRT\vcruntime140.dll" "D:\Projects\IP-Freely\build-IpFreely-Desktop_Qt_5_10_1_MSVC2015_64bit-Release\release"
 copy "C:\Program Files (x86)\Microsoft Visual Studio 14.0\VC\redist\x64\Microsoft.VC140.CRT\vccorlib140.dll" "D:\Projects\IP-Freely\build-IpFreely-Desktop_Qt_5_10_1_MSVC2015_64bit-Release\release"
 "C:\Applications\Qt\5.10.1\msvc2015_64\bin\windeployqt" --release "D:\Projects\IP-Freely\build-IpFreely-Desktop_Qt_5_10_1_MSVC2015_64bit-Release\release\IpFreely.exe"
+if exist "D:\Projects\IP-Freely\build-IpFreely-Desktop_Qt_5_10_1_MSVC2015_64bit-Release\release\IpFreelyStorageBrowser.exe" "C:\Applications\Qt\5.10.1\msvc2015_64\bin\windeployqt" --release "D:\Projects\IP-Freely\build-IpFreely-Desktop_Qt_5_10_1_MSVC2015_64bit-Release\release\IpFreelyStorageBrowser.exe"